@@ -0,0 +1,147 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include "collision.h"
+#include "jobs.h"
+#include "shape.h"
+
+/**
+ * Scaling benchmark for the job system.
+ *
+ * Runs separating axis tests over a fixed set of random rectangle pairs with
+ * jobs_parallel_for() for every worker count from 0 up to the machine's
+ * default, and measures the cost of creating, submitting and waiting on
+ * small jobs.
+ *
+ * Usage: bin/bench_jobs [-w max workers] [-n pairs] [-g grain]
+ */
+
+const size_t BENCH_DEFAULT_PAIRS = 200000;
+const size_t BENCH_DEFAULT_GRAIN = 256;
+const size_t BENCH_REPEATS = 20;
+const size_t BENCH_NUM_SMALL_JOBS = 20000;
+const double BENCH_FIELD_SIZE = 2000;
+const double BENCH_MAX_SIDE = 80;
+
+
+typedef struct bench_pairs {
+    body_t **bodies;
+    size_t num_pairs;
+    size_t *hits;
+} bench_pairs_t;
+
+
+double bench_now_ms() {
+    return (double)SDL_GetPerformanceCounter() * 1e3 / (double)SDL_GetPerformanceFrequency();
+}
+
+
+double bench_rand(double max) {
+    return (double)rand() / RAND_MAX * max;
+}
+
+
+void bench_collide_range(size_t start, size_t end, void *aux) {
+    bench_pairs_t *pairs = aux;
+    for (size_t i = start; i < end; i++) {
+        body_t *b1 = pairs->bodies[2 * i];
+        body_t *b2 = pairs->bodies[2 * i + 1];
+        collision_info_t info = find_collision(body_get_shape_nocpy(b1), body_get_shape_nocpy(b2));
+        pairs->hits[i] = info.collided;
+    }
+}
+
+
+void bench_empty_job(void *aux) {
+    (void)aux;
+}
+
+
+int main(int argc, char *argv[]) {
+    size_t max_workers = jobs_default_num_workers();
+    size_t num_pairs = BENCH_DEFAULT_PAIRS;
+    size_t grain = BENCH_DEFAULT_GRAIN;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            max_workers = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            num_pairs = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            grain = strtoul(argv[++i], NULL, 10);
+        }
+        else {
+            printf("Usage: %s [-w max workers] [-n pairs] [-g grain]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // Pairs close enough that most of them need the full SAT
+    srand(2023);
+    rgb_color_t color = {.r = 0, .g = 0, .b = 0};
+    bench_pairs_t pairs = {.num_pairs = num_pairs};
+    pairs.bodies = malloc(sizeof(body_t *) * 2 * num_pairs);
+    pairs.hits = malloc(sizeof(size_t) * num_pairs);
+    assert(pairs.bodies && pairs.hits);
+    for (size_t i = 0; i < 2 * num_pairs; i++) {
+        body_t *body = shape_init_rectangle(10 + bench_rand(BENCH_MAX_SIDE), 10 + bench_rand(BENCH_MAX_SIDE),
+                                            color, 1, NULL, NULL);
+        vector_t center = {.x = bench_rand(BENCH_FIELD_SIZE), .y = bench_rand(BENCH_FIELD_SIZE)};
+        if (i % 2 == 1) {
+            center = vec_add(body_get_centroid(pairs.bodies[i - 1]),
+                             (vector_t){bench_rand(BENCH_MAX_SIDE), bench_rand(BENCH_MAX_SIDE)});
+        }
+        body_set_centroid(body, center);
+        body_set_rotation(body, bench_rand(M_PI));
+        pairs.bodies[i] = body;
+    }
+
+    printf("%zu pairs, grain %zu, %zu repeats\n", num_pairs, grain, BENCH_REPEATS);
+    printf("%7s %7s %12s %9s %14s\n", "workers", "threads", "ms/pass", "speedup", "us/small job");
+
+    double base_ms = 0;
+    for (size_t workers = 0; workers <= max_workers; workers++) {
+        jobs_init(workers);
+
+        double start = bench_now_ms();
+        for (size_t r = 0; r < BENCH_REPEATS; r++) {
+            jobs_parallel_for(num_pairs, grain, bench_collide_range, &pairs);
+        }
+        double pass_ms = (bench_now_ms() - start) / BENCH_REPEATS;
+        if (workers == 0) {
+            base_ms = pass_ms;
+        }
+
+        job_t **jobs = malloc(sizeof(job_t *) * BENCH_NUM_SMALL_JOBS);
+        assert(jobs);
+        start = bench_now_ms();
+        for (size_t i = 0; i < BENCH_NUM_SMALL_JOBS; i++) {
+            jobs[i] = job_create(bench_empty_job, NULL);
+            job_submit(jobs[i]);
+        }
+        for (size_t i = 0; i < BENCH_NUM_SMALL_JOBS; i++) {
+            job_wait(jobs[i]);
+        }
+        double job_us = (bench_now_ms() - start) * 1e3 / BENCH_NUM_SMALL_JOBS;
+        free(jobs);
+
+        printf("%7zu %7zu %12.3f %8.2fx %14.3f\n", workers, jobs_num_threads(), pass_ms,
+               base_ms / pass_ms, job_us);
+        jobs_shutdown();
+    }
+
+    size_t hits = 0;
+    for (size_t i = 0; i < num_pairs; i++) {
+        hits += pairs.hits[i];
+        body_free(pairs.bodies[2 * i]);
+        body_free(pairs.bodies[2 * i + 1]);
+    }
+    printf("%zu of %zu pairs overlap\n", hits, num_pairs);
+    free(pairs.bodies);
+    free(pairs.hits);
+    return 0;
+}
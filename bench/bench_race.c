@@ -0,0 +1,360 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alloc.h"
+#include "faf_cars.h"
+#include "faf_hud.h"
+#include "faf_levels.h"
+#include "faf_standings.h"
+#include "jobs.h"
+#include "mathlib.h"
+#include "rng.h"
+#include "sdl_wrapper.h"
+#include "window.h"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+/**
+ * End-to-end race benchmark.
+ *
+ * Builds every level from a fixed seed, replays a recorded input stream for
+ * the player car through faf_car_on_key() and ticks the race at a fixed dt
+ * until the player crosses the finish. Each level is run once without
+ * rendering and once rendering every frame into an offscreen surface.
+ *
+ * Usage: bin/bench_race [-i inputs] [-s seed] [-l level] [-c cars | -g] [-n | -r]
+ *   -i  the recorded input stream (default bench/race_inputs.txt)
+ *   -s  the seed used to generate the levels (default 2023)
+ *   -l  only run the given level (0: desert, 1: ice, 2: forest)
+ *   -c  race with the given number of cars, the player's included (default 6)
+ *   -g  sweep the grid size, running each level with every size in BENCH_GRID_SIZES
+ *   -n  only run without rendering
+ *   -r  only run with rendering
+ *
+ * Built with ALLOC_TRACKING=1, each run also prints the tagged allocation
+ * report, and the simulation step is a hot section: any allocation in it,
+ * other than streaming in the track's chunks, fails an assert.
+ */
+
+extern const vector_t FAF_WINDOW_DIMENSIONS;
+
+const double BENCH_DT = 1. / 60.;
+const size_t BENCH_MAX_TICKS = 30000;
+const size_t BENCH_NUM_CARS = 6;
+// The grid sizes swept by -g, up to well past a full race of 100 AI cars
+const size_t BENCH_GRID_SIZES[5] = {6, 25, 50, 100, 200};
+const unsigned BENCH_DEFAULT_SEED = 2023;
+const char *BENCH_DEFAULT_INPUTS = "bench/race_inputs.txt";
+const vector_t BENCH_FOCUS_OFFSET = {.x = 0, .y = 100};
+const faf_car_t BENCH_PLAYER_CAR = FERRARI_488_GTE;
+const size_t BENCH_INIT_NUM_INPUTS = 64;
+const size_t BENCH_REPORT_CALLSITES = 12;
+
+const faf_level_t BENCH_LEVELS[3] = {DESERT_LEVEL, ICE_LEVEL, FOREST_LEVEL};
+const char BENCH_LEVEL_NAMES[3][10] = {"desert", "ice", "forest"};
+
+
+#ifdef BENCH_WRAP_MALLOC
+// Every allocation made by the game and library objects goes through these
+// when the benchmark is linked with -Wl,--wrap=malloc (and friends).
+size_t bench_num_allocs = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    bench_num_allocs++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    bench_num_allocs++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    bench_num_allocs++;
+    return __real_realloc(ptr, size);
+}
+
+size_t bench_get_num_allocs() {
+    return bench_num_allocs;
+}
+#else
+size_t bench_get_num_allocs() {
+    return 0;
+}
+#endif
+
+
+typedef struct bench_input {
+    double time;
+    char key;
+    key_event_type_t type;
+} bench_input_t;
+
+
+typedef struct bench_result {
+    size_t ticks;
+    double wall_ms;
+    double max_tick_ms;
+    size_t allocs;
+    long peak_rss_kb;
+    bool finished;
+    collision_stats_t collisions;
+} bench_result_t;
+
+
+double bench_now_ms() {
+    return (double)SDL_GetPerformanceCounter() * 1e3 / (double)SDL_GetPerformanceFrequency();
+}
+
+
+long bench_peak_rss_kb() {
+#ifndef _WIN32
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    // macOS reports bytes instead of kilobytes
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return 0;
+#endif
+}
+
+
+char bench_parse_key(const char *name) {
+    if (strcmp(name, "up") == 0) {
+        return UP_ARROW;
+    }
+    if (strcmp(name, "down") == 0) {
+        return DOWN_ARROW;
+    }
+    if (strcmp(name, "left") == 0) {
+        return LEFT_ARROW;
+    }
+    if (strcmp(name, "right") == 0) {
+        return RIGHT_ARROW;
+    }
+    return NO_KEY;
+}
+
+
+// Reads "<race time> <up|down|left|right> <press|release>" lines.
+// Blank lines and lines starting with '#' are ignored.
+list_t *bench_read_inputs(const char *filename) {
+    FILE *f = fopen(filename, "r");
+    if (!f) {
+        printf("Couldn't open input stream %s\n", filename);
+        exit(1);
+    }
+
+    list_t *inputs = list_init(BENCH_INIT_NUM_INPUTS, free);
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+        double time;
+        char key_name[16];
+        char type_name[16];
+        if (line[0] == '#' || sscanf(line, "%lf %15s %15s", &time, key_name, type_name) != 3) {
+            continue;
+        }
+        bench_input_t *input = malloc(sizeof(bench_input_t));
+        assert(input);
+        input->time = time;
+        input->key = bench_parse_key(key_name);
+        input->type = strcmp(type_name, "press") == 0 ? KEY_PRESSED : KEY_RELEASED;
+        assert(input->key != NO_KEY);
+        list_add(inputs, input);
+    }
+    fclose(f);
+
+    return inputs;
+}
+
+
+// Mirrors faf_setup_race() without the menus, audio and end-of-race screens.
+window_t *bench_setup_race(faf_level_t level, unsigned seed, size_t num_cars, list_t *cars) {
+    // Nothing in a race should draw from the shared stream, but seed it in case something does
+    mathlib_seed(seed);
+
+    body_t *player_car = faf_make_car(BENCH_PLAYER_CAR, true, 0);
+    body_t *player_indicator = faf_make_player_indicator(player_car);
+    list_add(cars, player_car);
+    for (size_t i = 0; i < num_cars - 1; i++) {
+        faf_car_t ai_type = (faf_car_t)((BENCH_PLAYER_CAR + i + 1) % 7);
+        body_t *ai_car = faf_make_car(ai_type, false, 0);
+        faf_car_set_rng(ai_car, rng_init_stream(seed, i));
+        list_add(cars, ai_car);
+    }
+
+    scene_t *scene = faf_make_level(level, seed, faf_get_scene_dimensions().y, cars);
+
+    for (size_t i = 0; i < list_size(cars); i++) {
+        body_set_centroid(list_get(cars, i), faf_get_grid_position(i, list_size(cars)));
+        scene_add_body_in_layer(scene, list_get(cars, i), FAF_OBJECT_LAYER);
+    }
+    scene_add_body_in_layer(scene, player_indicator, FAF_CAR_LAYER);
+    faf_standings_t *standings = faf_standings_init(cars);
+    faf_standings_add_to_scene(scene, standings);
+
+    window_t *window = window_init(scene, VEC_ZERO, FAF_WINDOW_DIMENSIONS);
+    faf_car_set_window(player_car, window);
+    window_follow_body(window, player_car, BENCH_FOCUS_OFFSET);
+    window_add_key_handler(window, (key_handler_t)faf_car_on_key, player_car, NULL);
+    window_set_hud(window, faf_make_race_hud(cars, standings));
+
+    return window;
+}
+
+
+bench_result_t bench_run_race(faf_level_t level, unsigned seed, size_t num_cars, list_t *inputs, bool render) {
+    list_t *cars = list_init(num_cars, NULL);
+    window_t *window = bench_setup_race(level, seed, num_cars, cars);
+    body_t *player_car = list_get(cars, 0);
+    double finish = faf_car_get_finish_y(player_car);
+
+    bench_result_t result = {.max_tick_ms = 0, .finished = false};
+    size_t next_input = 0;
+    alloc_reset();
+    size_t start_allocs = bench_get_num_allocs();
+    double start = bench_now_ms();
+
+    for (result.ticks = 0; result.ticks < BENCH_MAX_TICKS; result.ticks++) {
+        double race_time = faf_car_get_time(player_car);
+        while (next_input < list_size(inputs)) {
+            bench_input_t *input = list_get(inputs, next_input);
+            if (input->time > race_time) {
+                break;
+            }
+            window_on_key(window, input->key, input->type, 0);
+            next_input++;
+        }
+
+        double tick_start = bench_now_ms();
+        alloc_frame_begin();
+        alloc_hot_begin("window_tick");
+        window_tick(window, BENCH_DT);
+        alloc_hot_end();
+        if (render) {
+            sdl_render_window(window);
+        }
+        alloc_frame_end();
+        double tick_ms = bench_now_ms() - tick_start;
+        if (tick_ms > result.max_tick_ms) {
+            result.max_tick_ms = tick_ms;
+        }
+
+        if (body_get_centroid(player_car).y > finish) {
+            result.finished = true;
+            result.ticks++;
+            break;
+        }
+    }
+
+    result.wall_ms = bench_now_ms() - start;
+    result.allocs = bench_get_num_allocs() - start_allocs;
+    result.peak_rss_kb = bench_peak_rss_kb();
+    result.collisions = scene_get_total_collision_stats(window_get_scene(window));
+#ifdef FAF_ALLOC_TRACKING
+    alloc_print_report(stdout, BENCH_REPORT_CALLSITES);
+#endif
+
+    window_free(window);
+    list_free(cars);
+
+    return result;
+}
+
+
+void bench_print_result(const char *level_name, bool render, size_t num_cars, bench_result_t result) {
+    printf("%-7s %-9s %5zu %7zu %10.4f %10.4f %12.2f %10.1f %10ld %s\n",
+           level_name, render ? "offscreen" : "headless", num_cars, result.ticks,
+           result.wall_ms / result.ticks, result.max_tick_ms,
+           (double)result.allocs / result.ticks, result.wall_ms, result.peak_rss_kb,
+           result.finished ? "" : "(did not finish)");
+
+    collision_stats_t c = result.collisions;
+    double ticks = result.ticks;
+    printf("  collisions/tick: %.0f visited, %.0f radius rejects, %.1f SAT, %.1f axes, "
+           "%.1f early outs, %.2f contacts, %.2f handlers\n",
+           c.force_creators / ticks, c.radius_rejections / ticks, c.sat_tests / ticks,
+           c.axes_tested / ticks, c.early_outs / ticks, c.contacts / ticks, c.handlers_fired / ticks);
+}
+
+
+int main(int argc, char *argv[]) {
+    const char *inputs_file = BENCH_DEFAULT_INPUTS;
+    unsigned seed = BENCH_DEFAULT_SEED;
+    int only_level = -1;
+    bool run_headless = true;
+    bool run_render = true;
+    size_t num_cars = BENCH_NUM_CARS;
+    bool sweep = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            inputs_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seed = (unsigned)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            only_level = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            num_cars = (size_t)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-g") == 0) {
+            sweep = true;
+        }
+        else if (strcmp(argv[i], "-n") == 0) {
+            run_render = false;
+        }
+        else if (strcmp(argv[i], "-r") == 0) {
+            run_headless = false;
+        }
+        else {
+            printf("Usage: %s [-i inputs] [-s seed] [-l level] [-c cars | -g] [-n | -r]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    sdl_init_offscreen(VEC_ZERO, FAF_WINDOW_DIMENSIONS);
+    // Like the game, start the workers up front rather than in the first tick
+    jobs_init(jobs_default_num_workers());
+    list_t *inputs = bench_read_inputs(inputs_file);
+
+    printf("seed %u, dt %.5f s, %s coordinates, %zu inputs from %s\n", seed, BENCH_DT,
+           sizeof(real_t) == sizeof(float) ? "float" : "double", list_size(inputs), inputs_file);
+    printf("%-7s %-9s %5s %7s %10s %10s %12s %10s %10s\n", "level", "mode", "cars", "ticks", "ms/tick",
+           "max ms", "allocs/tick", "wall ms", "rss KiB");
+
+    size_t num_sizes = sweep ? sizeof(BENCH_GRID_SIZES) / sizeof(*BENCH_GRID_SIZES) : 1;
+    for (size_t i = 0; i < sizeof(BENCH_LEVELS) / sizeof(*BENCH_LEVELS); i++) {
+        if (only_level >= 0 && (size_t)only_level != i) {
+            continue;
+        }
+        for (size_t j = 0; j < num_sizes; j++) {
+            size_t cars = sweep ? BENCH_GRID_SIZES[j] : num_cars;
+            if (run_headless) {
+                bench_result_t result = bench_run_race(BENCH_LEVELS[i], seed, cars, inputs, false);
+                bench_print_result(BENCH_LEVEL_NAMES[i], false, cars, result);
+            }
+            if (run_render) {
+                bench_result_t result = bench_run_race(BENCH_LEVELS[i], seed, cars, inputs, true);
+                bench_print_result(BENCH_LEVEL_NAMES[i], true, cars, result);
+            }
+        }
+    }
+
+    list_free(inputs);
+    jobs_shutdown();
+    return 0;
+}
@@ -7,9 +7,16 @@ extern const int SONG_CHANNEL;
 extern const int CAR_SOUND_CHANNEL;
 extern const int ENVIRONMENT_SOUND_CHANNEL;
 extern const int COUNTDOWN_CHANNEL;
+// The volume of the car engine during a race
+extern const int CAR_SOUND_VOLUME;
 
 /**
- * Initializes the program to play audio.
+ * Initializes the program to play audio: opens the mixer with a small buffer
+ * for low latency and loads every sound, converted to the device's format.
+ *
+ * Volume and engine changes are sent to the audio thread through a lock-free
+ * queue and applied to the next buffer it mixes; values that haven't changed
+ * since they were last sent are never queued.
  */
 void faf_audio_init();
 
@@ -34,15 +41,25 @@ void faf_audio_play_music();
 void faf_audio_honk();
 
 /**
- * Sets the volume for a channel.
- * 
+ * Sets the volume for a channel. The volume of CAR_SOUND_CHANNEL is the engine's.
+ * Does nothing if the volume is already set.
+ *
  * @param channel the channel to change the volume for
  * @param volume the volume to set (0 to 128)
  */
 void faf_audio_set_volume(int channel, int volume);
 
 /**
- * Frees Mix_Music used to play audio.
+ * Sets the engine note of the player's car, which is pitched by its speed
+ * and louder on the throttle. Call it every tick; only audible changes are sent.
+ *
+ * @param speed the car's speed as a fraction of its top speed, clamped to [0, 1]
+ * @param throttle whether the car is accelerating
+ */
+void faf_audio_set_engine(double speed, bool throttle);
+
+/**
+ * Stops the audio and frees the sounds.
  */
 void faf_audio_free();
 
@@ -2,7 +2,10 @@
 #define __FAF_CARS_H__
 
 #include <stdbool.h>
+#include "arena.h"
 #include "body.h"
+#include "faf_lanes.h"
+#include "rng.h"
 #include "sdl_wrapper.h"
 #include "window.h"
 
@@ -21,11 +24,13 @@ typedef struct surface_info surface_info_t;
 
 /**
  * Creates a surface info struct for a given surface.
+ * The info is read-only, so every tile of the same surface can share it.
  *
+ * @param arena the arena to allocate from, e.g. the level's scene_get_arena()
  * @param surf_coef the surface coefficient for the surface
- * @return a pointer to the initialized info.
+ * @return a pointer to the initialized info, freed with the arena.
  */
-surface_info_t *faf_surface_init(double surf_coef);
+surface_info_t *faf_surface_init(arena_t *arena, double surf_coef);
 
 /**
  * Creates a car of a given type.
@@ -37,14 +42,6 @@ surface_info_t *faf_surface_init(double surf_coef);
  */
 body_t *faf_make_car(faf_car_t type, bool is_player_car, double start_time);
 
-/**
- * Creates the ai_collider that protects the ai_car
- *
- * @param ai_car the ai_car
- * @return ai_collider
- */
-body_t *faf_make_ai_car_collider(body_t *ai_car);
-
 body_t *faf_make_player_indicator(body_t *player_car);
 
 /**
@@ -73,16 +70,6 @@ double faf_car_get_curr_gas(body_t *car);
  */
 double faf_car_get_max_gas(body_t *car);
 
-/**
- * On-hit function for collisions with ai_collider.
- * 
- * @param ai_collider the player ai_collider to check
- * @param other the other body in collision
- * @param axis the axis of collision
- * @param aux an auxiliary value
- */
-void faf_ai_collider_on_hit(body_t *ai_collider, body_t *other, vector_t axis, void *aux);
-
 /**
  * On-hit function for collisions with a car.
  * 
@@ -95,8 +82,43 @@ void faf_car_on_hit(body_t *car, body_t *other, vector_t axis, void *aux);
 
 void faf_car_set_window(body_t *car, window_t *window);
 
+/**
+ * Gives a car the lane grid of the track it races on. AI cars plan which lane
+ * to drive in with it, and every car counts the objects it hits out of it.
+ *
+ * @param car the car
+ * @param lanes the track's lane grid
+ */
+void faf_car_set_lanes(body_t *car, faf_lanes_t *lanes);
+
+/**
+ * Tells a car where the finish line of the track it races on is.
+ *
+ * @param car the car
+ * @param finish_y where the center of the finish line is
+ */
+void faf_car_set_finish_y(body_t *car, double finish_y);
+
+/**
+ * Gives a car its own random stream, which its AI draws from when it has to
+ * choose between two equally good lanes.
+ *
+ * @param car the car to seed
+ * @param rng the stream, e.g. from rng_init_stream() with the race's seed
+ */
+void faf_car_set_rng(body_t *car, rng_t rng);
+
 window_t *faf_car_get_window(body_t *car);
 
+/**
+ * Returns where the finish line of a car's track is, whether the track was
+ * generated or loaded from a level file.
+ *
+ * @param car the car
+ * @return the finish line's y, or INFINITY if the car is on no track or an endless one
+ */
+double faf_car_get_finish_y(body_t *car);
+
 double faf_car_get_time(body_t *car);
 
 #endif // #ifndef __FAF_CARS_H__
\ No newline at end of file
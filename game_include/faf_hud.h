@@ -3,14 +3,32 @@
 
 #include <SDL2/SDL_image.h>
 #include "body.h"
+#include "faf_standings.h"
 #include "hud.h"
 
 /**
  * Creates a new racing HUD.
  *
  * @param cars a list of cars in the scene. The car to track should be at index 0.
+ * @param standings the race's standings, made from the same list, which the
+ *   player's place is read from; they must outlive the HUD's ticks
  * @return an initialized HUD for the racing scene.
  */
-hud_t *faf_make_race_hud(list_t *cars);
+hud_t *faf_make_race_hud(list_t *cars, faf_standings_t *standings);
+
+/**
+ * Adds the profiler overlay to a HUD. While shown, it lists the collision
+ * counters of the race scene over the last tick, in total and for the pairs
+ * of object types that ran the most collision checks.
+ *
+ * @param hud the HUD to add the overlay to
+ * @param car the player car, whose window holds the race scene
+ */
+void faf_hud_add_profiler(hud_t *hud, body_t *car);
+
+/**
+ * Shows the profiler overlay if it is hidden and hides it otherwise.
+ */
+void faf_hud_toggle_profiler();
 
 #endif // #ifndef __FAF_HUD_H__
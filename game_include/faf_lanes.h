@@ -0,0 +1,131 @@
+#ifndef __FAF_LANES_H__
+#define __FAF_LANES_H__
+
+#include <stddef.h>
+#include "body.h"
+#include "rng.h"
+#include "vector.h"
+
+/**
+ * A coarse occupancy grid over the road for the AI cars to plan with:
+ * the road is split into lanes across and bins along, and each cell counts
+ * the objects in it that a car would want to avoid or to drive through.
+ *
+ * The grid only covers the stretch of road that exists: rows are added as
+ * chunks of track are made and dropped as they are removed, and objects are
+ * counted out as cars hit them, so nothing is ever rebuilt from the scene.
+ */
+typedef struct faf_lanes faf_lanes_t;
+
+/**
+ * How much an AI car dislikes each thing in the lanes ahead, e.g. per difficulty.
+ * Negative costs are things a car wants.
+ */
+typedef struct faf_lane_costs {
+    // For each obstacle or harmful effect
+    double hazard;
+    // For each helpful effect
+    double boost;
+    // For each gas can
+    double gas;
+    // For each lane moved across
+    double change;
+    // How far ahead the car plans
+    double lookahead;
+} faf_lane_costs_t;
+
+/**
+ * Allocates a grid with no rows.
+ *
+ * @param left the x coordinate of the road's left edge
+ * @param width the width of the road
+ * @param num_lanes the number of lanes across the road
+ * @param bin_length the length of the road each row covers
+ * @param margin how far to the side of an object a car's center still hits it,
+ *   e.g. half a car's width
+ * @return the new grid
+ */
+faf_lanes_t *faf_lanes_init(double left, double width, size_t num_lanes, double bin_length, double margin);
+
+/**
+ * Frees a grid.
+ *
+ * @param lanes a grid returned from faf_lanes_init()
+ */
+void faf_lanes_free(faf_lanes_t *lanes);
+
+/**
+ * Adds empty rows until the grid covers the road up to a point.
+ *
+ * @param lanes the grid
+ * @param end_y how far along the road the grid should reach
+ */
+void faf_lanes_extend(faf_lanes_t *lanes, double end_y);
+
+/**
+ * Drops the rows that end at or before a point, with everything counted in them.
+ *
+ * @param lanes the grid
+ * @param start_y where the road that is still needed starts
+ */
+void faf_lanes_retire(faf_lanes_t *lanes, double start_y);
+
+/**
+ * Counts an object into the cells its bounding circle covers.
+ * Objects that don't matter to a car, e.g. decorations, are ignored,
+ * as are the parts of an object outside the grid's rows.
+ *
+ * @param lanes the grid
+ * @param object a level object's body (see faf_object_init())
+ */
+void faf_lanes_add(faf_lanes_t *lanes, body_t *object);
+
+/**
+ * Counts an object back out of the grid. Must be called before body_remove(),
+ * and does nothing for an object that has already been removed, so an object
+ * hit by two cars at once is only counted out once.
+ *
+ * @param lanes the grid
+ * @param object a body given to faf_lanes_add()
+ */
+void faf_lanes_remove(faf_lanes_t *lanes, body_t *object);
+
+/**
+ * Returns the lane a point on the road is in.
+ * Points off the road are in the nearest lane.
+ *
+ * @param lanes the grid
+ * @param x the point's x coordinate
+ * @return the lane's index, counting from the left
+ */
+size_t faf_lanes_lane_at(faf_lanes_t *lanes, double x);
+
+/**
+ * Returns the x coordinate of the middle of a lane.
+ *
+ * @param lanes the grid
+ * @param lane the lane's index, less than the number of lanes
+ * @return the lane's center
+ */
+double faf_lanes_center(faf_lanes_t *lanes, size_t lane);
+
+/**
+ * Chooses the lane for a car to head for: staying in its current target lane,
+ * or moving one lane either way. Each choice is scored by the cells the car would
+ * cover over its lookahead, nearer rows counting more, while it is still crossing
+ * into the new lane as well as after. Takes time proportional to the lookahead.
+ *
+ * @param lanes the grid
+ * @param position the car's centroid
+ * @param target the lane the car is heading for, or any index past the last lane
+ *   if it has none yet
+ * @param turn_rate how far sideways the car moves for each unit along the road
+ *   while it turns, which decides how long it takes to change lanes
+ * @param costs what the car avoids and seeks
+ * @param rng breaks ties between moving left and moving right
+ * @return the lane to head for
+ */
+size_t faf_lanes_plan(faf_lanes_t *lanes, vector_t position, size_t target, double turn_rate,
+                      const faf_lane_costs_t *costs, rng_t *rng);
+
+#endif // #ifndef __FAF_LANES_H__
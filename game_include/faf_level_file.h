@@ -0,0 +1,133 @@
+#ifndef __FAF_LEVEL_FILE_H__
+#define __FAF_LEVEL_FILE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "dynarray.h"
+#include "faf_levels.h"
+#include "faf_objects.h"
+
+/**
+ * A built level stored in a compact binary file, so a race can start
+ * without generating the track (see faf_make_level_from_file()).
+ *
+ * A level file is, in the byte order of the machine that wrote it:
+ *   - a faf_level_file_header_t,
+ *   - a faf_chunk_record_t for each chunk of the track, in order,
+ *   - every chunk's faf_tile_record_t's, one chunk after another,
+ *   - every chunk's faf_object_record_t's, one chunk after another.
+ * Every record is a multiple of 4 bytes, so the arrays can be used
+ * straight from a mapping of the file.
+ */
+
+// Changed whenever the layout of the file changes; files of other versions are rejected
+extern const uint32_t FAF_LEVEL_FILE_VERSION;
+
+typedef struct faf_level_file_header {
+    // "FAFL"
+    char magic[4];
+    uint32_t version;
+    // A faf_level_t
+    uint32_t level_type;
+    uint32_t num_chunks;
+    // Must be FAF_CHUNK_LENGTH
+    float chunk_length;
+    float track_length;
+    // Where the center of the finish line goes
+    float finish_y;
+    uint32_t num_tiles;
+    uint32_t num_objects;
+} faf_level_file_header_t;
+
+// Where one chunk's records are in the file's tile and object arrays
+typedef struct faf_chunk_record {
+    uint32_t first_tile;
+    uint32_t num_tiles;
+    uint32_t first_object;
+    uint32_t num_objects;
+} faf_chunk_record_t;
+
+// The surface a terrain tile is made of
+typedef enum {
+    FAF_ROAD_TILE,
+    FAF_SIDE_TILE
+} faf_tile_t;
+
+// A rectangle of road or of the level's side surface
+typedef struct faf_tile_record {
+    float x;
+    float y;
+    float width;
+    float height;
+    // A faf_tile_t
+    uint32_t tile_type;
+} faf_tile_record_t;
+
+DYNARRAY_DEFINE(faf_tile_records, faf_tile_record_t, 16)
+
+/**
+ * An open level file.
+ */
+typedef struct faf_level_file faf_level_file_t;
+
+/**
+ * Opens a level file, mapping it into memory where the platform allows it
+ * and reading it otherwise. Nothing is copied out of the file until a chunk is built.
+ *
+ * @param path the path of the file
+ * @return the open file, or NULL if it can't be read, is not a level file of this version,
+ *   or has a record that can't be built
+ */
+faf_level_file_t *faf_level_file_open(const char *path);
+
+/**
+ * Closes a level file. Records returned by it are no longer valid.
+ *
+ * @param file a file returned from faf_level_file_open()
+ */
+void faf_level_file_close(faf_level_file_t *file);
+
+/**
+ * Returns the header of a level file.
+ *
+ * @param file a file returned from faf_level_file_open()
+ * @return the header, with the level type, track length and counts
+ */
+const faf_level_file_header_t *faf_level_file_get_header(faf_level_file_t *file);
+
+/**
+ * Returns the terrain tiles of one chunk of a level file.
+ *
+ * @param file a file returned from faf_level_file_open()
+ * @param chunk the index of the chunk; must be less than the header's num_chunks
+ * @param num_tiles where to write the number of tiles
+ * @return the chunk's tiles, inside the file
+ */
+const faf_tile_record_t *faf_level_file_get_tiles(faf_level_file_t *file, size_t chunk, size_t *num_tiles);
+
+/**
+ * Returns the objects of one chunk of a level file.
+ *
+ * @param file a file returned from faf_level_file_open()
+ * @param chunk the index of the chunk; must be less than the header's num_chunks
+ * @param num_objects where to write the number of objects
+ * @return the chunk's objects, inside the file
+ */
+const faf_object_record_t *faf_level_file_get_objects(faf_level_file_t *file, size_t chunk,
+                                                      size_t *num_objects);
+
+/**
+ * Writes a level file.
+ *
+ * @param path the path of the file to write
+ * @param header the header to write; its magic and version are filled in
+ * @param chunks the header's num_chunks chunk records
+ * @param tiles the header's num_tiles tile records
+ * @param objects the header's num_objects object records
+ * @return whether the whole file was written
+ */
+bool faf_level_file_write(const char *path, faf_level_file_header_t header, const faf_chunk_record_t *chunks,
+                          const faf_tile_record_t *tiles, const faf_object_record_t *objects);
+
+#endif // #ifndef __FAF_LEVEL_FILE_H__
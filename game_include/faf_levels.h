@@ -1,6 +1,8 @@
 #ifndef __FAF_LEVELS_H__
 #define __FAF_LEVELS_H__
 
+#include <stdbool.h>
+#include <stdint.h>
 #include "scene.h"
 
 // Scene layer definitions
@@ -10,6 +12,9 @@ extern const size_t FAF_FOREGROUND_LAYER;
 extern const size_t FAF_OBJECT_LAYER;
 extern const size_t FAF_CAR_LAYER;
 
+// The length of each piece of track that is generated and removed as a unit
+extern const double FAF_CHUNK_LENGTH;
+
 // Different levels in the game
 typedef enum {
     DESERT_LEVEL = 0,
@@ -18,7 +23,7 @@ typedef enum {
 } faf_level_t;
 
 /**
- * Returns the dimensions of the scene.
+ * Returns the dimensions of the scene for a standard-length track.
  * 
  * @return a vector of the scene dimensions
  */
@@ -31,14 +36,64 @@ vector_t faf_get_scene_dimensions();
  */
 double faf_get_road_width();
 
+/**
+ * Returns where a car starts a race. Up to a row's worth of cars start side by side,
+ * spread evenly across the road; larger grids fill rows back from the start line,
+ * so the first car in the list always starts on the left of the front row, and
+ * every car starts well short of the track's first objects. The track lays road
+ * behind its start for rows that don't fit in front of it.
+ *
+ * @param index the car's position in the list of cars
+ * @param num_cars the number of cars in the race
+ * @return the car's starting centroid
+ */
+vector_t faf_get_grid_position(size_t index, size_t num_cars);
+
 /**
  * Creates and returns the scene for a level with player and AI cars.
+ * The track is made in chunks of FAF_CHUNK_LENGTH while the race goes on:
+ * each tick, chunks are generated a few screens ahead of the lead car
+ * and removed once every car has passed them, so a track of any length
+ * takes the same time to start and about the same memory.
+ * A chunk's contents depend only on the seed and the chunk's position:
+ * each chunk draws from its own stream of the seed (see rng_init_stream()).
+ * Each car tests itself against a grid of the bodies of the chunks it reaches,
+ * so the cost of collisions grows with the number of cars, not cars times bodies.
  * 
  * @param type the type of level to create
- * @param cars the list of cars in the level
- * @param ai_colliders the list of AI colliders in the level
- * @return the scene for the level
+ * @param seed the seed the track's contents are generated from
+ * @param track_length the length of the track, with the finish line at its end,
+ *   or INFINITY for an endless track
+ * @param cars the list of cars in the level, which decide which chunks exist
+ *   and are told where the finish line is (see faf_car_get_finish_y())
+ * @return the scene for the level, with a lane grid the AI cars plan with (see faf_lanes.h)
+ */
+scene_t *faf_make_level(faf_level_t type, uint64_t seed, double track_length, list_t *cars);
+
+/**
+ * Creates and returns the scene for a level stored in a level file
+ * (see faf_level_file.h), like faf_make_level() but with every chunk
+ * built from the file's records instead of generated. The file stays
+ * open, and mapped where the platform allows it, until the scene is freed.
+ *
+ * @param path the path of a file written by faf_save_level()
+ * @param type the type of level the file must hold
+ * @param cars the list of cars in the level, which decide which chunks exist
+ * @return the scene for the level, or NULL if the file can't be opened
+ *   or holds another type of level
+ */
+scene_t *faf_make_level_from_file(const char *path, faf_level_t type, list_t *cars);
+
+/**
+ * Generates every chunk of a level and writes them to a level file,
+ * so faf_make_level_from_file() builds the same track as faf_make_level().
+ *
+ * @param path the path of the file to write
+ * @param type the type of level
+ * @param seed the seed the track's contents are generated from
+ * @param track_length the length of the track; must be finite
+ * @return whether the file was written
  */
-scene_t *faf_make_level(faf_level_t type, list_t *cars, list_t *ai_colliders);
+bool faf_save_level(const char *path, faf_level_t type, uint64_t seed, double track_length);
 
 #endif // #ifndef __FAF_LEVELS_H__
\ No newline at end of file
@@ -8,8 +8,25 @@
 
 extern const vector_t FAF_WINDOW_DIMENSIONS;
 
+/**
+ * Opens the game's window on the loading screen and starts loading
+ * every asset in the background (see assets_preload()), from the
+ * asset archive if it has been built.
+ *
+ * @return the game's window
+ */
 window_t *faf_game_start();
 
+/**
+ * Finishes some of the assets being loaded and updates the loading screen's
+ * progress bar. Call once a frame after faf_game_start() until it returns true;
+ * once everything is loaded, it starts the audio and opens the main menu.
+ *
+ * @param window the window returned from faf_game_start()
+ * @return whether loading has finished
+ */
+bool faf_game_load_step(window_t *window);
+
 hud_t *faf_make_leaderboard_hud();
 
 /**
@@ -24,4 +41,17 @@ int faf_get_difficulty();
  */
 void faf_set_difficulty(int difficulty);
 
+/**
+ * Get the number of cars in each race, the player's included.
+ * @return the number of cars; 6 unless it has been set
+ */
+size_t faf_get_num_cars();
+
+/**
+ * Set the number of cars in each race, the player's included, from the next race on.
+ * Grids larger than a row start in several rows (see faf_get_grid_position()).
+ * @param num_cars the number of cars; at least 1
+ */
+void faf_set_num_cars(size_t num_cars);
+
 #endif // #ifndef __FAF_MENU_H__
\ No newline at end of file
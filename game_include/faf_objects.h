@@ -1,6 +1,10 @@
 #ifndef __FAF_OBJECT_H__
 #define __FAF_OBJECT_H__
 
+#include <stdbool.h>
+#include <stdint.h>
+#include "dynarray.h"
+#include "rng.h"
 #include "scene.h"
 #include "vector.h"
 
@@ -35,64 +39,134 @@ typedef struct faf_object_info faf_object_info_t;
  */
 faf_effect_t faf_objects_get_effect_type(faf_object_info_t *info);
 
+/**
+ * Where one object of a level goes and what it is, as stored in a level file
+ * (see faf_level_file.h). Fields are fixed-size so the layout never changes.
+ */
+typedef struct faf_object_record {
+    float x;
+    float y;
+    // A faf_object_t
+    uint8_t object_type;
+    // A faf_effect_t
+    uint8_t effect_type;
+    // Which of the object type's sprites to draw it with
+    uint8_t sprite;
+    uint8_t padding;
+} faf_object_record_t;
+
+DYNARRAY_DEFINE(faf_object_records, faf_object_record_t, 16)
+
+/**
+ * Checks that a record describes an object that can be placed: a decoration,
+ * effect, gas can or obstacle at a finite position, with one of its type's
+ * sprites, and with an effect only if it is an effect.
+ *
+ * @param record the record, e.g. read from a level file
+ * @return whether faf_object_init() can create the object
+ */
+bool faf_object_record_is_valid(const faf_object_record_t *record);
+
+/**
+ * Creates the body for an object of a level. The body is not added to a scene.
+ * Asserts that the record is valid (see faf_object_record_is_valid()).
+ *
+ * @param record the object's position, type, effect and sprite
+ * @return the object's body
+ */
+body_t *faf_object_init(const faf_object_record_t *record);
+
+/**
+ * Where objects have been placed in a region of a level, e.g. one chunk of track,
+ * binned into a grid so a new object can be kept clear of the others without
+ * checking every one of them. Objects stay inside the region.
+ * An object that finds no free position after a few tries is left out.
+ */
+typedef struct faf_placement faf_placement_t;
+
+/**
+ * Allocates an empty placement grid covering a region of a scene.
+ * The region spans the scene's full width, with the road in its middle.
+ *
+ * @param origin the bottom left corner of the region
+ * @param dim the dimensions of the region
+ * @return a pointer to the new placement grid
+ */
+faf_placement_t *faf_placement_init(vector_t origin, vector_t dim);
+
+/**
+ * Frees a placement grid. The objects placed with it are not affected.
+ *
+ * @param placement the placement grid to free
+ */
+void faf_placement_free(faf_placement_t *placement);
+
 /**
  * A function called to generate a position.
  * 
- * @param scene_dim the dimensions of the scene
+ * @param rng the random stream to draw from
+ * @param origin the bottom left corner of the region to spawn in
+ * @param dim the dimensions of the region
  * @param road_width the width of the road in the scene
  * @param object_radius the object's radius
- * @return a vector of where to spawn the object
+ * @param position where to write where to spawn the object
+ * @return false if the object can't fit anywhere in the region
  */
-typedef vector_t position_generator_t(vector_t scene_dim, double road_width, double object_radius);
+typedef bool position_generator_t(rng_t *rng, vector_t origin, vector_t dim, double road_width,
+                                  double object_radius, vector_t *position);
 
 /**
- * Spawns decorations into a level on the side of the road.
+ * Places decorations on the side of the road.
  * 
- * @param scene the scene to spawn the decorations in
- * @param scene_dim the dimensions of the scene
- * @param collision_bodies the list of collision bodies to add to
+ * @param placement the region to spawn in and the objects placed there so far,
+ *   which the new ones are added to
+ * @param objects the records to add the new objects to
+ * @param rng the random stream that picks positions and sprites
  * @param road_width the width of the road in the scene
  * @param num_decorations the number of decorations to spawn
  * @param level the level for the decorations
  */
-void faf_object_spawn_decorations(scene_t *scene, vector_t scene_dim, list_t *collision_bodies,
+void faf_object_spawn_decorations(faf_placement_t *placement, faf_object_records_t *objects, rng_t *rng,
                                   double road_width, size_t num_decorations, faf_level_t level);
 
 /**
- * Spawns effects into a level.
+ * Places effects on the road.
  * 
- * @param scene the scene to spawn the effects in
- * @param scene_dim the dimensions of the scene
- * @param collision_bodies the list of collision bodies to add to
+ * @param placement the region to spawn in and the objects placed there so far,
+ *   which the new ones are added to
+ * @param objects the records to add the new objects to
+ * @param rng the random stream that picks positions and sprites
  * @param road_width the width of the road in the scene
  * @param num_effects the number of effects to spawn
  */
-void faf_object_spawn_effects(scene_t *scene, vector_t scene_dim, list_t *collision_bodies,
+void faf_object_spawn_effects(faf_placement_t *placement, faf_object_records_t *objects, rng_t *rng,
                               double road_width, size_t num_effects);
 
 /**
- * Spawns gas into a level.
+ * Places gas on the road.
  * 
- * @param scene the scene to spawn the gas in
- * @param scene_dim the dimensions of the scene
- * @param collision_bodies the list of collision bodies to add to
+ * @param placement the region to spawn in and the objects placed there so far,
+ *   which the new ones are added to
+ * @param objects the records to add the new objects to
+ * @param rng the random stream that picks positions and sprites
  * @param road_width the width of the road in the scene
  * @param num_gas the number of gas to spawn
  */
-void faf_object_spawn_gas(scene_t *scene, vector_t scene_dim, list_t *collision_bodies,
+void faf_object_spawn_gas(faf_placement_t *placement, faf_object_records_t *objects, rng_t *rng,
                           double road_width, size_t num_gas);
 
 /**
- * Spawns obstacles into a level.
+ * Places obstacles on the road.
  * 
- * @param scene the scene to spawn the obstacles in
- * @param scene_dim the dimensions of the scene
- * @param collision_bodies the list of collision bodies to add to
+ * @param placement the region to spawn in and the objects placed there so far,
+ *   which the new ones are added to
+ * @param objects the records to add the new objects to
+ * @param rng the random stream that picks positions and sprites
  * @param road_width the width of the road in the scene
  * @param num_obstacles the number of obstacles to spawn
  * @param level the level for the obstacles
  */
-void faf_object_spawn_obstacles(scene_t *scene, vector_t scene_dim, list_t *collision_bodies,
+void faf_object_spawn_obstacles(faf_placement_t *placement, faf_object_records_t *objects, rng_t *rng,
                                 double road_width, size_t num_obstacles, faf_level_t level);
 
 #endif // #ifndef __FAF_OBJECT_H__
\ No newline at end of file
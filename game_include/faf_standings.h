@@ -0,0 +1,88 @@
+#ifndef __FAF_STANDINGS_H__
+#define __FAF_STANDINGS_H__
+
+#include <stddef.h>
+#include "list.h"
+#include "scene.h"
+
+/**
+ * The order of the cars in a race, by how far along the track each has got.
+ *
+ * The order is kept from tick to tick and only fixed up where cars have
+ * passed each other, which is a handful of swaps a tick however many cars
+ * there are, so reading any car's place never scans the other cars.
+ */
+typedef struct faf_standings faf_standings_t;
+
+/**
+ * Allocates the standings of a race, in the order the cars are listed
+ * until they are first updated.
+ *
+ * @param cars the cars in the race; the list is copied, and the cars are
+ *   referred to by their index in it from then on
+ * @return the new standings
+ */
+faf_standings_t *faf_standings_init(list_t *cars);
+
+/**
+ * Frees the standings of a race. The cars are not affected.
+ *
+ * @param standings standings returned from faf_standings_init()
+ */
+void faf_standings_free(faf_standings_t *standings);
+
+/**
+ * Updates the standings every tick of a scene. The scene takes ownership
+ * of the standings and frees them with itself.
+ *
+ * @param scene the race's scene, with the cars in it
+ * @param standings standings returned from faf_standings_init()
+ */
+void faf_standings_add_to_scene(scene_t *scene, faf_standings_t *standings);
+
+/**
+ * Reorders the cars by where they are now. Cars that are level stay in their
+ * previous order, and cars that no longer exist keep their last position.
+ * Takes time proportional to the number of cars plus the number of overtakes
+ * since the last update.
+ *
+ * @param standings the standings
+ */
+void faf_standings_update(faf_standings_t *standings);
+
+/**
+ * Returns the number of cars in a race.
+ *
+ * @param standings the standings
+ * @return the size of the list given to faf_standings_init()
+ */
+size_t faf_standings_num_cars(faf_standings_t *standings);
+
+/**
+ * Returns a car's place in the race as of the last update.
+ *
+ * @param standings the standings
+ * @param car the car's index in the list given to faf_standings_init()
+ * @return the car's place, 1 for the leader
+ */
+size_t faf_standings_get_place(faf_standings_t *standings, size_t car);
+
+/**
+ * Returns the car in a given place as of the last update.
+ *
+ * @param standings the standings
+ * @param place the place, from 1 for the leader to the number of cars
+ * @return the car's index in the list given to faf_standings_init()
+ */
+size_t faf_standings_get_car(faf_standings_t *standings, size_t place);
+
+/**
+ * Returns the English suffix of a place, e.g. "st" for 1, 21 and 101,
+ * and "th" for 11.
+ *
+ * @param place the place
+ * @return the suffix, a string constant
+ */
+const char *faf_standings_place_suffix(size_t place);
+
+#endif // #ifndef __FAF_STANDINGS_H__
@@ -1,74 +1,262 @@
+#include "assets.h"
 #include "faf_audio.h"
 #include "mathlib.h"
+#include "spsc.h"
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_mixer.h>
 
-const int NUM_TRACKS = 1;
-const char *PLAYLIST[2] = {"assets/music/Countdown.wav"};
+// The mixer plays 512-sample buffers, about 12 ms at 44.1 kHz instead of 46 ms for 2048
+const int FAF_AUDIO_FREQUENCY = 44100;
+const int FAF_AUDIO_OUTPUT_CHANNELS = 2;
+const int FAF_AUDIO_BUFFER_SAMPLES = 512;
+// Mixer channels, each with its own gain
+#define FAF_AUDIO_NUM_CHANNELS 8
+#define FAF_AUDIO_QUEUE_CAPACITY 256
+
 const int LOOPS = 0;
 const int SONG_CHANNEL = 1;
 const int CAR_SOUND_CHANNEL = 2;
 const int ENVIRONMENT_SOUND_CHANNEL = 3;
 const int COUNTDOWN_CHANNEL = 4;
+const int CAR_SOUND_VOLUME = 50;
+
+// The engine note is a low sawtooth with a touch of its octave, pitched by speed
+const double FAF_ENGINE_IDLE_HZ = 45;
+const double FAF_ENGINE_MAX_HZ = 160;
+const double FAF_ENGINE_AMPLITUDE = 0.3;
+// How loud the engine is off the throttle, relative to on it
+const double FAF_ENGINE_IDLE_LOUDNESS = 0.5;
+// Fraction of the way to its target the engine's pitch and loudness move each sample,
+// so changes glide over a few milliseconds instead of clicking
+const double FAF_ENGINE_SMOOTHING = 0.002;
+// Engine speeds closer than this are the same note, so they aren't sent again
+const double FAF_ENGINE_SPEED_STEP = 1. / 256;
+
+typedef enum {
+    FAF_SOUND_COUNTDOWN,
+    FAF_SOUND_HONK,
+    FAF_NUM_SOUNDS
+} faf_sound_t;
+
+const char *FAF_SOUND_PATHS[FAF_NUM_SOUNDS] = {"assets/music/Countdown.wav", "assets/car/Honking.wav"};
+
+typedef enum {
+    FAF_AUDIO_SET_GAIN,
+    FAF_AUDIO_SET_ENGINE
+} faf_audio_command_type_t;
+
+// Sent from the game loop to the audio callback
+typedef struct faf_audio_command {
+    faf_audio_command_type_t type;
+    int channel;
+    // The gain in [0, 1], or the engine's speed as a fraction of top speed
+    float value;
+    bool throttle;
+} faf_audio_command_t;
+
 
-Mix_Chunk *music[1];
-Mix_Chunk *car_sound;
-Mix_Chunk *environment_sound;
+// Converted to the device's format once, when loaded
+Mix_Chunk *sound_bank[FAF_NUM_SOUNDS];
 bool countdown_played = false;
+spsc_t *audio_commands = NULL;
+
+// The game loop's copy of what it last sent, so repeated values aren't queued
+int sent_volumes[FAF_AUDIO_NUM_CHANNELS];
+double sent_engine_speed = -1;
+bool sent_engine_throttle = false;
+
+// Set before the callbacks are registered: the gains and the engine need 16-bit samples,
+// which the device may not have given us
+bool audio_is_s16 = false;
+int audio_frequency;
+int audio_channels;
+
+// Owned by the audio callback thread
+float channel_gains[FAF_AUDIO_NUM_CHANNELS];
+double engine_target_speed = 0;
+double engine_speed = 0;
+double engine_target_loudness = 0;
+double engine_loudness = 0;
+double engine_phase = 0;
+
+
+// Sounds are opened from the asset cache, which already holds the files in memory
+Mix_Chunk *faf_audio_load(const char *path) {
+    size_t size;
+    const void *data = assets_get_data(path, &size);
+    return data ? Mix_LoadWAV_RW(SDL_RWFromConstMem(data, (int)size), 1) : NULL;
+}
+
+
+// Runs on the audio thread, once per mixed buffer
+void faf_audio_apply_commands() {
+    faf_audio_command_t command;
+    while (spsc_pop(audio_commands, &command)) {
+        switch (command.type) {
+            case FAF_AUDIO_SET_GAIN:
+                channel_gains[command.channel] = command.value;
+                break;
+            case FAF_AUDIO_SET_ENGINE:
+                engine_target_speed = command.value;
+                engine_target_loudness = command.throttle ? 1 : FAF_ENGINE_IDLE_LOUDNESS;
+                break;
+        }
+    }
+}
+
+
+// Scales a channel's samples by its gain, before the mixer adds it to the others
+void faf_audio_gain_effect(int channel, void *stream, int length, void *aux) {
+    float gain = channel_gains[channel];
+    if (gain == 1) {
+        return;
+    }
+    Sint16 *samples = stream;
+    for (int i = 0; i < length / (int)sizeof(Sint16); i++) {
+        samples[i] = (Sint16)(samples[i] * gain);
+    }
+}
+
+
+// Adds the engine note to the mixed output
+void faf_audio_post_mix(void *aux, Uint8 *stream, int length) {
+    faf_audio_apply_commands();
+
+    Sint16 *samples = (Sint16 *)stream;
+    int num_frames = length / (int)sizeof(Sint16) / audio_channels;
+    double gain = channel_gains[CAR_SOUND_CHANNEL];
+    for (int i = 0; i < num_frames; i++) {
+        engine_speed += (engine_target_speed - engine_speed) * FAF_ENGINE_SMOOTHING;
+        engine_loudness += (gain * engine_target_loudness - engine_loudness) * FAF_ENGINE_SMOOTHING;
+        double hz = FAF_ENGINE_IDLE_HZ + (FAF_ENGINE_MAX_HZ - FAF_ENGINE_IDLE_HZ) * engine_speed;
+        engine_phase += hz / audio_frequency;
+        engine_phase -= floor(engine_phase);
+
+        double octave = 2 * engine_phase - floor(2 * engine_phase);
+        double wave = (2 * engine_phase - 1) + 0.5 * (2 * octave - 1);
+        double value = wave * engine_loudness * FAF_ENGINE_AMPLITUDE * INT16_MAX;
+        for (int c = 0; c < audio_channels; c++) {
+            Sint16 *sample = &samples[i * audio_channels + c];
+            *sample = (Sint16)mathlib_min(mathlib_max(*sample + value, INT16_MIN), INT16_MAX);
+        }
+    }
+}
+
+
+// Plays a sound on a channel through the channel's gain
+void faf_audio_play(int channel, Mix_Chunk *sound, int loops, int ticks) {
+    if (!sound) {
+        return;
+    }
+    // Whether or not the mixer kept the effect from the last sound, the channel ends up with one
+    Mix_UnregisterEffect(channel, faf_audio_gain_effect);
+    Mix_PlayChannelTimed(channel, sound, loops, ticks);
+    if (audio_is_s16) {
+        Mix_RegisterEffect(channel, faf_audio_gain_effect, NULL, NULL);
+    }
+}
+
 
 void faf_audio_init() {
     Mix_Init(MIX_INIT_FLAC | MIX_INIT_MID | MIX_INIT_MOD |
              MIX_INIT_MP3 | MIX_INIT_OGG);
-    Mix_OpenAudio(44100, AUDIO_S16SYS, 4, 2048);
-    Mix_Volume(SONG_CHANNEL, 50);
-    Mix_Volume(CAR_SOUND_CHANNEL, 25);
-    Mix_Volume(ENVIRONMENT_SOUND_CHANNEL, 15);
-    Mix_Volume(COUNTDOWN_CHANNEL, 100);
-    for (size_t i = 0; i < NUM_TRACKS; i++) {
-        music[i] = Mix_LoadWAV(PLAYLIST[i]);
-    }
-    car_sound = Mix_LoadWAV("assets/car/Acceleration.wav");
-    environment_sound = Mix_LoadWAV("assets/car/Honking.wav");
+    Mix_OpenAudio(FAF_AUDIO_FREQUENCY, AUDIO_S16SYS, FAF_AUDIO_OUTPUT_CHANNELS, FAF_AUDIO_BUFFER_SAMPLES);
+    Mix_AllocateChannels(FAF_AUDIO_NUM_CHANNELS);
+
+    Uint16 format = 0;
+    Mix_QuerySpec(&audio_frequency, &format, &audio_channels);
+    audio_is_s16 = format == AUDIO_S16SYS && audio_frequency > 0 && audio_channels > 0;
+
+    audio_commands = spsc_init(FAF_AUDIO_QUEUE_CAPACITY, sizeof(faf_audio_command_t));
+    for (int i = 0; i < FAF_AUDIO_NUM_CHANNELS; i++) {
+        channel_gains[i] = 1;
+        sent_volumes[i] = MIX_MAX_VOLUME;
+    }
+    // The engine is silent until a race starts
+    channel_gains[CAR_SOUND_CHANNEL] = 0;
+    sent_volumes[CAR_SOUND_CHANNEL] = 0;
+    faf_audio_set_volume(SONG_CHANNEL, 50);
+    faf_audio_set_volume(ENVIRONMENT_SOUND_CHANNEL, 15);
+    faf_audio_set_volume(COUNTDOWN_CHANNEL, 100);
+    if (audio_is_s16) {
+        Mix_SetPostMix(faf_audio_post_mix, NULL);
+    }
+
+    for (size_t i = 0; i < FAF_NUM_SOUNDS; i++) {
+        sound_bank[i] = faf_audio_load(FAF_SOUND_PATHS[i]);
+    }
 }
 
 void faf_audio_start_race() {
     if (!countdown_played) {
-        Mix_PlayChannel(COUNTDOWN_CHANNEL, music[0], LOOPS);
+        faf_audio_play(COUNTDOWN_CHANNEL, sound_bank[FAF_SOUND_COUNTDOWN], LOOPS, -1);
         countdown_played = true;
     }
-
-    if (!Mix_Playing(CAR_SOUND_CHANNEL)) {
-        Mix_Volume(CAR_SOUND_CHANNEL, 25);
-        // LOOPS - 1 means to loop audio indefinitely
-        Mix_PlayChannel(CAR_SOUND_CHANNEL, car_sound, LOOPS - 1);
-    }
+    faf_audio_set_volume(CAR_SOUND_CHANNEL, CAR_SOUND_VOLUME);
 }
 
 void faf_audio_end_race() {
-    Mix_Volume(CAR_SOUND_CHANNEL, 0);
+    faf_audio_set_volume(CAR_SOUND_CHANNEL, 0);
+    faf_audio_set_engine(0, false);
     countdown_played = false;
 }
 
 void faf_audio_play_music() {
     if (!Mix_Playing(SONG_CHANNEL) && !Mix_Playing(COUNTDOWN_CHANNEL)) {
-        int song_idx = mathlib_rand_in_range(1, NUM_TRACKS);
-		Mix_PlayChannel(SONG_CHANNEL, music[song_idx], LOOPS);
+        faf_audio_play(SONG_CHANNEL, sound_bank[FAF_SOUND_COUNTDOWN], LOOPS, -1);
     }
 }
 
 void faf_audio_honk() {
-    Mix_PlayChannelTimed(ENVIRONMENT_SOUND_CHANNEL, environment_sound, LOOPS, 3000);
+    faf_audio_play(ENVIRONMENT_SOUND_CHANNEL, sound_bank[FAF_SOUND_HONK], LOOPS, 3000);
 }
 
 void faf_audio_set_volume(int channel, int volume) {
-    Mix_Volume(channel, volume);
+    assert(channel >= 0 && channel < FAF_AUDIO_NUM_CHANNELS);
+    if (!audio_commands || volume == sent_volumes[channel]) {
+        return;
+    }
+    if (!audio_is_s16) {
+        // Nothing on the audio thread can apply the gain, so the mixer does
+        Mix_Volume(channel, volume);
+        sent_volumes[channel] = volume;
+        return;
+    }
+    faf_audio_command_t command = {.type = FAF_AUDIO_SET_GAIN, .channel = channel,
+                                   .value = (float)volume / MIX_MAX_VOLUME};
+    // If the queue is full, the change is sent again on the next call
+    if (spsc_push(audio_commands, &command)) {
+        sent_volumes[channel] = volume;
+    }
+}
+
+void faf_audio_set_engine(double speed, bool throttle) {
+    speed = mathlib_min(mathlib_max(speed, 0), 1);
+    if (!audio_commands || !audio_is_s16 ||
+        (fabs(speed - sent_engine_speed) < FAF_ENGINE_SPEED_STEP && throttle == sent_engine_throttle)) {
+        return;
+    }
+    faf_audio_command_t command = {.type = FAF_AUDIO_SET_ENGINE, .value = (float)speed, .throttle = throttle};
+    if (spsc_push(audio_commands, &command)) {
+        sent_engine_speed = speed;
+        sent_engine_throttle = throttle;
+    }
 }
 
 void faf_audio_free() {
-    for (size_t i = 0; i < NUM_TRACKS; i++) {
-        Mix_FreeChunk(music[i]);
+    if (!audio_commands) {
+        return;
+    }
+    // Stops the audio thread before anything it uses is freed
+    Mix_SetPostMix(NULL, NULL);
+    Mix_CloseAudio();
+    for (size_t i = 0; i < FAF_NUM_SOUNDS; i++) {
+        Mix_FreeChunk(sound_bank[i]);
     }
-    Mix_FreeChunk(car_sound);
-    Mix_FreeChunk(environment_sound);
+    spsc_free(audio_commands);
+    audio_commands = NULL;
     Mix_Quit();
 }
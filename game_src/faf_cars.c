@@ -2,6 +2,8 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include "alloc.h"
+#include "assets.h"
 #include "color.h"
 #include "faf_audio.h"
 #include "faf_cars.h"
@@ -10,17 +12,27 @@
 #include "faf_objects.h"
 #include "forces.h"
 #include "mathlib.h"
+#include "rng.h"
 #include "shape.h"
 
 
 // Properties of all cars
 const double FAF_CAR_DENSITY = 1;
 const rgb_color_t FAF_CAR_DEBUG_COLOR = {.r = 1, .g = 0, .b = 0};
-const size_t CAR_INIT_NUM_EFFECTS = 3;
 const double FAF_CAR_GRAV_CONST = 100;
 const double FAF_CAR_EFFECT_TIME = 5;
 const vector_t FAF_CAR_DIMENSIONS = {.x = 50, .y = 125};
 
+// How AI cars choose lanes at each difficulty: easy cars only dodge what is close,
+// medium cars also go for helpful effects, and hard cars look furthest and go for gas too
+const faf_lane_costs_t FAF_AI_LANE_COSTS[] = {
+    {.hazard = 1, .boost = 0, .gas = 0, .change = 0.3, .lookahead = 400},
+    {.hazard = 1, .boost = -0.5, .gas = 0, .change = 0.2, .lookahead = 600},
+    {.hazard = 1, .boost = -0.6, .gas = -0.4, .change = 0.15, .lookahead = 800}
+};
+// AI cars steer until they are this close to the middle of their lane
+const double FAF_AI_STEER_DEADBAND = 10;
+
 // Properties of FERRARI 488 GTE
 const double FERRARI_488_GTE_ACCEL_dS = 125;
 const double FERRARI_488_GTE_BRAKE_dS = -150;
@@ -104,11 +116,24 @@ typedef struct surface_info {
 } surface_info_t;
 
 
-typedef struct car_effect {
-    body_func_t f;
-    double total_time;
-    double time_elapsed;
-} car_effect_t;
+// What happens when a car gets an effect it already has
+typedef enum {
+    // The effect lasts for whichever is longer, what was left or the new time
+    CAR_EFFECT_REFRESH,
+    // The new time is added to what was left
+    CAR_EFFECT_EXTEND
+} car_effect_stacking_t;
+
+// Indexed by faf_effect_t: picking up more of a helpful effect makes it last longer,
+// while harmful ones only restart, so hazards can't pile up on a car
+const car_effect_stacking_t CAR_EFFECT_STACKING[FAF_NULL] = {
+    [FAF_SPEED] = CAR_EFFECT_EXTEND,
+    [FAF_STRENGTH] = CAR_EFFECT_EXTEND,
+    [FAF_GREEN_ENERGY] = CAR_EFFECT_EXTEND,
+    [FAF_SLOWDOWN] = CAR_EFFECT_REFRESH,
+    [FAF_GASLEAK] = CAR_EFFECT_REFRESH,
+    [FAF_LOSE_CONTROL] = CAR_EFFECT_REFRESH
+};
 
 
 typedef struct car_info {
@@ -140,15 +165,24 @@ typedef struct car_info {
     SDL_Surface *normal;
     SDL_Surface *accelerated;
 
-    list_t *effects;
+    // The time left on each effect, indexed by faf_effect_t; 0 if the car doesn't have it
+    double effect_times[FAF_NULL];
+    // Drives the AI's decisions, so every car makes its own reproducible choices
+    rng_t rng;
+    // The lane an AI car is heading for
+    size_t target_lane;
 
     window_t *window;
+    faf_lanes_t *lanes;
+    // Where the track's finish line is; INFINITY on an endless track
+    double finish_y;
 } faf_car_info_t;
 
 
-surface_info_t *faf_surface_init(double surf_coef) {
-    surface_info_t *info = malloc(sizeof(surface_info_t));
-    assert(info);
+surface_info_t *faf_surface_init(arena_t *arena, double surf_coef) {
+    assert(arena);
+
+    surface_info_t *info = arena_alloc(arena, sizeof(surface_info_t));
 
     info->type = FAF_SURFACE_OBJ;
     info->surf_coefficient = surf_coef;
@@ -160,12 +194,12 @@ surface_info_t *faf_surface_init(double surf_coef) {
 void free_car_info(faf_car_info_t *info) {
     assert(info);
 
-    free(info);
+    alloc_free(ALLOC_TAG_GAME, info);
 }
 
 
 faf_car_info_t *make_car_info(faf_car_t car_type, bool is_player_car, double start_time) {
-    faf_car_info_t *info = malloc(sizeof(faf_car_info_t));
+    faf_car_info_t *info = alloc_malloc(ALLOC_TAG_GAME, sizeof(faf_car_info_t));
     assert(info);
 
     info->car_type = car_type;
@@ -179,8 +213,14 @@ faf_car_info_t *make_car_info(faf_car_t car_type, bool is_player_car, double sta
     info->turning_left = false;
     info->time = start_time;
     info->dimensions = FAF_CAR_DIMENSIONS;
-    info->effects = list_init(CAR_INIT_NUM_EFFECTS, free);
+    for (size_t i = 0; i < FAF_NULL; i++) {
+        info->effect_times[i] = 0;
+    }
+    info->rng = rng_init_stream(0, car_type);
+    info->target_lane = SIZE_MAX;
     info->window = NULL;
+    info->lanes = NULL;
+    info->finish_y = INFINITY;
 
     switch (car_type) {
         case FERRARI_488_GTE: {
@@ -195,8 +235,8 @@ faf_car_info_t *make_car_info(faf_car_t car_type, bool is_player_car, double sta
             info->gas_milage = FERRARI_488_GTE_GAS_MILAGE;
             info->default_gas_milage = FERRARI_488_GTE_GAS_MILAGE;
             info->filename = FERRARI_488_GTE_FILENAME;
-            info->accelerated = IMG_Load(FERRARI_488_GTE_FILENAME_FLAMES);
-            info->normal = IMG_Load(FERRARI_488_GTE_FILENAME);
+            info->accelerated = assets_get_surface(FERRARI_488_GTE_FILENAME_FLAMES);
+            info->normal = assets_get_surface(FERRARI_488_GTE_FILENAME);
             return info;
         }
         case PORSCHE_911: {
@@ -211,8 +251,8 @@ faf_car_info_t *make_car_info(faf_car_t car_type, bool is_player_car, double sta
             info->gas_milage = PORSCHE_911_GAS_MILAGE;
             info->default_gas_milage = PORSCHE_911_GAS_MILAGE;
             info->filename = PORSCHE_911_FILENAME;
-            info->accelerated = IMG_Load(PORSCHE_911_FILENAME_FLAMES);
-            info->normal = IMG_Load(PORSCHE_911_FILENAME);
+            info->accelerated = assets_get_surface(PORSCHE_911_FILENAME_FLAMES);
+            info->normal = assets_get_surface(PORSCHE_911_FILENAME);
             return info;
         }
         case BUGATTI_CHIRON: {
@@ -227,8 +267,8 @@ faf_car_info_t *make_car_info(faf_car_t car_type, bool is_player_car, double sta
             info->gas_milage = BUGATTI_CHIRON_GAS_MILAGE;
             info->default_gas_milage = BUGATTI_CHIRON_GAS_MILAGE;
             info->filename = BUGATTI_CHIRON_FILENAME;
-            info->accelerated = IMG_Load(BUGATTI_CHIRON_FILENAME_FLAMES);
-            info->normal = IMG_Load(BUGATTI_CHIRON_FILENAME);
+            info->accelerated = assets_get_surface(BUGATTI_CHIRON_FILENAME_FLAMES);
+            info->normal = assets_get_surface(BUGATTI_CHIRON_FILENAME);
             return info;
         }
         case MERCEDES_SLS_AMG: {
@@ -243,8 +283,8 @@ faf_car_info_t *make_car_info(faf_car_t car_type, bool is_player_car, double sta
             info->gas_milage = MERCEDES_SLS_AMG_GAS_MILAGE;
             info->default_gas_milage = MERCEDES_SLS_AMG_GAS_MILAGE;
             info->filename = MERCEDES_SLS_AMG_FILENAME;
-            info->accelerated = IMG_Load(MERCEDES_SLS_AMG_FILENAME_FLAMES);
-            info->normal = IMG_Load(MERCEDES_SLS_AMG_FILENAME);
+            info->accelerated = assets_get_surface(MERCEDES_SLS_AMG_FILENAME_FLAMES);
+            info->normal = assets_get_surface(MERCEDES_SLS_AMG_FILENAME);
             return info;
         }
         case BMW_I8: {
@@ -259,8 +299,8 @@ faf_car_info_t *make_car_info(faf_car_t car_type, bool is_player_car, double sta
             info->gas_milage = BMW_I8_GAS_MILAGE;
             info->default_gas_milage = BMW_I8_GAS_MILAGE;
             info->filename = BMW_I8_FILENAME;
-            info->accelerated = IMG_Load(BMW_I8_FILENAME_FLAMES);
-            info->normal = IMG_Load(BMW_I8_FILENAME);
+            info->accelerated = assets_get_surface(BMW_I8_FILENAME_FLAMES);
+            info->normal = assets_get_surface(BMW_I8_FILENAME);
             return info;
         }
         case LAMBORGHINI_HURACAN_EVO_SPYDER: {
@@ -275,8 +315,8 @@ faf_car_info_t *make_car_info(faf_car_t car_type, bool is_player_car, double sta
             info->gas_milage = LAMBORGHINI_HURACAN_EVO_SPYDER_GAS_MILAGE;
             info->default_gas_milage = LAMBORGHINI_HURACAN_EVO_SPYDER_GAS_MILAGE;
             info->filename = LAMBORGHINI_HURACAN_EVO_SPYDER_FILENAME;
-            info->accelerated = IMG_Load(LAMBORGHINI_HURACAN_EVO_SPYDER_FILENAME_FLAMES);
-            info->normal = IMG_Load(LAMBORGHINI_HURACAN_EVO_SPYDER_FILENAME);
+            info->accelerated = assets_get_surface(LAMBORGHINI_HURACAN_EVO_SPYDER_FILENAME_FLAMES);
+            info->normal = assets_get_surface(LAMBORGHINI_HURACAN_EVO_SPYDER_FILENAME);
             return info;
         }
         case ASTON_MARTON_VANQUISH: {
@@ -291,8 +331,8 @@ faf_car_info_t *make_car_info(faf_car_t car_type, bool is_player_car, double sta
             info->gas_milage = ASTON_MARTON_VANQUISH_GAS_MILAGE;
             info->default_gas_milage = ASTON_MARTON_VANQUISH_GAS_MILAGE;
             info->filename = ASTON_MARTON_VANQUISH_FILENAME;
-            info->accelerated = IMG_Load(ASTON_MARTON_VANQUISH_FILENAME_FLAMES);
-            info->normal = IMG_Load(ASTON_MARTON_VANQUISH_FILENAME);
+            info->accelerated = assets_get_surface(ASTON_MARTON_VANQUISH_FILENAME_FLAMES);
+            info->normal = assets_get_surface(ASTON_MARTON_VANQUISH_FILENAME);
             return info;
         }
         default: {
@@ -328,103 +368,6 @@ void faf_car_on_key(char key, key_event_type_t type, double held_time, body_t *c
 }
 
 
-void car_speed(body_t* car, void *dt) {
-    faf_car_info_t *car_info = body_get_info(car);
-    car_info->top_speed *= car_info->speed_boost;
-}
-
-
-void car_strength(body_t* car, void *dt) {
-    faf_car_info_t *car_info = body_get_info(car);
-    car_info->strength_enabled = true;
-}
-
-
-void car_green_energy(body_t* car, void *dt) {
-    faf_car_info_t *car_info = body_get_info(car);
-    car_info->gas_milage = 0;
-}
-
-
-void car_slowdown(body_t* car, void *dt) {
-    faf_car_info_t *car_info = body_get_info(car);
-    car_info->top_speed /= 2;
-}
-
-
-void car_gasleak(body_t* car, void *dt) {
-    faf_car_info_t *car_info = body_get_info(car);
-    car_info->gas_milage *= 2;
-}
-
-
-void car_lose_control(body_t* car, void *dt) {
-    faf_car_info_t *car_info = body_get_info(car);
-    car_info->control_enabled = false;
-}
-
-
-void car_turn_right(body_t *ai_car, void *dt) {
-    vector_t v = body_get_velocity(ai_car);
-    faf_car_info_t *info = (faf_car_info_t *)body_get_info(ai_car);
-
-    if (info->control_enabled) {
-        if (!info->turning_right) {
-            body_set_rotation(ai_car, -M_PI / 12);
-            // How much turning should depend on vertical velocity
-            v.x += info->turn_sensitivity * fabs(v.y);
-            body_set_velocity(ai_car, v);
-        }
-        info->turning_right = true;  
-    } 
-}
-
-
-void car_turn_left(body_t *ai_car, void *dt) {
-    vector_t v = body_get_velocity(ai_car);
-    faf_car_info_t *info = (faf_car_info_t *)body_get_info(ai_car);
-
-    if (info->control_enabled) {
-        if (!info->turning_left) {
-            body_set_rotation(ai_car, M_PI / 12);
-            // How much turning should depend on vertical velocity
-            v.x -= info->turn_sensitivity * fabs(v.y);
-            body_set_velocity(ai_car, v);
-        }
-        info->turning_left = true;
-    }
-}
-
-
-void faf_ai_collider_tick(body_t *ai_collider, void *dt) {
-    assert(ai_collider);
-
-    body_t *ai_car = body_get_info(ai_collider);
-    double displacement = 2.5;
-    if (faf_get_difficulty() == 2) {
-        displacement = 1.5;
-    }
-    else if (faf_get_difficulty() == 3) {
-        displacement = 1.1;
-    }
-    
-    vector_t centroid = {
-        .x = body_get_centroid(ai_car).x,
-        .y = body_get_centroid(ai_car).y + (displacement * body_get_dimensions(ai_car).y)
-    };
-    body_set_centroid(ai_collider, centroid);
-}
-
-
-body_t *faf_make_ai_car_collider(body_t *ai_car) {
-    assert(ai_car);
-
-    body_t *body = shape_init_ai_collider(ai_car);
-    body_register_tick_func(body, (body_func_t)faf_ai_collider_tick);
-    return body;
-}
-
-
 void faf_indicator_tick(body_t *indicator, void *dt) {
     assert(indicator);
 
@@ -460,16 +403,29 @@ body_t *faf_make_player_indicator(body_t *player_car) {
 }
 
 
-void faf_car_add_effect(body_t *car, body_func_t f, double total_time) {
+void faf_car_add_effect(body_t *car, faf_effect_t effect, double time) {
     assert(car);
+    assert(effect < FAF_NULL);
+    faf_car_info_t *info = body_get_info(car);
+    assert(info);
 
-    car_effect_t *effect = malloc(sizeof(car_effect_t));
-    effect->f = f;
-    effect->total_time = total_time;
-    effect->time_elapsed = 0.;
+    double *left = &info->effect_times[effect];
+    *left = CAR_EFFECT_STACKING[effect] == CAR_EFFECT_EXTEND ? *left + time : mathlib_max(*left, time);
+}
 
-    faf_car_info_t *info = body_get_info(car);
-    list_add(info->effects, effect);
+
+// Counts down every effect and applies the ones still going. faf_car_tick() resets
+// what they change at the end of each tick, so they're applied again every tick.
+void faf_car_apply_effects(faf_car_info_t *info, double dt) {
+    double *times = info->effect_times;
+    for (size_t i = 0; i < FAF_NULL; i++) {
+        times[i] = mathlib_max(times[i] - dt, 0);
+    }
+
+    info->top_speed *= (times[FAF_SPEED] > 0 ? info->speed_boost : 1) * (times[FAF_SLOWDOWN] > 0 ? 0.5 : 1);
+    info->gas_milage *= (times[FAF_GREEN_ENERGY] > 0 ? 0 : 1) * (times[FAF_GASLEAK] > 0 ? 2 : 1);
+    info->strength_enabled = info->strength_enabled || times[FAF_STRENGTH] > 0;
+    info->control_enabled = info->control_enabled && !(times[FAF_LOSE_CONTROL] > 0);
 }
 
 
@@ -500,13 +456,15 @@ void faf_car_tick_AI(body_t *ai_car, void *dt) {
         info->braking = true;
     }
 
-    // Make sure the AI car doesn't go off the road
-    double x_pos = body_get_centroid(ai_car).x;
-    if (x_pos > (faf_get_scene_dimensions().x - faf_get_road_width()) / 3.5 + faf_get_road_width()) {
-        faf_car_add_effect(ai_car, (body_func_t)car_turn_left, 1.2);
-    }
-    if (x_pos < (faf_get_scene_dimensions().x - faf_get_road_width()) / 3.5) {
-        faf_car_add_effect(ai_car, (body_func_t)car_turn_right, 1.2);
+    // Head for the best lane ahead; every lane is on the road, so this also keeps the car on it
+    if (info->lanes) {
+        int difficulty = (int)mathlib_min(mathlib_max(faf_get_difficulty(), 1), 3);
+        vector_t centroid = body_get_centroid(ai_car);
+        info->target_lane = faf_lanes_plan(info->lanes, centroid, info->target_lane, info->turn_sensitivity,
+                                           &FAF_AI_LANE_COSTS[difficulty - 1], &info->rng);
+        double offset = faf_lanes_center(info->lanes, info->target_lane) - centroid.x;
+        info->turning_right = offset > FAF_AI_STEER_DEADBAND;
+        info->turning_left = offset < -FAF_AI_STEER_DEADBAND;
     }
 }
 
@@ -535,16 +493,14 @@ void faf_car_tick(body_t *car, void *dt) {
 
     body_set_rotation(car, 0);
     if (info->is_player_car) {
-        faf_audio_set_volume(CAR_SOUND_CHANNEL, 25);
+        faf_audio_set_engine(vec_magnitude(v) / info->default_top_speed, info->accelerating);
     }
 
     if (info->accelerating) {
         vector_t force = {.x = 0, .y = info->accel_dS * body_get_mass(car)};
         body_add_force(car, force);
-        // Increase car engine volume when accelerating
         if (info->is_player_car) {
             body_set_surface(car, info->accelerated);
-            faf_audio_set_volume(CAR_SOUND_CHANNEL, 50);
             // Accelerating drains the gas twice as quickly
             info->gas_curr -= info->gas_milage * *((double *)dt);
         }
@@ -560,18 +516,16 @@ void faf_car_tick(body_t *car, void *dt) {
 
     if (info->control_enabled) {
         v.x = 0;
-        if (info->is_player_car) {
-            if (info->turning_right) {
-                body_set_rotation(car, -M_PI / 12);
-                // How much turning should depend on vertical velocity
-                v.x += info->turn_sensitivity * fabs(v.y);
-            }
+        if (info->turning_right) {
+            body_set_rotation(car, -M_PI / 12);
+            // How much turning should depend on vertical velocity
+            v.x += info->turn_sensitivity * fabs(v.y);
+        }
 
-            if (info->turning_left) {
-                body_set_rotation(car, M_PI / 12);
-                // How much turning should depend on vertical velocity
-                v.x -= info->turn_sensitivity * fabs(v.y);
-            }
+        if (info->turning_left) {
+            body_set_rotation(car, M_PI / 12);
+            // How much turning should depend on vertical velocity
+            v.x -= info->turn_sensitivity * fabs(v.y);
         }
     }
 
@@ -621,19 +575,7 @@ void faf_car_register_tick(body_t *car, void *dt) {
     assert(info);
 
     faf_car_tick(car, dt);
-
-    size_t e_idx = 0;
-    while (e_idx < list_size(info->effects)) {
-        car_effect_t *effect = list_get(info->effects, e_idx);
-        effect->time_elapsed += *((double *)dt);
-        if (effect->time_elapsed < effect->total_time) {
-            effect->f(car, dt);
-            e_idx++;
-        }
-        else {
-            list_remove(info->effects, e_idx);
-        }
-    }
+    faf_car_apply_effects(info, *(double *)dt);
 }
 
 
@@ -668,90 +610,12 @@ double faf_car_get_max_gas(body_t *car) {
 }
 
 
-void faf_ai_car_avoid(body_t *ai_car, body_t *other) {
-    double random_chance = mathlib_rand_in_range(0, 1);
-    double hit_rate = 1.0;
-    if (faf_get_difficulty() == 1) {
-        hit_rate = 0.95;
-    }
-    if (random_chance <= hit_rate) {
-        if (body_get_centroid(ai_car).x < body_get_centroid(other).x) {
-            faf_car_add_effect(ai_car, (body_func_t)car_turn_left, 0.65);
-        }
-        else {
-            faf_car_add_effect(ai_car, (body_func_t)car_turn_right, 0.65);
-        }
-    }
-}
-
-
-void faf_ai_car_seek(body_t *ai_car, body_t *other) {
-    double random_chance = mathlib_rand_in_range(0, 1);
-    double hit_rate = 1.0;
-    if (faf_get_difficulty() == 1) {
-        hit_rate = 0.85;
-    }
-    if (random_chance <= hit_rate) {
-        if (body_get_centroid(ai_car).x > body_get_centroid(other).x) {
-            faf_car_add_effect(ai_car, (body_func_t)car_turn_left, 0.65);
-        }
-        else {
-            faf_car_add_effect(ai_car, (body_func_t)car_turn_right, 0.65);
-        }
-    }
-}
-
-
-void faf_ai_collider_on_hit(body_t *ai_collider, body_t *other, vector_t axis, void *aux) {
-    assert(ai_collider);
-    faf_car_info_t *car_info = body_get_info(body_get_info(ai_collider));
-    assert(car_info->obj_type == FAF_CAR_OBJ);
-    assert(other);
-    faf_object_t *other_info = body_get_info(other);
-    assert(other_info);
-    assert(car_info);
-    assert(!car_info->is_player_car);
-    body_t *ai_car = body_get_info(ai_collider);
-
-    switch (*other_info) {
-        case FAF_CAR_OBJ:
-        case FAF_OBSTACLE_OBJ: {
-            faf_ai_car_avoid(ai_car, other);
-            break;
-        }
-        case FAF_GAS_OBJ: {
-            if (faf_get_difficulty() == 3) {
-                faf_ai_car_seek(ai_car, other);
-            }
-            break;
-        }
-        case FAF_EFFECT_OBJ: {
-            faf_object_info_t *object_info = (faf_object_info_t *)other_info;
-            faf_effect_t effect = faf_objects_get_effect_type(object_info);
-            switch (effect) {
-                case FAF_SPEED:
-                case FAF_STRENGTH:
-                case FAF_GREEN_ENERGY: {
-                    if (faf_get_difficulty() != 1) {
-                        faf_ai_car_seek(ai_car, other);
-                    }
-                    break;
-                }
-                case FAF_SLOWDOWN:
-                case FAF_GASLEAK:
-                case FAF_LOSE_CONTROL: {
-                    faf_ai_car_avoid(ai_car, other);
-                    break;
-                }
-                default: {
-                    break;
-                }
-            }
-        }
-        default: {
-            return;
-        }
+// Removes an object a car hit, counting it out of the lane grid first
+void faf_car_take_object(faf_car_info_t *car_info, body_t *object) {
+    if (car_info->lanes) {
+        faf_lanes_remove(car_info->lanes, object);
     }
+    body_remove(object);
 }
 
 
@@ -776,13 +640,13 @@ void faf_car_on_hit(body_t *car, body_t *other, vector_t axis, void *aux) {
             }
             if (car_info->strength_enabled) {
                 body_add_impulse(other, vec_multiply(-5, impulse));
-                faf_car_add_effect(other, (body_func_t)car_lose_control, 0.25);
+                faf_car_add_effect(other, FAF_LOSE_CONTROL, 0.25);
             }
             else {
                 body_add_impulse(car, impulse);
                 body_add_impulse(other, vec_negate(impulse));
-                faf_car_add_effect(car, (body_func_t)car_lose_control, 0.25);
-                faf_car_add_effect(other, (body_func_t)car_lose_control, 0.25);
+                faf_car_add_effect(car, FAF_LOSE_CONTROL, 0.25);
+                faf_car_add_effect(other, FAF_LOSE_CONTROL, 0.25);
             }
             break;
         }
@@ -790,52 +654,26 @@ void faf_car_on_hit(body_t *car, body_t *other, vector_t axis, void *aux) {
             if (!car_info->strength_enabled) {
                 body_set_velocity(car, VEC_ZERO);
             }
-            body_remove(other);
+            faf_car_take_object(car_info, other);
             break;
         }
         case FAF_EFFECT_OBJ: {
             faf_object_info_t *object_info = (faf_object_info_t *)other_info;
             faf_effect_t effect = faf_objects_get_effect_type(object_info);
-            switch (effect) {
-                case FAF_SPEED: {
-                    faf_car_add_effect(car, (body_func_t)car_speed, FAF_CAR_EFFECT_TIME);
-                    break;
-                }
-                case FAF_STRENGTH: {
-                    faf_car_add_effect(car, (body_func_t)car_strength, FAF_CAR_EFFECT_TIME);
-                    break;
-                }
-                case FAF_GREEN_ENERGY: {
-                    faf_car_add_effect(car, (body_func_t)car_green_energy, FAF_CAR_EFFECT_TIME);
-                    break;
-                }
-                case FAF_SLOWDOWN: {
-                    faf_car_add_effect(car, (body_func_t)car_slowdown, FAF_CAR_EFFECT_TIME);
-                    break;
-                }
-                case FAF_GASLEAK: {
-                    faf_car_add_effect(car, (body_func_t)car_gasleak, FAF_CAR_EFFECT_TIME);
-                    break;
-                }
-                case FAF_LOSE_CONTROL: {
-                    faf_car_add_effect(car, (body_func_t)car_lose_control, FAF_CAR_EFFECT_TIME);
-                    break;
-                }
-                default: {
-                    break;
-                }
+            if (effect != FAF_NULL) {
+                faf_car_add_effect(car, effect, FAF_CAR_EFFECT_TIME);
             }
-            body_remove(other);
+            faf_car_take_object(car_info, other);
             break;
         }
         case FAF_GAS_OBJ: {
-            body_remove(other);
+            faf_car_take_object(car_info, other);
             double gas_boost = car_info->gas_max / 3.;
             car_info->gas_curr = mathlib_min(car_info->gas_curr + gas_boost, car_info->gas_max);
             break;
         }
         case FAF_DECORATION_OBJ: {
-            body_remove(other);
+            faf_car_take_object(car_info, other);
             break;
         }
         default: {
@@ -854,6 +692,33 @@ void faf_car_set_window(body_t *car, window_t *window) {
 }
 
 
+void faf_car_set_lanes(body_t *car, faf_lanes_t *lanes) {
+    assert(car);
+    faf_car_info_t *info = body_get_info(car);
+    assert(info);
+
+    info->lanes = lanes;
+}
+
+
+void faf_car_set_finish_y(body_t *car, double finish_y) {
+    assert(car);
+    faf_car_info_t *info = body_get_info(car);
+    assert(info);
+
+    info->finish_y = finish_y;
+}
+
+
+void faf_car_set_rng(body_t *car, rng_t rng) {
+    assert(car);
+    faf_car_info_t *info = body_get_info(car);
+    assert(info);
+
+    info->rng = rng;
+}
+
+
 window_t *faf_car_get_window(body_t *car) {
     assert(car);
     faf_car_info_t *info = body_get_info(car);
@@ -863,6 +728,15 @@ window_t *faf_car_get_window(body_t *car) {
 }
 
 
+double faf_car_get_finish_y(body_t *car) {
+    assert(car);
+    faf_car_info_t *info = body_get_info(car);
+    assert(info);
+
+    return info->finish_y;
+}
+
+
 double faf_car_get_time(body_t *car) {
     assert(car);
     faf_car_info_t *info = body_get_info(car);
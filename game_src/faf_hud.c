@@ -2,8 +2,11 @@
 #include <stdio.h>
 #include <assert.h>
 #include <SDL2/SDL_image.h>
+#include "alloc.h"
+#include "assets.h"
 #include "faf_cars.h"
 #include "faf_hud.h"
+#include "faf_standings.h"
 #include "list.h"
 #include "mathlib.h"
 #include "scene.h"
@@ -36,6 +39,34 @@ const char* GAS_INDICATOR_FILENAME = "assets/hud/fuel_gauge.png";
 const char *GAS_INDICATOR_NEEDLE_FILENAME = "assets/hud/fuel_gauge_needle.png";
 const SDL_Rect GAS_INDICATOR_NEEDLE_LOC = {.x = 925, .y = 180, .w = 100, .h = 83};
 
+const size_t PROFILER_NUM_PAIRS = 5;
+const int PROFILER_FONT_SIZE = 14;
+const int PROFILER_X = 200;
+const int PROFILER_Y = 12;
+const int PROFILER_LINE_HEIGHT = 18;
+// Names of the body categories, indexed by faf_object_t
+const char PROFILER_CATEGORY_NAMES[8][12] = {
+    "car", "surface", "obstacle", "effect", "gas", "decoration", "other", "ai"
+};
+
+bool PROFILER_VISIBLE = false;
+
+
+// Collision counters of the race scene for the last tick, shared by the profiler lines
+typedef struct profiler {
+    body_t *car;
+    TTF_Font *font;
+    collision_stats_t *last_totals;
+    collision_stats_t *tick_stats;
+    size_t *busiest;
+} profiler_t;
+
+
+typedef struct profiler_line {
+    profiler_t *profiler;
+    size_t rank;
+} profiler_line_t;
+
 
 void widget_tick_speedometer(widget_t *speed_wid) {
     assert(speed_wid);
@@ -54,12 +85,12 @@ void faf_hud_add_speedometer(hud_t *hud, body_t *car) {
     assert(hud);
     assert(car);
 
-    SDL_Surface *background_surface = IMG_Load(SPEEDOMETER_FILENAME);
+    SDL_Surface *background_surface = assets_get_surface(SPEEDOMETER_FILENAME);
     widget_t *background = widget_init(background_surface, SPEEDOMETER_LOC, 0, NULL, NULL, NULL);
     hud_add_widget(hud, background);
 
 
-    SDL_Surface *needle_surface = IMG_Load(SPEEDOMETER_NEEDLE_FILENAME);
+    SDL_Surface *needle_surface = assets_get_surface(SPEEDOMETER_NEEDLE_FILENAME);
     widget_t *needle = widget_init(needle_surface, SPEEDOMETER_NEEDLE_LOC, (3 * M_PI / 4), widget_tick_speedometer, car, NULL);
     hud_add_widget(hud, needle);
 }
@@ -83,56 +114,54 @@ void faf_hud_add_gastank(hud_t *hud, body_t *car) {
     assert(hud);
     assert(car);
 
-    SDL_Surface *tank_surface = IMG_Load(GAS_INDICATOR_FILENAME);
+    SDL_Surface *tank_surface = assets_get_surface(GAS_INDICATOR_FILENAME);
     widget_t *background = widget_init(tank_surface, GAS_INDICATOR_LOC, 0, NULL, NULL, NULL);
     hud_add_widget(hud, background);
 
-    SDL_Surface *needle_surface = IMG_Load(GAS_INDICATOR_NEEDLE_FILENAME);
+    SDL_Surface *needle_surface = assets_get_surface(GAS_INDICATOR_NEEDLE_FILENAME);
     widget_t *needle = widget_init(needle_surface, GAS_INDICATOR_NEEDLE_LOC, 0, widget_tick_gas, car, NULL);
     hud_add_widget(hud, needle);
 }
 
 
+// The player's place, rendered again only when it changes
+typedef struct place_info {
+    faf_standings_t *standings;
+    size_t shown;
+} place_info_t;
+
+
 void widget_tick_place(widget_t *place_wid) {
     assert(place_wid);
-    list_t *cars = widget_get_aux(place_wid);
-    assert(cars);
+    place_info_t *info = widget_get_aux(place_wid);
+    assert(info);
 
-    size_t place = list_size(cars);
-    double player_y = body_get_centroid((body_t *)list_get(cars, 0)).y;
-    for (size_t i = 1; i < list_size(cars); i++) {
-        double car_y = body_get_centroid((body_t *)list_get(cars, i)).y;
-        if (player_y > car_y) {
-            place--;
-        }
+    // The player car is first in the standings' list
+    size_t place = faf_standings_get_place(info->standings, 0);
+    if (place == info->shown) {
+        return;
     }
+    info->shown = place;
 
     SDL_Color c;
-    char *plc_text = malloc(sizeof(char) * 4);
+    char plc_text[24];
 
     switch (place) {
         case (1): {
             c = FAF_GOLD_C;
-            sprintf(plc_text, "%zdst", place);
             break;
         }
         case (2): {
             c = FAF_SILVER_C;
-            sprintf(plc_text, "%zdnd", place);
-            break;
-        }
-        case (3): {
-            c = FAF_BRONZE_C;
-            sprintf(plc_text, "%zdrd", place);
             break;
         }
         default: {
             c = FAF_BRONZE_C;
-            sprintf(plc_text, "%zdth", place);
             break;
         }
     }
-    TTF_Font *font = TTF_OpenFont("assets/fonts/Sansation-Bold.ttf", FAF_FONT_XXL);
+    sprintf(plc_text, "%zd%s", place, faf_standings_place_suffix(place));
+    TTF_Font *font = assets_open_font("assets/fonts/Sansation-Bold.ttf", FAF_FONT_XXL);
     assert(font);
     SDL_Surface *txt = TTF_RenderText_Solid(font, plc_text, c);
     assert(txt);
@@ -140,16 +169,25 @@ void widget_tick_place(widget_t *place_wid) {
     widget_set_surface(place_wid, txt);
     widget_set_rect(place_wid, plc_rect);
     TTF_CloseFont(font);
-    free(plc_text);
 }
 
 
-void faf_hud_add_place(hud_t *hud, list_t *cars) {
+void place_info_free(place_info_t *info) {
+    alloc_free(ALLOC_TAG_GAME, info);
+}
+
+
+void faf_hud_add_place(hud_t *hud, faf_standings_t *standings) {
     assert(hud);
-    assert(cars);
+    assert(standings);
 
+    place_info_t *info = alloc_malloc(ALLOC_TAG_GAME, sizeof(place_info_t));
+    assert(info);
+    info->standings = standings;
+    // No place yet, so the first tick renders one
+    info->shown = 0;
     SDL_Rect place_rect = {.x = 75, .y = 75, .w = 100, .h = 100};
-    widget_t *wid = widget_init(NULL, place_rect, 0, widget_tick_place, cars, NULL);
+    widget_t *wid = widget_init(NULL, place_rect, 0, widget_tick_place, info, (free_func_t)place_info_free);
     hud_add_widget(hud, wid);
 }
 
@@ -172,7 +210,7 @@ void widget_tick_time(widget_t *time_wid) {
         sprintf(time_text, "%zdm %zd.%03zds", mins, secs, msecs);
     }
 
-    TTF_Font *font = TTF_OpenFont("assets/fonts/Sansation-Bold.ttf", FAF_FONT_MEDIUM);
+    TTF_Font *font = assets_open_font("assets/fonts/Sansation-Bold.ttf", FAF_FONT_MEDIUM);
     assert(font);
     SDL_Surface *txt = TTF_RenderText_Solid(font, time_text, color);
     assert(txt);
@@ -193,7 +231,149 @@ void faf_hud_add_time(hud_t *hud, body_t *car) {
 }
 
 
-hud_t *faf_make_race_hud(list_t *cars) {
+void profiler_free(profiler_t *profiler) {
+    assert(profiler);
+
+    TTF_CloseFont(profiler->font);
+    alloc_free(ALLOC_TAG_GAME, profiler->last_totals);
+    alloc_free(ALLOC_TAG_GAME, profiler->tick_stats);
+    alloc_free(ALLOC_TAG_GAME, profiler->busiest);
+    alloc_free(ALLOC_TAG_GAME, profiler);
+}
+
+
+collision_stats_t profiler_diff(collision_stats_t curr, collision_stats_t last) {
+    // The counters only go down when they were reset
+    if (curr.force_creators < last.force_creators) {
+        return curr;
+    }
+    collision_stats_t diff = {
+        .force_creators = curr.force_creators - last.force_creators,
+        .radius_rejections = curr.radius_rejections - last.radius_rejections,
+        .sat_tests = curr.sat_tests - last.sat_tests,
+        .axes_tested = curr.axes_tested - last.axes_tested,
+        .early_outs = curr.early_outs - last.early_outs,
+        .contacts = curr.contacts - last.contacts,
+        .handlers_fired = curr.handlers_fired - last.handlers_fired
+    };
+    return diff;
+}
+
+
+void profiler_render_line(widget_t *line_wid, TTF_Font *font, const char *text, size_t line) {
+    SDL_Surface *txt = TTF_RenderText_Solid(font, text, FAF_WHITE_C);
+    assert(txt);
+    SDL_Rect line_rect = {.x = PROFILER_X + txt->w / 2, .y = PROFILER_Y + line * PROFILER_LINE_HEIGHT,
+                          .w = txt->w, .h = txt->h};
+    widget_set_surface(line_wid, txt);
+    widget_set_rect(line_wid, line_rect);
+}
+
+
+void widget_tick_profiler(widget_t *profiler_wid) {
+    assert(profiler_wid);
+    profiler_t *profiler = widget_get_aux(profiler_wid);
+    assert(profiler);
+
+    window_t *window = faf_car_get_window(profiler->car);
+    if (!window) {
+        widget_set_surface(profiler_wid, NULL);
+        return;
+    }
+
+    // Keep the per-tick counters current even while hidden
+    scene_t *scene = window_get_scene(window);
+    size_t num_pairs = BODY_NUM_CATEGORIES * BODY_NUM_CATEGORIES;
+    collision_stats_t total = {0};
+    for (size_t i = 0; i < num_pairs; i++) {
+        collision_stats_t curr = scene_get_collision_stats(scene, i / BODY_NUM_CATEGORIES, i % BODY_NUM_CATEGORIES);
+        profiler->tick_stats[i] = profiler_diff(curr, profiler->last_totals[i]);
+        profiler->last_totals[i] = curr;
+        collision_stats_add(&total, profiler->tick_stats[i]);
+    }
+
+    if (!PROFILER_VISIBLE) {
+        widget_set_surface(profiler_wid, NULL);
+        return;
+    }
+
+    // Rank the pairs of categories by how many force creators they ran
+    for (size_t i = 0; i < num_pairs; i++) {
+        size_t j = i;
+        while (j > 0 && profiler->tick_stats[profiler->busiest[j - 1]].force_creators <
+                        profiler->tick_stats[i].force_creators) {
+            profiler->busiest[j] = profiler->busiest[j - 1];
+            j--;
+        }
+        profiler->busiest[j] = i;
+    }
+
+    char text[200];
+    sprintf(text, "collisions/tick: %zu visited, %zu radius rejects, %zu SAT, %zu axes, "
+            "%zu early outs, %zu contacts, %zu handlers", total.force_creators, total.radius_rejections,
+            total.sat_tests, total.axes_tested, total.early_outs, total.contacts, total.handlers_fired);
+    profiler_render_line(profiler_wid, profiler->font, text, 0);
+}
+
+
+void widget_tick_profiler_line(widget_t *line_wid) {
+    assert(line_wid);
+    profiler_line_t *line = widget_get_aux(line_wid);
+    assert(line);
+    profiler_t *profiler = line->profiler;
+
+    size_t pair = profiler->busiest[line->rank];
+    collision_stats_t stats = profiler->tick_stats[pair];
+    if (!PROFILER_VISIBLE || stats.force_creators == 0 || !faf_car_get_window(profiler->car)) {
+        widget_set_surface(line_wid, NULL);
+        return;
+    }
+
+    char text[200];
+    sprintf(text, "%s-%s: %zu visited, %zu radius rejects, %zu SAT, %zu axes, %zu contacts, %zu handlers",
+            PROFILER_CATEGORY_NAMES[pair / BODY_NUM_CATEGORIES], PROFILER_CATEGORY_NAMES[pair % BODY_NUM_CATEGORIES],
+            stats.force_creators, stats.radius_rejections, stats.sat_tests, stats.axes_tested,
+            stats.contacts, stats.handlers_fired);
+    profiler_render_line(line_wid, profiler->font, text, line->rank + 1);
+}
+
+
+void faf_hud_add_profiler(hud_t *hud, body_t *car) {
+    assert(hud);
+    assert(car);
+
+    size_t num_pairs = BODY_NUM_CATEGORIES * BODY_NUM_CATEGORIES;
+    profiler_t *profiler = alloc_malloc(ALLOC_TAG_GAME, sizeof(profiler_t));
+    assert(profiler);
+    profiler->car = car;
+    profiler->font = assets_open_font("assets/fonts/Sansation-Bold.ttf", PROFILER_FONT_SIZE);
+    assert(profiler->font);
+    profiler->last_totals = alloc_calloc(ALLOC_TAG_GAME, num_pairs, sizeof(collision_stats_t));
+    profiler->tick_stats = alloc_calloc(ALLOC_TAG_GAME, num_pairs, sizeof(collision_stats_t));
+    profiler->busiest = alloc_calloc(ALLOC_TAG_GAME, num_pairs, sizeof(size_t));
+    assert(profiler->last_totals && profiler->tick_stats && profiler->busiest);
+
+    SDL_Rect rect = {.x = PROFILER_X, .y = PROFILER_Y, .w = 0, .h = 0};
+    widget_t *totals = widget_init(NULL, rect, 0, widget_tick_profiler, profiler, (free_func_t)profiler_free);
+    hud_add_widget(hud, totals);
+
+    for (size_t i = 0; i < PROFILER_NUM_PAIRS; i++) {
+        profiler_line_t *line = alloc_malloc(ALLOC_TAG_GAME, sizeof(profiler_line_t));
+        assert(line);
+        line->profiler = profiler;
+        line->rank = i;
+        widget_t *line_wid = widget_init(NULL, rect, 0, widget_tick_profiler_line, line, free);
+        hud_add_widget(hud, line_wid);
+    }
+}
+
+
+void faf_hud_toggle_profiler() {
+    PROFILER_VISIBLE = !PROFILER_VISIBLE;
+}
+
+
+hud_t *faf_make_race_hud(list_t *cars, faf_standings_t *standings) {
     assert(cars);
     body_t *player_car = (body_t *)list_get(cars, 0);
 
@@ -201,8 +381,9 @@ hud_t *faf_make_race_hud(list_t *cars) {
 
     faf_hud_add_speedometer(hud, player_car);
     faf_hud_add_gastank(hud, player_car);
-    faf_hud_add_place(hud, cars);
+    faf_hud_add_place(hud, standings);
     faf_hud_add_time(hud, player_car);
+    faf_hud_add_profiler(hud, player_car);
 
     return hud;
 }
\ No newline at end of file
@@ -0,0 +1,292 @@
+#include "faf_lanes.h"
+#include "alloc.h"
+#include "dynarray.h"
+#include "faf_levels.h"
+#include "faf_objects.h"
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+// What a car makes of the objects in a cell
+typedef enum {
+    FAF_LANE_HAZARD,
+    FAF_LANE_BOOST,
+    FAF_LANE_GAS,
+    FAF_NUM_LANE_KINDS,
+    FAF_LANE_IGNORED = FAF_NUM_LANE_KINDS
+} faf_lane_kind_t;
+
+typedef struct faf_lane_cell {
+    uint8_t counts[FAF_NUM_LANE_KINDS];
+} faf_lane_cell_t;
+
+DYNARRAY_DEFINE(lane_cells, faf_lane_cell_t, 1)
+
+
+typedef struct faf_lanes {
+    double left;
+    double lane_width;
+    size_t num_lanes;
+    double bin_length;
+    double margin;
+    // The bin of the first row; rows are consecutive bins, row by row, lane by lane
+    size_t first_row;
+    lane_cells_t cells;
+} faf_lanes_t;
+
+
+faf_lanes_t *faf_lanes_init(double left, double width, size_t num_lanes, double bin_length, double margin) {
+    assert(width > 0);
+    assert(num_lanes > 0);
+    assert(bin_length > 0);
+    assert(margin >= 0);
+
+    faf_lanes_t *lanes = alloc_malloc(ALLOC_TAG_GAME, sizeof(faf_lanes_t));
+    assert(lanes);
+    lanes->left = left;
+    lanes->lane_width = width / num_lanes;
+    lanes->num_lanes = num_lanes;
+    lanes->bin_length = bin_length;
+    lanes->margin = margin;
+    lanes->first_row = 0;
+    lane_cells_init(&lanes->cells);
+    return lanes;
+}
+
+
+void faf_lanes_free(faf_lanes_t *lanes) {
+    assert(lanes);
+
+    lane_cells_free(&lanes->cells);
+    alloc_free(ALLOC_TAG_GAME, lanes);
+}
+
+
+size_t faf_lanes_num_rows(faf_lanes_t *lanes) {
+    return lane_cells_size(&lanes->cells) / lanes->num_lanes;
+}
+
+
+// The bin a point along the road is in; the road starts at 0
+size_t faf_lanes_bin(faf_lanes_t *lanes, double y) {
+    return y <= 0 ? 0 : (size_t)(y / lanes->bin_length);
+}
+
+
+// The cell of a lane in a bin, or NULL if the grid has no row for the bin
+faf_lane_cell_t *faf_lanes_cell(faf_lanes_t *lanes, size_t bin, size_t lane) {
+    if (bin < lanes->first_row || bin - lanes->first_row >= faf_lanes_num_rows(lanes)) {
+        return NULL;
+    }
+    return lane_cells_get(&lanes->cells, (bin - lanes->first_row) * lanes->num_lanes + lane);
+}
+
+
+void faf_lanes_extend(faf_lanes_t *lanes, double end_y) {
+    assert(lanes);
+
+    size_t end_bin = (size_t)ceil(fmax(end_y, 0) / lanes->bin_length);
+    faf_lane_cell_t empty = {{0}};
+    while (lanes->first_row + faf_lanes_num_rows(lanes) < end_bin) {
+        for (size_t i = 0; i < lanes->num_lanes; i++) {
+            lane_cells_push(&lanes->cells, empty);
+        }
+    }
+}
+
+
+void faf_lanes_retire(faf_lanes_t *lanes, double start_y) {
+    assert(lanes);
+
+    size_t num_rows = faf_lanes_num_rows(lanes);
+    size_t start_bin = faf_lanes_bin(lanes, start_y);
+    if (start_bin <= lanes->first_row) {
+        return;
+    }
+    size_t dropped = start_bin - lanes->first_row;
+    if (dropped > num_rows) {
+        dropped = num_rows;
+    }
+    // A handful of rows remain, so shifting them down is cheaper than a ring buffer's bookkeeping
+    faf_lane_cell_t *cells = lane_cells_data(&lanes->cells);
+    size_t kept = (num_rows - dropped) * lanes->num_lanes;
+    memmove(cells, &cells[dropped * lanes->num_lanes], sizeof(faf_lane_cell_t) * kept);
+    lane_cells_truncate(&lanes->cells, kept);
+    lanes->first_row += dropped;
+}
+
+
+faf_lane_kind_t faf_lanes_kind(body_t *object) {
+    faf_object_t *type = body_get_info(object);
+    assert(type);
+
+    switch (*type) {
+        case FAF_OBSTACLE_OBJ: {
+            return FAF_LANE_HAZARD;
+        }
+        case FAF_GAS_OBJ: {
+            return FAF_LANE_GAS;
+        }
+        case FAF_EFFECT_OBJ: {
+            switch (faf_objects_get_effect_type((faf_object_info_t *)type)) {
+                case FAF_SPEED:
+                case FAF_STRENGTH:
+                case FAF_GREEN_ENERGY: {
+                    return FAF_LANE_BOOST;
+                }
+                case FAF_SLOWDOWN:
+                case FAF_GASLEAK:
+                case FAF_LOSE_CONTROL: {
+                    return FAF_LANE_HAZARD;
+                }
+                default: {
+                    return FAF_LANE_IGNORED;
+                }
+            }
+        }
+        default: {
+            return FAF_LANE_IGNORED;
+        }
+    }
+}
+
+
+// Adds one to, or takes one from, every cell an object covers
+void faf_lanes_count(faf_lanes_t *lanes, body_t *object, bool add) {
+    faf_lane_kind_t kind = faf_lanes_kind(object);
+    if (kind == FAF_LANE_IGNORED) {
+        return;
+    }
+
+    vector_t center = body_get_centroid(object);
+    double reach = body_get_bounding_radius(object) + lanes->margin;
+    double right = lanes->left + lanes->lane_width * lanes->num_lanes;
+    if (center.x + reach < lanes->left || center.x - reach > right) {
+        return;
+    }
+    size_t first_lane = faf_lanes_lane_at(lanes, center.x - reach);
+    size_t last_lane = faf_lanes_lane_at(lanes, center.x + reach);
+    size_t first_bin = faf_lanes_bin(lanes, center.y - body_get_bounding_radius(object));
+    size_t last_bin = faf_lanes_bin(lanes, center.y + body_get_bounding_radius(object));
+    for (size_t bin = first_bin; bin <= last_bin; bin++) {
+        for (size_t lane = first_lane; lane <= last_lane; lane++) {
+            faf_lane_cell_t *cell = faf_lanes_cell(lanes, bin, lane);
+            if (!cell) {
+                continue;
+            }
+            if (add) {
+                assert(cell->counts[kind] < UINT8_MAX);
+                cell->counts[kind]++;
+            }
+            else {
+                assert(cell->counts[kind] > 0);
+                cell->counts[kind]--;
+            }
+        }
+    }
+}
+
+
+void faf_lanes_add(faf_lanes_t *lanes, body_t *object) {
+    assert(lanes);
+    assert(object);
+
+    faf_lanes_count(lanes, object, true);
+}
+
+
+void faf_lanes_remove(faf_lanes_t *lanes, body_t *object) {
+    assert(lanes);
+    assert(object);
+
+    if (!body_is_removed(object)) {
+        faf_lanes_count(lanes, object, false);
+    }
+}
+
+
+size_t faf_lanes_lane_at(faf_lanes_t *lanes, double x) {
+    assert(lanes);
+
+    double lane = floor((x - lanes->left) / lanes->lane_width);
+    if (lane < 0) {
+        return 0;
+    }
+    return lane >= (double)lanes->num_lanes ? lanes->num_lanes - 1 : (size_t)lane;
+}
+
+
+double faf_lanes_center(faf_lanes_t *lanes, size_t lane) {
+    assert(lanes);
+    assert(lane < lanes->num_lanes);
+
+    return lanes->left + (lane + 0.5) * lanes->lane_width;
+}
+
+
+double faf_lanes_cell_cost(faf_lane_cell_t *cell, const faf_lane_costs_t *costs) {
+    return cell->counts[FAF_LANE_HAZARD] * costs->hazard + cell->counts[FAF_LANE_BOOST] * costs->boost +
+           cell->counts[FAF_LANE_GAS] * costs->gas;
+}
+
+
+// The cost of heading from one lane to another over the lookahead
+double faf_lanes_trajectory_cost(faf_lanes_t *lanes, double y, size_t from, size_t to, double turn_rate,
+                                 const faf_lane_costs_t *costs) {
+    size_t low = from < to ? from : to;
+    size_t high = from < to ? to : from;
+    double crossing_end = y + lanes->lane_width / turn_rate * (high - low);
+    size_t first_bin = faf_lanes_bin(lanes, y);
+    size_t num_bins = (size_t)ceil(costs->lookahead / lanes->bin_length);
+
+    double cost = 0;
+    for (size_t i = 0; i < num_bins; i++) {
+        size_t bin = first_bin + i;
+        // While crossing, the car covers every lane it passes through
+        bool crossing = bin * lanes->bin_length < crossing_end;
+        double weight = (double)(num_bins - i) / num_bins;
+        for (size_t lane = crossing ? low : to; lane <= (crossing ? high : to); lane++) {
+            faf_lane_cell_t *cell = faf_lanes_cell(lanes, bin, lane);
+            if (cell) {
+                cost += weight * faf_lanes_cell_cost(cell, costs);
+            }
+        }
+    }
+    return cost;
+}
+
+
+size_t faf_lanes_plan(faf_lanes_t *lanes, vector_t position, size_t target, double turn_rate,
+                      const faf_lane_costs_t *costs, rng_t *rng) {
+    assert(lanes);
+    assert(turn_rate > 0);
+    assert(costs);
+    assert(rng);
+
+    size_t lane = faf_lanes_lane_at(lanes, position.x);
+    if (target >= lanes->num_lanes) {
+        target = lane;
+    }
+
+    double stay = faf_lanes_trajectory_cost(lanes, position.y, lane, target, turn_rate, costs);
+    double left = INFINITY, right = INFINITY;
+    if (target > 0) {
+        left = costs->change + faf_lanes_trajectory_cost(lanes, position.y, lane, target - 1, turn_rate, costs);
+    }
+    if (target + 1 < lanes->num_lanes) {
+        right = costs->change + faf_lanes_trajectory_cost(lanes, position.y, lane, target + 1, turn_rate, costs);
+    }
+
+    // Only a strictly better lane is worth moving for
+    if (left < stay && left < right) {
+        return target - 1;
+    }
+    if (right < stay && right < left) {
+        return target + 1;
+    }
+    if (left < stay && left == right) {
+        return rng_index(rng, 2) == 0 ? target - 1 : target + 1;
+    }
+    return target;
+}
@@ -2,6 +2,8 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <errno.h>
+#include "alloc.h"
+#include "assets.h"
 #include "faf_leaderboard.h"
 #include "faf_cars.h"
 #include "list.h"
@@ -50,7 +52,7 @@ typedef struct faf_leaderboard {
 
 
 char *faf_get_level_fname(faf_level_t level) {
-    char *buff = malloc(sizeof(char) * FAF_LEADERBOARD_PATH_SIZE);
+    char *buff = alloc_malloc(ALLOC_TAG_GAME, sizeof(char) * FAF_LEADERBOARD_PATH_SIZE);
     assert(buff);
     sprintf(buff, "./data/leaderboards/%d.ldb", (int)level);
     return buff;
@@ -71,7 +73,7 @@ void faf_save_leaderboard(faf_leaderboard_t *leaderboard) {
         fprintf(fp, "%zu\n", r.mseconds);
     }
 
-    free(fpath);
+    alloc_free(ALLOC_TAG_GAME, fpath);
     fclose(fp);
 }
 
@@ -81,7 +83,7 @@ faf_leaderboard_t *faf_get_leaderboard(faf_level_t level) {
     FILE *fp = fopen(fpath, "r");
     assert(fp);
 
-    faf_leaderboard_t *lb = malloc(sizeof(faf_leaderboard_t));
+    faf_leaderboard_t *lb = alloc_malloc(ALLOC_TAG_GAME, sizeof(faf_leaderboard_t));
     assert(lb);
     lb->level = level;
 
@@ -134,7 +136,7 @@ bool faf_update_leaderboard(faf_level_t level, double time) {
     }
 
     if (place == FAF_NUM_RECORDS) {
-        free(lb);
+        alloc_free(ALLOC_TAG_GAME, lb);
         return false;
     }
 
@@ -145,7 +147,7 @@ bool faf_update_leaderboard(faf_level_t level, double time) {
     lb->records[place] = new_rec;
 
     faf_save_leaderboard(lb);
-    free(lb);
+    alloc_free(ALLOC_TAG_GAME, lb);
     return true;
 }
 
@@ -156,7 +158,7 @@ void faf_lb_left_arrow_tick(widget_t *arrow) {
     assert(info);
 
     if (info->idx > 0) {
-        widget_set_surface(arrow, IMG_Load("assets/menus/LeftArrow.png"));
+        widget_set_surface(arrow, assets_get_surface("assets/menus/LeftArrow.png"));
     }
     else {
         widget_set_surface(arrow, NULL);
@@ -170,7 +172,7 @@ void faf_lb_right_arrow_tick(widget_t *arrow) {
     assert(info);
 
     if (info->idx < FAF_NUM_LEVELS - 1) {
-        widget_set_surface(arrow, IMG_Load("assets/menus/RightArrow.png"));
+        widget_set_surface(arrow, assets_get_surface("assets/menus/RightArrow.png"));
     }
     else {
         widget_set_surface(arrow, NULL);
@@ -184,7 +186,7 @@ void faf_lb_level_description_tick(widget_t *description) {
     assert(info);
 
     const char *desc = LB_LEVEL_DESCRIPTIONS[info->idx];
-    TTF_Font *font = TTF_OpenFont("assets/fonts/Freedom.ttf", FAF_FONT_XLARGE);
+    TTF_Font *font = assets_open_font("assets/fonts/Freedom.ttf", FAF_FONT_XLARGE);
     assert(font);
     SDL_Surface *message = TTF_RenderText_Solid(font, desc, FAF_BLACK_C);
     widget_set_surface(description, message);
@@ -209,10 +211,10 @@ void faf_leaderboard_hud_update(hud_t *hud) {
 
     for (size_t i = 0; i < FAF_NUM_RECORDS; i++) {
         faf_record_t rec = lb->records[i];
-        TTF_Font *font = TTF_OpenFont("assets/fonts/Sansation-Bold.ttf", FAF_FONT_LARGE);
+        TTF_Font *font = assets_open_font("assets/fonts/Sansation-Bold.ttf", FAF_FONT_LARGE);
         assert(font);
 
-        font = TTF_OpenFont("assets/fonts/Sansation-Bold.ttf", FAF_FONT_LARGE);
+        font = assets_open_font("assets/fonts/Sansation-Bold.ttf", FAF_FONT_LARGE);
         assert(font);
         widget_t *time_wid = info->times[i];
         char time[100];
@@ -226,18 +228,18 @@ void faf_leaderboard_hud_update(hud_t *hud) {
         TTF_CloseFont(font);
     }
 
-    free(lb);
+    alloc_free(ALLOC_TAG_GAME, lb);
 }
 
 
 hud_t *faf_make_leaderboard_hud() {
-    faf_lb_hud_t *info = malloc(sizeof(faf_lb_hud_t));
+    faf_lb_hud_t *info = alloc_malloc(ALLOC_TAG_GAME, sizeof(faf_lb_hud_t));
     assert(info);
     info->idx = 0;
     hud_t *hud = hud_init(info, free);
 
     // Add background
-    SDL_Surface *bgound_img = IMG_Load("assets/menus/MenuBackground.png");
+    SDL_Surface *bgound_img = assets_get_surface("assets/menus/MenuBackground.png");
     assert(bgound_img);
     SDL_Rect bgound_rect = {.x = (int)(FAF_WINDOW_DIMENSIONS.x / 2.),
                             .y = (int)(FAF_WINDOW_DIMENSIONS.y / 2.),
@@ -278,7 +280,7 @@ hud_t *faf_make_leaderboard_hud() {
         else {
             place_c = FAF_BRONZE_C;
         }
-        TTF_Font *font = TTF_OpenFont("assets/fonts/Sansation-Bold.ttf", FAF_FONT_LARGE);
+        TTF_Font *font = assets_open_font("assets/fonts/Sansation-Bold.ttf", FAF_FONT_LARGE);
         assert(font);
         char place[2];
         sprintf(place, "%zd", i + 1);
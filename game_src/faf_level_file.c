@@ -0,0 +1,146 @@
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "alloc.h"
+#include "faf_level_file.h"
+#include "file_map.h"
+
+const uint32_t FAF_LEVEL_FILE_VERSION = 1;
+const char FAF_LEVEL_FILE_MAGIC[4] = {'F', 'A', 'F', 'L'};
+
+
+typedef struct faf_level_file {
+    void *data;
+    size_t size;
+    const faf_level_file_header_t *header;
+    const faf_chunk_record_t *chunks;
+    const faf_tile_record_t *tiles;
+    const faf_object_record_t *objects;
+} faf_level_file_t;
+
+
+bool faf_level_file_tile_is_valid(const faf_tile_record_t *tile) {
+    return tile->tile_type <= FAF_SIDE_TILE && isfinite(tile->x) && isfinite(tile->y) &&
+           isfinite(tile->width) && tile->width > 0 && isfinite(tile->height) && tile->height > 0;
+}
+
+
+// Checks the header, that every array and every chunk's records lie inside the file,
+// and that every record can be built, so a corrupt file is rejected rather than tripping asserts mid-race
+bool faf_level_file_is_valid(faf_level_file_t *file) {
+    const faf_level_file_header_t *header = file->header;
+    if (file->size < sizeof(faf_level_file_header_t) ||
+        memcmp(header->magic, FAF_LEVEL_FILE_MAGIC, sizeof(FAF_LEVEL_FILE_MAGIC)) != 0 ||
+        header->version != FAF_LEVEL_FILE_VERSION || header->chunk_length != (float)FAF_CHUNK_LENGTH ||
+        header->level_type > FOREST_LEVEL || !isfinite(header->track_length) || !(header->track_length > 0) ||
+        !(header->finish_y >= 0 && header->finish_y <= header->track_length)) {
+        return false;
+    }
+    // 64-bit so the sum can't wrap around where size_t is 32 bits, as in WebAssembly
+    uint64_t expected = sizeof(faf_level_file_header_t) +
+                        (uint64_t)header->num_chunks * sizeof(faf_chunk_record_t) +
+                        (uint64_t)header->num_tiles * sizeof(faf_tile_record_t) +
+                        (uint64_t)header->num_objects * sizeof(faf_object_record_t);
+    if (file->size != expected) {
+        return false;
+    }
+    for (size_t i = 0; i < header->num_chunks; i++) {
+        const faf_chunk_record_t *chunk = &file->chunks[i];
+        if (chunk->first_tile > header->num_tiles || chunk->num_tiles > header->num_tiles - chunk->first_tile ||
+            chunk->first_object > header->num_objects ||
+            chunk->num_objects > header->num_objects - chunk->first_object) {
+            return false;
+        }
+    }
+    const faf_tile_record_t *tiles = (const faf_tile_record_t *)(file->chunks + header->num_chunks);
+    for (size_t i = 0; i < header->num_tiles; i++) {
+        if (!faf_level_file_tile_is_valid(&tiles[i])) {
+            return false;
+        }
+    }
+    const faf_object_record_t *objects = (const faf_object_record_t *)(tiles + header->num_tiles);
+    for (size_t i = 0; i < header->num_objects; i++) {
+        if (!faf_object_record_is_valid(&objects[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+faf_level_file_t *faf_level_file_open(const char *path) {
+    assert(path);
+
+    size_t size = 0;
+    void *data = file_map(path, ALLOC_TAG_GAME, &size);
+    if (!data) {
+        return NULL;
+    }
+
+    faf_level_file_t *file = alloc_malloc(ALLOC_TAG_GAME, sizeof(faf_level_file_t));
+    assert(file);
+    file->data = data;
+    file->size = size;
+    file->header = data;
+    file->chunks = (const faf_chunk_record_t *)(file->header + 1);
+    if (!faf_level_file_is_valid(file)) {
+        faf_level_file_close(file);
+        return NULL;
+    }
+    file->tiles = (const faf_tile_record_t *)(file->chunks + file->header->num_chunks);
+    file->objects = (const faf_object_record_t *)(file->tiles + file->header->num_tiles);
+    return file;
+}
+
+
+void faf_level_file_close(faf_level_file_t *file) {
+    assert(file);
+
+    file_unmap(file->data, ALLOC_TAG_GAME, file->size);
+    alloc_free(ALLOC_TAG_GAME, file);
+}
+
+
+const faf_level_file_header_t *faf_level_file_get_header(faf_level_file_t *file) {
+    assert(file);
+
+    return file->header;
+}
+
+
+const faf_tile_record_t *faf_level_file_get_tiles(faf_level_file_t *file, size_t chunk, size_t *num_tiles) {
+    assert(file);
+    assert(chunk < file->header->num_chunks);
+
+    *num_tiles = file->chunks[chunk].num_tiles;
+    return &file->tiles[file->chunks[chunk].first_tile];
+}
+
+
+const faf_object_record_t *faf_level_file_get_objects(faf_level_file_t *file, size_t chunk,
+                                                      size_t *num_objects) {
+    assert(file);
+    assert(chunk < file->header->num_chunks);
+
+    *num_objects = file->chunks[chunk].num_objects;
+    return &file->objects[file->chunks[chunk].first_object];
+}
+
+
+bool faf_level_file_write(const char *path, faf_level_file_header_t header, const faf_chunk_record_t *chunks,
+                          const faf_tile_record_t *tiles, const faf_object_record_t *objects) {
+    assert(path);
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        return false;
+    }
+    memcpy(header.magic, FAF_LEVEL_FILE_MAGIC, sizeof(FAF_LEVEL_FILE_MAGIC));
+    header.version = FAF_LEVEL_FILE_VERSION;
+    bool written = fwrite(&header, sizeof(header), 1, f) == 1 &&
+                   fwrite(chunks, sizeof(faf_chunk_record_t), header.num_chunks, f) == header.num_chunks &&
+                   fwrite(tiles, sizeof(faf_tile_record_t), header.num_tiles, f) == header.num_tiles &&
+                   fwrite(objects, sizeof(faf_object_record_t), header.num_objects, f) == header.num_objects;
+    return fclose(f) == 0 && written;
+}
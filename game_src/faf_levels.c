@@ -1,14 +1,23 @@
 #include <assert.h>
+#include <math.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include "alloc.h"
 #include "body.h"
+#include "collision.h"
 #include "color.h"
+#include "dynarray.h"
 #include "faf_cars.h"
+#include "faf_lanes.h"
+#include "faf_level_file.h"
 #include "faf_levels.h"
 #include "faf_objects.h"
-#include "forces.h"
+#include "jobs.h"
 #include "mathlib.h"
+#include "rng.h"
 #include "scene.h"
 #include "shape.h"
+#include "spatial_grid.h"
 #include "vector.h"
 
 
@@ -30,19 +39,44 @@ const size_t FAF_ROAD_LANES = 3;
 const double FAF_DEFAULT_DENSITY = 1;
 const size_t FAF_INIT_NUM_BODIES_IN_SCENE = 10;
 const double FAF_ELASTICITY = 1.;
-const size_t FAF_NUM_DECORATIONS = 80;
-const size_t FAF_NUM_EFFECTS = 60;
-const size_t FAF_NUM_OBSTACLES = 70;
-const size_t FAF_NUM_GAS = 80;
 const vector_t FAF_DIMENSIONS = {.x = 1000, .y = 20000};
 const double FAF_ROAD_WIDTH = 700;
 const double FAF_ROAD_COEF = 0.05;
 const double FAF_SIDE_WIDTH = 150;
 const double FAF_BLOCK_LENGTH = 1000;
 const double FAF_BLOCK_WIDTH = 10;
+// The starting grid: where the front row lines up, half a window up the track,
+// the most cars side by side, and the distance between rows
+const double FAF_GRID_START_Y = 250;
+const size_t FAF_GRID_ROW_CARS = 6;
+const double FAF_GRID_ROW_SPACING = 200;
 const vector_t FAF_FINISH_LINE_DIMENSIONS = {.x = 700, .y = 100};
 const rgb_color_t FAF_FINISH_LINE_COLOR = {.r = 0, .g = 0, .b = 0};
 
+// Properties of the track's chunks
+const double FAF_CHUNK_LENGTH = 1000;
+// Chunks are made this far ahead of the lead car and kept this far behind the last car
+const double FAF_CHUNK_LOOKAHEAD = 3000;
+const double FAF_CHUNK_TRAIL = 1000;
+// The cell size of the grids of the bodies cars collide with, about a car's length
+const double FAF_COLLISION_CELL_SIZE = 100;
+// How many cars one job tests against the others
+const size_t FAF_CAR_TEST_GRAIN = 16;
+// What a car's collider reserves up front so ticks don't allocate: a car's box reaches
+// about a hundred tiles, and it touches far fewer
+const size_t FAF_CAR_MAX_NEARBY = 256;
+const size_t FAF_CAR_MAX_CONTACTS = 64;
+// The AI cars' lane grid: lanes about two cars wide, and rows that split chunks evenly
+const size_t FAF_AI_LANES = 7;
+const double FAF_AI_LANE_BIN_LENGTH = 100;
+// Half a car's width
+const double FAF_AI_LANE_MARGIN = 25;
+// The average number of each object in a chunk; fractions carry over to later chunks
+const double FAF_DECORATIONS_PER_CHUNK = 4;
+const double FAF_EFFECTS_PER_CHUNK = 3;
+const double FAF_OBSTACLES_PER_CHUNK = 3.5;
+const double FAF_GAS_PER_CHUNK = 4;
+
 // Properties of the desert level
 const rgb_color_t FAF_DESERT_BACKGROUND_COLOR = {.r = (float)0.95, .g = (float)0.64, .b = (float)0.38};
 const double FAF_DESERT_SAND_COEF = 0.5;
@@ -66,7 +100,652 @@ double faf_get_road_width() {
 }
 
 
-scene_t *faf_make_level(faf_level_t type, list_t *cars, list_t *ai_colliders) {
+vector_t faf_get_grid_position(size_t index, size_t num_cars) {
+    assert(index < num_cars);
+
+    size_t row_cars = num_cars < FAF_GRID_ROW_CARS ? num_cars : FAF_GRID_ROW_CARS;
+    double step = FAF_ROAD_WIDTH / (row_cars + 1);
+    return (vector_t){.x = FAF_SIDE_WIDTH + step * (index % row_cars + 1),
+                      .y = FAF_GRID_START_Y - FAF_GRID_ROW_SPACING * (index / row_cars)};
+}
+
+
+// How much road the grid needs behind the start of the track, where chunk 0 begins
+double faf_grid_run_up(size_t num_cars) {
+    if (num_cars == 0) {
+        return 0;
+    }
+    double back_y = faf_get_grid_position(num_cars - 1, num_cars).y - FAF_GRID_ROW_SPACING;
+    return back_y < 0 ? -back_y : 0;
+}
+
+
+DYNARRAY_DEFINE(track_handles, body_handle_t, 8)
+DYNARRAY_DEFINE(collider_ids, size_t, 32)
+
+
+// Every body built for one chunk of track, removed together once every car has passed
+typedef struct faf_chunk {
+    size_t index;
+    track_handles_t bodies;
+    // The bodies cars collide with, found through the grid by their index here
+    track_handles_t colliders;
+    spatial_grid_t *grid;
+    // How far the colliders reach along the track
+    double min_y;
+    double max_y;
+} faf_chunk_t;
+
+
+DYNARRAY_DEFINE(chunk_array, faf_chunk_t, 8)
+
+
+typedef struct faf_track {
+    scene_t *scene;
+    faf_level_t type;
+    uint64_t seed;
+    // Where the chunks come from instead of the seed, or NULL
+    faf_level_file_t *file;
+    double length;
+    double finish_y;
+    // How far the road reaches behind the start of the track for the starting grid
+    double run_up;
+    size_t num_chunks;
+    rgb_color_t side_color;
+    // Shared by every chunk, in the scene's arena
+    surface_info_t *road_info;
+    surface_info_t *side_info;
+    faf_object_t *other_type;
+    double *elasticity;
+    // The cars decide which chunks exist, and collide with every chunk (see faf_car_collider_t)
+    track_handles_t cars;
+    // What the AI cars plan their lanes with, covering the chunks in the scene
+    faf_lanes_t *lanes;
+    size_t next_chunk;
+    // The chunks in the scene, oldest first
+    chunk_array_t chunks;
+    // Reused to generate each chunk's contents
+    faf_tile_records_t tiles;
+    faf_object_records_t objects;
+} faf_track_t;
+
+
+size_t faf_chunk_count(double per_chunk, size_t index) {
+    return (size_t)(floor((index + 1) * per_chunk) - floor(index * per_chunk));
+}
+
+
+size_t faf_num_chunks(double track_length) {
+    return isfinite(track_length) ? (size_t)ceil(track_length / FAF_CHUNK_LENGTH) : SIZE_MAX;
+}
+
+
+double faf_finish_y(double track_length) {
+    return track_length - 3 * FAF_FINISH_LINE_DIMENSIONS.y / 2;
+}
+
+
+void faf_add_tile(faf_tile_records_t *tiles, double x, double y, faf_tile_t tile_type) {
+    faf_tile_record_t tile = {.x = (float)x, .y = (float)y, .width = (float)FAF_BLOCK_WIDTH,
+                              .height = (float)FAF_BLOCK_LENGTH, .tile_type = tile_type};
+    faf_tile_records_push(tiles, tile);
+}
+
+
+// Appends the road and background of a row of blocks whose lower edge is at start
+void faf_add_tile_row(faf_tile_records_t *tiles, double start) {
+    double y = start + FAF_BLOCK_LENGTH / 2;
+    for (int i = 0; i < (int)(FAF_ROAD_WIDTH / FAF_BLOCK_WIDTH); i++) {
+        faf_add_tile(tiles, FAF_SIDE_WIDTH + FAF_BLOCK_WIDTH / 2 + i * FAF_BLOCK_WIDTH, y, FAF_ROAD_TILE);
+    }
+    for (int i = 0; i < (int)(FAF_SIDE_WIDTH / FAF_BLOCK_WIDTH); i++) {
+        faf_add_tile(tiles, FAF_BLOCK_WIDTH / 2 + i * FAF_BLOCK_WIDTH, y, FAF_SIDE_TILE);
+        faf_add_tile(tiles, FAF_ROAD_WIDTH + FAF_SIDE_WIDTH + FAF_BLOCK_WIDTH / 2 + i * FAF_BLOCK_WIDTH, y,
+                     FAF_SIDE_TILE);
+    }
+}
+
+
+// Appends one chunk's terrain and objects. They depend only on the seed and the chunk's index.
+void faf_generate_chunk(faf_level_t type, uint64_t seed, double track_length, size_t index,
+                        faf_tile_records_t *tiles, faf_object_records_t *objects) {
+    double start = index * FAF_CHUNK_LENGTH;
+    double length = fmin(FAF_CHUNK_LENGTH, track_length - start);
+
+    // Each chunk has its own stream, so chunks can be generated in any order or at the same time
+    rng_t rng = rng_init_stream(seed, index);
+    faf_placement_t *placement = faf_placement_init((vector_t){.x = 0, .y = start},
+                                                    (vector_t){.x = FAF_DIMENSIONS.x, .y = length});
+    faf_object_spawn_decorations(placement, objects, &rng, FAF_ROAD_WIDTH,
+                                 faf_chunk_count(FAF_DECORATIONS_PER_CHUNK, index), type);
+    faf_object_spawn_effects(placement, objects, &rng, FAF_ROAD_WIDTH, faf_chunk_count(FAF_EFFECTS_PER_CHUNK, index));
+    faf_object_spawn_gas(placement, objects, &rng, FAF_ROAD_WIDTH, faf_chunk_count(FAF_GAS_PER_CHUNK, index));
+    faf_object_spawn_obstacles(placement, objects, &rng, FAF_ROAD_WIDTH,
+                               faf_chunk_count(FAF_OBSTACLES_PER_CHUNK, index), type);
+    faf_placement_free(placement);
+
+    // The road and the background on both sides of it
+    for (int j = 0; j < (int)(FAF_CHUNK_LENGTH / FAF_BLOCK_LENGTH); j++) {
+        faf_add_tile_row(tiles, start + j * FAF_BLOCK_LENGTH);
+    }
+}
+
+
+void faf_chunk_free(faf_chunk_t *chunk) {
+    track_handles_free(&chunk->bodies);
+    track_handles_free(&chunk->colliders);
+    spatial_grid_free(chunk->grid);
+}
+
+
+void faf_chunk_add_body(faf_chunk_t *chunk, scene_t *scene, body_t *body, size_t layer) {
+    scene_add_body_in_layer(scene, body, layer);
+    track_handles_push(&chunk->bodies, body_get_handle(body));
+}
+
+
+// Builds the bodies of terrain tiles into a chunk
+void faf_chunk_add_tiles(faf_chunk_t *chunk, faf_track_t *track, const faf_tile_record_t *tiles, size_t num_tiles,
+                         list_t *collision_bodies) {
+    for (size_t i = 0; i < num_tiles; i++) {
+        const faf_tile_record_t *tile = &tiles[i];
+        bool road = tile->tile_type == FAF_ROAD_TILE;
+        body_t *body = shape_init_rectangle(tile->width, tile->height,
+                                            road ? FAF_REGULAR_ROAD_COLOR : track->side_color,
+                                            FAF_DEFAULT_DENSITY, road ? track->road_info : track->side_info, NULL);
+        body_set_centroid(body, (vector_t){.x = tile->x, .y = tile->y});
+        faf_chunk_add_body(chunk, track->scene, body, road ? FAF_FOREGROUND_LAYER : FAF_BACKGROUND_LAYER);
+        list_add(collision_bodies, body);
+    }
+}
+
+
+// Builds the bodies of the next chunk from its records and adds them to the scene
+void faf_track_build_chunk(faf_track_t *track, const faf_tile_record_t *tiles, size_t num_tiles,
+                           const faf_object_record_t *objects, size_t num_objects) {
+    faf_chunk_t chunk = {.index = track->next_chunk++, .min_y = INFINITY, .max_y = -INFINITY};
+    track_handles_init(&chunk.bodies);
+    track_handles_init(&chunk.colliders);
+    chunk.grid = spatial_grid_init(FAF_COLLISION_CELL_SIZE);
+    scene_t *scene = track->scene;
+    double start = chunk.index * FAF_CHUNK_LENGTH;
+    list_t *collision_bodies = list_init(FAF_INIT_NUM_BODIES_IN_SCENE, NULL);
+
+    // Add objects
+    faf_lanes_extend(track->lanes, start + FAF_CHUNK_LENGTH);
+    for (size_t i = 0; i < num_objects; i++) {
+        body_t *object = faf_object_init(&objects[i]);
+        faf_chunk_add_body(&chunk, scene, object, FAF_OBJECT_LAYER);
+        faf_lanes_add(track->lanes, object);
+        list_add(collision_bodies, object);
+    }
+
+    // Add the road and the background
+    faf_chunk_add_tiles(&chunk, track, tiles, num_tiles, collision_bodies);
+
+    // The first chunk also lays the road behind the start of the track that a large grid lines up on.
+    // It isn't part of the level, so it is the same for generated tracks and level files.
+    double stripes_start = start;
+    if (chunk.index == 0 && track->run_up > 0) {
+        faf_tile_records_t run_up;
+        faf_tile_records_init(&run_up);
+        for (stripes_start = 0; stripes_start > -track->run_up; stripes_start -= FAF_BLOCK_LENGTH) {
+            faf_add_tile_row(&run_up, stripes_start - FAF_BLOCK_LENGTH);
+        }
+        faf_chunk_add_tiles(&chunk, track, faf_tile_records_data(&run_up), faf_tile_records_size(&run_up),
+                            collision_bodies);
+        faf_tile_records_free(&run_up);
+    }
+
+    // Add stripes on the road
+    for (double curr_y = stripes_start; curr_y < start + FAF_CHUNK_LENGTH && curr_y < 0.995 * track->length;
+         curr_y += FAF_ROAD_STRIPE_SPACING) {
+        for (size_t i = 1; i < FAF_ROAD_LANES; i++) {
+            body_t *stripe = shape_init_rectangle(FAF_ROAD_STRIPE_WIDTH, FAF_ROAD_STRIPE_HEIGHT, 
+                                                  FAF_ROAD_STRIPE_COLOR, FAF_DEFAULT_DENSITY,
+                                                  track->other_type, NULL);
+            double dist_from_side = (FAF_DIMENSIONS.x - FAF_ROAD_WIDTH) / 2;
+            double curr_x = i * FAF_ROAD_WIDTH / FAF_ROAD_LANES + dist_from_side;
+            vector_t center = {.x = curr_x, .y = curr_y};
+            body_set_centroid(stripe, center);
+            faf_chunk_add_body(&chunk, scene, stripe, FAF_FOREGROUND_LAYER);
+        }
+    }
+
+    // Add finish line
+    if (track->finish_y >= start && track->finish_y < start + FAF_CHUNK_LENGTH) {
+        body_t *finish_line = shape_init_rectangle_with_sprite(FAF_FINISH_LINE_DIMENSIONS.x,
+                                                               FAF_FINISH_LINE_DIMENSIONS.y,
+                                                               FAF_FINISH_LINE_COLOR, FAF_DEFAULT_DENSITY,
+                                                               track->other_type, NULL,
+                                                               "assets/object/finish_line.png",
+                                                               FAF_FINISH_LINE_DIMENSIONS);
+        body_set_centroid(finish_line, (vector_t){.x = FAF_DIMENSIONS.x / 2, .y = track->finish_y});
+        faf_chunk_add_body(&chunk, scene, finish_line, FAF_FOREGROUND_LAYER);
+    }
+
+    // Break the scene's collision counters down by object type, and grid the bodies for the cars.
+    // They never move, so the grid is made once, and ids in build order keep the handlers in that order.
+    for (size_t i = 0; i < list_size(collision_bodies); i++) {
+        body_t *body = list_get(collision_bodies, i);
+        body_set_category(body, *(faf_object_t *)body_get_info(body));
+        vector_t center = body_get_centroid(body);
+        double radius = body_get_bounding_radius(body);
+        spatial_grid_insert(chunk.grid, i, (vector_t){.x = center.x - radius, .y = center.y - radius},
+                            (vector_t){.x = center.x + radius, .y = center.y + radius});
+        track_handles_push(&chunk.colliders, body_get_handle(body));
+        chunk.min_y = fmin(chunk.min_y, center.y - radius);
+        chunk.max_y = fmax(chunk.max_y, center.y + radius);
+    }
+
+    list_free(collision_bodies);
+    chunk_array_push(&track->chunks, chunk);
+}
+
+
+// A body a car touches, with the axis for its collision handler
+typedef struct faf_contact {
+    body_handle_t body;
+    vector_t axis;
+} faf_contact_t;
+
+
+DYNARRAY_DEFINE(contact_array, faf_contact_t, 16)
+
+
+// One car's collisions with the track. Instead of a collision for every pair of a car and
+// a chunk's body, each car looks itself up in the grids of the chunks it reaches, so the
+// work grows with the number of cars rather than cars times bodies.
+typedef struct faf_car_collider {
+    faf_track_t *track;
+    body_t *car;
+    // What the car touched last tick, so a handler only runs when a collision starts
+    contact_array_t touching;
+    // What the car touches this tick, becoming touching once the tick's test is done
+    contact_array_t found;
+    // The collisions that started this tick, for the handler
+    contact_array_t started;
+    // The grid's results for the chunk being tested
+    collider_ids_t ids;
+} faf_car_collider_t;
+
+
+bool faf_contacts_include(contact_array_t *contacts, body_handle_t body) {
+    for (size_t i = 0; i < contact_array_size(contacts); i++) {
+        body_handle_t other = contact_array_get(contacts, i)->body;
+        if (other.index == body.index && other.generation == body.generation) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// Sorts a grid query's ids; there are only ever a handful, so insertion sort is quickest
+void faf_sort_ids(size_t *ids, size_t num_ids) {
+    for (size_t i = 1; i < num_ids; i++) {
+        size_t id = ids[i];
+        size_t j = i;
+        for (; j > 0 && ids[j - 1] > id; j--) {
+            ids[j] = ids[j - 1];
+        }
+        ids[j] = id;
+    }
+}
+
+
+// Finds the boxes near a car, sorted. The ids are reserved when the car's collisions are
+// set up, so they only grow (and allocate) if a car ever reaches more boxes than that.
+size_t faf_query_ids(spatial_grid_t *grid, vector_t min, vector_t max, collider_ids_t *ids) {
+    size_t num_ids = spatial_grid_query(grid, min, max, collider_ids_data(ids), ids->capacity);
+    if (num_ids > ids->capacity) {
+        collider_ids_reserve(ids, num_ids > 2 * ids->capacity ? num_ids : 2 * ids->capacity);
+        spatial_grid_query(grid, min, max, collider_ids_data(ids), num_ids);
+    }
+    faf_sort_ids(collider_ids_data(ids), num_ids);
+    return num_ids;
+}
+
+
+// Tests a car against the colliders of one chunk near it
+void faf_car_collider_test_chunk(faf_car_collider_t *collider, faf_chunk_t *chunk, vector_t min, vector_t max) {
+    body_t *car = collider->car;
+    // The grid finds them in no particular order, and handlers run in the order the bodies were built
+    size_t num_ids = faf_query_ids(chunk->grid, min, max, &collider->ids);
+    size_t *ids = collider_ids_data(&collider->ids);
+
+    for (size_t i = 0; i < num_ids; i++) {
+        body_handle_t handle = *track_handles_get(&chunk->colliders, ids[i]);
+        body_t *other = body_from_handle(handle);
+        // Objects that were hit may already be gone
+        if (!other) {
+            continue;
+        }
+        collision_stats_t *stats = scene_get_thread_collision_stats(collider->track->scene, body_get_category(car),
+                                                                    body_get_category(other));
+        stats->force_creators++;
+        double distance = vec_distance(body_get_centroid(car), body_get_centroid(other));
+        if (distance > body_get_bounding_radius(car) + body_get_bounding_radius(other)) {
+            stats->radius_rejections++;
+            continue;
+        }
+        collision_info_t c_info = find_collision_points(body_get_vertices(car), body_get_num_vertices(car),
+                                                        body_get_vertices(other), body_get_num_vertices(other),
+                                                        stats);
+        if (!c_info.collided) {
+            continue;
+        }
+        faf_contact_t contact = {.body = handle, .axis = c_info.axis};
+        contact_array_push(&collider->found, contact);
+        if (!faf_contacts_include(&collider->touching, handle)) {
+            contact_array_push(&collider->started, contact);
+        }
+    }
+}
+
+
+// Runs on any job thread: the chunks only change in faf_track_update(), after every test
+bool faf_car_collider_test(faf_car_collider_t *collider) {
+    vector_t center = body_get_centroid(collider->car);
+    double radius = body_get_bounding_radius(collider->car);
+    vector_t min = {.x = center.x - radius, .y = center.y - radius};
+    vector_t max = {.x = center.x + radius, .y = center.y + radius};
+
+    contact_array_clear(&collider->found);
+    contact_array_clear(&collider->started);
+    for (size_t i = 0; i < chunk_array_size(&collider->track->chunks); i++) {
+        faf_chunk_t *chunk = chunk_array_get(&collider->track->chunks, i);
+        if (chunk->max_y >= min.y && chunk->min_y <= max.y) {
+            faf_car_collider_test_chunk(collider, chunk, min, max);
+        }
+    }
+
+    contact_array_t last = collider->touching;
+    collider->touching = collider->found;
+    collider->found = last;
+    return contact_array_size(&collider->started) > 0;
+}
+
+
+void faf_car_collider_hit(faf_car_collider_t *collider) {
+    body_t *car = collider->car;
+    for (size_t i = 0; i < contact_array_size(&collider->started); i++) {
+        faf_contact_t *contact = contact_array_get(&collider->started, i);
+        body_t *other = body_from_handle(contact->body);
+        faf_car_on_hit(car, other, contact->axis, collider->track->elasticity);
+        scene_get_thread_collision_stats(collider->track->scene, body_get_category(car),
+                                         body_get_category(other))->handlers_fired++;
+    }
+}
+
+
+void faf_car_collider_free(faf_car_collider_t *collider) {
+    contact_array_free(&collider->touching);
+    contact_array_free(&collider->found);
+    contact_array_free(&collider->started);
+    collider_ids_free(&collider->ids);
+    alloc_free(ALLOC_TAG_GAME, collider);
+}
+
+
+// Collides a car with every chunk for as long as both the car and the track exist
+void faf_track_add_car_collider(faf_track_t *track, body_t *car) {
+    faf_car_collider_t *collider = alloc_malloc(ALLOC_TAG_GAME, sizeof(faf_car_collider_t));
+    assert(collider);
+    collider->track = track;
+    collider->car = car;
+    contact_array_init(&collider->touching);
+    contact_array_init(&collider->found);
+    contact_array_init(&collider->started);
+    collider_ids_init(&collider->ids);
+    contact_array_reserve(&collider->touching, FAF_CAR_MAX_CONTACTS);
+    contact_array_reserve(&collider->found, FAF_CAR_MAX_CONTACTS);
+    contact_array_reserve(&collider->started, FAF_CAR_MAX_CONTACTS);
+    collider_ids_reserve(&collider->ids, FAF_CAR_MAX_NEARBY);
+
+    list_t *bodies = list_init(1, NULL);
+    list_add(bodies, car);
+    scene_add_tested_force_creator(track->scene, (force_tester_t)faf_car_collider_test,
+                                   (force_creator_t)faf_car_collider_hit, collider, bodies,
+                                   (free_func_t)faf_car_collider_free);
+}
+
+
+// What one car touches of the other cars, kept like a faf_car_collider_t's contacts
+typedef struct faf_car_contacts {
+    contact_array_t touching;
+    contact_array_t found;
+    contact_array_t started;
+    collider_ids_t ids;
+} faf_car_contacts_t;
+
+
+DYNARRAY_DEFINE(car_contacts_array, faf_car_contacts_t, 8)
+
+
+// The cars' collisions with each other. Each tick the cars' boxes go into a grid, every car
+// finds the cars near it through the grid in parallel, and the handlers then run in car order,
+// so the work grows with the number of cars rather than with every pair of them.
+typedef struct faf_car_traffic {
+    scene_t *scene;
+    double *elasticity;
+    track_handles_t cars;
+    // By car, in the order of cars
+    car_contacts_array_t contacts;
+    // Each car's bounding box, by its index in cars
+    spatial_grid_t *grid;
+} faf_car_traffic_t;
+
+
+// Finds the cars each car of a slice touches; called by jobs_parallel_for()
+void faf_car_traffic_test_range(size_t start, size_t end, faf_car_traffic_t *traffic) {
+    for (size_t i = start; i < end; i++) {
+        faf_car_contacts_t *contacts = car_contacts_array_get(&traffic->contacts, i);
+        contact_array_clear(&contacts->found);
+        contact_array_clear(&contacts->started);
+        body_t *car = body_from_handle(*track_handles_get(&traffic->cars, i));
+        if (car) {
+            vector_t center = body_get_centroid(car);
+            double radius = body_get_bounding_radius(car);
+            vector_t min = {.x = center.x - radius, .y = center.y - radius};
+            vector_t max = {.x = center.x + radius, .y = center.y + radius};
+            // The other cars in the order they were listed, so the handlers run in the same order every race
+            size_t num_ids = faf_query_ids(traffic->grid, min, max, &contacts->ids);
+            size_t *ids = collider_ids_data(&contacts->ids);
+
+            for (size_t j = 0; j < num_ids; j++) {
+                if (ids[j] == i) {
+                    continue;
+                }
+                body_handle_t handle = *track_handles_get(&traffic->cars, ids[j]);
+                body_t *other = body_from_handle(handle);
+                collision_stats_t *stats = scene_get_thread_collision_stats(traffic->scene, body_get_category(car),
+                                                                            body_get_category(other));
+                stats->force_creators++;
+                if (vec_distance(center, body_get_centroid(other)) > radius + body_get_bounding_radius(other)) {
+                    stats->radius_rejections++;
+                    continue;
+                }
+                collision_info_t c_info = find_collision_points(body_get_vertices(car), body_get_num_vertices(car),
+                                                                body_get_vertices(other),
+                                                                body_get_num_vertices(other), stats);
+                if (!c_info.collided) {
+                    continue;
+                }
+                faf_contact_t contact = {.body = handle, .axis = c_info.axis};
+                contact_array_push(&contacts->found, contact);
+                if (!faf_contacts_include(&contacts->touching, handle)) {
+                    contact_array_push(&contacts->started, contact);
+                }
+            }
+        }
+
+        contact_array_t last = contacts->touching;
+        contacts->touching = contacts->found;
+        contacts->found = last;
+    }
+}
+
+
+// Collides the cars with each other. As a force creator without bodies it runs serially,
+// after the cars' collisions with the track and before the bodies move.
+void faf_car_traffic_update(faf_car_traffic_t *traffic) {
+    size_t num_cars = track_handles_size(&traffic->cars);
+    spatial_grid_clear(traffic->grid);
+    for (size_t i = 0; i < num_cars; i++) {
+        body_t *car = body_from_handle(*track_handles_get(&traffic->cars, i));
+        if (car) {
+            vector_t center = body_get_centroid(car);
+            double radius = body_get_bounding_radius(car);
+            spatial_grid_insert(traffic->grid, i, (vector_t){.x = center.x - radius, .y = center.y - radius},
+                                (vector_t){.x = center.x + radius, .y = center.y + radius});
+        }
+    }
+
+    jobs_parallel_for(num_cars, FAF_CAR_TEST_GRAIN, (job_range_func_t)faf_car_traffic_test_range, traffic);
+
+    // Like every other collision, a handler runs from each car's side when a contact starts
+    for (size_t i = 0; i < num_cars; i++) {
+        faf_car_contacts_t *contacts = car_contacts_array_get(&traffic->contacts, i);
+        if (contact_array_size(&contacts->started) == 0) {
+            continue;
+        }
+        body_t *car = body_from_handle(*track_handles_get(&traffic->cars, i));
+        for (size_t j = 0; j < contact_array_size(&contacts->started); j++) {
+            faf_contact_t *contact = contact_array_get(&contacts->started, j);
+            body_t *other = body_from_handle(contact->body);
+            faf_car_on_hit(car, other, contact->axis, traffic->elasticity);
+            scene_get_thread_collision_stats(traffic->scene, body_get_category(car),
+                                             body_get_category(other))->handlers_fired++;
+        }
+    }
+}
+
+
+void faf_car_traffic_free(faf_car_traffic_t *traffic) {
+    for (size_t i = 0; i < car_contacts_array_size(&traffic->contacts); i++) {
+        faf_car_contacts_t *contacts = car_contacts_array_get(&traffic->contacts, i);
+        contact_array_free(&contacts->touching);
+        contact_array_free(&contacts->found);
+        contact_array_free(&contacts->started);
+        collider_ids_free(&contacts->ids);
+    }
+    car_contacts_array_free(&traffic->contacts);
+    track_handles_free(&traffic->cars);
+    spatial_grid_free(traffic->grid);
+    alloc_free(ALLOC_TAG_GAME, traffic);
+}
+
+
+// Collides the track's cars with each other for as long as the track exists
+void faf_track_add_traffic(faf_track_t *track) {
+    faf_car_traffic_t *traffic = alloc_malloc(ALLOC_TAG_GAME, sizeof(faf_car_traffic_t));
+    assert(traffic);
+    traffic->scene = track->scene;
+    traffic->elasticity = track->elasticity;
+    traffic->grid = spatial_grid_init(FAF_COLLISION_CELL_SIZE);
+    track_handles_init(&traffic->cars);
+    car_contacts_array_init(&traffic->contacts);
+    size_t num_cars = track_handles_size(&track->cars);
+    double max_size = 0;
+    for (size_t i = 0; i < num_cars; i++) {
+        body_handle_t handle = *track_handles_get(&track->cars, i);
+        track_handles_push(&traffic->cars, handle);
+        max_size = fmax(max_size, 2 * body_get_bounding_radius(body_from_handle(handle)));
+        faf_car_contacts_t contacts;
+        contact_array_init(&contacts.touching);
+        contact_array_init(&contacts.found);
+        contact_array_init(&contacts.started);
+        collider_ids_init(&contacts.ids);
+        car_contacts_array_push(&traffic->contacts, contacts);
+    }
+    spatial_grid_reserve(traffic->grid, num_cars, max_size);
+
+    scene_add_bodies_force_creator(track->scene, (force_creator_t)faf_car_traffic_update, traffic,
+                                   list_init(1, NULL), (free_func_t)faf_car_traffic_free);
+}
+
+
+void faf_track_add_chunk(faf_track_t *track) {
+    if (track->file) {
+        size_t num_tiles, num_objects;
+        const faf_tile_record_t *tiles = faf_level_file_get_tiles(track->file, track->next_chunk, &num_tiles);
+        const faf_object_record_t *objects = faf_level_file_get_objects(track->file, track->next_chunk,
+                                                                        &num_objects);
+        faf_track_build_chunk(track, tiles, num_tiles, objects, num_objects);
+        return;
+    }
+
+    faf_tile_records_clear(&track->tiles);
+    faf_object_records_clear(&track->objects);
+    faf_generate_chunk(track->type, track->seed, track->length, track->next_chunk, &track->tiles, &track->objects);
+    faf_track_build_chunk(track, faf_tile_records_data(&track->tiles), faf_tile_records_size(&track->tiles),
+                          faf_object_records_data(&track->objects), faf_object_records_size(&track->objects));
+}
+
+
+// The scene frees the bodies, and with them their collisions, at the end of the tick
+void faf_track_retire_chunk(faf_track_t *track) {
+    faf_chunk_t *chunk = chunk_array_get(&track->chunks, 0);
+    for (size_t i = 0; i < track_handles_size(&chunk->bodies); i++) {
+        body_t *body = body_from_handle(*track_handles_get(&chunk->bodies, i));
+        // Objects that were hit may already be gone
+        if (body) {
+            body_remove(body);
+        }
+    }
+    faf_chunk_free(chunk);
+    faf_lanes_retire(track->lanes, (chunk->index + 1) * FAF_CHUNK_LENGTH);
+    chunk_array_remove(&track->chunks, 0);
+}
+
+
+// Adds chunks up to the lead car's lookahead and retires the ones the last car is done with
+void faf_track_update(faf_track_t *track) {
+    double lead_y = -INFINITY;
+    double last_y = INFINITY;
+    for (size_t i = 0; i < track_handles_size(&track->cars); i++) {
+        body_t *car = body_from_handle(*track_handles_get(&track->cars, i));
+        if (car) {
+            double y = body_get_centroid(car).y;
+            lead_y = fmax(lead_y, y);
+            last_y = fmin(last_y, y);
+        }
+    }
+
+    // Building a chunk allocates its bodies, which a tick otherwise never does
+    alloc_cold_begin("faf_track_add_chunk");
+    while (track->next_chunk < track->num_chunks &&
+           track->next_chunk * FAF_CHUNK_LENGTH < lead_y + FAF_CHUNK_LOOKAHEAD) {
+        faf_track_add_chunk(track);
+    }
+    alloc_cold_end();
+    while (chunk_array_size(&track->chunks) > 0 &&
+           (chunk_array_get(&track->chunks, 0)->index + 1) * FAF_CHUNK_LENGTH < last_y - FAF_CHUNK_TRAIL) {
+        faf_track_retire_chunk(track);
+    }
+}
+
+
+// The chunks' bodies belong to the scene, which frees them first
+void faf_track_free(faf_track_t *track) {
+    for (size_t i = 0; i < chunk_array_size(&track->chunks); i++) {
+        faf_chunk_free(chunk_array_get(&track->chunks, i));
+    }
+    chunk_array_free(&track->chunks);
+    track_handles_free(&track->cars);
+    faf_lanes_free(track->lanes);
+    faf_tile_records_free(&track->tiles);
+    faf_object_records_free(&track->objects);
+    if (track->file) {
+        faf_level_file_close(track->file);
+    }
+    alloc_free(ALLOC_TAG_GAME, track);
+}
+
+
+scene_t *faf_make_track(faf_level_t type, uint64_t seed, faf_level_file_t *file, double track_length,
+                        double finish_y, list_t *cars) {
     rgb_color_t side_color;
     double side_coef;
 
@@ -92,116 +771,112 @@ scene_t *faf_make_level(faf_level_t type, list_t *cars, list_t *ai_colliders) {
     }
 
     assert(cars);
+    assert(track_length > 0);
 
-    scene_t *scene = scene_init(FAF_DIMENSIONS);
-    list_t *collision_bodies = list_init(FAF_INIT_NUM_BODIES_IN_SCENE, NULL);
-
-    // Add decorations on the side of the road
-    faf_object_spawn_decorations(scene, FAF_DIMENSIONS, collision_bodies, FAF_ROAD_WIDTH,
-                                 FAF_NUM_DECORATIONS, type);
-
-    // Add random effects
-    faf_object_spawn_effects(scene, FAF_DIMENSIONS, collision_bodies,
-                             FAF_ROAD_WIDTH, FAF_NUM_EFFECTS);
-
-    // Add gas
-    faf_object_spawn_gas(scene, FAF_DIMENSIONS, collision_bodies,
-                         FAF_ROAD_WIDTH, FAF_NUM_GAS);
+    scene_t *scene = scene_init((vector_t){.x = FAF_DIMENSIONS.x, .y = track_length});
 
-    // Add obstacles
-    faf_object_spawn_obstacles(scene, FAF_DIMENSIONS, collision_bodies, FAF_ROAD_WIDTH,
-                               FAF_NUM_OBSTACLES, type);
+    faf_track_t *track = alloc_malloc(ALLOC_TAG_GAME, sizeof(faf_track_t));
+    assert(track);
+    track->scene = scene;
+    track->type = type;
+    track->seed = seed;
+    track->file = file;
+    track->length = track_length;
+    track->finish_y = finish_y;
+    track->run_up = faf_grid_run_up(list_size(cars));
+    track->num_chunks = file ? faf_level_file_get_header(file)->num_chunks : faf_num_chunks(track_length);
+    track->side_color = side_color;
 
-    // Add the road
-    for (int i = 0; i < (int)(FAF_ROAD_WIDTH / FAF_BLOCK_WIDTH); i++) {
-        for (int j = 0; j < (int)(FAF_DIMENSIONS.y / FAF_BLOCK_LENGTH); j++) {
-            surface_info_t *surf_info = faf_surface_init(FAF_ROAD_COEF);
-            body_t *road = shape_init_rectangle(FAF_BLOCK_WIDTH, FAF_BLOCK_LENGTH, FAF_REGULAR_ROAD_COLOR,
-                                                FAF_DEFAULT_DENSITY, surf_info, free);
-            vector_t center = {.x = FAF_SIDE_WIDTH + FAF_BLOCK_WIDTH / 2 + i * FAF_BLOCK_WIDTH,
-                               .y = FAF_BLOCK_LENGTH / 2 + j * FAF_BLOCK_LENGTH};
-            body_set_centroid(road, center);
-            scene_add_body_in_layer(scene, road, FAF_FOREGROUND_LAYER);
-            list_add(collision_bodies, road);
-        }
-    }
+    // Level-lifetime infos come from the scene's arena and are freed with it
+    arena_t *arena = scene_get_arena(scene);
+    track->road_info = faf_surface_init(arena, FAF_ROAD_COEF);
+    track->side_info = faf_surface_init(arena, side_coef);
+    track->other_type = arena_alloc(arena, sizeof(faf_object_t));
+    *track->other_type = FAF_OTHER_OBJ;
+    track->elasticity = arena_alloc(arena, sizeof(double));
+    *track->elasticity = FAF_ELASTICITY;
+    track->lanes = faf_lanes_init((FAF_DIMENSIONS.x - FAF_ROAD_WIDTH) / 2, FAF_ROAD_WIDTH, FAF_AI_LANES,
+                                  FAF_AI_LANE_BIN_LENGTH, FAF_AI_LANE_MARGIN);
 
-    // Add stripes on the road
-    for (double curr_y = 0; curr_y < 0.995 * FAF_DIMENSIONS.y; curr_y += FAF_ROAD_STRIPE_SPACING) {
-        for (size_t i = 1; i < FAF_ROAD_LANES; i++) {
-            faf_object_t *obj_type = malloc(sizeof(faf_object_t));
-            *obj_type = FAF_OTHER_OBJ;
-            body_t *stripe = shape_init_rectangle(FAF_ROAD_STRIPE_WIDTH, FAF_ROAD_STRIPE_HEIGHT, 
-                                                  FAF_ROAD_STRIPE_COLOR, FAF_DEFAULT_DENSITY,
-                                                  obj_type, free);
-            double dist_from_side = (FAF_DIMENSIONS.x - FAF_ROAD_WIDTH) / 2;
-            double curr_x = i * FAF_ROAD_WIDTH / FAF_ROAD_LANES + dist_from_side;
-            vector_t center = {.x = curr_x, .y = curr_y};
-            body_set_centroid(stripe, center);
-            scene_add_body_in_layer(scene, stripe, FAF_FOREGROUND_LAYER);
-        }
+    track_handles_init(&track->cars);
+    for (size_t i = 0; i < list_size(cars); i++) {
+        body_t *car = list_get(cars, i);
+        body_set_category(car, *(faf_object_t *)body_get_info(car));
+        track_handles_push(&track->cars, body_get_handle(car));
+        faf_car_set_lanes(car, track->lanes);
+        faf_car_set_finish_y(car, finish_y);
     }
+    track->next_chunk = 0;
+    chunk_array_init(&track->chunks);
+    faf_tile_records_init(&track->tiles);
+    faf_object_records_init(&track->objects);
 
-    // Add the background
-    for (int i = 0; i < (int)(FAF_SIDE_WIDTH / FAF_BLOCK_WIDTH); i++) {
-        for (int j = 0; j < (int)(FAF_DIMENSIONS.y / FAF_BLOCK_LENGTH); j++) {
-            // Left side
-            surface_info_t *surf_l_info = faf_surface_init(side_coef);
-            body_t *background_left = shape_init_rectangle(FAF_BLOCK_WIDTH, FAF_BLOCK_LENGTH, side_color,
-                                                            FAF_DEFAULT_DENSITY, surf_l_info, free);
-            vector_t center_l = {.x = FAF_BLOCK_WIDTH / 2 + i * FAF_BLOCK_WIDTH, .y = FAF_BLOCK_LENGTH / 2 + j * FAF_BLOCK_LENGTH};
-            body_set_centroid(background_left, center_l);
-            scene_add_body_in_layer(scene, background_left, FAF_BACKGROUND_LAYER);
-            list_add(collision_bodies, background_left);
-            // Right side
-            surface_info_t *surf_r_info = faf_surface_init(side_coef);
-            body_t *background_right = shape_init_rectangle(FAF_BLOCK_WIDTH, FAF_BLOCK_LENGTH, side_color,
-                                                            FAF_DEFAULT_DENSITY, surf_r_info, free);
-            vector_t center_r = {.x = FAF_ROAD_WIDTH + FAF_SIDE_WIDTH + FAF_BLOCK_WIDTH / 2 + i * FAF_BLOCK_WIDTH,
-                                .y = FAF_BLOCK_LENGTH / 2 + j * FAF_BLOCK_LENGTH};
-            body_set_centroid(background_right, center_r);
-            scene_add_body_in_layer(scene, background_right, FAF_BACKGROUND_LAYER);
-            list_add(collision_bodies, background_right);
-        }
+    // The cars are placed after this, so start with the chunks ahead of the start line
+    while (track->next_chunk < track->num_chunks && track->next_chunk * FAF_CHUNK_LENGTH < FAF_CHUNK_LOOKAHEAD) {
+        faf_track_add_chunk(track);
     }
 
-    // Add finish line
-    faf_object_t *obj_type = malloc(sizeof(faf_object_t));
-    *obj_type = FAF_OTHER_OBJ;
-    body_t *finish_line = shape_init_rectangle_with_sprite(FAF_FINISH_LINE_DIMENSIONS.x, FAF_FINISH_LINE_DIMENSIONS.y,
-                                                           FAF_FINISH_LINE_COLOR, FAF_DEFAULT_DENSITY, obj_type, free,
-                                                           "assets/object/finish_line.png", FAF_FINISH_LINE_DIMENSIONS);
-    vector_t center = {.x = FAF_DIMENSIONS.x / 2, .y = FAF_DIMENSIONS.y - 3 * FAF_FINISH_LINE_DIMENSIONS.y / 2};
-    body_set_centroid(finish_line, center);
-    scene_add_body_in_layer(scene, finish_line, FAF_FOREGROUND_LAYER);
-
-    // Add all cars to collision bodies
+    // The cars' collisions come before the track's update, which may retire the chunks they hit
     for (size_t i = 0; i < list_size(cars); i++) {
-        body_t *car = list_get(cars, i);
-        list_add(collision_bodies, car);
+        faf_track_add_car_collider(track, list_get(cars, i));
     }
+    faf_track_add_traffic(track);
 
-    // Register all cars for collision with bodies
-    double *aux = malloc(sizeof(double));
-    *aux = FAF_ELASTICITY;
-    for (size_t i = 0; i < list_size(cars); i++) {
-        body_t *car = list_get(cars, i);
-        for (size_t j = 0; j < list_size(collision_bodies); j++) {
-            body_t *other = list_get(collision_bodies, j);
-            create_collision(scene, car, other, (collision_handler_t)faf_car_on_hit, aux, free);
-        }
-    }
+    // Update the track every tick. As a force creator without bodies it runs before the bodies
+    // move, where adding and removing bodies is safe, and it is freed with the scene.
+    scene_add_bodies_force_creator(scene, (force_creator_t)faf_track_update, track, list_init(1, NULL),
+                                   (free_func_t)faf_track_free);
 
-    // Register all AI colliders for collision with bodies
-    for (size_t i = 0; i < list_size(ai_colliders); i++) {
-        body_t *collider = list_get(ai_colliders, i);
-        for (size_t j = 0; j < list_size(collision_bodies); j++) {
-            body_t *other = list_get(collision_bodies, j);
-            create_collision(scene, collider, other, (collision_handler_t)faf_ai_collider_on_hit, aux, free);
-        }
+    return scene;
+}
+
+
+scene_t *faf_make_level(faf_level_t type, uint64_t seed, double track_length, list_t *cars) {
+    return faf_make_track(type, seed, NULL, track_length, faf_finish_y(track_length), cars);
+}
+
+
+scene_t *faf_make_level_from_file(const char *path, faf_level_t type, list_t *cars) {
+    faf_level_file_t *file = faf_level_file_open(path);
+    if (!file) {
+        return NULL;
+    }
+    const faf_level_file_header_t *header = faf_level_file_get_header(file);
+    if (header->level_type != type) {
+        faf_level_file_close(file);
+        return NULL;
     }
+    return faf_make_track(type, 0, file, header->track_length, header->finish_y, cars);
+}
 
-    list_free(collision_bodies);
 
-    return scene;
-}
\ No newline at end of file
+bool faf_save_level(const char *path, faf_level_t type, uint64_t seed, double track_length) {
+    assert(isfinite(track_length) && track_length > 0);
+
+    faf_level_file_header_t header = {.level_type = type, .num_chunks = (uint32_t)faf_num_chunks(track_length),
+                                      .chunk_length = (float)FAF_CHUNK_LENGTH,
+                                      .track_length = (float)track_length,
+                                      .finish_y = (float)faf_finish_y(track_length)};
+    faf_chunk_record_t *chunks = alloc_malloc(ALLOC_TAG_GAME, sizeof(faf_chunk_record_t) * header.num_chunks);
+    assert(chunks);
+    faf_tile_records_t tiles;
+    faf_object_records_t objects;
+    faf_tile_records_init(&tiles);
+    faf_object_records_init(&objects);
+    for (size_t i = 0; i < header.num_chunks; i++) {
+        chunks[i].first_tile = (uint32_t)faf_tile_records_size(&tiles);
+        chunks[i].first_object = (uint32_t)faf_object_records_size(&objects);
+        faf_generate_chunk(type, seed, track_length, i, &tiles, &objects);
+        chunks[i].num_tiles = (uint32_t)faf_tile_records_size(&tiles) - chunks[i].first_tile;
+        chunks[i].num_objects = (uint32_t)faf_object_records_size(&objects) - chunks[i].first_object;
+    }
+    header.num_tiles = (uint32_t)faf_tile_records_size(&tiles);
+    header.num_objects = (uint32_t)faf_object_records_size(&objects);
+
+    bool saved = faf_level_file_write(path, header, chunks, faf_tile_records_data(&tiles),
+                                      faf_object_records_data(&objects));
+    alloc_free(ALLOC_TAG_GAME, chunks);
+    faf_tile_records_free(&tiles);
+    faf_object_records_free(&objects);
+    return saved;
+}
@@ -1,11 +1,16 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <assert.h>
-#include "mathlib.h"
+#include <stdint.h>
+#include <time.h>
+#include "alloc.h"
+#include "assets.h"
+#include "rng.h"
 #include "faf_menu.h"
 #include "faf_hud.h"
 #include "faf_cars.h"
 #include "faf_leaderboard.h"
+#include "faf_standings.h"
 #include "faf_audio.h"
 #include "sdl_wrapper.h"
 #include "color.h"
@@ -42,8 +47,11 @@ extern const int FAF_FONT_XXXL;
 const vector_t FAF_MENU_OPTION_DIMS = {.x = 450, .y = 75};
 
 const double FAF_TRACK_LEN = 20000;
+// Built by "make levels"; a level without one is generated from a random seed
+const char *FAF_LEVEL_FILES[3] = {"assets/levels/desert.faflvl", "assets/levels/ice.faflvl",
+                                  "assets/levels/forest.faflvl"};
 
-const size_t FAF_NUM_CARS = 6;
+const char FAF_PROFILER_KEY = 'p';
 
 const faf_car_t CAR_TYPES[7] = {FERRARI_488_GTE, PORSCHE_911, BUGATTI_CHIRON, MERCEDES_SLS_AMG,
                                 BMW_I8, LAMBORGHINI_HURACAN_EVO_SPYDER, ASTON_MARTON_VANQUISH};
@@ -120,6 +128,13 @@ const vector_t RACE_FOCUS_OFFSET = {.x = 0, .y = 100};
 const size_t MAIN_MENU_NUM_OPTIONS = 1;
 
 const char* LOADING_BGOUND_PATH = "assets/menus/faf_load_page.jpg";
+const char* FAF_ASSETS_DIR = "assets";
+// Built by "make packs"; without it, the assets are decoded from their files
+const char* FAF_ASSETS_PACK = "assets/faf.fafpak";
+// How long each frame of the loading screen spends finishing decoded assets
+const double LOADING_STEP_TIME = 1. / 120;
+// The full progress bar; like every widget rectangle, x and y are its center
+const SDL_Rect LOADING_BAR_RECT = {.x = 500, .y = 400, .w = 600, .h = 12};
 const char* MAIN_BGOUND_PATH = "assets/menus/main_menu_bg.png";
 
 const int NUM_DIFFICULTIES = 3;
@@ -130,8 +145,12 @@ const char DIFFICULTY_DESCRIPTIONS[3][10] = {
 };
 
 int DIFFICULTY = 3;
+// The number of cars in each race, the player's included
+size_t NUM_CARS = 6;
 faf_level_t CURR_LEVEL = DESERT_LEVEL;
 list_t *CARS_LIST = NULL;
+// Owned by the race's scene
+faf_standings_t *STANDINGS = NULL;
 
 
 typedef struct faf_menu_info {
@@ -151,7 +170,7 @@ typedef struct faf_menu_opt {
 typedef struct pause_info {
     size_t idx;
     hud_t *old_hud;
-    list_t *old_handlers;
+    key_handlers_t *old_handlers;
 } pause_info_t;
 
 
@@ -169,7 +188,7 @@ hud_t *faf_make_game_over_hud() {
     hud_t *hud = hud_init(NULL, NULL);
 
     // Add background
-    SDL_Surface *bgound_img = IMG_Load("assets/menus/MenuBackground.png");
+    SDL_Surface *bgound_img = assets_get_surface("assets/menus/MenuBackground.png");
     assert(bgound_img);
     SDL_Rect bgound_rect = {.x = (int)(FAF_WINDOW_DIMENSIONS.x / 2.),
                             .y = (int)(FAF_WINDOW_DIMENSIONS.y / 2.),
@@ -178,7 +197,7 @@ hud_t *faf_make_game_over_hud() {
     hud_add_widget(hud, bgound);
 
     // Add game over title
-    TTF_Font *font = TTF_OpenFont("assets/fonts/Freedom.ttf", FAF_FONT_XXL);
+    TTF_Font *font = assets_open_font("assets/fonts/Freedom.ttf", FAF_FONT_XXL);
     assert(font);
     SDL_Surface *message = TTF_RenderText_Solid(font, FAF_GAME_OVER, FAF_DARKRED_C);
     assert(message);
@@ -190,7 +209,7 @@ hud_t *faf_make_game_over_hud() {
     TTF_CloseFont(font);
 
     // Add out of gas image
-    SDL_Surface *oog_img = IMG_Load("assets/menus/OutOfGas.png");
+    SDL_Surface *oog_img = assets_get_surface("assets/menus/OutOfGas.png");
     assert(oog_img);
     SDL_Rect img_rect = {.x = (int)(FAF_WINDOW_DIMENSIONS.x / 2.),
                          .y = (int)(FAF_WINDOW_DIMENSIONS.y / 2.),
@@ -199,7 +218,7 @@ hud_t *faf_make_game_over_hud() {
     hud_add_widget(hud, oog_wid);
 
     // Add message
-    font = TTF_OpenFont("assets/fonts/Sansation-Bold.ttf", FAF_FONT_XLARGE);
+    font = assets_open_font("assets/fonts/Sansation-Bold.ttf", FAF_FONT_XLARGE);
     assert(font);
     message = TTF_RenderText_Solid(font, FAF_OUT_OF_GAS, FAF_WHITE_C);
     assert(message);
@@ -218,7 +237,7 @@ hud_t *faf_make_race_over_hud(faf_level_t level, double time) {
     hud_t *hud = hud_init(NULL, NULL);
 
     // Add background
-    SDL_Surface *bgound_img = IMG_Load("assets/menus/MenuBackground.png");
+    SDL_Surface *bgound_img = assets_get_surface("assets/menus/MenuBackground.png");
     assert(bgound_img);
     SDL_Rect bgound_rect = {.x = (int)(FAF_WINDOW_DIMENSIONS.x / 2.),
                             .y = (int)(FAF_WINDOW_DIMENSIONS.y / 2.),
@@ -227,7 +246,7 @@ hud_t *faf_make_race_over_hud(faf_level_t level, double time) {
     hud_add_widget(hud, bgound);
 
     // Add race over title
-    TTF_Font *font = TTF_OpenFont("assets/fonts/Freedom.ttf", FAF_FONT_XXL);
+    TTF_Font *font = assets_open_font("assets/fonts/Freedom.ttf", FAF_FONT_XXL);
     assert(font);
     SDL_Surface *message = TTF_RenderText_Solid(font, FAF_RACE_OVER, FAF_GOLD_C);
     assert(message);
@@ -239,7 +258,7 @@ hud_t *faf_make_race_over_hud(faf_level_t level, double time) {
     TTF_CloseFont(font);
 
     // Add flag image
-    SDL_Surface *flag_img = IMG_Load("assets/menus/FinishFlag.png");
+    SDL_Surface *flag_img = assets_get_surface("assets/menus/FinishFlag.png");
     assert(flag_img);
     SDL_Rect img_rect = {.x = (int)(FAF_WINDOW_DIMENSIONS.x / 2. - 100),
                          .y = (int)(FAF_WINDOW_DIMENSIONS.y / 2. + 50),
@@ -247,40 +266,27 @@ hud_t *faf_make_race_over_hud(faf_level_t level, double time) {
     widget_t *flag_wid = widget_init(flag_img, img_rect, 0, NULL, NULL, NULL);
     hud_add_widget(hud, flag_wid);
 
-    // Add place
-    size_t place = list_size(CARS_LIST);
-    double player_y = body_get_centroid((body_t *)list_get(CARS_LIST, 0)).y;
-    for (size_t i = 1; i < list_size(CARS_LIST); i++) {
-        double car_y = body_get_centroid((body_t *)list_get(CARS_LIST, i)).y;
-        if (player_y > car_y) {
-            place--;
-        }
-    }
+    // Add place; the player car is first in the standings' list
+    faf_standings_update(STANDINGS);
+    size_t place = faf_standings_get_place(STANDINGS, 0);
     SDL_Color c;
-    char plc_text[4];
+    char plc_text[24];
     switch (place) {
         case (1): {
             c = FAF_GOLD_C;
-            sprintf(plc_text, "%zdst", place);
             break;
         }
         case (2): {
             c = FAF_SILVER_C;
-            sprintf(plc_text, "%zdnd", place);
-            break;
-        }
-        case (3): {
-            c = FAF_BRONZE_C;
-            sprintf(plc_text, "%zdrd", place);
             break;
         }
         default: {
             c = FAF_BRONZE_C;
-            sprintf(plc_text, "%zdth", place);
             break;
         }
     }
-    font = TTF_OpenFont("assets/fonts/Sansation-Bold.ttf", 100);
+    sprintf(plc_text, "%zd%s", place, faf_standings_place_suffix(place));
+    font = assets_open_font("assets/fonts/Sansation-Bold.ttf", 100);
     assert(font);
     SDL_Surface *txt = TTF_RenderText_Solid(font, plc_text, c);
     assert(txt);
@@ -293,7 +299,7 @@ hud_t *faf_make_race_over_hud(faf_level_t level, double time) {
         
 
     // Add message
-    font = TTF_OpenFont("assets/fonts/Sansation-Bold.ttf", FAF_FONT_XLARGE);
+    font = assets_open_font("assets/fonts/Sansation-Bold.ttf", FAF_FONT_XLARGE);
     assert(font);
     size_t mins = (size_t)(time / 60.);
     size_t secs = (size_t)(time) - (mins * 60);
@@ -312,7 +318,7 @@ hud_t *faf_make_race_over_hud(faf_level_t level, double time) {
     /*
     if (faf_update_leaderboard(level, time)) {
         // Add new record text
-        font = TTF_OpenFont("assets/fonts/Sansation-Bold.ttf", FAF_FONT_XLARGE);
+        font = assets_open_font("assets/fonts/Sansation-Bold.ttf", FAF_FONT_XLARGE);
         assert(font);
         message = TTF_RenderText_Solid(font, "New Record!", FAF_GOLD_C);
         assert(message);
@@ -346,7 +352,7 @@ void faf_pause_arrow_tick(widget_t *arrow) {
     assert(opt);
 
     if (opt->idx == opt->info->idx) {
-        SDL_Surface *img = IMG_Load("assets/menus/RightArrow.png");
+        SDL_Surface *img = assets_get_surface("assets/menus/RightArrow.png");
         widget_set_surface(arrow, img);
     }
     else {
@@ -355,11 +361,11 @@ void faf_pause_arrow_tick(widget_t *arrow) {
 }
 
 
-hud_t *faf_make_pause_hud(hud_t *old_hud, list_t *old_handlers) {
+hud_t *faf_make_pause_hud(hud_t *old_hud, key_handlers_t *old_handlers) {
     assert(old_hud);
     assert(old_handlers);
 
-    pause_info_t *info = malloc(sizeof(pause_info_t));
+    pause_info_t *info = alloc_malloc(ALLOC_TAG_GAME, sizeof(pause_info_t));
     info->idx = 1;
     info->old_hud = old_hud;
     info->old_handlers = old_handlers;
@@ -367,7 +373,7 @@ hud_t *faf_make_pause_hud(hud_t *old_hud, list_t *old_handlers) {
     hud_t *hud = hud_init(info, free);
 
     // Add background
-    SDL_Surface *bgound_img = IMG_Load("assets/menus/BlueGray.jpg");
+    SDL_Surface *bgound_img = assets_get_surface("assets/menus/BlueGray.jpg");
     assert(bgound_img);
     SDL_Rect bgound_rect = {.x = (int)(FAF_WINDOW_DIMENSIONS.x / 2.),
                             .y = (int)(FAF_WINDOW_DIMENSIONS.y / 2.),
@@ -376,7 +382,7 @@ hud_t *faf_make_pause_hud(hud_t *old_hud, list_t *old_handlers) {
     hud_add_widget(hud, bgound);
 
     // Add title
-    TTF_Font *font = TTF_OpenFont("assets/fonts/Freedom.ttf", FAF_FONT_XLARGE);
+    TTF_Font *font = assets_open_font("assets/fonts/Freedom.ttf", FAF_FONT_XLARGE);
     assert(font);
     SDL_Surface *message = TTF_RenderText_Solid(font, "Paused", FAF_DARKRED_C);
     assert(message);
@@ -388,7 +394,7 @@ hud_t *faf_make_pause_hud(hud_t *old_hud, list_t *old_handlers) {
     TTF_CloseFont(font);
 
     // Add options
-    font = TTF_OpenFont("assets/fonts/Freedom.ttf", FAF_FONT_LARGE);
+    font = assets_open_font("assets/fonts/Freedom.ttf", FAF_FONT_LARGE);
     assert(font);
     message = TTF_RenderText_Solid(font, "Resume", FAF_WHITE_C);
     assert(message);
@@ -407,7 +413,7 @@ hud_t *faf_make_pause_hud(hud_t *old_hud, list_t *old_handlers) {
     TTF_CloseFont(font);
 
     // Add option arrows
-    pause_opt_t *opt = malloc(sizeof(pause_opt_t));
+    pause_opt_t *opt = alloc_malloc(ALLOC_TAG_GAME, sizeof(pause_opt_t));
     assert(opt);
     opt->idx = 1;
     opt->info = info;
@@ -416,7 +422,7 @@ hud_t *faf_make_pause_hud(hud_t *old_hud, list_t *old_handlers) {
                            .w = 40, .h = 40};
     widget_t *arrow = widget_init(NULL, arrow_rect, 0, faf_pause_arrow_tick, opt, free);
     hud_add_widget(hud, arrow);
-    opt = malloc(sizeof(pause_opt_t));
+    opt = alloc_malloc(ALLOC_TAG_GAME, sizeof(pause_opt_t));
     assert(opt);
     opt->idx = 2;
     opt->info = info;
@@ -449,10 +455,10 @@ void faf_pause_on_key(char key, key_event_type_t type, double held_time, window_
                 window_set_key_handlers(window, info->old_handlers);
                 window_set_hud(window, info->old_hud);
                 scene_resume(window_get_scene(window));
-                faf_audio_set_volume(2, 25);
+                faf_audio_set_volume(CAR_SOUND_CHANNEL, CAR_SOUND_VOLUME);
             }
             else {
-                list_free(info->old_handlers);
+                window_free_key_handlers(info->old_handlers);
                 hud_free(info->old_hud);
                 window_clear_key_handlers(window);
                 window_set_hud(window, faf_make_main_menu_hud());
@@ -460,6 +466,7 @@ void faf_pause_on_key(char key, key_event_type_t type, double held_time, window_
                 window_clear_scene(window);
                 list_free(CARS_LIST);
                 CARS_LIST = NULL;
+                STANDINGS = NULL;
                 faf_audio_end_race();
             }
             break;
@@ -483,11 +490,12 @@ void faf_car_check_race_over(body_t *car, void *dt) {
         window_clear_scene(window);
         list_free(CARS_LIST);
         CARS_LIST = NULL;
+        STANDINGS = NULL;
         return;
     }
 
     double pos = body_get_centroid(car).y;
-    if (pos > FAF_TRACK_LEN) {
+    if (pos > faf_car_get_finish_y(car)) {
         window_clear_key_handlers(window);
         window_set_hud(window, faf_make_race_over_hud(CURR_LEVEL, faf_car_get_time(car)));
         window_add_key_handler(window, (key_handler_t)faf_end_of_race_hud_on_key, window, NULL);
@@ -495,6 +503,7 @@ void faf_car_check_race_over(body_t *car, void *dt) {
         window_clear_scene(window);
         list_free(CARS_LIST);
         CARS_LIST = NULL;
+        STANDINGS = NULL;
     }
 }
 
@@ -508,48 +517,51 @@ void faf_race_on_key(char key, key_event_type_t type, double held_time, window_t
         window_clear_key_handlers_no_free(window);
         window_set_hud_no_free(window, pause_hud);
         window_add_key_handler(window, (key_handler_t)faf_pause_on_key, window, NULL);
-        faf_audio_set_volume(2, 0);
+        faf_audio_set_volume(CAR_SOUND_CHANNEL, 0);
+    }
+    else if (key == FAF_PROFILER_KEY) {
+        faf_hud_toggle_profiler();
     }
 }
 
 
-void faf_setup_race(window_t *window, faf_level_t level_type, faf_car_t player_car_type) {
+// The seed decides the AI cars and their choices, so the same seed gives the same race. It only
+// decides the track when the level has no level file; a level file's track is the same every race
+void faf_setup_race(window_t *window, faf_level_t level_type, faf_car_t player_car_type, uint64_t seed) {
+    rng_t race_rng = rng_init(seed);
+    uint64_t car_seed = rng_next(&race_rng);
     window_clear_key_handlers(window);
     // Create the cars for the race
-    list_t *cars = list_init(FAF_NUM_CARS, NULL);
+    list_t *cars = list_init(NUM_CARS, NULL);
     CARS_LIST = cars;
-    list_t *ai_colliders = list_init(FAF_NUM_CARS - 1, NULL);
     body_t *player_car = faf_make_car(player_car_type, true, -RACE_START_DELAY);
     body_t *player_indicator = faf_make_player_indicator(player_car);
     body_register_tick_func(player_car, (body_func_t)faf_car_check_race_over);
     faf_car_set_window(player_car, window);
     list_add(cars, player_car);
-    for (size_t i = 0; i < FAF_NUM_CARS - 1; i++) {
+    for (size_t i = 0; i < NUM_CARS - 1; i++) {
         faf_car_t ai_type = player_car_type;
         while (ai_type == player_car_type) {
-            int random_type = (int)mathlib_rand_in_range(0, NUM_CAR_TYPES);
-            ai_type = CAR_TYPES[random_type];
+            ai_type = CAR_TYPES[rng_index(&race_rng, NUM_CAR_TYPES)];
         }
         body_t *ai_car = faf_make_car(ai_type, false, -RACE_START_DELAY);
-        body_t *ai_collider = faf_make_ai_car_collider(ai_car);
+        faf_car_set_rng(ai_car, rng_init_stream(car_seed, i));
         list_add(cars, ai_car);
-        list_add(ai_colliders, ai_collider);
     }
 
     // Make the race scene
-    scene_t *scene = faf_make_level(level_type, cars, ai_colliders);
+    scene_t *scene = faf_make_level_from_file(FAF_LEVEL_FILES[level_type], level_type, cars);
+    if (!scene) {
+        scene = faf_make_level(level_type, rng_next(&race_rng), FAF_TRACK_LEN, cars);
+    }
 
     // Position the cars and add them to the scene
-    double step = faf_get_road_width() / (FAF_NUM_CARS + 1);
     for (size_t i = 0; i < list_size(cars); i++) {
-        vector_t car_start_loc = {.x = 150 + (step * (i + 1)), .y = FAF_WINDOW_DIMENSIONS.y / 2.};
-        body_set_centroid(list_get(cars, i), car_start_loc);
+        body_set_centroid(list_get(cars, i), faf_get_grid_position(i, list_size(cars)));
         scene_add_body_in_layer(scene, list_get(cars, i), FAF_OBJECT_LAYER);
     }
-
-    for (size_t i = 0; i < list_size(ai_colliders); i++) {
-        scene_add_body_in_layer(scene, list_get(ai_colliders, i), FAF_HIDDEN_LAYER);
-    }
+    STANDINGS = faf_standings_init(cars);
+    faf_standings_add_to_scene(scene, STANDINGS);
 
     scene_add_body_in_layer(scene, player_indicator, FAF_CAR_LAYER);
 
@@ -561,10 +573,8 @@ void faf_setup_race(window_t *window, faf_level_t level_type, faf_car_t player_c
     window_add_key_handler(window, (key_handler_t)faf_race_on_key, window, NULL);
 
     // Create the HUD for the race
-    hud_t *hud = faf_make_race_hud(cars);
+    hud_t *hud = faf_make_race_hud(cars, STANDINGS);
     window_set_hud(window, hud);
-    
-    list_free(ai_colliders);
 
     // Start race sounds
     faf_audio_start_race();
@@ -575,7 +585,7 @@ hud_t *faf_make_loading_hud() {
     hud_t *loading_hud = hud_init(NULL, NULL);
 
     // Add background
-    SDL_Surface *bgound_img = IMG_Load(LOADING_BGOUND_PATH);
+    SDL_Surface *bgound_img = assets_get_surface(LOADING_BGOUND_PATH);
     assert(bgound_img);
     SDL_Rect bgound_rect = {.x = (int)(FAF_WINDOW_DIMENSIONS.x / 2.),
                             .y = (int)(FAF_WINDOW_DIMENSIONS.y / 2.),
@@ -584,7 +594,7 @@ hud_t *faf_make_loading_hud() {
     hud_add_widget(loading_hud, bgound);
 
     // Add loading text
-    TTF_Font *font = TTF_OpenFont("assets/fonts/Freedom.ttf", FAF_FONT_XXXL);
+    TTF_Font *font = assets_open_font("assets/fonts/Freedom.ttf", FAF_FONT_XXXL);
     assert(font);
     SDL_Surface *message = TTF_RenderText_Solid(font, FAF_LOADING_TEXT, FAF_RED_C);
     assert(message);
@@ -603,7 +613,7 @@ hud_t *faf_make_instructions_hud(faf_menu_info_t *info) {
     hud_t *hud = hud_init(info, NULL);
 
     // Add background
-    SDL_Surface *bgound_img = IMG_Load("assets/menus/InstructionScreen.png");
+    SDL_Surface *bgound_img = assets_get_surface("assets/menus/InstructionScreen.png");
     assert(bgound_img);
     SDL_Rect bgound_rect = {.x = (int)(FAF_WINDOW_DIMENSIONS.x / 2.),
                             .y = (int)(FAF_WINDOW_DIMENSIONS.y / 2.),
@@ -627,8 +637,8 @@ void faf_instructions_on_key(char key, key_event_type_t type, double held_time,
     window_clear_key_handlers(window);
     window_set_hud(window, faf_make_loading_hud());
     sdl_render_window(window);
-    faf_setup_race(window, info->level, info->car);
-    free(info);
+    faf_setup_race(window, info->level, info->car, (uint64_t)time(NULL));
+    alloc_free(ALLOC_TAG_GAME, info);
 }
 
 
@@ -638,7 +648,7 @@ void faf_ds_arrow_tick(widget_t *arrow) {
     assert(opt);
 
     if (opt->idx == opt->parent_info->curr_opt_idx) {
-        SDL_Surface *img = IMG_Load("assets/menus/RightArrow.png");
+        SDL_Surface *img = assets_get_surface("assets/menus/RightArrow.png");
         widget_set_surface(arrow, img);
     }
     else {
@@ -655,7 +665,7 @@ hud_t *faf_make_diff_sel_hud(faf_menu_info_t *info) {
     hud_t *hud = hud_init(info, NULL);
 
     // Add background
-    SDL_Surface *bgound_img = IMG_Load("assets/menus/MenuBackground.png");
+    SDL_Surface *bgound_img = assets_get_surface("assets/menus/MenuBackground.png");
     assert(bgound_img);
     SDL_Rect bgound_rect = {.x = (int)(FAF_WINDOW_DIMENSIONS.x / 2.),
                             .y = (int)(FAF_WINDOW_DIMENSIONS.y / 2.),
@@ -664,7 +674,7 @@ hud_t *faf_make_diff_sel_hud(faf_menu_info_t *info) {
     hud_add_widget(hud, bgound);
 
     // Add title
-    TTF_Font *font = TTF_OpenFont("assets/fonts/Freedom.ttf", FAF_FONT_XXL);
+    TTF_Font *font = assets_open_font("assets/fonts/Freedom.ttf", FAF_FONT_XXL);
     assert(font);
     SDL_Surface *message = TTF_RenderText_Solid(font, FAF_DIFFICULTY_SELECT, FAF_BLACK_C);
     assert(message);
@@ -692,7 +702,7 @@ hud_t *faf_make_diff_sel_hud(faf_menu_info_t *info) {
             arr_ofs = 125;
         }
 
-        font = TTF_OpenFont("assets/fonts/Freedom.ttf", FAF_FONT_XXL);
+        font = assets_open_font("assets/fonts/Freedom.ttf", FAF_FONT_XXL);
         assert(font);
         message = TTF_RenderText_Solid(font, DIFFICULTY_DESCRIPTIONS[i - 1], c);
         assert(message);
@@ -703,7 +713,7 @@ hud_t *faf_make_diff_sel_hud(faf_menu_info_t *info) {
         hud_add_widget(hud, diff_txt);
         TTF_CloseFont(font);
 
-        faf_menu_opt_t *opt = malloc(sizeof(faf_menu_opt_t));
+        faf_menu_opt_t *opt = alloc_malloc(ALLOC_TAG_GAME, sizeof(faf_menu_opt_t));
         assert(opt);
         opt->idx = i;
         opt->parent_info = info;
@@ -755,7 +765,7 @@ void faf_left_arrow_tick(widget_t *arrow) {
     assert(info);
 
     if (info->curr_opt_idx > 1) {
-        widget_set_surface(arrow, IMG_Load("assets/menus/LeftArrow.png"));
+        widget_set_surface(arrow, assets_get_surface("assets/menus/LeftArrow.png"));
     }
     else {
         widget_set_surface(arrow, NULL);
@@ -769,7 +779,7 @@ void faf_right_arrow_tick(widget_t *arrow) {
     assert(info);
 
     if (info->curr_opt_idx < info->max_opt_idx) {
-        widget_set_surface(arrow, IMG_Load("assets/menus/RightArrow.png"));
+        widget_set_surface(arrow, assets_get_surface("assets/menus/RightArrow.png"));
     }
     else {
         widget_set_surface(arrow, NULL);
@@ -783,7 +793,7 @@ void faf_car_preview_tick(widget_t *preview) {
     assert(info);
 
     const char *path = CAR_PREVIEWS[info->curr_opt_idx - 1];
-    widget_set_surface(preview, IMG_Load(path));
+    widget_set_surface(preview, assets_get_surface(path));
 }
 
 
@@ -793,7 +803,7 @@ void faf_car_description_tick(widget_t *description) {
     assert(info);
 
     const char *desc = CAR_NAMES[info->curr_opt_idx - 1];
-    TTF_Font *font = TTF_OpenFont("assets/fonts/Sansation-Bold.ttf", FAF_FONT_XLARGE);
+    TTF_Font *font = assets_open_font("assets/fonts/Sansation-Bold.ttf", FAF_FONT_XLARGE);
     assert(font);
     SDL_Surface *message = TTF_RenderText_Solid(font, desc, FAF_BLACK_C);
     widget_set_surface(description, message);
@@ -817,7 +827,7 @@ void faf_power_star_tick(widget_t *star) {
 
     size_t power = CAR_POWERS[parent_info->curr_opt_idx - 1];
     if (power >= info->idx) {
-        widget_set_surface(star, IMG_Load("assets/menus/Star.png"));
+        widget_set_surface(star, assets_get_surface("assets/menus/Star.png"));
     }
     else {
         widget_set_surface(star, NULL);
@@ -833,7 +843,7 @@ void faf_handling_star_tick(widget_t *star) {
 
     size_t handling = CAR_HANDLINGS[parent_info->curr_opt_idx - 1];
     if (handling >= info->idx) {
-        widget_set_surface(star, IMG_Load("assets/menus/Star.png"));
+        widget_set_surface(star, assets_get_surface("assets/menus/Star.png"));
     }
     else {
         widget_set_surface(star, NULL);
@@ -849,7 +859,7 @@ void faf_efficiency_star_tick(widget_t *star) {
 
     size_t efficiency = CAR_EFFICIENCIES[parent_info->curr_opt_idx - 1];
     if (efficiency >= info->idx) {
-        widget_set_surface(star, IMG_Load("assets/menus/Star.png"));
+        widget_set_surface(star, assets_get_surface("assets/menus/Star.png"));
     }
     else {
         widget_set_surface(star, NULL);
@@ -864,7 +874,7 @@ hud_t *faf_make_car_select_hud(faf_menu_info_t *info) {
     hud_t *hud = hud_init(info, NULL);
 
     // Add background
-    SDL_Surface *bgound_img = IMG_Load("assets/menus/MenuBackground.png");
+    SDL_Surface *bgound_img = assets_get_surface("assets/menus/MenuBackground.png");
     assert(bgound_img);
     SDL_Rect bgound_rect = {.x = (int)(FAF_WINDOW_DIMENSIONS.x / 2.),
                             .y = (int)(FAF_WINDOW_DIMENSIONS.y / 2.),
@@ -899,7 +909,7 @@ hud_t *faf_make_car_select_hud(faf_menu_info_t *info) {
     hud_add_widget(hud, description);
 
     // Add title
-    TTF_Font *font = TTF_OpenFont("assets/fonts/Freedom.ttf", FAF_FONT_XXL);
+    TTF_Font *font = assets_open_font("assets/fonts/Freedom.ttf", FAF_FONT_XXL);
     assert(font);
     SDL_Surface *message = TTF_RenderText_Solid(font, FAF_CAR_SELECT, FAF_BLACK_C);
     assert(message);
@@ -911,7 +921,7 @@ hud_t *faf_make_car_select_hud(faf_menu_info_t *info) {
     TTF_CloseFont(font);
 
     // Add power description
-    font = TTF_OpenFont("assets/fonts/Freedom.ttf", FAF_FONT_LARGE);
+    font = assets_open_font("assets/fonts/Freedom.ttf", FAF_FONT_LARGE);
     assert(font);
     message = TTF_RenderText_Solid(font, CAR_POWER, FAF_DARKRED_C);
     assert(message);
@@ -922,7 +932,7 @@ hud_t *faf_make_car_select_hud(faf_menu_info_t *info) {
     hud_add_widget(hud, power);
     TTF_CloseFont(font);
     for (size_t i = 1; i <= 5; i++) {
-        faf_menu_opt_t *star_info = malloc(sizeof(faf_menu_opt_t));
+        faf_menu_opt_t *star_info = alloc_malloc(ALLOC_TAG_GAME, sizeof(faf_menu_opt_t));
         assert(star_info);
         star_info->idx = i;
         star_info->parent_info = info;
@@ -934,7 +944,7 @@ hud_t *faf_make_car_select_hud(faf_menu_info_t *info) {
     }
 
     // Add handling description
-    font = TTF_OpenFont("assets/fonts/Freedom.ttf", FAF_FONT_LARGE);
+    font = assets_open_font("assets/fonts/Freedom.ttf", FAF_FONT_LARGE);
     assert(font);
     message = TTF_RenderText_Solid(font, CAR_HANDLING, FAF_DARKBLUE_C);
     assert(message);
@@ -945,7 +955,7 @@ hud_t *faf_make_car_select_hud(faf_menu_info_t *info) {
     hud_add_widget(hud, handling);
     TTF_CloseFont(font);
     for (size_t i = 1; i <= 5; i++) {
-        faf_menu_opt_t *star_info = malloc(sizeof(faf_menu_opt_t));
+        faf_menu_opt_t *star_info = alloc_malloc(ALLOC_TAG_GAME, sizeof(faf_menu_opt_t));
         assert(star_info);
         star_info->idx = i;
         star_info->parent_info = info;
@@ -957,7 +967,7 @@ hud_t *faf_make_car_select_hud(faf_menu_info_t *info) {
     }
 
     // Add efficiency description
-    font = TTF_OpenFont("assets/fonts/Freedom.ttf", FAF_FONT_LARGE);
+    font = assets_open_font("assets/fonts/Freedom.ttf", FAF_FONT_LARGE);
     assert(font);
     message = TTF_RenderText_Solid(font, CAR_EFFICIENCY, FAF_GREEN_C);
     assert(message);
@@ -968,7 +978,7 @@ hud_t *faf_make_car_select_hud(faf_menu_info_t *info) {
     hud_add_widget(hud, efficiency);
     TTF_CloseFont(font);
      for (size_t i = 1; i <= 5; i++) {
-        faf_menu_opt_t *star_info = malloc(sizeof(faf_menu_opt_t));
+        faf_menu_opt_t *star_info = alloc_malloc(ALLOC_TAG_GAME, sizeof(faf_menu_opt_t));
         assert(star_info);
         star_info->idx = i;
         star_info->parent_info = info;
@@ -1022,7 +1032,7 @@ void faf_level_preview_tick(widget_t *preview) {
     assert(info);
 
     const char *path = LEVEL_PREVIEWS[info->curr_opt_idx - 1];
-    widget_set_surface(preview, IMG_Load(path));
+    widget_set_surface(preview, assets_get_surface(path));
 }
 
 
@@ -1032,7 +1042,7 @@ void faf_level_description_tick(widget_t *description) {
     assert(info);
 
     const char *desc = LEVEL_DESCRIPTIONS[info->curr_opt_idx - 1];
-    TTF_Font *font = TTF_OpenFont("assets/fonts/Freedom.ttf", FAF_FONT_XLARGE);
+    TTF_Font *font = assets_open_font("assets/fonts/Freedom.ttf", FAF_FONT_XLARGE);
     assert(font);
     SDL_Surface *message = TTF_RenderText_Solid(font, desc, FAF_BLACK_C);
     widget_set_surface(description, message);
@@ -1054,7 +1064,7 @@ hud_t *faf_make_level_select_hud(faf_menu_info_t *info) {
     hud_t *hud = hud_init(info, NULL);
 
     // Add background
-    SDL_Surface *bgound_img = IMG_Load("assets/menus/MenuBackground.png");
+    SDL_Surface *bgound_img = assets_get_surface("assets/menus/MenuBackground.png");
     assert(bgound_img);
     SDL_Rect bgound_rect = {.x = (int)(FAF_WINDOW_DIMENSIONS.x / 2.),
                             .y = (int)(FAF_WINDOW_DIMENSIONS.y / 2.),
@@ -1089,7 +1099,7 @@ hud_t *faf_make_level_select_hud(faf_menu_info_t *info) {
     hud_add_widget(hud, description);
 
     // Add title
-    TTF_Font *font = TTF_OpenFont("assets/fonts/Freedom.ttf", FAF_FONT_XXL);
+    TTF_Font *font = assets_open_font("assets/fonts/Freedom.ttf", FAF_FONT_XXL);
     assert(font);
     SDL_Surface *message = TTF_RenderText_Solid(font, FAF_TRACK_SELECT, FAF_BLACK_C);
     assert(message);
@@ -1143,10 +1153,10 @@ void faf_menu_opt_tick(widget_t *wid) {
     assert(info);
 
     if (info->parent_info->curr_opt_idx == info->idx) {
-        widget_set_surface(wid, IMG_Load("assets/menus/DarkRed.png"));
+        widget_set_surface(wid, assets_get_surface("assets/menus/DarkRed.png"));
     }
     else {
-        widget_set_surface(wid, IMG_Load("assets/menus/Gray.png"));
+        widget_set_surface(wid, assets_get_surface("assets/menus/Gray.png"));
     }
 }
 
@@ -1187,7 +1197,7 @@ void faf_leaderboard_on_key(char key, key_event_type_t type, double held_time, w
 
 
 hud_t *faf_make_main_menu_hud() {
-    faf_menu_info_t *info = malloc(sizeof(faf_menu_info_t));
+    faf_menu_info_t *info = alloc_malloc(ALLOC_TAG_GAME, sizeof(faf_menu_info_t));
     assert(info);
     info->curr_opt_idx = 1;
     info->max_opt_idx = MAIN_MENU_NUM_OPTIONS;
@@ -1195,7 +1205,7 @@ hud_t *faf_make_main_menu_hud() {
     info->car = LAMBORGHINI_HURACAN_EVO_SPYDER;
     hud_t *hud = hud_init(info, NULL);
 
-    SDL_Surface *bgound_img = IMG_Load(MAIN_BGOUND_PATH);
+    SDL_Surface *bgound_img = assets_get_surface(MAIN_BGOUND_PATH);
     assert(bgound_img);
     SDL_Rect bgound_rect = {.x = (int)(FAF_WINDOW_DIMENSIONS.x / 2.),
                             .y = (int)(FAF_WINDOW_DIMENSIONS.y / 2.),
@@ -1203,13 +1213,13 @@ hud_t *faf_make_main_menu_hud() {
     widget_t *bgound = widget_init(bgound_img, bgound_rect, 0, NULL, NULL, NULL);
     hud_add_widget(hud, bgound);
 
-    faf_menu_opt_t *opt_info = malloc(sizeof(faf_menu_opt_t));
+    faf_menu_opt_t *opt_info = alloc_malloc(ALLOC_TAG_GAME, sizeof(faf_menu_opt_t));
     opt_info->idx = 1;
     opt_info->parent_info = info;
     SDL_Rect bg_rect = {.x = 500, .y = 250, .w = (int)FAF_MENU_OPTION_DIMS.x, .h = (int)FAF_MENU_OPTION_DIMS.y};
     widget_t *bg = widget_init(NULL, bg_rect, 0, faf_menu_opt_tick, opt_info, free);
     hud_add_widget(hud, bg);
-    TTF_Font *font = TTF_OpenFont("assets/fonts/Freedom.ttf", FAF_FONT_LARGE);
+    TTF_Font *font = assets_open_font("assets/fonts/Freedom.ttf", FAF_FONT_LARGE);
     assert(font);
     SDL_Surface *message = TTF_RenderText_Solid(font, FAF_START_RACE, FAF_WHITE_C);
     assert(message);
@@ -1221,13 +1231,13 @@ hud_t *faf_make_main_menu_hud() {
     TTF_CloseFont(font);
 
     /*
-    opt_info = malloc(sizeof(faf_menu_opt_t));
+    opt_info = alloc_malloc(ALLOC_TAG_GAME, sizeof(faf_menu_opt_t));
     opt_info->idx = 2;
     opt_info->parent_info = info;
     bg_rect = (SDL_Rect) {.x = 500, .y = 150, .w = (int)FAF_MENU_OPTION_DIMS.x, .h = (int)FAF_MENU_OPTION_DIMS.y};
     bg = widget_init(NULL, bg_rect, 0, faf_menu_opt_tick, opt_info, free);
     hud_add_widget(hud, bg);
-    font = TTF_OpenFont("assets/fonts/Freedom.ttf", FAF_FONT_LARGE);
+    font = assets_open_font("assets/fonts/Freedom.ttf", FAF_FONT_LARGE);
     assert(font);
     message = TTF_RenderText_Solid(font, FAF_VIEW_LDBS, FAF_WHITE_C);
     assert(message);
@@ -1291,15 +1301,61 @@ void faf_set_difficulty(int difficulty) {
 }
 
 
+size_t faf_get_num_cars() {
+    return NUM_CARS;
+}
+
+
+void faf_set_num_cars(size_t num_cars) {
+    assert(num_cars > 0);
+
+    NUM_CARS = num_cars;
+}
+
+
+// Grows from the left edge of LOADING_BAR_RECT as the assets are loaded
+void faf_set_loading_bar(widget_t *bar, double progress) {
+    SDL_Rect rect = LOADING_BAR_RECT;
+    rect.w = (int)(LOADING_BAR_RECT.w * progress);
+    rect.x = LOADING_BAR_RECT.x - (LOADING_BAR_RECT.w - rect.w) / 2;
+    widget_set_rect(bar, rect);
+}
+
+
+widget_t *faf_make_loading_bar() {
+    SDL_Surface *fill = SDL_CreateRGBSurfaceWithFormat(0, 1, 1, 32, SDL_PIXELFORMAT_RGBA32);
+    assert(fill);
+    SDL_FillRect(fill, NULL, SDL_MapRGBA(fill->format, FAF_RED_C.r, FAF_RED_C.g, FAF_RED_C.b, FAF_RED_C.a));
+    widget_t *bar = widget_init(fill, LOADING_BAR_RECT, 0, NULL, NULL, NULL);
+    faf_set_loading_bar(bar, 0);
+    return bar;
+}
+
+
 window_t *faf_game_start() {
+    assets_open_pack(FAF_ASSETS_PACK);
     scene_t *loading_scene = scene_init(FAF_WINDOW_DIMENSIONS);
     hud_t *loading_hud = faf_make_loading_hud();
+    hud_add_widget(loading_hud, faf_make_loading_bar());
     window_t *window = window_init(loading_scene, VEC_ZERO, FAF_WINDOW_DIMENSIONS);
     window_set_hud(window, loading_hud);
-    sdl_render_window(window);
+    // Decoded on the worker threads while faf_game_load_step() draws the progress
+    assets_preload(FAF_ASSETS_DIR);
+
+    return window;
+}
+
+
+bool faf_game_load_step(window_t *window) {
+    bool loaded = assets_pump(LOADING_STEP_TIME);
+    hud_t *loading_hud = window_get_hud(window);
+    faf_set_loading_bar(hud_get_widget(loading_hud, hud_num_widgets(loading_hud) - 1), assets_progress());
+    if (!loaded) {
+        return false;
+    }
+
     faf_audio_init();
     window_set_hud(window, faf_make_main_menu_hud());
     window_add_key_handler(window, (key_handler_t)faf_mm_on_key, window, NULL);
-
-    return window;
+    return true;
 }
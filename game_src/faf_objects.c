@@ -1,12 +1,25 @@
+#include "alloc.h"
 #include "body.h"
 #include "color.h"
+#include "dynarray.h"
 #include "faf_levels.h"
 #include "faf_objects.h"
-#include "mathlib.h"
 #include "shape.h"
 #include <assert.h>
+#include <math.h>
+#include <stdint.h>
 
 const double OBJECT_DENSITY = 1.;
+// The space left between any two objects
+const double OBJECT_GAP = 10.;
+// At least the largest distance objects must keep: two obstacles' radii and the gap
+const double PLACEMENT_CELL_SIZE = 110.;
+// How many positions to try for one object before giving up on it
+const size_t PLACEMENT_MAX_ATTEMPTS = 30;
+const size_t PLACEMENT_NONE = SIZE_MAX;
+// Where objects may start on and off the road, leaving the starting grid clear
+const double ON_ROAD_START = 1000.;
+const double OFF_ROAD_START = 400.;
 
 const double DECORATION_RADIUS = 45.;
 const rgb_color_t DECORATION_COLOR = {.r = 0, .g = 1, .b = 0};
@@ -43,9 +56,11 @@ typedef struct faf_object_info {
     faf_effect_t effect_type;
 } faf_object_info_t;
 
-faf_object_info_t *make_info(faf_object_t type, faf_effect_t effect_type) {
-    faf_object_info_t *info = malloc(sizeof(faf_object_info_t));
-    assert(info);
+// Infos are never changed or freed, so every object of a kind shares one
+// and streamed chunks don't allocate any
+faf_object_info_t *object_info(faf_object_t type, faf_effect_t effect_type) {
+    static faf_object_info_t infos[FAF_OTHER_OBJ + 1][FAF_NULL + 1];
+    faf_object_info_t *info = &infos[type][effect_type];
     info->object_type = type;
     info->effect_type = effect_type;
     return info;
@@ -55,65 +70,220 @@ faf_effect_t faf_objects_get_effect_type(faf_object_info_t *info) {
     return info->effect_type;
 }
 
-vector_t generate_position_on_road(vector_t scene_dim, double road_width, double object_radius) {
-    double x = mathlib_rand_in_range((scene_dim.x - road_width) / 2 + object_radius,
-                                     road_width + (scene_dim.x - road_width) / 2 - object_radius);
-    double y = mathlib_rand_in_range(object_radius + 0.05 * scene_dim.y, scene_dim.y - object_radius);
-    return (vector_t){.x = x, .y = y};
+// Objects keep half the gap from the ends of their region, so objects
+// in neighbouring regions are kept apart as well
+bool generate_position_on_road(rng_t *rng, vector_t origin, vector_t dim, double road_width, double object_radius,
+                               vector_t *position) {
+    double min_y = fmax(origin.y, ON_ROAD_START) + object_radius + OBJECT_GAP / 2;
+    double max_y = origin.y + dim.y - object_radius - OBJECT_GAP / 2;
+    if (min_y > max_y) {
+        return false;
+    }
+    double x = rng_range(rng, origin.x + (dim.x - road_width) / 2 + object_radius,
+                                     origin.x + road_width + (dim.x - road_width) / 2 - object_radius);
+    double y = rng_range(rng, min_y, max_y);
+    *position = (vector_t){.x = x, .y = y};
+    return true;
 }
 
-vector_t generate_position_off_road(vector_t scene_dim, double road_width, double object_radius) {
-    double x = mathlib_rand_in_range(object_radius, scene_dim.x - object_radius);
+bool generate_position_off_road(rng_t *rng, vector_t origin, vector_t dim, double road_width, double object_radius,
+                                vector_t *position) {
+    double min_y = fmax(origin.y, OFF_ROAD_START) + object_radius + OBJECT_GAP / 2;
+    double max_y = origin.y + dim.y - object_radius - OBJECT_GAP / 2;
+    if (min_y > max_y) {
+        return false;
+    }
+    double x = rng_range(rng, object_radius, dim.x - object_radius);
     // Generate new x coordinate while it is not a valid postion (on the road)
-    while (x > (scene_dim.x - road_width) / 2 - object_radius &&
-           x < road_width + (scene_dim.x - road_width) / 2 + object_radius) {
-        x = mathlib_rand_in_range(object_radius, scene_dim.x - object_radius);
+    while (x > (dim.x - road_width) / 2 - object_radius &&
+           x < road_width + (dim.x - road_width) / 2 + object_radius) {
+        x = rng_range(rng, object_radius, dim.x - object_radius);
+    }
+    double y = rng_range(rng, min_y, max_y);
+    *position = (vector_t){.x = origin.x + x, .y = y};
+    return true;
+}
+
+typedef struct placement {
+    vector_t center;
+    double radius;
+    // The previous placement in the same cell, or PLACEMENT_NONE
+    size_t next;
+} placement_t;
+
+DYNARRAY_DEFINE(placement_array, placement_t, 1)
+
+typedef struct faf_placement {
+    // The region objects are placed in
+    vector_t origin;
+    vector_t dim;
+    size_t columns;
+    size_t rows;
+    // The latest placement in each cell, or PLACEMENT_NONE
+    size_t *cells;
+    placement_array_t placements;
+} faf_placement_t;
+
+faf_placement_t *faf_placement_init(vector_t origin, vector_t dim) {
+    faf_placement_t *placement = alloc_malloc(ALLOC_TAG_GAME, sizeof(faf_placement_t));
+    assert(placement);
+    placement->origin = origin;
+    placement->dim = dim;
+    placement->columns = (size_t)ceil(dim.x / PLACEMENT_CELL_SIZE);
+    placement->rows = (size_t)ceil(dim.y / PLACEMENT_CELL_SIZE);
+    size_t num_cells = placement->columns * placement->rows;
+    placement->cells = alloc_malloc(ALLOC_TAG_GAME, sizeof(size_t) * num_cells);
+    assert(placement->cells);
+    for (size_t i = 0; i < num_cells; i++) {
+        placement->cells[i] = PLACEMENT_NONE;
+    }
+    placement_array_init(&placement->placements);
+    return placement;
+}
+
+void faf_placement_free(faf_placement_t *placement) {
+    alloc_free(ALLOC_TAG_GAME, placement->cells);
+    placement_array_free(&placement->placements);
+    alloc_free(ALLOC_TAG_GAME, placement);
+}
+
+size_t placement_cell_index(double coord, size_t num_cells) {
+    if (coord <= 0) {
+        return 0;
+    }
+    size_t index = (size_t)(coord / PLACEMENT_CELL_SIZE);
+    return index < num_cells ? index : num_cells - 1;
+}
+
+// Checks the 3x3 cells around the center, which hold every object close enough to overlap
+bool placement_is_free(faf_placement_t *placement, vector_t center, double radius) {
+    size_t column = placement_cell_index(center.x - placement->origin.x, placement->columns);
+    size_t row = placement_cell_index(center.y - placement->origin.y, placement->rows);
+    for (size_t r = row > 0 ? row - 1 : 0; r <= row + 1 && r < placement->rows; r++) {
+        for (size_t c = column > 0 ? column - 1 : 0; c <= column + 1 && c < placement->columns; c++) {
+            size_t i = placement->cells[r * placement->columns + c];
+            while (i != PLACEMENT_NONE) {
+                placement_t *other = placement_array_get(&placement->placements, i);
+                if (vec_distance(center, other->center) < radius + other->radius + OBJECT_GAP) {
+                    return false;
+                }
+                i = other->next;
+            }
+        }
+    }
+    return true;
+}
+
+void placement_add(faf_placement_t *placement, vector_t center, double radius) {
+    size_t cell = placement_cell_index(center.y - placement->origin.y, placement->rows) * placement->columns +
+                  placement_cell_index(center.x - placement->origin.x, placement->columns);
+    placement_t added = {.center = center, .radius = radius, .next = placement->cells[cell]};
+    placement->cells[cell] = placement_array_size(&placement->placements);
+    placement_array_push(&placement->placements, added);
+}
+
+// Poisson-disk dart throwing: each candidate only meets the few objects in nearby cells,
+// so placing n objects takes O(n) time while the region is far from full
+bool object_position(faf_placement_t *placement, rng_t *rng, double road_width, double object_radius,
+                     position_generator_t position_generator, vector_t *center) {
+    assert(2 * object_radius + OBJECT_GAP <= PLACEMENT_CELL_SIZE);
+    for (size_t attempt = 0; attempt < PLACEMENT_MAX_ATTEMPTS; attempt++) {
+        if (!position_generator(rng, placement->origin, placement->dim, road_width, object_radius, center)) {
+            return false;
+        }
+        if (placement_is_free(placement, *center, object_radius)) {
+            placement_add(placement, *center, object_radius);
+            return true;
+        }
     }
-    double y = mathlib_rand_in_range(object_radius + 0.02 * scene_dim.y, scene_dim.y - object_radius);
-    return (vector_t){.x = x, .y = y};
-}
-
-vector_t object_position(vector_t scene_dim, double road_width, double object_radius, list_t *list,
-                         position_generator_t position_generator) {
-    vector_t center = position_generator(scene_dim, road_width, object_radius);
-    // Create a reference body
-    body_t *ref_body = shape_init_circle(object_radius, (rgb_color_t){.r = 0, .g = 0, .b = 0},
-                                         OBJECT_DENSITY, NULL, NULL);
-    body_set_centroid(ref_body, center);
-    for (size_t i = 0; i < list_size(list); i++) {
-        body_t *body = list_get(list, i);
-        // Generate new position if there is an overlap
-        if (body_are_overlapping(body, ref_body)) {
-            center = position_generator(scene_dim, road_width, object_radius);
-            body_set_centroid(ref_body, center);
-            i = 0;
+    return false;
+}
+
+void place_item(faf_placement_t *placement, faf_object_records_t *objects, rng_t *rng, double road_width,
+                double obj_radius, size_t sprite, faf_object_t obj_type, faf_effect_t effect_type,
+                position_generator_t position_generator) {
+    vector_t center;
+    // Leave the object out if its part of the region is already full
+    if (!object_position(placement, rng, road_width, obj_radius, position_generator, &center)) {
+        return;
+    }
+    faf_object_record_t record = {.x = (float)center.x, .y = (float)center.y, .object_type = (uint8_t)obj_type,
+                                  .effect_type = (uint8_t)effect_type, .sprite = (uint8_t)sprite};
+    faf_object_records_push(objects, record);
+}
+
+bool faf_object_record_is_valid(const faf_object_record_t *record) {
+    if (!isfinite(record->x) || !isfinite(record->y)) {
+        return false;
+    }
+    switch (record->object_type) {
+        case FAF_DECORATION_OBJ: {
+            return record->sprite < DECORATIONS && record->effect_type == FAF_NULL;
+        }
+        case FAF_EFFECT_OBJ: {
+            return record->sprite < EFFECTS && record->effect_type < FAF_NULL;
+        }
+        case FAF_GAS_OBJ: {
+            return record->sprite == 0 && record->effect_type == FAF_NULL;
+        }
+        case FAF_OBSTACLE_OBJ: {
+            return record->sprite < OBSTACLES && record->effect_type == FAF_NULL;
+        }
+        default: {
+            return false;
         }
     }
-    body_free(ref_body);
-    return center;
 }
 
-void spawn_and_register_item(scene_t *scene, vector_t scene_dim, list_t *list,
-                             double road_width, double obj_radius, const char *filename,
-                             faf_object_t obj_type, faf_effect_t effect_type,
-                             position_generator_t position_generator, rgb_color_t obj_color) {
-    faf_object_info_t *info = make_info(obj_type, effect_type);
-    body_t *item = shape_init_circle_with_sprite(obj_radius, obj_color, OBJECT_DENSITY,
-                                                 info, (free_func_t)free, filename,
-                                                 (vector_t){.x = obj_radius * 2, .y = obj_radius * 2});
-    vector_t center = object_position(scene_dim, road_width, obj_radius, list, position_generator);
-    body_set_centroid(item, center);
-    list_add(list, item);
-    scene_add_body_in_layer(scene, item, FAF_OBJECT_LAYER);
+body_t *faf_object_init(const faf_object_record_t *record) {
+    assert(faf_object_record_is_valid(record));
+
+    double radius;
+    rgb_color_t color;
+    const char *filename;
+    switch (record->object_type) {
+        case FAF_DECORATION_OBJ: {
+            radius = DECORATION_RADIUS;
+            color = DECORATION_COLOR;
+            filename = DECORATION_OPTIONS[record->sprite];
+            break;
+        }
+        case FAF_EFFECT_OBJ: {
+            radius = EFFECT_RADIUS;
+            color = EFFECT_COLOR;
+            filename = EFFECTS_OPTIONS[record->sprite];
+            break;
+        }
+        case FAF_GAS_OBJ: {
+            radius = GAS_RADIUS;
+            color = GAS_COLOR;
+            filename = "assets/object/gas.png";
+            break;
+        }
+        case FAF_OBSTACLE_OBJ: {
+            radius = OBSTACLE_RADIUS;
+            color = OBSTACLE_COLOR;
+            filename = OBSTACLE_OPTIONS[record->sprite];
+            break;
+        }
+        default: {
+            return NULL;
+        }
+    }
+    faf_object_info_t *info = object_info(record->object_type, record->effect_type);
+    body_t *item = shape_init_circle_with_sprite(radius, color, OBJECT_DENSITY, info, NULL, filename,
+                                                 (vector_t){.x = radius * 2, .y = radius * 2});
+    body_set_centroid(item, (vector_t){.x = record->x, .y = record->y});
+    return item;
 }
 
-void faf_object_spawn_decorations(scene_t *scene, vector_t scene_dim, list_t *collision_bodies,
+void faf_object_spawn_decorations(faf_placement_t *placement, faf_object_records_t *objects, rng_t *rng,
                                   double road_width, size_t num_decorations, faf_level_t level) {
     for (size_t i = 0; i < num_decorations; i++) {
-        int idx;
+        int idx = 0;
         switch (level) {
             case DESERT_LEVEL: {
-                idx = (int)mathlib_rand_in_range(0, 3 - 1e-4);
+                idx = (int)rng_index(rng, 3);
                 break;
             }
             case ICE_LEVEL: {
@@ -129,17 +299,15 @@ void faf_object_spawn_decorations(scene_t *scene, vector_t scene_dim, list_t *co
             }
             
         }
-        spawn_and_register_item(scene, scene_dim, collision_bodies, road_width, DECORATION_RADIUS,
-                                DECORATION_OPTIONS[idx], FAF_DECORATION_OBJ, FAF_NULL,
-                                generate_position_off_road, DECORATION_COLOR);
+        place_item(placement, objects, rng, road_width, DECORATION_RADIUS, idx, FAF_DECORATION_OBJ, FAF_NULL,
+                   generate_position_off_road);
     }
 }
 
-void faf_object_spawn_effects(scene_t *scene, vector_t scene_dim, list_t *collision_bodies,
+void faf_object_spawn_effects(faf_placement_t *placement, faf_object_records_t *objects, rng_t *rng,
                               double road_width, size_t num_effects) {
     for (size_t i = 0; i < num_effects; i++) {
-        int idx = (int)mathlib_rand_in_range(0, EFFECTS);
-        const char *option = EFFECTS_OPTIONS[idx];
+        int idx = (int)rng_index(rng, EFFECTS);
         faf_effect_t effect;
         switch (idx) {
             case 0: {
@@ -171,24 +339,23 @@ void faf_object_spawn_effects(scene_t *scene, vector_t scene_dim, list_t *collis
                 break;
             }
         }
-        spawn_and_register_item(scene, scene_dim, collision_bodies, road_width, EFFECT_RADIUS, option,
-                                FAF_EFFECT_OBJ, effect, generate_position_on_road, EFFECT_COLOR);
+        place_item(placement, objects, rng, road_width, EFFECT_RADIUS, idx, FAF_EFFECT_OBJ, effect,
+                   generate_position_on_road);
     }
 }
 
-void faf_object_spawn_gas(scene_t *scene, vector_t scene_dim, list_t *collision_bodies,
+void faf_object_spawn_gas(faf_placement_t *placement, faf_object_records_t *objects, rng_t *rng,
                           double road_width, size_t num_gas) {
     for (size_t i = 0; i < num_gas; i++) {
-        spawn_and_register_item(scene, scene_dim, collision_bodies, road_width, GAS_RADIUS,
-                                "assets/object/gas.png", FAF_GAS_OBJ, FAF_NULL,
-                                generate_position_on_road, GAS_COLOR);
+        place_item(placement, objects, rng, road_width, GAS_RADIUS, 0, FAF_GAS_OBJ, FAF_NULL,
+                   generate_position_on_road);
     }
 }
 
-void faf_object_spawn_obstacles(scene_t *scene, vector_t scene_dim, list_t *collision_bodies,
+void faf_object_spawn_obstacles(faf_placement_t *placement, faf_object_records_t *objects, rng_t *rng,
                                 double road_width, size_t num_obstacles, faf_level_t level) {
     for (size_t i = 0; i < num_obstacles; i++) {
-        int idx;
+        int idx = 0;
         switch (level) {
             case DESERT_LEVEL: {
                 idx = 0;
@@ -199,14 +366,14 @@ void faf_object_spawn_obstacles(scene_t *scene, vector_t scene_dim, list_t *coll
                 break;
             }
             case FOREST_LEVEL: {
-                idx = (int)mathlib_rand_in_range(2, OBSTACLES - 1e-4);
+                idx = 2 + (int)rng_index(rng, OBSTACLES - 2);
                 break;
             }
             default: {
                 break;
             }
         }
-        spawn_and_register_item(scene, scene_dim, collision_bodies, road_width, OBSTACLE_RADIUS, OBSTACLE_OPTIONS[idx],
-                                FAF_OBSTACLE_OBJ, FAF_NULL, generate_position_on_road, OBSTACLE_COLOR);
+        place_item(placement, objects, rng, road_width, OBSTACLE_RADIUS, idx, FAF_OBSTACLE_OBJ, FAF_NULL,
+                   generate_position_on_road);
     }
 }
\ No newline at end of file
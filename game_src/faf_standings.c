@@ -0,0 +1,132 @@
+#include "faf_standings.h"
+#include "alloc.h"
+#include "body.h"
+#include <assert.h>
+
+
+typedef struct faf_standings {
+    size_t num_cars;
+    body_handle_t *cars;
+    // How far along the track each car was at the last update, by car
+    double *progress;
+    // The cars from the leader back
+    size_t *order;
+    // Each car's index in order
+    size_t *ranks;
+} faf_standings_t;
+
+
+faf_standings_t *faf_standings_init(list_t *cars) {
+    assert(cars);
+
+    faf_standings_t *standings = alloc_malloc(ALLOC_TAG_GAME, sizeof(faf_standings_t));
+    assert(standings);
+    size_t num_cars = list_size(cars);
+    standings->num_cars = num_cars;
+    standings->cars = alloc_malloc(ALLOC_TAG_GAME, sizeof(body_handle_t) * num_cars);
+    standings->progress = alloc_malloc(ALLOC_TAG_GAME, sizeof(double) * num_cars);
+    standings->order = alloc_malloc(ALLOC_TAG_GAME, sizeof(size_t) * num_cars);
+    standings->ranks = alloc_malloc(ALLOC_TAG_GAME, sizeof(size_t) * num_cars);
+    assert(num_cars == 0 || (standings->cars && standings->progress && standings->order && standings->ranks));
+    for (size_t i = 0; i < num_cars; i++) {
+        body_t *car = list_get(cars, i);
+        standings->cars[i] = body_get_handle(car);
+        standings->progress[i] = body_get_centroid(car).y;
+        standings->order[i] = i;
+        standings->ranks[i] = i;
+    }
+    return standings;
+}
+
+
+void faf_standings_free(faf_standings_t *standings) {
+    assert(standings);
+
+    alloc_free(ALLOC_TAG_GAME, standings->cars);
+    alloc_free(ALLOC_TAG_GAME, standings->progress);
+    alloc_free(ALLOC_TAG_GAME, standings->order);
+    alloc_free(ALLOC_TAG_GAME, standings->ranks);
+    alloc_free(ALLOC_TAG_GAME, standings);
+}
+
+
+void faf_standings_update(faf_standings_t *standings) {
+    assert(standings);
+
+    for (size_t i = 0; i < standings->num_cars; i++) {
+        body_t *car = body_from_handle(standings->cars[i]);
+        if (car) {
+            standings->progress[i] = body_get_centroid(car).y;
+        }
+    }
+
+    // Insertion sort: the order is already right apart from the cars that overtook
+    // since the last update, so each car only moves past the few it overtook
+    size_t *order = standings->order;
+    for (size_t i = 1; i < standings->num_cars; i++) {
+        size_t car = order[i];
+        double progress = standings->progress[car];
+        size_t j = i;
+        while (j > 0 && standings->progress[order[j - 1]] < progress) {
+            order[j] = order[j - 1];
+            standings->ranks[order[j]] = j;
+            j--;
+        }
+        order[j] = car;
+        standings->ranks[car] = j;
+    }
+}
+
+
+void faf_standings_add_to_scene(scene_t *scene, faf_standings_t *standings) {
+    assert(scene);
+    assert(standings);
+
+    // Like the track, a force creator without bodies that is freed with the scene
+    scene_add_bodies_force_creator(scene, (force_creator_t)faf_standings_update, standings, list_init(1, NULL),
+                                   (free_func_t)faf_standings_free);
+}
+
+
+size_t faf_standings_num_cars(faf_standings_t *standings) {
+    assert(standings);
+
+    return standings->num_cars;
+}
+
+
+size_t faf_standings_get_place(faf_standings_t *standings, size_t car) {
+    assert(standings);
+    assert(car < standings->num_cars);
+
+    return standings->ranks[car] + 1;
+}
+
+
+size_t faf_standings_get_car(faf_standings_t *standings, size_t place) {
+    assert(standings);
+    assert(place >= 1 && place <= standings->num_cars);
+
+    return standings->order[place - 1];
+}
+
+
+const char *faf_standings_place_suffix(size_t place) {
+    if (place % 100 >= 11 && place % 100 <= 13) {
+        return "th";
+    }
+    switch (place % 10) {
+        case 1: {
+            return "st";
+        }
+        case 2: {
+            return "nd";
+        }
+        case 3: {
+            return "rd";
+        }
+        default: {
+            return "th";
+        }
+    }
+}
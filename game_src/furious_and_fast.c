@@ -1,8 +1,10 @@
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include "faf_audio.h"
 #include "faf_menu.h"
+#include "jobs.h"
 #include "mathlib.h"
 #include "sdl_wrapper.h"
 #include "window.h"
@@ -23,15 +25,17 @@ void faf_on_key(char key, key_event_type_t type, double held_time, window_t *win
 }
 
 bool inited = false;
+bool loaded = false;
 window_t *_window;
 
 
 void init() {
     sdl_init(VEC_ZERO, FAF_WINDOW_DIMENSIONS);
     sdl_on_key((key_handler_t)faf_on_key);
-    srand((unsigned)time(0));
+    jobs_init(jobs_default_num_workers());
+    mathlib_seed((uint64_t)time(0));
 
-    // Game start also initializes the audio system
+    // The audio system starts once the loading screen has loaded every asset
     _window = faf_game_start();
 }
 
@@ -40,14 +44,19 @@ void c_main(){
         init();
         inited = true;
     }
+    if (!loaded) {
+        loaded = faf_game_load_step(_window);
+    }
     double dt = time_since_last_tick();
     window_tick(_window, dt);
     sdl_render_window(_window);
     //faf_audio_play_music();
     if (sdl_is_done(_window)) {
+        faf_audio_free();
         #ifdef __EMSCRIPTEN__
         emscripten_cancel_main_loop();
         #else
+        jobs_shutdown();
         exit(0);
         #endif
         return;
@@ -55,7 +64,11 @@ void c_main(){
 }
 
 
-int main() {
+// "-c <cars>" races with that many cars instead of the default grid
+int main(int argc, char *argv[]) {
+    if (argc == 3 && strcmp(argv[1], "-c") == 0 && atoi(argv[2]) > 0) {
+        faf_set_num_cars((size_t)atoi(argv[2]));
+    }
 #ifdef __EMSCRIPTEN__
     emscripten_set_main_loop(c_main, 0, 1);
 #else
@@ -0,0 +1,226 @@
+#ifndef __ALLOC_H__
+#define __ALLOC_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Optional allocation instrumentation.
+ *
+ * Library and game code allocate through the alloc_malloc(), alloc_calloc(),
+ * alloc_realloc() and alloc_free() macros, which take the subsystem the memory
+ * belongs to. When compiled with FAF_ALLOC_TRACKING defined (make ALLOC_TRACKING=1)
+ * every call is recorded with its tag and file:line callsite; otherwise the macros
+ * are plain malloc/calloc/realloc/free and cost nothing.
+ *
+ * Frees that go through a free_func_t such as `free` or list_free() are not seen,
+ * so only allocation counts and bytes are exact. Any thread may allocate:
+ * the counters and the callsite table are updated under a lock.
+ */
+
+/**
+ * The subsystem an allocation is charged to.
+ */
+typedef enum {
+    ALLOC_TAG_OTHER,
+    ALLOC_TAG_LIST,
+    ALLOC_TAG_BODY,
+    ALLOC_TAG_SCENE,
+    ALLOC_TAG_FORCES,
+    ALLOC_TAG_COLLISION,
+    ALLOC_TAG_SHAPE,
+    ALLOC_TAG_WINDOW,
+    ALLOC_TAG_HUD,
+    ALLOC_TAG_SDL,
+    ALLOC_TAG_GAME,
+    ALLOC_TAG_ARENA,
+    ALLOC_TAG_ASSETS,
+    NUM_ALLOC_TAGS
+} alloc_tag_t;
+
+/**
+ * Allocation counters for one tag, callsite or frame.
+ */
+typedef struct alloc_stats {
+    size_t allocs;
+    size_t bytes;
+    size_t frees;
+} alloc_stats_t;
+
+#ifdef FAF_ALLOC_TRACKING
+#define alloc_malloc(tag, size) alloc_malloc_at(tag, size, __FILE__, __LINE__)
+#define alloc_calloc(tag, count, size) alloc_calloc_at(tag, count, size, __FILE__, __LINE__)
+#define alloc_realloc(tag, ptr, size) alloc_realloc_at(tag, ptr, size, __FILE__, __LINE__)
+#define alloc_free(tag, ptr) alloc_free_at(tag, ptr)
+#define alloc_hot_begin(name) alloc_hot_section_begin(name)
+#define alloc_hot_end() alloc_hot_section_end()
+#define alloc_cold_begin(name) alloc_cold_section_begin(name)
+#define alloc_cold_end() alloc_cold_section_end()
+#else
+#define alloc_malloc(tag, size) malloc(size)
+#define alloc_calloc(tag, count, size) calloc(count, size)
+#define alloc_realloc(tag, ptr, size) realloc(ptr, size)
+#define alloc_free(tag, ptr) free(ptr)
+#define alloc_hot_begin(name) ((void)0)
+#define alloc_hot_end() ((void)0)
+#define alloc_cold_begin(name) ((void)0)
+#define alloc_cold_end() ((void)0)
+#endif
+
+/**
+ * Allocates memory with malloc() and records it against a tag and callsite.
+ * Asserts that no hot section is active if hot section asserts are enabled.
+ *
+ * @param tag the subsystem the memory belongs to
+ * @param size the number of bytes to allocate
+ * @param file the source file of the callsite; must be a string literal
+ * @param line the source line of the callsite
+ * @return the memory returned by malloc()
+ */
+void *alloc_malloc_at(alloc_tag_t tag, size_t size, const char *file, int line);
+
+/**
+ * Allocates zeroed memory with calloc() and records it like alloc_malloc_at().
+ *
+ * @param tag the subsystem the memory belongs to
+ * @param count the number of elements to allocate
+ * @param size the size of each element
+ * @param file the source file of the callsite; must be a string literal
+ * @param line the source line of the callsite
+ * @return the memory returned by calloc()
+ */
+void *alloc_calloc_at(alloc_tag_t tag, size_t count, size_t size, const char *file, int line);
+
+/**
+ * Resizes memory with realloc() and records it like alloc_malloc_at().
+ * The full new size is counted, since the old size is not known.
+ *
+ * @param tag the subsystem the memory belongs to
+ * @param ptr the memory to resize, or NULL
+ * @param size the new size in bytes
+ * @param file the source file of the callsite; must be a string literal
+ * @param line the source line of the callsite
+ * @return the memory returned by realloc()
+ */
+void *alloc_realloc_at(alloc_tag_t tag, void *ptr, size_t size, const char *file, int line);
+
+/**
+ * Frees memory and records the free against a tag.
+ *
+ * @param tag the subsystem the memory belongs to
+ * @param ptr the memory to free, or NULL
+ */
+void alloc_free_at(alloc_tag_t tag, void *ptr);
+
+/**
+ * Starts a new frame. The counters returned by alloc_get_frame_stats()
+ * cover everything recorded between this and the next alloc_frame_end().
+ */
+void alloc_frame_begin();
+
+/**
+ * Ends the current frame and keeps its counters until the next frame ends.
+ */
+void alloc_frame_end();
+
+/**
+ * Gets the counters of the last completed frame for one tag.
+ *
+ * @param tag the subsystem to look up
+ * @return the allocations, bytes and frees recorded during the last frame
+ */
+alloc_stats_t alloc_get_frame_stats(alloc_tag_t tag);
+
+/**
+ * Gets the counters recorded for one tag since the last alloc_reset().
+ *
+ * @param tag the subsystem to look up
+ * @return the allocations, bytes and frees recorded so far
+ */
+alloc_stats_t alloc_get_total_stats(alloc_tag_t tag);
+
+/**
+ * Gets the number of frames completed since the last alloc_reset().
+ *
+ * @return the number of alloc_frame_end() calls
+ */
+size_t alloc_get_num_frames();
+
+/**
+ * Gets the counters recorded at one callsite since the last alloc_reset().
+ *
+ * @param file the source file of the callsite
+ * @param line the source line of the callsite
+ * @return the allocations and bytes recorded there; zero if there were none
+ */
+alloc_stats_t alloc_get_callsite_stats(const char *file, int line);
+
+/**
+ * Clears every counter, including the callsite table.
+ */
+void alloc_reset();
+
+/**
+ * Marks the start of a section that must not allocate, such as a tick.
+ * Sections may nest. While one is active, every tracked allocation the same
+ * thread makes is reported and, if hot section asserts are on, fails an assert.
+ * Sections belong to the thread that began them: allocations by job workers,
+ * even for work the section waits on, are counted but never checked.
+ *
+ * @param name a name for the section, shown in the report
+ */
+void alloc_hot_section_begin(const char *name);
+
+/**
+ * Marks the end of the innermost section started by alloc_hot_section_begin().
+ */
+void alloc_hot_section_end();
+
+/**
+ * Marks the start of a section that may allocate even inside a hot section,
+ * such as streaming in more of the level during a tick. Only the innermost
+ * section counts, so hot sections nested in it are checked again.
+ *
+ * @param name a name for the section
+ */
+void alloc_cold_section_begin(const char *name);
+
+/**
+ * Marks the end of the innermost section started by alloc_cold_section_begin().
+ */
+void alloc_cold_section_end();
+
+/**
+ * Turns the assert for allocations inside hot sections on or off.
+ * When off, offending allocations are only counted. Defaults to on.
+ *
+ * @param enabled whether to assert
+ */
+void alloc_set_hot_asserts(bool enabled);
+
+/**
+ * Gets the number of tracked allocations made inside hot sections.
+ *
+ * @return the count since the last alloc_reset()
+ */
+size_t alloc_get_hot_violations();
+
+/**
+ * Prints the per-tag totals, per-frame averages and the busiest callsites.
+ *
+ * @param out the stream to print to, e.g. stdout
+ * @param max_callsites how many callsites to list, busiest first
+ */
+void alloc_print_report(FILE *out, size_t max_callsites);
+
+/**
+ * Gets the name of a tag, e.g. "body".
+ *
+ * @param tag the subsystem
+ * @return a string literal naming it
+ */
+const char *alloc_tag_name(alloc_tag_t tag);
+
+#endif // #ifndef __ALLOC_H__
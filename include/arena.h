@@ -0,0 +1,58 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+
+/**
+ * A bump allocator for memory that lives exactly as long as its owner,
+ * e.g. everything a level creates for its scene (see scene_get_arena()).
+ *
+ * Memory is handed out from large blocks and can't be freed on its own;
+ * arena_free() releases every block at once. Allocations that don't fit
+ * in a block get a block of their own.
+ */
+typedef struct arena arena_t;
+
+/**
+ * Allocates an empty arena. No blocks are allocated until the first arena_alloc().
+ *
+ * @param block_size the size in bytes of each block, or 0 for a default
+ * @return the new arena
+ */
+arena_t *arena_init(size_t block_size);
+
+/**
+ * Releases every block of an arena, and with them everything allocated from it.
+ *
+ * @param arena an arena returned from arena_init()
+ */
+void arena_free(arena_t *arena);
+
+/**
+ * Allocates memory from an arena, aligned for any type.
+ * The memory is not zeroed. Asserts that the memory is allocated.
+ *
+ * @param arena an arena returned from arena_init()
+ * @param size the number of bytes to allocate
+ * @return the memory, valid until arena_free()
+ */
+void *arena_alloc(arena_t *arena, size_t size);
+
+/**
+ * Returns the number of bytes handed out by an arena, not counting padding.
+ *
+ * @param arena an arena returned from arena_init()
+ * @return the total size of every arena_alloc() so far
+ */
+size_t arena_bytes_used(arena_t *arena);
+
+/**
+ * Returns the number of blocks an arena has allocated, i.e. the number of
+ * frees arena_free() will make besides the arena itself.
+ *
+ * @param arena an arena returned from arena_init()
+ * @return the number of blocks
+ */
+size_t arena_num_blocks(arena_t *arena);
+
+#endif // #ifndef __ARENA_H__
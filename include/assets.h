@@ -0,0 +1,113 @@
+#ifndef __ASSETS_H__
+#define __ASSETS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_ttf.h>
+
+/**
+ * A cache of decoded assets: each image is decoded once and shared by everything
+ * that draws it, and each font or sound file is read into memory once.
+ *
+ * assets_preload() decodes a whole directory on the job system's worker threads
+ * while the main thread keeps drawing a loading screen. assets_pump() takes the
+ * decoded assets off the ready queue and finishes them on the main thread,
+ * which creates their textures. An asset that wasn't preloaded, or isn't ready
+ * yet, is loaded when it is first asked for.
+ *
+ * Except for the decoding done by the workers, everything here runs on the main thread.
+ */
+
+/**
+ * Sets the renderer that cached images' textures are created with.
+ * sdl_init() calls this; with no renderer, no textures are created.
+ *
+ * @param renderer the renderer, or NULL
+ */
+void assets_set_renderer(SDL_Renderer *renderer);
+
+/**
+ * Opens an archive of assets built by tools/faf_pack.c. From then on, an asset
+ * in the archive is used straight from it: pre-decoded images need no decoding,
+ * and files need no reading. Assets missing from it are still loaded from their files.
+ * The archive stays open until assets_free().
+ *
+ * @param path the path of the archive
+ * @return whether the archive was opened
+ */
+bool assets_open_pack(const char *path);
+
+/**
+ * Starts decoding every image (.png, .jpg), font (.ttf) and sound (.wav)
+ * in a directory and its subdirectories, or every asset under the directory
+ * in the archive if one is open. Returns without waiting for them.
+ * Without worker threads (e.g. on Emscripten), assets_pump() decodes them instead.
+ *
+ * @param dir the directory to load, e.g. "assets"
+ */
+void assets_preload(const char *dir);
+
+/**
+ * Finishes preloaded assets that have been decoded, creating the textures for images.
+ * Without worker threads, decodes the next preloaded assets as well.
+ * Stops once the time limit has passed, after at least one asset.
+ *
+ * @param max_time roughly how long to spend, in seconds
+ * @return whether every preloaded asset is ready
+ */
+bool assets_pump(double max_time);
+
+/**
+ * Returns how much of the preloading has finished, for a progress bar.
+ *
+ * @return the fraction of preloaded assets that are ready, or 1 if there are none
+ */
+double assets_progress();
+
+/**
+ * Returns an image, decoding it now if it isn't ready.
+ * The surface is shared: the caller gets its own reference and releases it
+ * with SDL_FreeSurface(), just like a surface from IMG_Load(), and must not change it.
+ *
+ * @param path the path of the image file
+ * @return the image, or NULL if it can't be loaded
+ */
+SDL_Surface *assets_get_surface(const char *path);
+
+/**
+ * Returns the texture created for an image from assets_get_surface(), creating it if needed.
+ *
+ * @param surface any surface
+ * @return the texture, owned by the cache, or NULL if the surface isn't
+ *   one of the cache's images or there is no renderer
+ */
+SDL_Texture *assets_get_texture(SDL_Surface *surface);
+
+/**
+ * Returns the contents of a file, reading it now if it isn't ready.
+ *
+ * @param path the path of the file
+ * @param size where to write the number of bytes in the file
+ * @return the contents, owned by the cache, or NULL if the file can't be read
+ */
+const void *assets_get_data(const char *path, size_t *size);
+
+/**
+ * Opens a font from the cached contents of its file, like TTF_OpenFont().
+ *
+ * @param path the path of the font file
+ * @param point_size the size of the font
+ * @return the font, closed by the caller with TTF_CloseFont(), or NULL if it can't be opened
+ */
+TTF_Font *assets_open_font(const char *path, int point_size);
+
+/**
+ * Waits for any preloading and frees everything in the cache,
+ * including the cache's references to images. Textures it created are destroyed
+ * and the archive is closed, after which images from it must not be drawn.
+ */
+void assets_free();
+
+#endif // #ifndef __ASSETS_H__
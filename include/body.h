@@ -2,6 +2,7 @@
 #define __BODY_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <SDL2/SDL_image.h>
 #include "color.h"
 #include "list.h"
@@ -20,6 +21,36 @@ typedef struct body body_t;
  */
 typedef void (*body_func_t)(body_t *, void *);
 
+/**
+ * Contiguous storage for the kinematic state of a set of bodies:
+ * centroids, velocities, accumulated forces and impulses, and inverse masses,
+ * each kept in its own array so a whole set can be integrated in one pass.
+ * Every body is in exactly one store. New bodies start in a shared default store,
+ * and a scene moves the bodies added to it into its own store.
+ */
+typedef struct body_store body_store_t;
+
+/**
+ * A reference to a body that can be checked after the body is freed.
+ * Bodies are allocated from a pool, and each slot counts how many times
+ * it has been reused, so a handle to a freed body never finds the body
+ * that takes its place.
+ */
+typedef struct body_handle {
+    uint32_t index;
+    uint32_t generation;
+} body_handle_t;
+
+/**
+ * A handle that never refers to a body.
+ */
+extern const body_handle_t BODY_NULL_HANDLE;
+
+/**
+ * The number of categories a body can be put in with body_set_category().
+ */
+extern const size_t BODY_NUM_CATEGORIES;
+
 /**
  * Initializes a body without any info.
  * Acts like body_init_with_info() where info and info_freer are NULL.
@@ -31,7 +62,8 @@ body_t *body_init(list_t *shape, double mass, rgb_color_t color);
  * The body is initially at rest.
  * Asserts that the mass is positive and that the required memory is allocated.
  *
- * @param shape a list of vectors describing the initial shape of the body
+ * @param shape a list of vectors describing the initial shape of the body.
+ *   The body copies the vertices into its own array and frees the list.
  * @param mass the mass of the body (if INFINITY, stops the body from moving)
  * @param color the color of the body, used to draw it on the screen
  * @param info additional information to associate with the body,
@@ -52,7 +84,8 @@ body_t *body_init_with_info(
  * The body is initially at rest.
  * Asserts that the mass is positive and that the required memory is allocated.
  *
- * @param shape a list of vectors describing the initial shape of the body
+ * @param shape a list of vectors describing the initial shape of the body.
+ *   The body copies the vertices into its own array and frees the list.
  * @param mass the mass of the body (if INFINITY, stops the body from moving)
  * @param color the color of the body, used to draw it on the screen
  * @param info additional information to associate with the body,
@@ -68,12 +101,47 @@ body_t *body_init_with_info_and_sprite(list_t *shape, double mass, rgb_color_t c
                                        vector_t dimensions);
 
 /**
- * Releases the memory allocated for a body.
+ * Releases the memory allocated for a body and returns its slot to the pool.
+ * Pointers to it fail body_is_live() until the slot is reused,
+ * and its handles never resolve again.
  *
  * @param body a pointer to a body returned from body_init()
  */
 void body_free(body_t *body);
 
+/**
+ * Gets a handle to a body.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return a handle that body_from_handle() resolves to the body until it is freed
+ */
+body_handle_t body_get_handle(body_t *body);
+
+/**
+ * Looks up the body a handle refers to.
+ *
+ * @param handle a handle returned from body_get_handle(), or BODY_NULL_HANDLE
+ * @return the body, or NULL if it has been freed
+ */
+body_t *body_from_handle(body_handle_t handle);
+
+/**
+ * Returns whether a pointer is to a body that hasn't been freed yet.
+ * Every other body function asserts this, so most uses of a freed body are caught
+ * until its slot in the pool is reused; keep a handle to be sure.
+ *
+ * @param body a pointer to a body, or NULL
+ * @return whether the body is allocated
+ */
+bool body_is_live(body_t *body);
+
+/**
+ * Returns the number of bodies that have been allocated and not yet freed.
+ *
+ * @return the number of live bodies in the pool
+ */
+size_t body_pool_num_live();
+
 /**
  * Gets the current shape of a body.
  * Returns a newly allocated vector list, which must be list_free()d.
@@ -85,13 +153,33 @@ list_t *body_get_shape(body_t *body);
 
 /**
  * Gets the current shape of a body.
- * Returns a reference to the body's polygon.
+ * Returns a reference to the body's polygon, whose vectors point into
+ * the array returned by body_get_vertices(). Vertices must not be added or removed.
+ * The polygon is created by the first call, so the first call for a body
+ * must not race with other calls for the same body.
  *
  * @param body a pointer to a body returned from body_init()
  * @return the polygon describing the body's current position
  */
 list_t *body_get_shape_nocpy(body_t *body);
 
+/**
+ * Gets the vertices of a body's current shape as one contiguous array,
+ * e.g. to pass to the vec_batch_*() kernels.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's vertices, in order; valid until the body is freed
+ */
+const vector_t *body_get_vertices(body_t *body);
+
+/**
+ * Gets the number of vertices in a body's shape.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the length of the array returned by body_get_vertices()
+ */
+size_t body_get_num_vertices(body_t *body);
+
 /**
  * Gets the current center of mass of a body.
  * While this could be calculated with polygon_centroid(), that becomes too slow
@@ -222,6 +310,62 @@ vector_t body_calculate_impulse(body_t *body1, body_t *body2, vector_t axis, dou
  */
 void body_tick(body_t *body, double dt);
 
+/**
+ * Finishes the tick of a body after body_store_tick() was called on its store:
+ * runs its tick functions and then moves it by the average of its velocities
+ * before and after the forces and impulses were applied.
+ * Does nothing for bodies without tick functions, which body_store_tick() already moved.
+ * Bodies added to the store since then are ticked in full, as by body_tick().
+ *
+ * @param body the body to tick
+ * @param dt the number of seconds elapsed since the last tick
+ */
+void body_finish_tick(body_t *body, double dt);
+
+/**
+ * Allocates an empty body store.
+ *
+ * @param capacity the number of bodies to allocate space for, or 0 for a default
+ * @return the new store
+ */
+body_store_t *body_store_init(size_t capacity);
+
+/**
+ * Releases the memory of a body store.
+ * Asserts that every body in it has been freed or moved to another store.
+ *
+ * @param store a store returned from body_store_init()
+ */
+void body_store_free(body_store_t *store);
+
+/**
+ * Returns the number of bodies in a store.
+ *
+ * @param store a store returned from body_store_init()
+ * @return the number of bodies whose state it holds
+ */
+size_t body_store_size(body_store_t *store);
+
+/**
+ * Moves a body's kinematic state into a store.
+ *
+ * @param body the body to move
+ * @param store the store to move it to
+ */
+void body_set_store(body_t *body, body_store_t *store);
+
+/**
+ * Applies the accumulated forces and impulses to every body in a store
+ * and resets them, splitting the bodies across the job system's threads.
+ * Bodies without tick functions are also moved.
+ * The others must be finished with body_finish_tick(), in whatever order
+ * their tick functions need, before the store is ticked again.
+ *
+ * @param store a store returned from body_store_init()
+ * @param dt the number of seconds elapsed since the last tick
+ */
+void body_store_tick(body_store_t *store, double dt);
+
 /**
  * Returns if a body appears on the screen bounded by the input vectors.
  *
@@ -330,4 +474,22 @@ bool body_get_debug_mode(body_t *body);
  */
 void body_set_debug_mode(body_t *body, bool mode);
 
+/**
+ * Returns the category of a body. Bodies start in category 0.
+ *
+ * @param body the body to check
+ * @return the category given to body_set_category()
+ */
+size_t body_get_category(body_t *body);
+
+/**
+ * Puts a body in a category, e.g. its object type in a game.
+ * The scene breaks its collision counters down by the categories of the bodies.
+ * Asserts that the category is less than BODY_NUM_CATEGORIES.
+ *
+ * @param body the body to change
+ * @param category the new category
+ */
+void body_set_category(body_t *body, size_t category);
+
 #endif // #ifndef __BODY_H__
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define __COLLISION_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "list.h"
 #include "vector.h"
 #include "body.h"
@@ -11,6 +12,8 @@
  * The shapes are either not colliding, or they are colliding along some axis.
  */
 typedef struct collision_info {
+    /** Whether the two shapes are colliding */
+    bool collided;
     /**
      * If the shapes are colliding, the axis they are colliding on.
      * This is a unit vector pointing from the first shape towards the second.
@@ -18,9 +21,31 @@ typedef struct collision_info {
      * If collided is false, this value is undefined.
      */
     vector_t axis;
+    /** If collided is true, the depth of the overlap along the axis. */
     double min_overlap;
 } collision_info_t;
 
+/**
+ * Counters for the collision pipeline, from the collision force creators
+ * down to the separating axis tests they run.
+ */
+typedef struct collision_stats {
+    /** Collision force creators run */
+    size_t force_creators;
+    /** Pairs skipped because their bounding circles don't overlap */
+    size_t radius_rejections;
+    /** Separating axis tests run */
+    size_t sat_tests;
+    /** Axes projected onto across all separating axis tests */
+    size_t axes_tested;
+    /** Separating axis tests that stopped at a separating axis */
+    size_t early_outs;
+    /** Separating axis tests that found the shapes overlapping */
+    size_t contacts;
+    /** Collision handlers called */
+    size_t handlers_fired;
+} collision_stats_t;
+
 /**
  * Computes the status of the collision between two convex polygons.
  * The shapes are given as lists of vertices in counterclockwise order.
@@ -32,6 +57,97 @@ typedef struct collision_info {
  * @return whether the shapes are colliding, and if so, the collision axis.
  * The axis should be a unit vector pointing from shape1 towards shape2.
  */
-collision_info_t *find_collision(list_t *shape1, list_t *shape2);
+collision_info_t find_collision(list_t *shape1, list_t *shape2);
+
+/**
+ * Computes the status of the collision between two convex polygons
+ * like find_collision(), counting the work done in the given stats.
+ *
+ * @param shape1 the first shape
+ * @param shape2 the second shape
+ * @param stats the counters to add the test to; may be NULL
+ * @return whether the shapes are colliding, and if so, the collision axis.
+ */
+collision_info_t find_collision_with_stats(list_t *shape1, list_t *shape2, collision_stats_t *stats);
+
+/**
+ * Computes the status of the collision between two convex polygons
+ * like find_collision_with_stats(), given contiguous arrays of vertices
+ * such as those returned by body_get_vertices().
+ *
+ * @param shape1 the vertices of the first shape
+ * @param num_points1 the number of vertices in the first shape
+ * @param shape2 the vertices of the second shape
+ * @param num_points2 the number of vertices in the second shape
+ * @param stats the counters to add the test to; may be NULL
+ * @return whether the shapes are colliding, and if so, the collision axis.
+ */
+collision_info_t find_collision_points(const vector_t *shape1, size_t num_points1,
+                                       const vector_t *shape2, size_t num_points2,
+                                       collision_stats_t *stats);
+
+/** The most candidates find_collision_batch() tests at once, one per bit of a mask */
+#define COLLISION_BATCH_MAX 64
+
+/**
+ * The results of testing one shape against many candidates with find_collision_batch().
+ */
+typedef struct collision_batch {
+    /** Bit i is set if the shape and candidate i are colliding */
+    uint64_t overlaps;
+    /** For each colliding candidate, the collision axis, as in collision_info_t */
+    vector_t axes[COLLISION_BATCH_MAX];
+    /**
+     * For each colliding candidate, the depth of the overlap along its axis.
+     * Scaling the axis by the depth gives the minimum translation vector.
+     */
+    double depths[COLLISION_BATCH_MAX];
+    /** For each candidate, the axes projected onto, as counted by find_collision_with_stats() */
+    size_t axes_tested[COLLISION_BATCH_MAX];
+} collision_batch_t;
+
+/**
+ * Tests one convex polygon against many candidate polygons that all have the same
+ * number of vertices, e.g. a car against the rectangles around it.
+ * The candidates are projected in parallel, one per SIMD lane (see vector_batch.h),
+ * and each result is identical to find_collision_points() with the shape first.
+ *
+ * @param shape the vertices of the shape
+ * @param num_points the number of vertices in the shape
+ * @param candidates the vertices of every candidate, one candidate after another
+ * @param candidate_points the number of vertices in each candidate
+ * @param num_candidates the number of candidates; at most COLLISION_BATCH_MAX
+ * @param batch where to write which candidates collide and their axes
+ */
+void find_collision_batch(const vector_t *shape, size_t num_points,
+                          const vector_t *candidates, size_t candidate_points, size_t num_candidates,
+                          collision_batch_t *batch);
+
+/**
+ * Gets the result for one candidate of find_collision_batch().
+ *
+ * @param batch the results of the batch
+ * @param i the index of the candidate
+ * @return the same collision info as find_collision_points() would return
+ */
+collision_info_t collision_batch_get_info(const collision_batch_t *batch, size_t i);
+
+/**
+ * Counts the test of one candidate of find_collision_batch() in the given stats,
+ * as find_collision_points() would have.
+ *
+ * @param batch the results of the batch
+ * @param i the index of the candidate
+ * @param stats the counters to add the test to
+ */
+void collision_batch_add_stats(const collision_batch_t *batch, size_t i, collision_stats_t *stats);
+
+/**
+ * Adds one set of collision counters to another.
+ *
+ * @param total the counters to add to
+ * @param stats the counters to add
+ */
+void collision_stats_add(collision_stats_t *total, collision_stats_t stats);
 
 #endif // #ifndef __COLLISION_H__
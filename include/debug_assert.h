@@ -0,0 +1,18 @@
+#ifndef __DEBUG_ASSERT_H__
+#define __DEBUG_ASSERT_H__
+
+#include <assert.h>
+
+/**
+ * An assert() for checks on hot paths, such as the argument checks
+ * at the top of the body, list, scene and window accessors.
+ * Release builds (make release, which defines FAF_RELEASE) compile these away
+ * and keep every ordinary assert().
+ */
+#ifdef FAF_RELEASE
+#define DEBUG_ASSERT(condition) ((void)0)
+#else
+#define DEBUG_ASSERT(condition) assert(condition)
+#endif
+
+#endif // #ifndef __DEBUG_ASSERT_H__
@@ -0,0 +1,144 @@
+#ifndef __DYNARRAY_H__
+#define __DYNARRAY_H__
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "alloc.h"
+#include "debug_assert.h"
+
+/**
+ * Typed dynamic arrays, generated for each element type by a macro.
+ *
+ * DYNARRAY_DEFINE(name, type, inline_capacity) defines name_t, an array that
+ * stores `type` values directly, and static inline functions to use it:
+ *
+ *   name_init(a), name_free(a), name_clear(a), name_truncate(a, size),
+ *   name_size(a), name_data(a), name_get(a, i), name_reserve(a, capacity),
+ *   name_push(a, value), name_insert(a, i, value), name_remove(a, i),
+ *   name_swap_remove(a, i), name_remove_if(a, pred, aux)
+ *
+ * The first inline_capacity elements (at least 1) live in the struct itself,
+ * so small arrays never allocate. Elements are always reached through
+ * name_data(), so a name_t can be moved to another address at any time.
+ * Unlike list_t, the array never frees its elements; pointers into it
+ * are invalidated by anything that adds or removes elements.
+ * Index checks are DEBUG_ASSERT()s, so release builds skip them.
+ */
+
+#define DYNARRAY_DEFINE(name, type, inline_capacity)                                                  \
+    typedef struct name {                                                                             \
+        /* NULL while the elements fit in inline_data */                                              \
+        type *heap;                                                                                   \
+        size_t size;                                                                                  \
+        size_t capacity;                                                                              \
+        type inline_data[inline_capacity];                                                            \
+    } name##_t;                                                                                       \
+                                                                                                      \
+    static inline void name##_init(name##_t *a) {                                                     \
+        a->heap = NULL;                                                                               \
+        a->size = 0;                                                                                  \
+        a->capacity = inline_capacity;                                                                \
+    }                                                                                                 \
+                                                                                                      \
+    static inline void name##_free(name##_t *a) {                                                     \
+        alloc_free(ALLOC_TAG_LIST, a->heap);                                                          \
+        name##_init(a);                                                                               \
+    }                                                                                                 \
+                                                                                                      \
+    static inline void name##_clear(name##_t *a) {                                                    \
+        a->size = 0;                                                                                  \
+    }                                                                                                 \
+                                                                                                      \
+    static inline void name##_truncate(name##_t *a, size_t size) {                                    \
+        DEBUG_ASSERT(size <= a->size);                                                                \
+        a->size = size;                                                                               \
+    }                                                                                                 \
+                                                                                                      \
+    static inline size_t name##_size(const name##_t *a) {                                             \
+        return a->size;                                                                               \
+    }                                                                                                 \
+                                                                                                      \
+    static inline type *name##_data(name##_t *a) {                                                    \
+        return a->heap ? a->heap : a->inline_data;                                                    \
+    }                                                                                                 \
+                                                                                                      \
+    static inline type *name##_get(name##_t *a, size_t i) {                                           \
+        DEBUG_ASSERT(i < a->size);                                                                    \
+        return &name##_data(a)[i];                                                                    \
+    }                                                                                                 \
+                                                                                                      \
+    static inline void name##_reserve(name##_t *a, size_t capacity) {                                 \
+        if (capacity <= a->capacity) {                                                                \
+            return;                                                                                   \
+        }                                                                                             \
+        if (a->heap) {                                                                                \
+            a->heap = alloc_realloc(ALLOC_TAG_LIST, a->heap, sizeof(type) * capacity);                \
+            assert(a->heap);                                                                          \
+        }                                                                                             \
+        else {                                                                                        \
+            a->heap = alloc_malloc(ALLOC_TAG_LIST, sizeof(type) * capacity);                          \
+            assert(a->heap);                                                                          \
+            memcpy(a->heap, a->inline_data, sizeof(type) * a->size);                                  \
+        }                                                                                             \
+        a->capacity = capacity;                                                                       \
+    }                                                                                                 \
+                                                                                                      \
+    static inline type *name##_push(name##_t *a, type value) {                                        \
+        if (a->size == a->capacity) {                                                                 \
+            name##_reserve(a, 2 * a->capacity);                                                       \
+        }                                                                                             \
+        type *slot = &name##_data(a)[a->size++];                                                      \
+        *slot = value;                                                                                \
+        return slot;                                                                                  \
+    }                                                                                                 \
+                                                                                                      \
+    /* Shifts the elements from i on up by one */                                                     \
+    static inline type *name##_insert(name##_t *a, size_t i, type value) {                            \
+        DEBUG_ASSERT(i <= a->size);                                                                   \
+        if (a->size == a->capacity) {                                                                 \
+            name##_reserve(a, 2 * a->capacity);                                                       \
+        }                                                                                             \
+        type *data = name##_data(a);                                                                  \
+        memmove(&data[i + 1], &data[i], sizeof(type) * (a->size - i));                                \
+        data[i] = value;                                                                              \
+        a->size++;                                                                                    \
+        return &data[i];                                                                              \
+    }                                                                                                 \
+                                                                                                      \
+    /* Keeps the order of the other elements */                                                       \
+    static inline void name##_remove(name##_t *a, size_t i) {                                         \
+        DEBUG_ASSERT(i < a->size);                                                                    \
+        type *data = name##_data(a);                                                                  \
+        memmove(&data[i], &data[i + 1], sizeof(type) * (a->size - i - 1));                            \
+        a->size--;                                                                                    \
+    }                                                                                                 \
+                                                                                                      \
+    /* Moves the last element into the gap, in O(1) */                                                \
+    static inline void name##_swap_remove(name##_t *a, size_t i) {                                    \
+        DEBUG_ASSERT(i < a->size);                                                                    \
+        type *data = name##_data(a);                                                                  \
+        data[i] = data[a->size - 1];                                                                  \
+        a->size--;                                                                                    \
+    }                                                                                                 \
+                                                                                                      \
+    /* Removes every element pred() returns true for in one pass, keeping the order of the rest. */   \
+    /* pred() may release what the element owns. Returns the number of elements removed. */           \
+    static inline size_t name##_remove_if(name##_t *a, bool (*pred)(type *, void *), void *aux) {     \
+        type *data = name##_data(a);                                                                  \
+        size_t kept = 0;                                                                              \
+        for (size_t i = 0; i < a->size; i++) {                                                        \
+            if (!pred(&data[i], aux)) {                                                               \
+                if (kept != i) {                                                                      \
+                    data[kept] = data[i];                                                             \
+                }                                                                                     \
+                kept++;                                                                               \
+            }                                                                                         \
+        }                                                                                             \
+        size_t removed = a->size - kept;                                                              \
+        a->size = kept;                                                                               \
+        return removed;                                                                               \
+    }
+
+#endif // #ifndef __DYNARRAY_H__
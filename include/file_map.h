@@ -0,0 +1,36 @@
+#ifndef __FILE_MAP_H__
+#define __FILE_MAP_H__
+
+#include <stddef.h>
+#include "alloc.h"
+
+/**
+ * Read-only access to a whole file's bytes, e.g. an asset archive or a level
+ * file that is used straight from memory.
+ *
+ * The file is mapped where the platform can, so its pages are only read once
+ * they are touched (Emscripten maps files in its preloaded filesystem the same
+ * way), and read into memory in one go on Windows.
+ */
+
+/**
+ * Maps a file into memory.
+ *
+ * @param path the file's path
+ * @param tag what the bytes are counted against where they have to be read into memory
+ * @param size where to write the file's size
+ * @return the file's bytes, which must not be written to, or NULL if the file
+ *   is missing, empty or can't be read
+ */
+void *file_map(const char *path, alloc_tag_t tag, size_t *size);
+
+/**
+ * Unmaps a file mapped by file_map().
+ *
+ * @param data the bytes returned from file_map()
+ * @param tag the tag passed to file_map()
+ * @param size the size file_map() gave
+ */
+void file_unmap(void *data, alloc_tag_t tag, size_t size);
+
+#endif // #ifndef __FILE_MAP_H__
@@ -118,12 +118,21 @@ void hud_add_widget(hud_t *hud, widget_t *widget);
 void hud_tick(hud_t *hud);
 
 /**
- * Returns a reference to the HUD's widgets.
+ * Returns the number of widgets in a HUD.
  *
  * @param hud a pointer returned from hud_init()
- * @return a reference to the list of widgets for the hud
+ * @return the number of widgets added with hud_add_widget()
  */
-list_t *hud_get_widgets(hud_t *hud);
+size_t hud_num_widgets(hud_t *hud);
+
+/**
+ * Gets a widget of a HUD, in the order they were added.
+ *
+ * @param hud a pointer returned from hud_init()
+ * @param index the index of the widget in [0, hud_num_widgets())
+ * @return the widget, still owned by the HUD
+ */
+widget_t *hud_get_widget(hud_t *hud, size_t index);
 
 void *hud_get_aux(hud_t *hud);
 
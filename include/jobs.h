@@ -0,0 +1,126 @@
+#ifndef __JOBS_H__
+#define __JOBS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * A shared job system: a fixed set of worker threads, each with its own
+ * deque of jobs, that steal from each other when they run out of work.
+ * Every parallel phase in the library and the game submits to this one
+ * scheduler instead of creating its own threads.
+ *
+ * The thread that calls jobs_init() counts as thread 0 and runs jobs
+ * while it waits in job_wait() or jobs_parallel_for(). Functions that need the
+ * workers start them if jobs_init() hasn't been called, and any number of
+ * threads may do so at once: the job system is started exactly once.
+ * With no worker threads (e.g. on Emscripten), jobs run on the waiting thread.
+ */
+typedef struct job job_t;
+
+/**
+ * A function run by a job.
+ *
+ * @param aux the auxiliary value passed to job_create()
+ */
+typedef void (*job_func_t)(void *aux);
+
+/**
+ * A function run over a slice of an index range by jobs_parallel_for().
+ *
+ * @param start the first index in the slice
+ * @param end one past the last index in the slice
+ * @param aux the auxiliary value passed to jobs_parallel_for()
+ */
+typedef void (*job_range_func_t)(size_t start, size_t end, void *aux);
+
+/**
+ * Starts the job system's worker threads.
+ * Asserts that the job system is not already running.
+ *
+ * @param num_workers the number of worker threads to start,
+ *   not counting the calling thread. jobs_default_num_workers() is a good choice.
+ */
+void jobs_init(size_t num_workers);
+
+/**
+ * Stops and joins the worker threads. Every submitted job must have been waited on.
+ * jobs_init() may be called again afterwards.
+ */
+void jobs_shutdown();
+
+/**
+ * Returns the number of worker threads to use on this machine:
+ * one less than the number of CPUs, or 0 where threads are unavailable.
+ *
+ * @return the suggested argument to jobs_init()
+ */
+size_t jobs_default_num_workers();
+
+/**
+ * Returns the number of threads that run jobs, including the main thread.
+ * Starts the job system with the default number of workers if it isn't running.
+ *
+ * @return the number of worker threads plus one
+ */
+size_t jobs_num_threads();
+
+/**
+ * Returns the index of the calling thread in the job system.
+ * The main thread is 0 and worker threads are 1 to jobs_num_threads() - 1,
+ * so the index can pick a per-thread buffer. Other threads also get 0.
+ *
+ * @return the index of the calling thread
+ */
+size_t jobs_thread_index();
+
+/**
+ * Creates a job that will call a function once it is submitted and its
+ * dependencies have finished. The job must be submitted and then waited on,
+ * which frees it.
+ *
+ * @param f the function to run
+ * @param aux the value to pass to f
+ * @return the new job
+ */
+job_t *job_create(job_func_t f, void *aux);
+
+/**
+ * Makes a job wait for another job to finish before it can run.
+ * Must be called before the job is submitted.
+ * Asserts that the dependency has no more than 8 jobs waiting on it.
+ *
+ * @param job the job that waits
+ * @param dependency the job it waits for; it may already be running or finished,
+ *   but must not have been waited on yet
+ */
+void job_depends_on(job_t *job, job_t *dependency);
+
+/**
+ * Submits a job to run as soon as its dependencies have finished.
+ *
+ * @param job a job returned from job_create()
+ */
+void job_submit(job_t *job);
+
+/**
+ * Waits until a submitted job has finished, running other jobs in the meantime,
+ * and frees it.
+ *
+ * @param job a job passed to job_submit()
+ */
+void job_wait(job_t *job);
+
+/**
+ * Calls a function over the range [0, count) split into slices of about grain indices,
+ * running the slices in parallel, and waits for all of them.
+ * Small ranges run directly on the calling thread.
+ *
+ * @param count the number of indices
+ * @param grain the smallest number of indices worth a job of its own
+ * @param f the function to call on each slice
+ * @param aux the value to pass to f
+ */
+void jobs_parallel_for(size_t count, size_t grain, job_range_func_t f, void *aux);
+
+#endif // #ifndef __JOBS_H__
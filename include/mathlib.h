@@ -1,6 +1,17 @@
 #ifndef __MATHLIB_H__
 #define __MATHLIB_H__
 
+#include <stdint.h>
+
+/**
+ * Reseeds the shared stream used by mathlib_rand_in_range().
+ * Code that must be reproducible or run on several threads
+ * should own an rng_t (see rng.h) instead of sharing this stream.
+ *
+ * @param seed the seed
+ */
+void mathlib_seed(uint64_t seed);
+
 /**
  * Returns a random double between min and max
  * 
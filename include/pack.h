@@ -0,0 +1,145 @@
+#ifndef __PACK_H__
+#define __PACK_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * An archive of assets built offline (see tools/faf_pack.c), so the game can
+ * start without decoding image files or reading many small files.
+ *
+ * An archive file is, in the byte order of the machine that wrote it:
+ *   - a pack_header_t,
+ *   - the lookup table: num_slots uint32_t's, each 0 for an empty slot or
+ *     one more than the index of the entry whose id hashes there (linear probing),
+ *   - num_entries pack_entry_t's,
+ *   - the entries' paths, each ending in '\0',
+ *   - the entries' contents, each starting at a multiple of PACK_ALIGNMENT bytes.
+ * Every part is aligned, so the archive can be used straight from a mapping of the file.
+ */
+
+// Changed whenever the layout of the file changes; archives of other versions are rejected
+extern const uint32_t PACK_VERSION;
+// Contents start at multiples of this many bytes, enough for any pixel row
+#define PACK_ALIGNMENT 16
+
+typedef enum {
+    // Decoded image pixels in SDL_PIXELFORMAT_RGBA32, width * 4 bytes a row
+    PACK_PIXELS,
+    // A file's bytes as they are, e.g. a font, a WAV sound or an encoded image
+    PACK_FILE
+} pack_kind_t;
+
+typedef struct pack_header {
+    // "FAFP"
+    char magic[4];
+    uint32_t version;
+    uint32_t num_entries;
+    // A power of two, at least twice num_entries
+    uint32_t num_slots;
+} pack_header_t;
+
+typedef struct pack_entry {
+    // pack_id() of the entry's path
+    uint64_t id;
+    // A pack_kind_t
+    uint32_t kind;
+    // Where the path is, from the start of the paths
+    uint32_t path_offset;
+    // Where the contents are, from the start of the file
+    uint32_t offset;
+    uint32_t size;
+    // The image's size in pixels; 0 unless kind is PACK_PIXELS
+    uint32_t width;
+    uint32_t height;
+} pack_entry_t;
+
+/**
+ * An open archive.
+ */
+typedef struct pack pack_t;
+
+/**
+ * Returns the id an asset is looked up by.
+ *
+ * @param path the path of the asset, e.g. "assets/car/bmw_i8.png"
+ * @return the 64-bit FNV-1a hash of the path
+ */
+uint64_t pack_id(const char *path);
+
+/**
+ * Opens an archive, mapping it into memory where the platform allows it
+ * and reading it otherwise.
+ *
+ * @param path the path of the file
+ * @return the open archive, or NULL if it can't be read or is not an archive of this version
+ */
+pack_t *pack_open(const char *path);
+
+/**
+ * Closes an archive. Entries and contents returned by it are no longer valid.
+ *
+ * @param pack an archive returned from pack_open()
+ */
+void pack_close(pack_t *pack);
+
+/**
+ * Returns the number of entries in an archive.
+ *
+ * @param pack an archive returned from pack_open()
+ * @return the number of entries
+ */
+size_t pack_num_entries(pack_t *pack);
+
+/**
+ * Returns an entry of an archive by its index, e.g. to list the archive.
+ *
+ * @param pack an archive returned from pack_open()
+ * @param index the index of the entry; must be less than pack_num_entries()
+ * @return the entry, inside the archive
+ */
+const pack_entry_t *pack_get_entry(pack_t *pack, size_t index);
+
+/**
+ * Looks up an entry of an archive by its id, in constant time.
+ *
+ * @param pack an archive returned from pack_open()
+ * @param id the pack_id() of the asset's path
+ * @return the entry, inside the archive, or NULL if the archive has no such asset
+ */
+const pack_entry_t *pack_find(pack_t *pack, uint64_t id);
+
+/**
+ * Returns the path of an entry.
+ *
+ * @param pack an archive returned from pack_open()
+ * @param entry one of the archive's entries
+ * @return the path, inside the archive
+ */
+const char *pack_entry_path(pack_t *pack, const pack_entry_t *entry);
+
+/**
+ * Returns the contents of an entry.
+ *
+ * @param pack an archive returned from pack_open()
+ * @param entry one of the archive's entries
+ * @return the entry's size bytes, inside the archive
+ */
+const void *pack_entry_data(pack_t *pack, const pack_entry_t *entry);
+
+/**
+ * Writes an archive.
+ *
+ * @param path the path of the file to write
+ * @param entries the entries to write, whose kind, size, width and height are used;
+ *   their id and offsets are filled in
+ * @param paths each entry's path
+ * @param contents each entry's contents, of its size in bytes
+ * @param num_entries the number of entries
+ * @return whether the whole file was written; false if two paths have the same id
+ */
+bool pack_write(const char *path, const pack_entry_t *entries, const char *const *paths,
+                const void *const *contents, size_t num_entries);
+
+#endif // #ifndef __PACK_H__
@@ -0,0 +1,94 @@
+#ifndef __RNG_H__
+#define __RNG_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A small, fast pseudo-random number generator (xoshiro256**).
+ *
+ * Unlike rand(), each generator is a plain value with no hidden global state,
+ * so every subsystem can own its own stream: the same seed always gives
+ * the same numbers, and streams on different threads never interfere.
+ */
+typedef struct rng {
+    uint64_t s[4];
+} rng_t;
+
+/**
+ * Creates a generator from a seed.
+ * Every seed, including 0, gives a valid generator.
+ *
+ * @param seed the seed
+ * @return the seeded generator
+ */
+rng_t rng_init(uint64_t seed);
+
+/**
+ * Creates one of many independent generators from the same seed,
+ * e.g. one per chunk of a level or one per car.
+ * rng_init_stream(seed, 0) is not the same generator as rng_init(seed).
+ *
+ * @param seed the seed shared by all the streams
+ * @param stream the number of the stream
+ * @return the seeded generator
+ */
+rng_t rng_init_stream(uint64_t seed, uint64_t stream);
+
+/**
+ * Returns the next 64 random bits of a generator.
+ *
+ * @param rng the generator to advance
+ * @return a uniformly distributed 64-bit number
+ */
+uint64_t rng_next(rng_t *rng);
+
+/**
+ * Returns a random double in [0, 1).
+ *
+ * @param rng the generator to advance
+ * @return a uniformly distributed double, a multiple of 2^-53
+ */
+double rng_double(rng_t *rng);
+
+/**
+ * Returns a random double in [min, max).
+ *
+ * @param rng the generator to advance
+ * @param min the minimum value
+ * @param max the maximum value
+ * @return a uniformly distributed double between min and max
+ */
+double rng_range(rng_t *rng, double min, double max);
+
+/**
+ * Returns a random index in [0, n).
+ *
+ * @param rng the generator to advance
+ * @param n the number of possible indices; must be positive
+ * @return a uniformly distributed index
+ */
+size_t rng_index(rng_t *rng, size_t n);
+
+/**
+ * Fills an array with random bits. Gives the same numbers as calling rng_next() n times.
+ *
+ * @param rng the generator to advance
+ * @param values where to write the numbers
+ * @param n the number of numbers to write
+ */
+void rng_fill(rng_t *rng, uint64_t *values, size_t n);
+
+/**
+ * Fills an array with random doubles in [min, max).
+ * Gives the same numbers as calling rng_range() n times.
+ *
+ * @param rng the generator to advance
+ * @param values where to write the numbers
+ * @param n the number of numbers to write
+ * @param min the minimum value
+ * @param max the maximum value
+ */
+void rng_fill_range(rng_t *rng, double *values, size_t n, double min, double max);
+
+#endif // #ifndef __RNG_H__
@@ -1,7 +1,9 @@
 #ifndef __SCENE_H__
 #define __SCENE_H__
 
+#include "arena.h"
 #include "body.h"
+#include "collision.h"
 #include "list.h"
 #include "vector.h"
 
@@ -19,6 +21,31 @@ typedef struct scene scene_t;
  */
 typedef void (*force_creator_t)(void *aux);
 
+/**
+ * The read-only first half of a force creator, e.g. a collision test.
+ * Testers run in parallel on the job system's threads (see jobs.h),
+ * so they must not change bodies or anything shared with other force creators.
+ * They may change state that belongs to their own auxiliary value.
+ *
+ * @param aux the auxiliary value passed to scene_add_tested_force_creator()
+ * @return whether the force creator needs to be called this tick
+ */
+typedef bool (*force_tester_t)(void *aux);
+
+/**
+ * Tests several force creators at once, e.g. one body against many others
+ * in a single batched collision test. Runs under the same rules as force_tester_t.
+ *
+ * @param auxes the auxiliary values of consecutive force creators
+ *   added with the same batch tester
+ * @param num_auxes the number of auxiliary values; at most SCENE_BATCH_MAX
+ * @param results where to write whether each force creator needs to be called this tick
+ */
+typedef void (*force_batch_tester_t)(void **auxes, size_t num_auxes, bool *results);
+
+/** The most force creators passed to one call of a force_batch_tester_t */
+#define SCENE_BATCH_MAX 64
+
 /**
  * Allocates memory for an empty scene.
  * Makes a reasonable guess of the number of bodies to allocate space for.
@@ -32,11 +59,23 @@ scene_t *scene_init(vector_t dimensions);
 /**
  * Releases memory allocated for a given scene
  * and all the bodies and force creators it contains.
+ * Everything allocated from the scene's arena is released at once.
  *
  * @param scene a pointer to a scene returned from scene_init()
  */
 void scene_free(scene_t *scene);
 
+/**
+ * Gets the arena that lives as long as a scene, for auxiliary values and
+ * other data that never outlives it. Memory taken from it is not freed
+ * when a body is removed, only when the scene is freed, so anything
+ * created for short-lived bodies should be allocated normally.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the scene's arena, freed by scene_free()
+ */
+arena_t *scene_get_arena(scene_t *scene);
+
 /**
  * Returns the number of layers in a scene.
  *
@@ -46,13 +85,24 @@ void scene_free(scene_t *scene);
 size_t scene_num_layers(scene_t *scene);
 
 /**
- * Returns a reference to a given layer in a scene.
- * DOES NOT create a deep copy of the body list.
+ * Returns the number of bodies in a given layer of a scene.
  *
  * @param scene a pointer to a scene returned from scene_init()
- * @param idx the layer to get in [0, scene_num_layers())
+ * @param idx the layer to count in [0, scene_num_layers())
+ * @return the number of bodies added to that layer and not yet removed
  */
-list_t *scene_get_layer(scene_t *scene, size_t idx);
+size_t scene_num_bodies_in_layer(scene_t *scene, size_t idx);
+
+/**
+ * Gets a body in a scene by its position in draw order:
+ * layer by layer from layer 0, and within a layer in the order bodies were added.
+ * Positions change when bodies are added to lower layers or removed.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param index the position of the body in [0, scene_num_bodies())
+ * @return the body at that position
+ */
+body_t *scene_get_body(scene_t *scene, size_t index);
 
 /**
  * Gets the number of bodies in a given scene.
@@ -108,7 +158,9 @@ void scene_set_dimensions(scene_t *scene, vector_t dimensions);
  * @param bodies the list of bodies affected by the force creator.
  *   The force creator will be removed if any of these bodies are removed.
  *   This list does not own the bodies, so its freer should be NULL.
- * @param freer if non-NULL, a function to call in order to free aux
+ *   The scene copies and frees the list.
+ * @param freer if non-NULL, a function to call in order to free aux;
+ *   NULL if aux was allocated from scene_get_arena()
  */
 void scene_add_bodies_force_creator(
     scene_t *scene,
@@ -118,10 +170,66 @@ void scene_add_bodies_force_creator(
     free_func_t freer
 );
 
+/**
+ * Adds a force creator to a scene that is split into a parallel test
+ * and a serial response, e.g. a collision check and its collision handler.
+ * Every tick, the tester is called first, alongside the other testers,
+ * and the force creator is only called if the tester returned true.
+ * Force creators are still called in the order they were added,
+ * interleaved with the ones added by scene_add_bodies_force_creator(),
+ * so the result doesn't depend on the number of threads.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param tester a force tester function
+ * @param forcer a force creator function
+ * @param aux an auxiliary value to pass to tester and forcer when they are called
+ * @param bodies the list of bodies affected by the force creator,
+ *   as in scene_add_bodies_force_creator()
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void scene_add_tested_force_creator(
+    scene_t *scene,
+    force_tester_t tester,
+    force_creator_t forcer,
+    void *aux,
+    list_t *bodies,
+    free_func_t freer
+);
+
+/**
+ * Adds a force creator like scene_add_tested_force_creator() whose test can also
+ * be run in batches. Consecutive force creators added with the same batch tester
+ * are tested with one call to it instead of one call to the tester each.
+ * The tester is still used for force creators added during a tick.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param batch_tester a function that tests many force creators at once
+ * @param tester a force tester function giving the same results one at a time
+ * @param forcer a force creator function
+ * @param aux an auxiliary value to pass to the testers and forcer when they are called
+ * @param bodies the list of bodies affected by the force creator,
+ *   as in scene_add_bodies_force_creator()
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void scene_add_batch_tested_force_creator(
+    scene_t *scene,
+    force_batch_tester_t batch_tester,
+    force_tester_t tester,
+    force_creator_t forcer,
+    void *aux,
+    list_t *bodies,
+    free_func_t freer
+);
+
 /**
  * Executes a tick of a given scene over a small time interval.
  * This requires executing all the force creators
  * and then ticking each body (see body_tick()).
+ * The testers of force creators added with scene_add_tested_force_creator()
+ * are split across the job system's threads before any force creator is called.
+ * Bodies are then integrated in parallel (see body_store_tick()), and bodies with
+ * tick functions are finished one at a time in layer order (see body_finish_tick()).
+ * Tick functions therefore see bodies without tick functions already moved.
  * If any bodies are marked for removal, they should be removed from the scene
  * and freed, along with any force creators acting on them.
  *
@@ -136,4 +244,44 @@ void scene_resume(scene_t *scene);
 
 void scene_toggle_pause(scene_t *scene);
 
+/**
+ * Gets the collision counters for pairs whose first body is in one category
+ * and whose second body is in another (see body_set_category()).
+ * The counters accumulate across ticks until scene_reset_collision_stats().
+ * Asserts that both categories are less than BODY_NUM_CATEGORIES.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param category1 the category of the first body in create_collision()
+ * @param category2 the category of the second body in create_collision()
+ * @return the scene's counters for that pair of categories, summed over all threads
+ */
+collision_stats_t scene_get_collision_stats(scene_t *scene, size_t category1, size_t category2);
+
+/**
+ * Gets the calling thread's collision counters for a pair of categories,
+ * so force testers can count their work without locking.
+ * Asserts that both categories are less than BODY_NUM_CATEGORIES.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param category1 the category of the first body in create_collision()
+ * @param category2 the category of the second body in create_collision()
+ * @return a pointer to the counters owned by the thread at jobs_thread_index()
+ */
+collision_stats_t *scene_get_thread_collision_stats(scene_t *scene, size_t category1, size_t category2);
+
+/**
+ * Sums the collision counters over every pair of categories and every thread.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the scene's total collision counters
+ */
+collision_stats_t scene_get_total_collision_stats(scene_t *scene);
+
+/**
+ * Sets every collision counter in the scene back to zero.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ */
+void scene_reset_collision_stats(scene_t *scene);
+
 #endif // #ifndef __SCENE_H__
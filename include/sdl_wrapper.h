@@ -33,6 +33,16 @@ enum event sdl_event_loop(void);
  */
 void sdl_init(vector_t min, vector_t max);
 
+/**
+ * Initializes a software renderer that draws into an offscreen surface
+ * instead of a window. Useful for benchmarks and headless runs.
+ * Must be called once instead of sdl_init().
+ *
+ * @param min the x and y coordinates of the bottom left of the scene
+ * @param max the x and y coordinates of the top right of the scene
+ */
+void sdl_init_offscreen(vector_t min, vector_t max);
+
 /**
  * Processes all SDL events and returns whether the window has been closed.
  * This function must be called in order to handle keypresses.
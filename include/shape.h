@@ -2,6 +2,7 @@
 #define __SHAPE_H__
 
 #include "body.h"
+#include "rng.h"
 
 /**
  * Initializes and returns a star with the specified characteristics
@@ -23,6 +24,7 @@ body_t *shape_init_star(size_t n_points, double outer_radius,
 /**
  * Initializes and returns a star with random characteristics
  * 
+ * @param rng the random stream the star's size and color are drawn from
  * @param n_points the number of points of the star
  * @param density the density of the star
  * @param center the center of the star
@@ -31,7 +33,7 @@ body_t *shape_init_star(size_t n_points, double outer_radius,
  * Starts with DEFAULT_VELOCITY = {.x = 50, .y = 50} if true
  * @return a pointer to the randomly initialized star
  */
-body_t *shape_init_random_star(size_t n_points, double density, vector_t center,
+body_t *shape_init_random_star(rng_t *rng, size_t n_points, double density, vector_t center,
                                bool rand_size, bool init_velocity);
 
 /**
@@ -162,8 +164,6 @@ body_t *shape_init_rectangle_with_sprite(double l, double h, rgb_color_t color,
 body_t *shape_init_needle(double radius, double length, rgb_color_t color, void *info,
                           free_func_t info_freer);
 
-body_t *shape_init_ai_collider(body_t *ai_car);
-
 body_t *shape_init_player_indicator(body_t *player_car);
 
 /**
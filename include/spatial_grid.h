@@ -0,0 +1,86 @@
+#ifndef __SPATIAL_GRID_H__
+#define __SPATIAL_GRID_H__
+
+#include <stddef.h>
+#include "vector.h"
+
+/**
+ * A uniform grid of axis-aligned boxes for finding the boxes near a region,
+ * e.g. the bodies ahead of a car, without testing every box.
+ *
+ * The plane is split into square cells, and each box is listed in every cell it
+ * touches. Cells are hashed into a fixed number of buckets, so the grid has
+ * no bounds and only ever uses memory for the cells that hold boxes.
+ * The grid is meant to be cleared and refilled whenever the boxes move.
+ * Queries don't change the grid, so any number of them can run at once,
+ * e.g. from force testers on different threads, as long as nothing is inserted.
+ *
+ * Each box has an id, a small index such as its position in an array:
+ * the grid keeps per-id state, so ids should be dense.
+ */
+typedef struct spatial_grid spatial_grid_t;
+
+/**
+ * Allocates an empty grid.
+ *
+ * @param cell_size the width and height of each cell; about the size of the
+ *   typical box or query works well
+ * @return the new grid
+ */
+spatial_grid_t *spatial_grid_init(double cell_size);
+
+/**
+ * Frees a grid.
+ *
+ * @param grid a grid returned from spatial_grid_init()
+ */
+void spatial_grid_free(spatial_grid_t *grid);
+
+/**
+ * Removes every box from a grid, keeping its memory for the next boxes.
+ *
+ * @param grid the grid
+ */
+void spatial_grid_clear(spatial_grid_t *grid);
+
+/**
+ * Reserves memory for boxes up to a given size, so filling the grid with them,
+ * e.g. every tick after spatial_grid_clear(), never allocates.
+ *
+ * @param grid the grid
+ * @param num_boxes how many boxes, with ids below num_boxes
+ * @param max_size the most any of them measures across
+ */
+void spatial_grid_reserve(spatial_grid_t *grid, size_t num_boxes, double max_size);
+
+/**
+ * Adds a box to a grid.
+ *
+ * @param grid the grid
+ * @param id the box's id, different from every other box in the grid
+ * @param min the box's lowest x and y
+ * @param max the box's highest x and y
+ */
+void spatial_grid_insert(spatial_grid_t *grid, size_t id, vector_t min, vector_t max);
+
+/**
+ * Returns the number of boxes in a grid.
+ *
+ * @param grid the grid
+ * @return the number of boxes added since it was last cleared
+ */
+size_t spatial_grid_size(spatial_grid_t *grid);
+
+/**
+ * Finds the boxes that overlap a region, each once, in no particular order.
+ *
+ * @param grid the grid
+ * @param min the region's lowest x and y
+ * @param max the region's highest x and y
+ * @param ids where to write the ids of the boxes found
+ * @param max_ids the most ids to write
+ * @return the number of boxes found, which may be more than max_ids
+ */
+size_t spatial_grid_query(spatial_grid_t *grid, vector_t min, vector_t max, size_t *ids, size_t max_ids);
+
+#endif // #ifndef __SPATIAL_GRID_H__
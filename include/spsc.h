@@ -0,0 +1,60 @@
+#ifndef __SPSC_H__
+#define __SPSC_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * A fixed-size, lock-free queue from one producer thread to one consumer thread,
+ * e.g. commands from the game loop to the audio callback.
+ *
+ * Neither end ever blocks or allocates: pushing to a full queue and popping
+ * from an empty one fail instead. Exactly one thread may push and exactly one
+ * (possibly different) thread may pop.
+ */
+typedef struct spsc spsc_t;
+
+/**
+ * Allocates an empty queue.
+ *
+ * @param capacity the most items the queue can hold; must be a power of two
+ * @param item_size the size of each item in bytes
+ * @return the new queue
+ */
+spsc_t *spsc_init(size_t capacity, size_t item_size);
+
+/**
+ * Frees a queue. Neither thread may use it any more.
+ *
+ * @param queue a queue returned from spsc_init()
+ */
+void spsc_free(spsc_t *queue);
+
+/**
+ * Adds a copy of an item to the back of a queue. Called only by the producer.
+ *
+ * @param queue the queue
+ * @param item the item_size bytes to copy in
+ * @return whether the item was added; false if the queue is full
+ */
+bool spsc_push(spsc_t *queue, const void *item);
+
+/**
+ * Removes the item at the front of a queue. Called only by the consumer.
+ *
+ * @param queue the queue
+ * @param item where to copy the item's item_size bytes
+ * @return whether an item was removed; false if the queue is empty
+ */
+bool spsc_pop(spsc_t *queue, void *item);
+
+/**
+ * Returns how many items a queue holds. Exact only when neither thread is using it,
+ * e.g. in tests; otherwise a snapshot.
+ *
+ * @param queue the queue
+ * @return the number of items
+ */
+size_t spsc_size(spsc_t *queue);
+
+#endif // #ifndef __SPSC_H__
@@ -15,6 +15,10 @@
  * Floating-point math is approximate, so isclose() is preferable to ==.
  * There are some exceptions: ints (<= 53 bits) and fractions whose denominators
  * are powers of 2 (e.g. 0.5 or 0.75) can be represented exactly as a double.
+ *
+ * When vector coordinates are floats (see real_t in vector.h), which only carry
+ * about 7 significant digits, the values must instead be within 10 ** -5
+ * times the larger magnitude, or 10 ** -5 if both are below 1.
  */
 bool isclose(double d1, double d2);
 
@@ -27,7 +31,7 @@ bool vec_equal(vector_t v1, vector_t v2);
 
 /**
  * Return if two vectors are close to each other; that is, if the corresponding
- * components are within 1e-7 of each other.
+ * components are within 1e-7 of each other, or close by isclose() in single precision.
  * This may be more useful than vec_equal, because vector components are
  * doubles, not integers, and floating-point math is approximate.
  */
@@ -3,14 +3,28 @@
 
 #include <stdbool.h>
 
+/**
+ * The type of each coordinate of a vector_t.
+ * Defining FAF_SINGLE_PRECISION (make SINGLE_PRECISION=1) makes coordinates floats,
+ * which halves the size of every vertex array. Scenes stay within a few tens of
+ * thousands of units of the origin, where a float is still precise to a few
+ * thousandths of a unit, well below a pixel. Other quantities such as masses,
+ * angles and times stay doubles.
+ */
+#ifdef FAF_SINGLE_PRECISION
+typedef float real_t;
+#else
+typedef double real_t;
+#endif
+
 /**
  * A real-valued 2-dimensional vector.
  * Positive x is towards the right; positive y is towards the top.
  * vector_t is defined here instead of vector.c because it is passed *by value*.
  */
 typedef struct {
-    double x;
-    double y;
+    real_t x;
+    real_t y;
 } vector_t;
 
 /**
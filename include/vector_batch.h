@@ -0,0 +1,178 @@
+#ifndef __VECTOR_BATCH_H__
+#define __VECTOR_BATCH_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "vector.h"
+
+/**
+ * Kernels that apply one vector operation to a contiguous array of points,
+ * e.g. the vertices of a body (see body_get_vertices()).
+ *
+ * Each kernel has a scalar version and, on x86, SSE2 and AVX2 versions.
+ * The fastest set the CPU supports is chosen the first time a kernel is called.
+ * Every version does the same floating-point operations in the same order
+ * as the functions in vector.h and polygon.h, so they all give identical results.
+ *
+ * With float coordinates (see real_t in vector.h) each SIMD register holds twice
+ * as many points. The versions still match each other exactly, but only approximately
+ * match vector.h and polygon.h, which round some intermediate results as doubles.
+ */
+
+/**
+ * A set of kernel implementations.
+ */
+typedef enum {
+    VEC_BATCH_SCALAR,
+    VEC_BATCH_SSE2,
+    VEC_BATCH_AVX2,
+    NUM_VEC_BATCH_ISAS
+} vec_batch_isa_t;
+
+/**
+ * Returns the fastest set of kernels this CPU supports.
+ *
+ * @return the set chosen by default
+ */
+vec_batch_isa_t vec_batch_best_isa();
+
+/**
+ * Returns the set of kernels currently in use.
+ *
+ * @return the set used by the vec_batch_*() functions
+ */
+vec_batch_isa_t vec_batch_get_isa();
+
+/**
+ * Switches every kernel to another set, e.g. to compare them.
+ * Must not be called while other threads may be running kernels.
+ * Asserts that the set is supported (see vec_batch_isa_supported()).
+ *
+ * @param isa the set of kernels to use
+ */
+void vec_batch_set_isa(vec_batch_isa_t isa);
+
+/**
+ * Returns whether this build and CPU can run a set of kernels.
+ *
+ * @param isa a set of kernels
+ * @return whether vec_batch_set_isa() accepts it
+ */
+bool vec_batch_isa_supported(vec_batch_isa_t isa);
+
+/**
+ * Gets the name of a set of kernels, e.g. "sse2".
+ *
+ * @param isa a set of kernels
+ * @return a string literal naming it
+ */
+const char *vec_batch_isa_name(vec_batch_isa_t isa);
+
+/**
+ * Adds a translation to every point, like polygon_translate().
+ *
+ * @param points the points to move
+ * @param n the number of points
+ * @param translation the vector to add to each point
+ */
+void vec_batch_translate(vector_t *points, size_t n, vector_t translation);
+
+/**
+ * Rotates every point about another point, like polygon_rotate().
+ *
+ * @param points the points to rotate
+ * @param n the number of points
+ * @param angle the angle to rotate by, in radians counterclockwise
+ * @param point the point to rotate about
+ */
+void vec_batch_rotate(vector_t *points, size_t n, double angle, vector_t point);
+
+/**
+ * Projects every point onto an axis and finds the smallest and largest projection,
+ * as in the separating axis test in find_collision().
+ *
+ * @param points the points to project
+ * @param n the number of points; must be positive
+ * @param axis the axis to take the dot product with
+ * @return the minimum projection in x and the maximum projection in y
+ */
+vector_t vec_batch_project(const vector_t *points, size_t n, vector_t axis);
+
+/**
+ * Computes the centroid of a polygon, like polygon_centroid().
+ *
+ * @param points the vertices of the polygon, in order
+ * @param n the number of vertices
+ * @return the centroid
+ */
+vector_t vec_batch_centroid(const vector_t *points, size_t n);
+
+/**
+ * Computes the centroids of polygons stored one after another.
+ *
+ * @param points the vertices of every polygon, in order
+ * @param sizes the number of vertices in each polygon
+ * @param num_polygons the number of polygons
+ * @param centroids where to write the centroid of each polygon
+ */
+void vec_batch_centroids(const vector_t *points, const size_t *sizes, size_t num_polygons,
+                         vector_t *centroids);
+
+/**
+ * Projects each of several polygons with the same number of vertices onto its own axis,
+ * like vec_batch_project(). The polygons run in parallel, one per SIMD lane.
+ *
+ * @param points the vertices of every polygon, n per polygon, one polygon after another
+ * @param n the number of vertices in each polygon; must be positive
+ * @param num_polygons the number of polygons
+ * @param axes the axis to project each polygon onto
+ * @param projections where to write each polygon's minimum projection in x and maximum in y
+ */
+void vec_batch_project_polygons(const vector_t *points, size_t n, size_t num_polygons,
+                                const vector_t *axes, vector_t *projections);
+
+/**
+ * Projects one polygon onto each of several axes, like vec_batch_project().
+ * The axes run in parallel, one per SIMD lane.
+ *
+ * @param points the vertices of the polygon
+ * @param n the number of vertices; must be positive
+ * @param axes the axes to project onto
+ * @param num_axes the number of axes
+ * @param projections where to write the minimum projection in x and maximum in y for each axis
+ */
+void vec_batch_project_axes(const vector_t *points, size_t n, const vector_t *axes, size_t num_axes,
+                            vector_t *projections);
+
+/**
+ * Computes the unit normal of the same edge of several polygons with the same
+ * number of vertices: the edge from vertex `edge` to the next vertex, made a unit
+ * vector and rotated by pi/2 with vec_rotate(), as in the separating axis test.
+ *
+ * @param points the vertices of every polygon, n per polygon, one polygon after another
+ * @param n the number of vertices in each polygon
+ * @param num_polygons the number of polygons
+ * @param edge the index of the first vertex of the edge; must be less than n
+ * @param normals where to write the normal of each polygon's edge
+ */
+void vec_batch_edge_normals(const vector_t *points, size_t n, size_t num_polygons, size_t edge,
+                            vector_t *normals);
+
+/**
+ * Converts points to pixels: each point is offset, scaled about the origin,
+ * flipped vertically and moved to the screen center, then rounded
+ * to the nearest pixel and clamped to the range of int16_t.
+ *
+ * @param points the points to convert
+ * @param n the number of points
+ * @param offset the vector to add to each point before scaling
+ * @param scale the number of pixels per unit
+ * @param screen_center the pixel that the origin maps to
+ * @param xs where to write the x coordinate of each pixel
+ * @param ys where to write the y coordinate of each pixel
+ */
+void vec_batch_to_screen(const vector_t *points, size_t n, vector_t offset, double scale,
+                         vector_t screen_center, int16_t *xs, int16_t *ys);
+
+#endif // #ifndef __VECTOR_BATCH_H__
@@ -11,6 +11,11 @@
  */
 typedef struct window window_t;
 
+/**
+ * The key handlers registered to a window, in the order they were added.
+ */
+typedef struct key_handlers key_handlers_t;
+
 /**
  * Allocates memory for a window.
  * Asserts that the required memory is successfully allocated.
@@ -154,9 +159,29 @@ void window_set_hud(window_t *window, hud_t *hud);
 
 void window_set_hud_no_free(window_t *window, hud_t *hud);
 
-list_t *window_get_key_handlers(window_t *window);
+/**
+ * Gets the key handlers registered to a window, e.g. to restore them later
+ * with window_set_key_handlers() after window_clear_key_handlers_no_free().
+ *
+ * @param window a pointer to a window returned from window_init()
+ * @return the window's key handlers
+ */
+key_handlers_t *window_get_key_handlers(window_t *window);
 
-void window_set_key_handlers(window_t *window, list_t *handlers);
+/**
+ * Replaces the key handlers of a window, freeing the current ones.
+ *
+ * @param window a pointer to a window returned from window_init()
+ * @param handlers key handlers returned from window_get_key_handlers()
+ */
+void window_set_key_handlers(window_t *window, key_handlers_t *handlers);
+
+/**
+ * Frees key handlers that no window uses any more, along with their auxiliary values.
+ *
+ * @param handlers key handlers returned from window_get_key_handlers()
+ */
+void window_free_key_handlers(key_handlers_t *handlers);
 
 /**
  * Gets the HUD for a given window.
@@ -0,0 +1,328 @@
+#include "alloc.h"
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+
+#ifdef _WIN32
+#define ALLOC_THREAD_LOCAL __declspec(thread)
+#else
+#define ALLOC_THREAD_LOCAL __thread
+#endif
+
+
+const size_t ALLOC_MAX_CALLSITES = 1024;
+const uint32_t ALLOC_CALLSITE_HASH = 2654435761u;
+
+const char ALLOC_TAG_NAMES[NUM_ALLOC_TAGS][12] = {
+    "other", "list", "body", "scene", "forces", "collision",
+    "shape", "window", "hud", "sdl", "game", "arena", "assets"
+};
+
+
+typedef struct alloc_callsite {
+    const char *file;
+    int line;
+    alloc_tag_t tag;
+    alloc_stats_t stats;
+} alloc_callsite_t;
+
+
+// Job workers allocate too, so the table and every counter below are only touched under this lock.
+// Tracking is a diagnostic build, and an uncontended spin lock costs little next to malloc() itself.
+SDL_SpinLock alloc_lock = 0;
+
+// Callsites are never removed, so an open-addressed table with linear probing
+// keeps recording to a hash and a couple of compares per allocation.
+alloc_callsite_t alloc_callsites[1024];
+size_t alloc_num_callsites = 0;
+size_t alloc_dropped_callsites = 0;
+
+alloc_stats_t alloc_totals[NUM_ALLOC_TAGS];
+alloc_stats_t alloc_curr_frame[NUM_ALLOC_TAGS];
+alloc_stats_t alloc_last_frame[NUM_ALLOC_TAGS];
+size_t alloc_num_frames = 0;
+
+typedef struct alloc_section {
+    const char *name;
+    // False for a cold section, which may allocate inside a hot one
+    bool hot;
+} alloc_section_t;
+
+// Each thread has its own sections, so a worker's allocation never trips the main thread's
+ALLOC_THREAD_LOCAL alloc_section_t alloc_sections[16];
+ALLOC_THREAD_LOCAL size_t alloc_section_depth = 0;
+size_t alloc_hot_violations = 0;
+bool alloc_hot_asserts = true;
+
+
+// Only the innermost section counts, so a cold section exempts everything inside it
+bool alloc_in_hot_section() {
+    return alloc_section_depth > 0 && alloc_sections[alloc_section_depth - 1].hot;
+}
+
+
+alloc_callsite_t *alloc_find_callsite(const char *file, int line, bool insert) {
+    size_t idx = ((uint32_t)line * ALLOC_CALLSITE_HASH) % ALLOC_MAX_CALLSITES;
+    for (size_t probes = 0; probes < ALLOC_MAX_CALLSITES; probes++) {
+        alloc_callsite_t *site = &alloc_callsites[idx];
+        if (!site->file) {
+            if (!insert || alloc_num_callsites == ALLOC_MAX_CALLSITES / 2) {
+                alloc_dropped_callsites += insert;
+                return NULL;
+            }
+            site->file = file;
+            site->line = line;
+            alloc_num_callsites++;
+            return site;
+        }
+        if (site->line == line && (site->file == file || strcmp(site->file, file) == 0)) {
+            return site;
+        }
+        idx = (idx + 1) % ALLOC_MAX_CALLSITES;
+    }
+    return NULL;
+}
+
+
+void alloc_record(alloc_tag_t tag, size_t size, const char *file, int line) {
+    assert(tag < NUM_ALLOC_TAGS);
+
+    SDL_AtomicLock(&alloc_lock);
+    alloc_totals[tag].allocs++;
+    alloc_totals[tag].bytes += size;
+    alloc_curr_frame[tag].allocs++;
+    alloc_curr_frame[tag].bytes += size;
+
+    alloc_callsite_t *site = alloc_find_callsite(file, line, true);
+    if (site) {
+        site->tag = tag;
+        site->stats.allocs++;
+        site->stats.bytes += size;
+    }
+    bool hot = alloc_in_hot_section();
+    if (hot) {
+        alloc_hot_violations++;
+    }
+    SDL_AtomicUnlock(&alloc_lock);
+
+    if (hot) {
+        if (alloc_hot_asserts) {
+            fprintf(stderr, "%s:%d allocated %zu bytes inside hot section \"%s\"\n",
+                    file, line, size, alloc_sections[alloc_section_depth - 1].name);
+            assert(!"allocation inside hot section");
+        }
+    }
+}
+
+
+void *alloc_malloc_at(alloc_tag_t tag, size_t size, const char *file, int line) {
+    alloc_record(tag, size, file, line);
+    return malloc(size);
+}
+
+
+void *alloc_calloc_at(alloc_tag_t tag, size_t count, size_t size, const char *file, int line) {
+    alloc_record(tag, count * size, file, line);
+    return calloc(count, size);
+}
+
+
+void *alloc_realloc_at(alloc_tag_t tag, void *ptr, size_t size, const char *file, int line) {
+    alloc_record(tag, size, file, line);
+    return realloc(ptr, size);
+}
+
+
+void alloc_free_at(alloc_tag_t tag, void *ptr) {
+    assert(tag < NUM_ALLOC_TAGS);
+    if (ptr) {
+        SDL_AtomicLock(&alloc_lock);
+        alloc_totals[tag].frees++;
+        alloc_curr_frame[tag].frees++;
+        SDL_AtomicUnlock(&alloc_lock);
+    }
+    free(ptr);
+}
+
+
+void alloc_frame_begin() {
+    SDL_AtomicLock(&alloc_lock);
+    memset(alloc_curr_frame, 0, sizeof(alloc_curr_frame));
+    SDL_AtomicUnlock(&alloc_lock);
+}
+
+
+void alloc_frame_end() {
+    SDL_AtomicLock(&alloc_lock);
+    memcpy(alloc_last_frame, alloc_curr_frame, sizeof(alloc_last_frame));
+    memset(alloc_curr_frame, 0, sizeof(alloc_curr_frame));
+    alloc_num_frames++;
+    SDL_AtomicUnlock(&alloc_lock);
+}
+
+
+alloc_stats_t alloc_get_frame_stats(alloc_tag_t tag) {
+    assert(tag < NUM_ALLOC_TAGS);
+    SDL_AtomicLock(&alloc_lock);
+    alloc_stats_t stats = alloc_last_frame[tag];
+    SDL_AtomicUnlock(&alloc_lock);
+    return stats;
+}
+
+
+alloc_stats_t alloc_get_total_stats(alloc_tag_t tag) {
+    assert(tag < NUM_ALLOC_TAGS);
+    SDL_AtomicLock(&alloc_lock);
+    alloc_stats_t stats = alloc_totals[tag];
+    SDL_AtomicUnlock(&alloc_lock);
+    return stats;
+}
+
+
+size_t alloc_get_num_frames() {
+    SDL_AtomicLock(&alloc_lock);
+    size_t num_frames = alloc_num_frames;
+    SDL_AtomicUnlock(&alloc_lock);
+    return num_frames;
+}
+
+
+alloc_stats_t alloc_get_callsite_stats(const char *file, int line) {
+    assert(file);
+    alloc_stats_t stats = {.allocs = 0, .bytes = 0, .frees = 0};
+    SDL_AtomicLock(&alloc_lock);
+    alloc_callsite_t *site = alloc_find_callsite(file, line, false);
+    if (site) {
+        stats = site->stats;
+    }
+    SDL_AtomicUnlock(&alloc_lock);
+    return stats;
+}
+
+
+void alloc_reset() {
+    SDL_AtomicLock(&alloc_lock);
+    memset(alloc_callsites, 0, sizeof(alloc_callsites));
+    memset(alloc_totals, 0, sizeof(alloc_totals));
+    memset(alloc_curr_frame, 0, sizeof(alloc_curr_frame));
+    memset(alloc_last_frame, 0, sizeof(alloc_last_frame));
+    alloc_num_callsites = 0;
+    alloc_dropped_callsites = 0;
+    alloc_num_frames = 0;
+    alloc_hot_violations = 0;
+    SDL_AtomicUnlock(&alloc_lock);
+    alloc_section_depth = 0;
+}
+
+
+void alloc_section_begin(const char *name, bool hot) {
+    assert(alloc_section_depth < sizeof(alloc_sections) / sizeof(*alloc_sections));
+    alloc_sections[alloc_section_depth++] = (alloc_section_t){.name = name, .hot = hot};
+}
+
+
+void alloc_section_end(bool hot) {
+    assert(alloc_section_depth > 0);
+    assert(alloc_sections[alloc_section_depth - 1].hot == hot);
+    alloc_section_depth--;
+}
+
+
+void alloc_hot_section_begin(const char *name) {
+    alloc_section_begin(name, true);
+}
+
+
+void alloc_hot_section_end() {
+    alloc_section_end(true);
+}
+
+
+void alloc_cold_section_begin(const char *name) {
+    alloc_section_begin(name, false);
+}
+
+
+void alloc_cold_section_end() {
+    alloc_section_end(false);
+}
+
+
+void alloc_set_hot_asserts(bool enabled) {
+    alloc_hot_asserts = enabled;
+}
+
+
+size_t alloc_get_hot_violations() {
+    SDL_AtomicLock(&alloc_lock);
+    size_t violations = alloc_hot_violations;
+    SDL_AtomicUnlock(&alloc_lock);
+    return violations;
+}
+
+
+const char *alloc_tag_name(alloc_tag_t tag) {
+    assert(tag < NUM_ALLOC_TAGS);
+    return ALLOC_TAG_NAMES[tag];
+}
+
+
+int alloc_compare_callsites(const void *a, const void *b) {
+    const alloc_callsite_t *site1 = *(const alloc_callsite_t **)a;
+    const alloc_callsite_t *site2 = *(const alloc_callsite_t **)b;
+    if (site1->stats.allocs != site2->stats.allocs) {
+        return site1->stats.allocs < site2->stats.allocs ? 1 : -1;
+    }
+    if (site1->stats.bytes != site2->stats.bytes) {
+        return site1->stats.bytes < site2->stats.bytes ? 1 : -1;
+    }
+    // Ties go by position in the source, so the report's order doesn't depend on the table's
+    int files = strcmp(site1->file, site2->file);
+    if (files != 0) {
+        return files;
+    }
+    return (site1->line > site2->line) - (site1->line < site2->line);
+}
+
+
+void alloc_print_report(FILE *out, size_t max_callsites) {
+    assert(out);
+    // Allocations made while the report prints wait for it rather than changing it halfway
+    SDL_AtomicLock(&alloc_lock);
+    double frames = alloc_num_frames > 0 ? (double)alloc_num_frames : 1.;
+
+    fprintf(out, "allocations over %zu frames\n", alloc_num_frames);
+    fprintf(out, "  %-10s %12s %14s %12s %12s\n", "tag", "allocs", "bytes", "allocs/frm", "bytes/frm");
+    for (size_t i = 0; i < NUM_ALLOC_TAGS; i++) {
+        alloc_stats_t stats = alloc_totals[i];
+        if (stats.allocs == 0) {
+            continue;
+        }
+        fprintf(out, "  %-10s %12zu %14zu %12.2f %12.1f\n", ALLOC_TAG_NAMES[i], stats.allocs,
+                stats.bytes, stats.allocs / frames, stats.bytes / frames);
+    }
+    if (alloc_hot_violations > 0) {
+        fprintf(out, "  %zu allocations inside hot sections\n", alloc_hot_violations);
+    }
+
+    alloc_callsite_t *sorted[1024];
+    size_t num_sorted = 0;
+    for (size_t i = 0; i < ALLOC_MAX_CALLSITES; i++) {
+        if (alloc_callsites[i].file) {
+            sorted[num_sorted++] = &alloc_callsites[i];
+        }
+    }
+    qsort(sorted, num_sorted, sizeof(*sorted), alloc_compare_callsites);
+
+    fprintf(out, "busiest callsites\n");
+    for (size_t i = 0; i < num_sorted && i < max_callsites; i++) {
+        alloc_callsite_t *site = sorted[i];
+        fprintf(out, "  %-32s:%-5d %-10s %12zu %14zu\n", site->file, site->line,
+                ALLOC_TAG_NAMES[site->tag], site->stats.allocs, site->stats.bytes);
+    }
+    if (alloc_dropped_callsites > 0) {
+        fprintf(out, "  (%zu allocations from callsites past the table limit)\n", alloc_dropped_callsites);
+    }
+    SDL_AtomicUnlock(&alloc_lock);
+}
@@ -0,0 +1,110 @@
+#include "arena.h"
+#include "alloc.h"
+#include <assert.h>
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+const size_t ARENA_DEFAULT_BLOCK_SIZE = 64 * 1024;
+const size_t ARENA_ALIGNMENT = alignof(max_align_t);
+
+
+// Blocks are chained newest first; the data follows the header
+typedef struct arena_block {
+    struct arena_block *next;
+    size_t size;
+    size_t used;
+    max_align_t data[];
+} arena_block_t;
+
+
+typedef struct arena {
+    arena_block_t *blocks;
+    size_t block_size;
+    size_t bytes_used;
+    size_t num_blocks;
+} arena_t;
+
+
+arena_t *arena_init(size_t block_size) {
+    if (block_size == 0) {
+        block_size = ARENA_DEFAULT_BLOCK_SIZE;
+    }
+
+    arena_t *arena = alloc_malloc(ALLOC_TAG_ARENA, sizeof(arena_t));
+    assert(arena);
+    arena->blocks = NULL;
+    arena->block_size = block_size;
+    arena->bytes_used = 0;
+    arena->num_blocks = 0;
+    return arena;
+}
+
+
+void arena_free(arena_t *arena) {
+    assert(arena);
+
+    arena_block_t *block = arena->blocks;
+    while (block) {
+        arena_block_t *next = block->next;
+        alloc_free(ALLOC_TAG_ARENA, block);
+        block = next;
+    }
+    alloc_free(ALLOC_TAG_ARENA, arena);
+}
+
+
+arena_block_t *arena_add_block(arena_t *arena, size_t size) {
+    arena_block_t *block = alloc_malloc(ALLOC_TAG_ARENA, sizeof(arena_block_t) + size);
+    assert(block);
+    block->size = size;
+    block->used = 0;
+    arena->num_blocks++;
+    return block;
+}
+
+
+void *arena_alloc(arena_t *arena, size_t size) {
+    assert(arena);
+
+    size_t padded = (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+    arena_block_t *block = arena->blocks;
+    if (!block || block->size - block->used < padded) {
+        if (padded > arena->block_size / 4) {
+            // Too big to share a block; keep the current block in front so its space isn't lost
+            block = arena_add_block(arena, padded);
+            if (arena->blocks) {
+                block->next = arena->blocks->next;
+                arena->blocks->next = block;
+            }
+            else {
+                block->next = NULL;
+                arena->blocks = block;
+            }
+        }
+        else {
+            block = arena_add_block(arena, arena->block_size);
+            block->next = arena->blocks;
+            arena->blocks = block;
+        }
+    }
+
+    void *memory = (char *)block->data + block->used;
+    block->used += padded;
+    arena->bytes_used += size;
+    return memory;
+}
+
+
+size_t arena_bytes_used(arena_t *arena) {
+    assert(arena);
+
+    return arena->bytes_used;
+}
+
+
+size_t arena_num_blocks(arena_t *arena) {
+    assert(arena);
+
+    return arena->num_blocks;
+}
@@ -0,0 +1,540 @@
+#include "assets.h"
+#include "alloc.h"
+#include "dynarray.h"
+#include "jobs.h"
+#include "pack.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+// The path table is doubled whenever it would become more than half full
+#define ASSETS_INIT_TABLE_SIZE 128
+const size_t ASSETS_EMPTY_SLOT = SIZE_MAX;
+const uint64_t ASSETS_FNV_OFFSET = UINT64_C(14695981039346656037);
+const uint64_t ASSETS_FNV_PRIME = UINT64_C(1099511628211);
+
+
+typedef enum {
+    ASSET_IMAGE,
+    ASSET_FILE
+} asset_kind_t;
+
+
+typedef struct asset {
+    char *path;
+    asset_kind_t kind;
+    // Written by whichever thread decodes the asset, before it is put on the ready queue
+    SDL_Surface *surface;
+    void *data;
+    size_t size;
+    SDL_Texture *texture;
+    // The job decoding the asset, until the main thread has waited on it
+    job_t *job;
+    // Whether the surface's pixels or the data are inside assets_pack, rather than owned by the asset
+    bool packed;
+    bool ready;
+    bool preloaded;
+} asset_t;
+
+DYNARRAY_DEFINE(asset_array, asset_t *, 1)
+
+
+bool assets_initialized = false;
+SDL_Renderer *assets_renderer = NULL;
+// Assets found in the archive are used from it instead of being decoded or read
+pack_t *assets_pack = NULL;
+asset_array_t assets_all;
+// Indices into assets_all by the hash of their paths, with linear probing
+size_t *assets_table = NULL;
+size_t assets_table_size = 0;
+
+// Decoded assets waiting for the main thread. Space for every preloaded asset is
+// reserved up front, so workers never allocate while holding the lock.
+asset_array_t assets_ready;
+size_t assets_ready_head = 0;
+SDL_SpinLock assets_ready_lock = 0;
+// Preloaded assets that assets_pump() decodes itself when there are no workers
+asset_array_t assets_unstarted;
+size_t assets_unstarted_head = 0;
+
+size_t assets_num_preloaded = 0;
+size_t assets_num_preloaded_ready = 0;
+
+
+void assets_init() {
+    if (assets_initialized) {
+        return;
+    }
+    asset_array_init(&assets_all);
+    asset_array_init(&assets_ready);
+    asset_array_init(&assets_unstarted);
+    assets_table_size = ASSETS_INIT_TABLE_SIZE;
+    assets_table = alloc_malloc(ALLOC_TAG_ASSETS, sizeof(size_t) * assets_table_size);
+    assert(assets_table);
+    for (size_t i = 0; i < assets_table_size; i++) {
+        assets_table[i] = ASSETS_EMPTY_SLOT;
+    }
+    assets_initialized = true;
+}
+
+
+// FNV-1a
+uint64_t assets_hash(const char *path) {
+    uint64_t hash = ASSETS_FNV_OFFSET;
+    for (const char *c = path; *c; c++) {
+        hash = (hash ^ (uint8_t)*c) * ASSETS_FNV_PRIME;
+    }
+    return hash;
+}
+
+
+// Returns the slot holding the asset with this path, or the empty slot where it would go
+size_t *assets_find_slot(const char *path) {
+    size_t mask = assets_table_size - 1;
+    for (size_t i = assets_hash(path) & mask;; i = (i + 1) & mask) {
+        size_t index = assets_table[i];
+        if (index == ASSETS_EMPTY_SLOT || strcmp(asset_array_data(&assets_all)[index]->path, path) == 0) {
+            return &assets_table[i];
+        }
+    }
+}
+
+
+asset_t *assets_find(const char *path) {
+    assets_init();
+    size_t index = *assets_find_slot(path);
+    return index == ASSETS_EMPTY_SLOT ? NULL : asset_array_data(&assets_all)[index];
+}
+
+
+void assets_grow_table() {
+    size_t *old_table = assets_table;
+    size_t old_size = assets_table_size;
+    assets_table_size *= 2;
+    assets_table = alloc_malloc(ALLOC_TAG_ASSETS, sizeof(size_t) * assets_table_size);
+    assert(assets_table);
+    for (size_t i = 0; i < assets_table_size; i++) {
+        assets_table[i] = ASSETS_EMPTY_SLOT;
+    }
+    for (size_t i = 0; i < old_size; i++) {
+        if (old_table[i] != ASSETS_EMPTY_SLOT) {
+            *assets_find_slot(asset_array_data(&assets_all)[old_table[i]]->path) = old_table[i];
+        }
+    }
+    alloc_free(ALLOC_TAG_ASSETS, old_table);
+}
+
+
+// Adds an asset that is not in the cache yet; it is decoded later
+asset_t *assets_add(const char *path, asset_kind_t kind) {
+    assets_init();
+    if (2 * (asset_array_size(&assets_all) + 1) > assets_table_size) {
+        assets_grow_table();
+    }
+
+    asset_t *asset = alloc_malloc(ALLOC_TAG_ASSETS, sizeof(asset_t));
+    assert(asset);
+    size_t path_size = strlen(path) + 1;
+    asset->path = alloc_malloc(ALLOC_TAG_ASSETS, path_size);
+    assert(asset->path);
+    memcpy(asset->path, path, path_size);
+    asset->kind = kind;
+    asset->surface = NULL;
+    asset->data = NULL;
+    asset->size = 0;
+    asset->texture = NULL;
+    asset->job = NULL;
+    asset->packed = false;
+    asset->ready = false;
+    asset->preloaded = false;
+
+    *assets_find_slot(path) = asset_array_size(&assets_all);
+    asset_array_push(&assets_all, asset);
+    return asset;
+}
+
+
+// Uses an asset from the archive without copying it; only encoded images are decoded
+bool asset_unpack(asset_t *asset) {
+    const pack_entry_t *entry = assets_pack ? pack_find(assets_pack, pack_id(asset->path)) : NULL;
+    if (!entry || (entry->kind == PACK_PIXELS && asset->kind != ASSET_IMAGE)) {
+        return false;
+    }
+    const void *contents = pack_entry_data(assets_pack, entry);
+    if (entry->kind == PACK_PIXELS) {
+        // SDL only reads the pixels of a surface it didn't allocate, and never frees them
+        asset->surface = SDL_CreateRGBSurfaceWithFormatFrom((void *)contents, (int)entry->width, (int)entry->height,
+                                                            32, (int)entry->width * 4, SDL_PIXELFORMAT_RGBA32);
+        asset->packed = true;
+    }
+    else if (asset->kind == ASSET_IMAGE) {
+        asset->surface = IMG_Load_RW(SDL_RWFromConstMem(contents, (int)entry->size), 1);
+    }
+    else {
+        asset->data = (void *)contents;
+        asset->size = entry->size;
+        asset->packed = true;
+    }
+    return true;
+}
+
+
+void asset_decode(asset_t *asset) {
+    if (asset_unpack(asset)) {
+        return;
+    }
+    if (asset->kind == ASSET_IMAGE) {
+        asset->surface = IMG_Load(asset->path);
+    }
+    else {
+        asset->data = SDL_LoadFile(asset->path, &asset->size);
+    }
+}
+
+
+void asset_decode_job(void *aux) {
+    asset_t *asset = aux;
+    asset_decode(asset);
+
+    SDL_AtomicLock(&assets_ready_lock);
+    asset_array_push(&assets_ready, asset);
+    SDL_AtomicUnlock(&assets_ready_lock);
+}
+
+
+// Makes an asset ready to use on the main thread, decoding it first if no job has
+void asset_finish(asset_t *asset) {
+    if (asset->ready) {
+        return;
+    }
+    if (asset->job) {
+        job_wait(asset->job);
+        asset->job = NULL;
+    }
+    else {
+        asset_decode(asset);
+    }
+
+    if (asset->surface) {
+        // Lets assets_get_texture() find the asset from the surface
+        asset->surface->userdata = asset;
+        if (assets_renderer) {
+            asset->texture = SDL_CreateTextureFromSurface(assets_renderer, asset->surface);
+        }
+    }
+    asset->ready = true;
+    if (asset->preloaded) {
+        assets_num_preloaded_ready++;
+    }
+}
+
+
+asset_t *assets_get(const char *path, asset_kind_t kind) {
+    assert(path);
+
+    asset_t *asset = assets_find(path);
+    if (!asset) {
+        asset = assets_add(path, kind);
+    }
+    assert(asset->kind == kind);
+    asset_finish(asset);
+    return asset;
+}
+
+
+void assets_set_renderer(SDL_Renderer *renderer) {
+    assets_renderer = renderer;
+}
+
+
+// Images are decoded into surfaces; fonts and sounds are only read, since
+// SDL_ttf and SDL_mixer have to open them on the main thread
+bool assets_kind_of(const char *path, asset_kind_t *kind) {
+    const char *extension = strrchr(path, '.');
+    if (!extension) {
+        return false;
+    }
+    if (strcmp(extension, ".png") == 0 || strcmp(extension, ".jpg") == 0) {
+        *kind = ASSET_IMAGE;
+        return true;
+    }
+    if (strcmp(extension, ".ttf") == 0 || strcmp(extension, ".wav") == 0) {
+        *kind = ASSET_FILE;
+        return true;
+    }
+    return false;
+}
+
+
+void assets_preload_file(const char *path, bool use_jobs) {
+    asset_kind_t kind;
+    if (!assets_kind_of(path, &kind) || assets_find(path)) {
+        return;
+    }
+    asset_t *asset = assets_add(path, kind);
+    asset->preloaded = true;
+    assets_num_preloaded++;
+
+    if (use_jobs) {
+        SDL_AtomicLock(&assets_ready_lock);
+        // Each preloaded asset is pushed once, and the queue is only emptied once drained
+        asset_array_reserve(&assets_ready, assets_num_preloaded);
+        SDL_AtomicUnlock(&assets_ready_lock);
+        asset->job = job_create(asset_decode_job, asset);
+        job_submit(asset->job);
+    }
+    else {
+        asset_array_push(&assets_unstarted, asset);
+    }
+}
+
+
+#ifdef _WIN32
+bool assets_is_dir(const char *path) {
+    DWORD attributes = GetFileAttributesA(path);
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+#else
+bool assets_is_dir(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+#endif
+
+
+void assets_preload_dir(const char *dir, bool use_jobs);
+
+
+// Preloads one entry of a directory, walking into it if it is a directory itself
+void assets_preload_entry(const char *dir, const char *name, bool use_jobs) {
+    // Skips ".", ".." and hidden files such as .DS_Store
+    if (name[0] == '.') {
+        return;
+    }
+    size_t path_size = strlen(dir) + strlen(name) + 2;
+    char *path = alloc_malloc(ALLOC_TAG_ASSETS, path_size);
+    assert(path);
+    snprintf(path, path_size, "%s/%s", dir, name);
+    if (assets_is_dir(path)) {
+        assets_preload_dir(path, use_jobs);
+    }
+    else {
+        assets_preload_file(path, use_jobs);
+    }
+    alloc_free(ALLOC_TAG_ASSETS, path);
+}
+
+
+#ifdef _WIN32
+void assets_preload_dir(const char *dir, bool use_jobs) {
+    size_t pattern_size = strlen(dir) + 3;
+    char *pattern = alloc_malloc(ALLOC_TAG_ASSETS, pattern_size);
+    assert(pattern);
+    snprintf(pattern, pattern_size, "%s/*", dir);
+    WIN32_FIND_DATAA entry;
+    HANDLE find = FindFirstFileA(pattern, &entry);
+    alloc_free(ALLOC_TAG_ASSETS, pattern);
+    if (find == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    do {
+        assets_preload_entry(dir, entry.cFileName, use_jobs);
+    } while (FindNextFileA(find, &entry));
+    FindClose(find);
+}
+#else
+void assets_preload_dir(const char *dir, bool use_jobs) {
+    DIR *d = opendir(dir);
+    if (!d) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        assets_preload_entry(dir, entry->d_name, use_jobs);
+    }
+    closedir(d);
+}
+#endif
+
+
+// Preloads the archive's assets in a directory, which needn't exist outside the archive
+void assets_preload_pack(const char *dir, bool use_jobs) {
+    size_t dir_length = strlen(dir);
+    for (size_t i = 0; i < pack_num_entries(assets_pack); i++) {
+        const char *path = pack_entry_path(assets_pack, pack_get_entry(assets_pack, i));
+        if (strncmp(path, dir, dir_length) == 0 && path[dir_length] == '/') {
+            assets_preload_file(path, use_jobs);
+        }
+    }
+}
+
+
+void assets_preload(const char *dir) {
+    assert(dir);
+    assets_init();
+
+    bool use_jobs = jobs_num_threads() > 1;
+    if (assets_pack) {
+        assets_preload_pack(dir, use_jobs);
+    }
+    else {
+        assets_preload_dir(dir, use_jobs);
+    }
+}
+
+
+bool assets_open_pack(const char *path) {
+    assert(path);
+    assets_init();
+    assert(!assets_pack);
+
+    assets_pack = pack_open(path);
+    return assets_pack != NULL;
+}
+
+
+asset_t *assets_pop_ready() {
+    asset_t *asset = NULL;
+    SDL_AtomicLock(&assets_ready_lock);
+    if (assets_ready_head < asset_array_size(&assets_ready)) {
+        asset = asset_array_data(&assets_ready)[assets_ready_head++];
+    }
+    if (assets_ready_head == asset_array_size(&assets_ready)) {
+        asset_array_clear(&assets_ready);
+        assets_ready_head = 0;
+    }
+    SDL_AtomicUnlock(&assets_ready_lock);
+    return asset;
+}
+
+
+asset_t *assets_pop_unstarted() {
+    if (assets_unstarted_head == asset_array_size(&assets_unstarted)) {
+        return NULL;
+    }
+    asset_t *asset = asset_array_data(&assets_unstarted)[assets_unstarted_head++];
+    if (assets_unstarted_head == asset_array_size(&assets_unstarted)) {
+        asset_array_clear(&assets_unstarted);
+        assets_unstarted_head = 0;
+    }
+    return asset;
+}
+
+
+bool assets_pump(double max_time) {
+    assets_init();
+
+    uint64_t start = SDL_GetPerformanceCounter();
+    uint64_t max_ticks = (uint64_t)(max_time * SDL_GetPerformanceFrequency());
+    while (assets_num_preloaded_ready < assets_num_preloaded) {
+        asset_t *asset = assets_pop_ready();
+        if (!asset) {
+            asset = assets_pop_unstarted();
+        }
+        if (!asset) {
+            // The rest are still being decoded
+            break;
+        }
+        asset_finish(asset);
+        if (SDL_GetPerformanceCounter() - start >= max_ticks) {
+            break;
+        }
+    }
+    return assets_num_preloaded_ready == assets_num_preloaded;
+}
+
+
+double assets_progress() {
+    return assets_num_preloaded == 0 ? 1 : (double)assets_num_preloaded_ready / assets_num_preloaded;
+}
+
+
+SDL_Surface *assets_get_surface(const char *path) {
+    asset_t *asset = assets_get(path, ASSET_IMAGE);
+    if (asset->surface) {
+        asset->surface->refcount++;
+    }
+    return asset->surface;
+}
+
+
+SDL_Texture *assets_get_texture(SDL_Surface *surface) {
+    assert(surface);
+
+    asset_t *asset = surface->userdata;
+    if (!asset || asset->surface != surface) {
+        return NULL;
+    }
+    if (!asset->texture && assets_renderer) {
+        asset->texture = SDL_CreateTextureFromSurface(assets_renderer, surface);
+    }
+    return asset->texture;
+}
+
+
+const void *assets_get_data(const char *path, size_t *size) {
+    assert(size);
+
+    asset_t *asset = assets_get(path, ASSET_FILE);
+    *size = asset->size;
+    return asset->data;
+}
+
+
+TTF_Font *assets_open_font(const char *path, int point_size) {
+    size_t size;
+    const void *data = assets_get_data(path, &size);
+    if (!data) {
+        return NULL;
+    }
+    // The font reads from the cached contents, which outlive it
+    return TTF_OpenFontRW(SDL_RWFromConstMem(data, (int)size), 1, point_size);
+}
+
+
+void assets_free() {
+    if (!assets_initialized) {
+        return;
+    }
+
+    for (size_t i = 0; i < asset_array_size(&assets_all); i++) {
+        asset_t *asset = asset_array_data(&assets_all)[i];
+        if (asset->job) {
+            job_wait(asset->job);
+        }
+        if (asset->texture) {
+            SDL_DestroyTexture(asset->texture);
+        }
+        if (asset->surface) {
+            asset->surface->userdata = NULL;
+            SDL_FreeSurface(asset->surface);
+        }
+        if (!asset->packed) {
+            SDL_free(asset->data);
+        }
+        alloc_free(ALLOC_TAG_ASSETS, asset->path);
+        alloc_free(ALLOC_TAG_ASSETS, asset);
+    }
+    asset_array_free(&assets_all);
+    asset_array_free(&assets_ready);
+    asset_array_free(&assets_unstarted);
+    alloc_free(ALLOC_TAG_ASSETS, assets_table);
+    if (assets_pack) {
+        pack_close(assets_pack);
+        assets_pack = NULL;
+    }
+    assets_table = NULL;
+    assets_table_size = 0;
+    assets_ready_head = 0;
+    assets_unstarted_head = 0;
+    assets_num_preloaded = 0;
+    assets_num_preloaded_ready = 0;
+    assets_initialized = false;
+}
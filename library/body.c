@@ -1,35 +1,386 @@
+#include "alloc.h"
+#include "assets.h"
 #include "body.h"
 #include "collision.h"
 #include "forces.h"
+#include "jobs.h"
 #include "polygon.h"
+#include "vector_batch.h"
 #include <assert.h>
+#include "debug_assert.h"
+#include <stdint.h>
 #include <stdlib.h>
 
+// Shapes with at most this many vertices are stored in the body itself
+#define BODY_INLINE_VERTICES 4
+
 const size_t BODY_INIT_TICK_FUNC_COUNT = 10;
 const size_t BODY_INIT_FORCES_COUNT = 10;
 const size_t BODY_INIT_SURFACE_COUNT = 10;
-
-typedef struct body {
+const size_t BODY_NUM_CATEGORIES = 8;
+const size_t BODY_STORE_INIT_CAPACITY = 64;
+const size_t BODY_INTEGRATE_GRAIN = 512;
+const size_t BODY_POOL_CHUNK_SIZE = 256;
+const size_t BODY_POOL_INIT_CHUNKS = 4;
+// Marks the end of the pool's free list
+const uint32_t BODY_POOL_NO_SLOT = UINT32_MAX;
+const body_handle_t BODY_NULL_HANDLE = {.index = UINT32_MAX, .generation = 0};
+
+
+// Kinematic state of every body in the store, indexed by slot
+typedef struct body_store {
+    size_t size;
+    size_t capacity;
+    // Incremented by body_store_tick(); a slot is integrated when its tick matches
+    size_t tick;
+    body_t **bodies;
+    vector_t *centroids;
+    vector_t *velocities;
+    vector_t *forces;
+    vector_t *impulses;
+    double *inv_masses;
+    // How far to move the body at the end of its current tick
+    vector_t *movements;
+    size_t *ticks;
+} body_store_t;
+
+
+// The parts of a body that only drawing and game logic use,
+// kept apart so collision tests and integration walk fewer cache lines
+typedef struct body_cold {
+    // Points into the body's vertices; created on first use by body_get_shape_nocpy()
     list_t *shape;
-    vector_t velocity;
-    double mass;
     rgb_color_t color;
-    vector_t centroid;
-    double curr_rotation;
+    // Created on first use, since most bodies never have tick functions or sprites
     list_t *tick_funcs;
-    vector_t pending_force;
-    vector_t pending_impulse;
     void *info;
     free_func_t info_freer;
-    bool removed;
-    double bounding_radius;
     SDL_Surface *surface;
     list_t *surface_list;
+    // The shared image of the body's sprite file, released when the body is freed
+    SDL_Surface *sprite;
     vector_t dimensions;
     bool debug_mode;
+} body_cold_t;
+
+
+typedef struct body {
+    // Where the body lives in the pool; the generation changes every time the slot is freed
+    uint32_t pool_index;
+    uint32_t generation;
+    uint32_t next_free;
+    bool live;
+    bool removed;
+    bool has_tick_funcs;
+    // Either inline_vertices or its own allocation
+    vector_t *vertices;
+    size_t num_vertices;
+    body_store_t *store;
+    size_t slot;
+    double mass;
+    double curr_rotation;
+    double bounding_radius;
+    size_t category;
+    // The slot with the same index in the pool's cold chunks
+    body_cold_t *cold;
+    vector_t inline_vertices[BODY_INLINE_VERTICES];
 } body_t;
 
 
+// Every body, in fixed-size chunks so a body never moves once allocated.
+// Each chunk of bodies has a matching chunk of their cold parts.
+typedef struct body_pool {
+    body_t **chunks;
+    body_cold_t **cold_chunks;
+    size_t num_chunks;
+    size_t chunk_capacity;
+    // Slots handed out so far; the rest of the last chunk is untouched
+    uint32_t num_slots;
+    uint32_t free_head;
+    size_t num_live;
+} body_pool_t;
+
+
+// Holds bodies that haven't been added to a scene
+body_store_t *body_default_store = NULL;
+
+body_pool_t body_pool = {
+    .chunks = NULL, .cold_chunks = NULL, .num_chunks = 0, .chunk_capacity = 0, .num_slots = 0, .free_head = UINT32_MAX, .num_live = 0
+};
+
+
+body_t *body_pool_get(uint32_t index) {
+    return &body_pool.chunks[index / BODY_POOL_CHUNK_SIZE][index % BODY_POOL_CHUNK_SIZE];
+}
+
+
+// Takes a free slot, reusing the most recently freed one first
+body_t *body_pool_alloc() {
+    body_t *body;
+    if (body_pool.free_head != BODY_POOL_NO_SLOT) {
+        body = body_pool_get(body_pool.free_head);
+        body_pool.free_head = body->next_free;
+    }
+    else {
+        assert(body_pool.num_slots < BODY_POOL_NO_SLOT);
+        if (body_pool.num_slots == body_pool.num_chunks * BODY_POOL_CHUNK_SIZE) {
+            if (body_pool.num_chunks == body_pool.chunk_capacity) {
+                body_pool.chunk_capacity = body_pool.chunk_capacity ? 2 * body_pool.chunk_capacity
+                                                                    : BODY_POOL_INIT_CHUNKS;
+                body_pool.chunks = alloc_realloc(ALLOC_TAG_BODY, body_pool.chunks,
+                                                 sizeof(body_t *) * body_pool.chunk_capacity);
+                body_pool.cold_chunks = alloc_realloc(ALLOC_TAG_BODY, body_pool.cold_chunks,
+                                                      sizeof(body_cold_t *) * body_pool.chunk_capacity);
+                assert(body_pool.chunks && body_pool.cold_chunks);
+            }
+            body_t *chunk = alloc_malloc(ALLOC_TAG_BODY, sizeof(body_t) * BODY_POOL_CHUNK_SIZE);
+            body_cold_t *cold_chunk = alloc_malloc(ALLOC_TAG_BODY, sizeof(body_cold_t) * BODY_POOL_CHUNK_SIZE);
+            assert(chunk && cold_chunk);
+            body_pool.chunks[body_pool.num_chunks] = chunk;
+            body_pool.cold_chunks[body_pool.num_chunks++] = cold_chunk;
+        }
+        uint32_t index = body_pool.num_slots++;
+        body = body_pool_get(index);
+        body->pool_index = index;
+        body->cold = &body_pool.cold_chunks[index / BODY_POOL_CHUNK_SIZE][index % BODY_POOL_CHUNK_SIZE];
+        // Generation 0 is never live, so BODY_NULL_HANDLE never matches a body
+        body->generation = 0;
+    }
+    body->generation++;
+    body->live = true;
+    body_pool.num_live++;
+    return body;
+}
+
+
+void body_pool_release(body_t *body) {
+    body->live = false;
+    body->next_free = body_pool.free_head;
+    body_pool.free_head = body->pool_index;
+    body_pool.num_live--;
+}
+
+
+// Catches bodies used after body_free(); their slot stays mapped until it is reused
+bool body_is_live(body_t *body) {
+    return body && body->live;
+}
+
+
+body_handle_t body_get_handle(body_t *body) {
+    DEBUG_ASSERT(body_is_live(body));
+
+    return (body_handle_t){.index = body->pool_index, .generation = body->generation};
+}
+
+
+body_t *body_from_handle(body_handle_t handle) {
+    if (handle.index >= body_pool.num_slots) {
+        return NULL;
+    }
+    body_t *body = body_pool_get(handle.index);
+    if (!body->live || body->generation != handle.generation) {
+        return NULL;
+    }
+    return body;
+}
+
+
+size_t body_pool_num_live() {
+    return body_pool.num_live;
+}
+
+
+body_store_t *body_store_init(size_t capacity) {
+    if (capacity == 0) {
+        capacity = BODY_STORE_INIT_CAPACITY;
+    }
+
+    body_store_t *store = alloc_malloc(ALLOC_TAG_BODY, sizeof(body_store_t));
+    assert(store);
+    store->size = 0;
+    store->capacity = capacity;
+    store->tick = 0;
+    store->bodies = alloc_malloc(ALLOC_TAG_BODY, sizeof(body_t *) * capacity);
+    store->centroids = alloc_malloc(ALLOC_TAG_BODY, sizeof(vector_t) * capacity);
+    store->velocities = alloc_malloc(ALLOC_TAG_BODY, sizeof(vector_t) * capacity);
+    store->forces = alloc_malloc(ALLOC_TAG_BODY, sizeof(vector_t) * capacity);
+    store->impulses = alloc_malloc(ALLOC_TAG_BODY, sizeof(vector_t) * capacity);
+    store->inv_masses = alloc_malloc(ALLOC_TAG_BODY, sizeof(double) * capacity);
+    store->movements = alloc_malloc(ALLOC_TAG_BODY, sizeof(vector_t) * capacity);
+    store->ticks = alloc_malloc(ALLOC_TAG_BODY, sizeof(size_t) * capacity);
+    assert(store->bodies && store->centroids && store->velocities && store->forces &&
+           store->impulses && store->inv_masses && store->movements && store->ticks);
+    return store;
+}
+
+
+void body_store_free(body_store_t *store) {
+    assert(store);
+    assert(store->size == 0);
+
+    alloc_free(ALLOC_TAG_BODY, store->bodies);
+    alloc_free(ALLOC_TAG_BODY, store->centroids);
+    alloc_free(ALLOC_TAG_BODY, store->velocities);
+    alloc_free(ALLOC_TAG_BODY, store->forces);
+    alloc_free(ALLOC_TAG_BODY, store->impulses);
+    alloc_free(ALLOC_TAG_BODY, store->inv_masses);
+    alloc_free(ALLOC_TAG_BODY, store->movements);
+    alloc_free(ALLOC_TAG_BODY, store->ticks);
+    alloc_free(ALLOC_TAG_BODY, store);
+}
+
+
+size_t body_store_size(body_store_t *store) {
+    assert(store);
+
+    return store->size;
+}
+
+
+void body_store_grow(body_store_t *store) {
+    store->capacity *= 2;
+    size_t capacity = store->capacity;
+    store->bodies = alloc_realloc(ALLOC_TAG_BODY, store->bodies, sizeof(body_t *) * capacity);
+    store->centroids = alloc_realloc(ALLOC_TAG_BODY, store->centroids, sizeof(vector_t) * capacity);
+    store->velocities = alloc_realloc(ALLOC_TAG_BODY, store->velocities, sizeof(vector_t) * capacity);
+    store->forces = alloc_realloc(ALLOC_TAG_BODY, store->forces, sizeof(vector_t) * capacity);
+    store->impulses = alloc_realloc(ALLOC_TAG_BODY, store->impulses, sizeof(vector_t) * capacity);
+    store->inv_masses = alloc_realloc(ALLOC_TAG_BODY, store->inv_masses, sizeof(double) * capacity);
+    store->movements = alloc_realloc(ALLOC_TAG_BODY, store->movements, sizeof(vector_t) * capacity);
+    store->ticks = alloc_realloc(ALLOC_TAG_BODY, store->ticks, sizeof(size_t) * capacity);
+    assert(store->bodies && store->centroids && store->velocities && store->forces &&
+           store->impulses && store->inv_masses && store->movements && store->ticks);
+}
+
+
+// Appends a body at rest to a store and returns its slot
+size_t body_store_add(body_store_t *store, body_t *body) {
+    if (store->size == store->capacity) {
+        body_store_grow(store);
+    }
+
+    size_t slot = store->size++;
+    store->bodies[slot] = body;
+    store->centroids[slot] = VEC_ZERO;
+    store->velocities[slot] = VEC_ZERO;
+    store->forces[slot] = VEC_ZERO;
+    store->impulses[slot] = VEC_ZERO;
+    store->inv_masses[slot] = 0;
+    store->movements[slot] = VEC_ZERO;
+    // Not integrated during the store's current tick
+    store->ticks[slot] = store->tick - 1;
+    return slot;
+}
+
+
+// Fills the slot with the last body so the store stays contiguous
+void body_store_remove(body_store_t *store, size_t slot) {
+    assert(slot < store->size);
+
+    size_t last = --store->size;
+    if (slot != last) {
+        store->bodies[slot] = store->bodies[last];
+        store->centroids[slot] = store->centroids[last];
+        store->velocities[slot] = store->velocities[last];
+        store->forces[slot] = store->forces[last];
+        store->impulses[slot] = store->impulses[last];
+        store->inv_masses[slot] = store->inv_masses[last];
+        store->movements[slot] = store->movements[last];
+        store->ticks[slot] = store->ticks[last];
+        store->bodies[slot]->slot = slot;
+    }
+}
+
+
+void body_set_store(body_t *body, body_store_t *store) {
+    DEBUG_ASSERT(body_is_live(body));
+    assert(store);
+    if (body->store == store) {
+        return;
+    }
+
+    body_store_t *old = body->store;
+    size_t old_slot = body->slot;
+    size_t slot = body_store_add(store, body);
+    store->centroids[slot] = old->centroids[old_slot];
+    store->velocities[slot] = old->velocities[old_slot];
+    store->forces[slot] = old->forces[old_slot];
+    store->impulses[slot] = old->impulses[old_slot];
+    store->inv_masses[slot] = old->inv_masses[old_slot];
+    body_store_remove(old, old_slot);
+
+    body->store = store;
+    body->slot = slot;
+}
+
+
+// Applies the forces and impulses on one slot and works out how far it moves
+void body_integrate(body_store_t *store, size_t slot, double dt) {
+    vector_t old_v = store->velocities[slot];
+
+    // Add acceleration from forces
+    vector_t accel = vec_multiply(store->inv_masses[slot], store->forces[slot]);
+    vector_t new_v = vec_add(old_v, vec_multiply(dt, accel));
+    // Add acceleration from impules
+    vector_t dv = vec_multiply(store->inv_masses[slot], store->impulses[slot]);
+    new_v = vec_add(new_v, dv);
+    store->forces[slot] = VEC_ZERO;
+    store->impulses[slot] = VEC_ZERO;
+    store->velocities[slot] = new_v;
+
+    // Take average velocity for movement
+    vector_t avg_v = vec_multiply(1. / 2., vec_add(old_v, new_v));
+    store->movements[slot] = vec_multiply(dt, avg_v);
+    store->ticks[slot] = store->tick;
+}
+
+
+void body_apply_movement(body_t *body) {
+    vector_t movement = body->store->movements[body->slot];
+    vec_batch_translate(body->vertices, body->num_vertices, movement);
+    body->store->centroids[body->slot] = vec_add(body->store->centroids[body->slot], movement);
+}
+
+
+bool body_has_tick_funcs(body_t *body) {
+    return body->has_tick_funcs;
+}
+
+
+typedef struct integrate_aux {
+    body_store_t *store;
+    double dt;
+} integrate_aux_t;
+
+// Integrates one slice of a store; called by jobs_parallel_for()
+void body_store_integrate_range(size_t start, size_t end, void *aux) {
+    integrate_aux_t *integrate = aux;
+    body_store_t *store = integrate->store;
+
+    for (size_t i = start; i < end; i++) {
+        body_integrate(store, i, integrate->dt);
+    }
+
+    // Bodies without tick functions can move now; the rest wait for body_finish_tick()
+    for (size_t i = start; i < end; i++) {
+        body_t *body = store->bodies[i];
+        if (!body_has_tick_funcs(body)) {
+            body_apply_movement(body);
+        }
+    }
+}
+
+
+void body_store_tick(body_store_t *store, double dt) {
+    assert(store);
+
+    store->tick++;
+    integrate_aux_t aux = {.store = store, .dt = dt};
+    jobs_parallel_for(store->size, BODY_INTEGRATE_GRAIN, body_store_integrate_range, &aux);
+}
+
+
 void body_do_nothing(void *arg) {
     return;
 }
@@ -49,74 +400,107 @@ body_t *body_init_with_info(list_t *shape, double mass,
 body_t *body_init_with_info_and_sprite(list_t *shape, double mass, rgb_color_t color,
                                        void *info, free_func_t info_freer, const char *filename,
                                        vector_t dimensions) {
-    body_t *new_body = malloc(sizeof(body_t));
-    assert(new_body);
     assert(mass > 0);
+    body_t *new_body = body_pool_alloc();
+
+    if (!body_default_store) {
+        body_default_store = body_store_init(0);
+    }
 
-    new_body->shape = shape;
-    new_body->velocity = VEC_ZERO;
+    // Copy the vertices into one array and take ownership of them
+    size_t num_vertices = list_size(shape);
+    if (num_vertices <= BODY_INLINE_VERTICES) {
+        new_body->vertices = new_body->inline_vertices;
+    }
+    else {
+        new_body->vertices = alloc_malloc(ALLOC_TAG_BODY, sizeof(vector_t) * num_vertices);
+        assert(new_body->vertices);
+    }
+    new_body->num_vertices = num_vertices;
+    new_body->cold->shape = NULL;
+    for (size_t i = 0; i < num_vertices; i++) {
+        new_body->vertices[i] = *(vector_t *)list_get(shape, i);
+    }
+    list_free(shape);
+
+    new_body->store = body_default_store;
+    new_body->slot = body_store_add(body_default_store, new_body);
     new_body->mass = mass;
-    new_body->color = color;
-    new_body->centroid = polygon_centroid(shape);
+    new_body->cold->color = color;
+    vector_t centroid = vec_batch_centroid(new_body->vertices, num_vertices);
+    body_default_store->centroids[new_body->slot] = centroid;
+    body_default_store->inv_masses[new_body->slot] = 1. / mass;
     new_body->curr_rotation = 0;
-    new_body->tick_funcs = list_init(BODY_INIT_TICK_FUNC_COUNT, 
-                                     (free_func_t)body_do_nothing);
-
-    new_body->pending_force = VEC_ZERO;
-    new_body->pending_impulse = VEC_ZERO;
+    new_body->cold->tick_funcs = NULL;
+    new_body->has_tick_funcs = false;
 
     double bounding_radius = 0;
-    for (size_t i = 0; i < list_size(shape); i++) {
-        double d = vec_distance(new_body->centroid, *((vector_t *)list_get(shape, i)));
+    for (size_t i = 0; i < num_vertices; i++) {
+        double d = vec_distance(centroid, new_body->vertices[i]);
         if (d > bounding_radius) {
             bounding_radius = d;
         }
     }
     new_body->bounding_radius = bounding_radius;
 
-    new_body->info = info;
-    new_body->info_freer = info_freer;
+    new_body->cold->info = info;
+    new_body->cold->info_freer = info_freer;
 
     new_body->removed = false;
-    new_body->debug_mode = false;
+    new_body->cold->debug_mode = false;
+    new_body->category = 0;
 
     if (filename) {
-        new_body->surface = IMG_Load(filename);
-        new_body->dimensions = dimensions;
+        new_body->cold->sprite = assets_get_surface(filename);
+        new_body->cold->dimensions = dimensions;
     }
     else {
-        new_body->surface = NULL;
+        new_body->cold->sprite = NULL;
     }
+    new_body->cold->surface = new_body->cold->sprite;
 
-    new_body->surface_list = list_init(BODY_INIT_SURFACE_COUNT, (free_func_t)SDL_FreeSurface);
+    new_body->cold->surface_list = NULL;
 
     return new_body;
 }
 
 
 void body_free(body_t *body) {
-    assert(body);
+    assert(body_is_live(body));
 
-    list_free(body->shape);
-    list_free(body->tick_funcs);
+    if (body->cold->shape) {
+        list_free(body->cold->shape);
+    }
+    if (body->vertices != body->inline_vertices) {
+        alloc_free(ALLOC_TAG_BODY, body->vertices);
+    }
+    if (body->cold->tick_funcs) {
+        list_free(body->cold->tick_funcs);
+    }
 
-    if (body->info_freer && body->info) {
-        body->info_freer(body->info);
+    if (body->cold->info_freer && body->cold->info) {
+        body->cold->info_freer(body->cold->info);
     }
 
-    list_free(body->surface_list);
+    if (body->cold->surface_list) {
+        list_free(body->cold->surface_list);
+    }
+    if (body->cold->sprite) {
+        SDL_FreeSurface(body->cold->sprite);
+    }
 
-    free(body);
+    body_store_remove(body->store, body->slot);
+    body_pool_release(body);
 }
 
 
 list_t *body_get_shape(body_t *body) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
-    list_t *shape_cpy = list_init(list_size(body->shape), (free_func_t)free);
-    for (size_t i = 0; i < list_size(body->shape); i++) {
-        vector_t *v = malloc(sizeof(vector_t));
-        *v = *(vector_t *)(list_get(body->shape, i));
+    list_t *shape_cpy = list_init(body->num_vertices, (free_func_t)free);
+    for (size_t i = 0; i < body->num_vertices; i++) {
+        vector_t *v = alloc_malloc(ALLOC_TAG_BODY, sizeof(vector_t));
+        *v = body->vertices[i];
         list_add(shape_cpy, v);
     }
 
@@ -124,107 +508,127 @@ list_t *body_get_shape(body_t *body) {
 }
 
 
+const vector_t *body_get_vertices(body_t *body) {
+    DEBUG_ASSERT(body_is_live(body));
+
+    return body->vertices;
+}
+
+
+size_t body_get_num_vertices(body_t *body) {
+    DEBUG_ASSERT(body_is_live(body));
+
+    return body->num_vertices;
+}
+
+
 list_t *body_get_shape_nocpy(body_t *body) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
-    return body->shape;
+    if (!body->cold->shape) {
+        body->cold->shape = list_init(body->num_vertices, NULL);
+        for (size_t i = 0; i < body->num_vertices; i++) {
+            list_add(body->cold->shape, &body->vertices[i]);
+        }
+    }
+    return body->cold->shape;
 }
 
 
 vector_t body_get_centroid(body_t *body) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
-    return body->centroid;
+    return body->store->centroids[body->slot];
 }
 
 
 vector_t body_get_velocity(body_t *body) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
-    return body->velocity;
+    return body->store->velocities[body->slot];
 }
 
 
 double body_get_mass(body_t *body) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
     return body->mass;
 }
 
 
 rgb_color_t body_get_color(body_t *body) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
-    return body->color;
+    return body->cold->color;
 }
 
 
 void *body_get_info(body_t *body) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
-    return body->info;
+    return body->cold->info;
 }
 
 
 double body_get_rotation(body_t *body) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
     return body->curr_rotation;
 }
 
 
 void body_set_centroid(body_t *body, vector_t x) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
     // x = c + t  ==>  t = x - c
-    vector_t translation = vec_subtract(x, body->centroid);
+    vector_t translation = vec_subtract(x, body_get_centroid(body));
 
-    polygon_translate(body->shape, translation);
-    body->centroid = x;
+    vec_batch_translate(body->vertices, body->num_vertices, translation);
+    body->store->centroids[body->slot] = x;
 }
 
 
 void body_set_velocity(body_t *body, vector_t v) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
-    body->velocity = v;
+    body->store->velocities[body->slot] = v;
 }
 
 
 void body_set_rotation(body_t *body, double angle) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
-    vector_t c = body->centroid;
+    vector_t c = body_get_centroid(body);
     double delta_angle = angle - body->curr_rotation;
-    polygon_rotate(body->shape, delta_angle, c);
+    vec_batch_rotate(body->vertices, body->num_vertices, delta_angle, c);
     body->curr_rotation = angle;
 }
 
 
 void body_set_color(body_t *body, rgb_color_t color) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
-    body->color = color;
+    body->cold->color = color;
 }
 
 
 void body_add_force(body_t *body, vector_t force) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
-    body->pending_force = vec_add(body->pending_force, force);
+    body->store->forces[body->slot] = vec_add(body->store->forces[body->slot], force);
 }
 
 
 void body_add_impulse(body_t *body, vector_t impulse) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
-    body->pending_impulse = vec_add(body->pending_impulse, impulse);
+    body->store->impulses[body->slot] = vec_add(body->store->impulses[body->slot], impulse);
 }
 
 
 vector_t body_calculate_impulse(body_t *body1, body_t *body2, vector_t axis, double elasticity) {
-    assert(body1);
-    assert(body2);
+    DEBUG_ASSERT(body_is_live(body1));
+    DEBUG_ASSERT(body_is_live(body2));
     assert(0 <= elasticity && elasticity <= 1);
     double mass1 = body_get_mass(body1);
     double mass2 = body_get_mass(body2);
@@ -247,44 +651,45 @@ vector_t body_calculate_impulse(body_t *body1, body_t *body2, vector_t axis, dou
 }
 
 
+void body_run_tick_funcs(body_t *body, double dt) {
+    if (!body->has_tick_funcs) {
+        return;
+    }
+    for (size_t i = 0; i < list_size(body->cold->tick_funcs); i++) {
+        body_func_t f = list_get(body->cold->tick_funcs, i);
+        f(body, &dt);
+    }
+}
+
+
 void body_tick(body_t *body, double dt) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
-    vector_t old_v = body->velocity;
+    body_integrate(body->store, body->slot, dt);
+    body_run_tick_funcs(body, dt);
+    body_apply_movement(body);
+}
 
-    // Add acceleration from forces
-    vector_t accel = vec_multiply(1. / body->mass, body->pending_force);
-    vector_t new_v = vec_add(old_v, vec_multiply(dt, accel));
-    // Add acceleration from impules
-    vector_t dv = vec_multiply(1. / body->mass, body->pending_impulse);
-    new_v = vec_add(new_v, dv);
-    body->pending_force = VEC_ZERO;
-    body->pending_impulse = VEC_ZERO;
 
-    body_set_velocity(body, new_v);
+void body_finish_tick(body_t *body, double dt) {
+    DEBUG_ASSERT(body_is_live(body));
 
-    double *d = malloc(sizeof(double));
-    assert(d);
-    *d = dt;
-    for (size_t i = 0; i < list_size(body->tick_funcs); i++) {
-        body_func_t f = list_get(body->tick_funcs, i);
-        f(body, d);
+    if (body->store->ticks[body->slot] != body->store->tick) {
+        // Added to the store since body_store_tick()
+        body_tick(body, dt);
+    }
+    else if (body_has_tick_funcs(body)) {
+        body_run_tick_funcs(body, dt);
+        body_apply_movement(body);
     }
-    free(d);
-
-    // Take average velocity for movement
-    vector_t avg_v = vec_multiply(1. / 2., vec_add(old_v, new_v));
-    vector_t movement = vec_multiply(dt, avg_v);
-    polygon_translate(body->shape, movement);
-    body->centroid = vec_add(body->centroid, movement);
 }
 
 
 bool body_is_on_screen(body_t *body, vector_t lower_bounds, vector_t upper_bounds) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
-    for (size_t i = 0; i < list_size(body->shape); i++) {
-        vector_t *v = list_get(body->shape, i);
+    for (size_t i = 0; i < body->num_vertices; i++) {
+        vector_t *v = &body->vertices[i];
 
         if ((v->x >= lower_bounds.x && v->x <= upper_bounds.x)
             && (v->y >= lower_bounds.y && v->y <= upper_bounds.y)) {
@@ -297,19 +702,27 @@ bool body_is_on_screen(body_t *body, vector_t lower_bounds, vector_t upper_bound
 
 
 void body_register_tick_func(body_t *body, body_func_t f) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
     assert(f);
 
-    list_add(body->tick_funcs, f);
+    if (!body->cold->tick_funcs) {
+        body->cold->tick_funcs = list_init(BODY_INIT_TICK_FUNC_COUNT, (free_func_t)body_do_nothing);
+    }
+    list_add(body->cold->tick_funcs, f);
+    body->has_tick_funcs = true;
 }
 
 
 void body_unregister_tick_func(body_t *body, body_func_t f) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
-    for (size_t i = 0; i < list_size(body->tick_funcs); i++) {
-        if (f == list_get(body->tick_funcs, i)) {
-            list_remove(body->tick_funcs, i);
+    if (!body->cold->tick_funcs) {
+        return;
+    }
+    for (size_t i = 0; i < list_size(body->cold->tick_funcs); i++) {
+        if (f == list_get(body->cold->tick_funcs, i)) {
+            list_remove(body->cold->tick_funcs, i);
+            body->has_tick_funcs = list_size(body->cold->tick_funcs) > 0;
             return;
         }
     }
@@ -317,86 +730,100 @@ void body_unregister_tick_func(body_t *body, body_func_t f) {
 
 
 bool body_are_overlapping(body_t *b1, body_t *b2) {
-    assert(b1);
-    assert(b2);
+    DEBUG_ASSERT(body_is_live(b1));
+    DEBUG_ASSERT(body_is_live(b2));
 
-    collision_info_t *c_info = find_collision(body_get_shape_nocpy(b1), body_get_shape_nocpy(b2));
-    if (c_info) {
-        free(c_info);
-        return true;
-    }
-    return false;
+    return find_collision_points(b1->vertices, b1->num_vertices, b2->vertices, b2->num_vertices, NULL).collided;
 }
 
 
 void body_remove(body_t *body) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
     body->removed = true;
 }
 
 
 bool body_is_removed(body_t *body) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
     return body->removed;
 }
 
 
 double body_get_bounding_radius(body_t *body) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
     return body->bounding_radius;
 }
 
 
 SDL_Surface *body_get_surface(body_t *body) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
-    return body->surface;
+    return body->cold->surface;
 }
 
 
 void body_set_surface(body_t *body, SDL_Surface *surface) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
-    if (surface != body->surface) {
-        body->surface = surface;
+    if (surface != body->cold->surface) {
+        body->cold->surface = surface;
     }
 
-    for (size_t i = 0; i < list_size(body->surface_list); i++) {
-        if (list_get(body->surface_list, i) == surface) {
+    if (!surface) {
+        return;
+    }
+    if (!body->cold->surface_list) {
+        body->cold->surface_list = list_init(BODY_INIT_SURFACE_COUNT, (free_func_t)SDL_FreeSurface);
+    }
+    for (size_t i = 0; i < list_size(body->cold->surface_list); i++) {
+        if (list_get(body->cold->surface_list, i) == surface) {
             return;
         }
     }
-    if (surface) {
-        list_add(body->surface_list, surface);
-    }
+    list_add(body->cold->surface_list, surface);
 }
 
 
 vector_t body_get_dimensions(body_t *body) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
-    return body->dimensions;
+    return body->cold->dimensions;
 }
 
 
 void body_set_dimensions(body_t *body, vector_t dimensions) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
-    body->dimensions = dimensions;
+    body->cold->dimensions = dimensions;
 }
 
 
 bool body_get_debug_mode(body_t *body) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
 
-    return body->debug_mode;
+    return body->cold->debug_mode;
 }
 
 
 void body_set_debug_mode(body_t *body, bool mode) {
-    assert(body);
+    DEBUG_ASSERT(body_is_live(body));
+
+    body->cold->debug_mode = mode;
+}
+
+
+size_t body_get_category(body_t *body) {
+    DEBUG_ASSERT(body_is_live(body));
+
+    return body->category;
+}
+
+
+void body_set_category(body_t *body, size_t category) {
+    DEBUG_ASSERT(body_is_live(body));
+    assert(category < BODY_NUM_CATEGORIES);
 
-    body->debug_mode = mode;
+    body->category = category;
 }
@@ -1,45 +1,51 @@
+#include "alloc.h"
 #include "collision.h"
 #include "mathlib.h"
-#include "polygon.h"
+#include "vector_batch.h"
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
 
-// Computes the min and max projection of a shape onto a line
-vector_t min_and_max_projection(list_t *shape, vector_t line) {
-    double max = -INFINITY;
-    double min = INFINITY;
+#define COLLISION_STACK_POINTS 64
+
+
+// A shape in a separating axis test, with its centroid computed when first needed
+typedef struct sat_shape {
+    const vector_t *points;
+    size_t num_points;
+    vector_t centroid;
+    bool has_centroid;
+} sat_shape_t;
 
-    for (size_t i = 0; i < list_size(shape); i++) { 
-        double dot = vec_dot(*(vector_t *)list_get(shape, i), line);
-        if (dot < min) {
-            min = dot;
-        }
-        if (dot > max) {
-            max = dot;
-        }
-    }
 
-    return (vector_t){.x = min, .y = max};
+vector_t sat_shape_centroid(sat_shape_t *shape) {
+    if (!shape->has_centroid) {
+        shape->centroid = vec_batch_centroid(shape->points, shape->num_points);
+        shape->has_centroid = true;
+    }
+    return shape->centroid;
 }
 
 
 // Finds if the projections of shape1 and shape2 onto any perpendicular of shape1's edge overlap 
-bool find_projection_overlap(list_t *shape1, list_t *shape2, collision_info_t *info) {
+bool find_projection_overlap(sat_shape_t *shape1, sat_shape_t *shape2, collision_info_t *info,
+                             collision_stats_t *stats) {
     assert(shape1);
     assert(shape2);
     assert(info);
 
-    for (size_t i = 0; i < list_size(shape1); i++) {
-        vector_t vertex1 = *(vector_t *)list_get(shape1, i);
-        vector_t vertex2 = *(vector_t *)list_get(shape1, (i+1) % list_size(shape1));
-        vector_t edge = vec_unit(vec_subtract(vertex1, vertex2));
-        // create a line that is perpendicular to that edge
-        vector_t perp = vec_rotate(edge, M_PI / 2);
+    size_t n = shape1->num_points;
+    for (size_t i = 0; i < n; i++) {
+        if (stats) {
+            stats->axes_tested++;
+        }
+        // create a line that is perpendicular to the edge from vertex i to the next one
+        vector_t perp;
+        vec_batch_edge_normals(shape1->points, n, 1, i, &perp);
 
         // go through every point and dot it with the edge
-        vector_t shape1_proj = min_and_max_projection(shape1, perp);
-        vector_t shape2_proj = min_and_max_projection(shape2, perp);
+        vector_t shape1_proj = vec_batch_project(shape1->points, n, perp);
+        vector_t shape2_proj = vec_batch_project(shape2->points, shape2->num_points, perp);
 
         // finds if the two projections overlap
         // x = min projection and y = max projection
@@ -54,8 +60,8 @@ bool find_projection_overlap(list_t *shape1, list_t *shape2, collision_info_t *i
         if (min < info->min_overlap) {
             info->min_overlap = min;
 
-            vector_t centroid1 = polygon_centroid(shape1);
-            vector_t centroid2 = polygon_centroid(shape2);
+            vector_t centroid1 = sat_shape_centroid(shape1);
+            vector_t centroid2 = sat_shape_centroid(shape2);
             double og_dist = vec_distance(centroid1, centroid2);
             double new_dist = vec_distance(vec_add(centroid1, perp), centroid2);
             if (og_dist > new_dist) {
@@ -70,12 +76,214 @@ bool find_projection_overlap(list_t *shape1, list_t *shape2, collision_info_t *i
 }
 
 
-collision_info_t *find_collision(list_t *shape1, list_t *shape2) {
-    collision_info_t *info = malloc(sizeof(collision_info_t));
-    info->min_overlap = INFINITY;
-    if (find_projection_overlap(shape1, shape2, info) && find_projection_overlap(shape2, shape1, info)) {
-        return info;
+collision_info_t find_collision(list_t *shape1, list_t *shape2) {
+    return find_collision_with_stats(shape1, shape2, NULL);
+}
+
+
+// Copies a list of vectors into an array, using the heap only if the buffer is too small
+vector_t *collision_gather_points(list_t *shape, vector_t *buffer) {
+    size_t n = list_size(shape);
+    vector_t *points = buffer;
+    if (n > COLLISION_STACK_POINTS) {
+        points = alloc_malloc(ALLOC_TAG_COLLISION, sizeof(vector_t) * n);
+        assert(points);
+    }
+    for (size_t i = 0; i < n; i++) {
+        points[i] = *(vector_t *)list_get(shape, i);
+    }
+    return points;
+}
+
+
+collision_info_t find_collision_with_stats(list_t *shape1, list_t *shape2, collision_stats_t *stats) {
+    assert(shape1);
+    assert(shape2);
+
+    vector_t buffer1[COLLISION_STACK_POINTS], buffer2[COLLISION_STACK_POINTS];
+    vector_t *points1 = collision_gather_points(shape1, buffer1);
+    vector_t *points2 = collision_gather_points(shape2, buffer2);
+    collision_info_t info = find_collision_points(points1, list_size(shape1), points2, list_size(shape2), stats);
+    if (points1 != buffer1) {
+        alloc_free(ALLOC_TAG_COLLISION, points1);
+    }
+    if (points2 != buffer2) {
+        alloc_free(ALLOC_TAG_COLLISION, points2);
+    }
+    return info;
+}
+
+
+collision_info_t find_collision_points(const vector_t *shape1, size_t num_points1,
+                                       const vector_t *shape2, size_t num_points2,
+                                       collision_stats_t *stats) {
+    assert(shape1);
+    assert(shape2);
+
+    sat_shape_t sat1 = {.points = shape1, .num_points = num_points1, .has_centroid = false};
+    sat_shape_t sat2 = {.points = shape2, .num_points = num_points2, .has_centroid = false};
+    collision_info_t info = {.collided = false, .min_overlap = INFINITY};
+    info.collided = find_projection_overlap(&sat1, &sat2, &info, stats) &&
+                    find_projection_overlap(&sat2, &sat1, &info, stats);
+    if (stats) {
+        stats->sat_tests++;
+        if (info.collided) {
+            stats->contacts++;
+        }
+        else {
+            stats->early_outs++;
+        }
+    }
+    return info;
+}
+
+
+// Which shape's edge gave a candidate's smallest overlap, since the axis direction depends on it
+typedef enum {
+    COLLISION_SHAPE_EDGE,
+    COLLISION_CANDIDATE_EDGE
+} collision_edge_owner_t;
+
+
+// Batch state for one candidate, alongside the results in collision_batch_t
+typedef struct batch_candidate {
+    vector_t perp;
+    collision_edge_owner_t owner;
+} batch_candidate_t;
+
+
+// Does the test in find_projection_overlap() for one candidate and one axis,
+// where proj1 belongs to the shape whose edge the axis came from
+void collision_batch_test_axis(collision_batch_t *batch, batch_candidate_t *candidate, size_t i,
+                               vector_t proj1, vector_t proj2, vector_t perp,
+                               collision_edge_owner_t owner, uint64_t *live) {
+    batch->axes_tested[i]++;
+    if (proj2.x > proj1.y || proj1.x > proj2.y) {
+        *live &= ~((uint64_t)1 << i);
+        return;
     }
-    free(info);
-    return NULL;
+
+    double overlap1 = proj2.y - proj1.x;
+    double overlap2 = proj1.y - proj2.x;
+    double min = mathlib_min(overlap1, overlap2);
+    if (min < batch->depths[i]) {
+        batch->depths[i] = min;
+        candidate->perp = perp;
+        candidate->owner = owner;
+    }
+}
+
+
+void find_collision_batch(const vector_t *shape, size_t num_points,
+                          const vector_t *candidates, size_t candidate_points, size_t num_candidates,
+                          collision_batch_t *batch) {
+    assert(shape);
+    assert(num_points > 0);
+    assert(candidates || num_candidates == 0);
+    assert(candidate_points > 0);
+    assert(num_candidates <= COLLISION_BATCH_MAX);
+    assert(batch);
+
+    batch_candidate_t state[COLLISION_BATCH_MAX];
+    vector_t axes[COLLISION_BATCH_MAX];
+    vector_t shape_projs[COLLISION_BATCH_MAX];
+    vector_t candidate_projs[COLLISION_BATCH_MAX];
+    for (size_t i = 0; i < num_candidates; i++) {
+        batch->depths[i] = INFINITY;
+        batch->axes_tested[i] = 0;
+    }
+    uint64_t live = num_candidates == COLLISION_BATCH_MAX ? ~(uint64_t)0
+                                                          : ((uint64_t)1 << num_candidates) - 1;
+
+    // The shape's edges: every candidate is projected onto the same axis
+    for (size_t k = 0; k < num_points && live; k++) {
+        vector_t perp;
+        vec_batch_edge_normals(shape, num_points, 1, k, &perp);
+        vector_t shape_proj = vec_batch_project(shape, num_points, perp);
+        for (size_t i = 0; i < num_candidates; i++) {
+            axes[i] = perp;
+        }
+        vec_batch_project_polygons(candidates, candidate_points, num_candidates, axes, candidate_projs);
+        for (size_t i = 0; i < num_candidates; i++) {
+            if (live & ((uint64_t)1 << i)) {
+                collision_batch_test_axis(batch, &state[i], i, shape_proj, candidate_projs[i], perp,
+                                          COLLISION_SHAPE_EDGE, &live);
+            }
+        }
+    }
+
+    // Each candidate's edges: each candidate has its own axis
+    for (size_t k = 0; k < candidate_points && live; k++) {
+        vec_batch_edge_normals(candidates, candidate_points, num_candidates, k, axes);
+        vec_batch_project_polygons(candidates, candidate_points, num_candidates, axes, candidate_projs);
+        vec_batch_project_axes(shape, num_points, axes, num_candidates, shape_projs);
+        for (size_t i = 0; i < num_candidates; i++) {
+            if (live & ((uint64_t)1 << i)) {
+                collision_batch_test_axis(batch, &state[i], i, candidate_projs[i], shape_projs[i], axes[i],
+                                          COLLISION_CANDIDATE_EDGE, &live);
+            }
+        }
+    }
+
+    // Orient each colliding candidate's axis the way find_projection_overlap() does
+    batch->overlaps = live;
+    vector_t shape_centroid = VEC_ZERO;
+    if (live) {
+        shape_centroid = vec_batch_centroid(shape, num_points);
+    }
+    for (size_t i = 0; i < num_candidates; i++) {
+        if (!(live & ((uint64_t)1 << i))) {
+            continue;
+        }
+        vector_t centroid1 = shape_centroid;
+        vector_t centroid2 = vec_batch_centroid(&candidates[i * candidate_points], candidate_points);
+        if (state[i].owner == COLLISION_CANDIDATE_EDGE) {
+            centroid2 = shape_centroid;
+            centroid1 = vec_batch_centroid(&candidates[i * candidate_points], candidate_points);
+        }
+        vector_t perp = state[i].perp;
+        double og_dist = vec_distance(centroid1, centroid2);
+        double new_dist = vec_distance(vec_add(centroid1, perp), centroid2);
+        batch->axes[i] = og_dist > new_dist ? perp : vec_negate(perp);
+    }
+}
+
+
+collision_info_t collision_batch_get_info(const collision_batch_t *batch, size_t i) {
+    assert(batch);
+    assert(i < COLLISION_BATCH_MAX);
+
+    collision_info_t info = {.collided = (batch->overlaps >> i) & 1, .min_overlap = batch->depths[i]};
+    if (info.collided) {
+        info.axis = batch->axes[i];
+    }
+    return info;
+}
+
+
+void collision_batch_add_stats(const collision_batch_t *batch, size_t i, collision_stats_t *stats) {
+    assert(batch);
+    assert(i < COLLISION_BATCH_MAX);
+    assert(stats);
+
+    stats->sat_tests++;
+    stats->axes_tested += batch->axes_tested[i];
+    if ((batch->overlaps >> i) & 1) {
+        stats->contacts++;
+    }
+    else {
+        stats->early_outs++;
+    }
+}
+
+
+void collision_stats_add(collision_stats_t *total, collision_stats_t stats) {
+    assert(total);
+    total->force_creators += stats.force_creators;
+    total->radius_rejections += stats.radius_rejections;
+    total->sat_tests += stats.sat_tests;
+    total->axes_tested += stats.axes_tested;
+    total->early_outs += stats.early_outs;
+    total->contacts += stats.contacts;
+    total->handlers_fired += stats.handlers_fired;
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include "file_map.h"
+#include <assert.h>
+#include <stdio.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+#ifndef _WIN32
+void *file_map(const char *path, alloc_tag_t tag, size_t *size) {
+    assert(path);
+    assert(size);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    void *data = NULL;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        data = data == MAP_FAILED ? NULL : data;
+        *size = (size_t)st.st_size;
+    }
+    // The mapping stays valid after the file is closed
+    close(fd);
+    return data;
+}
+
+
+void file_unmap(void *data, alloc_tag_t tag, size_t size) {
+    munmap(data, size);
+}
+#else
+void *file_map(const char *path, alloc_tag_t tag, size_t *size) {
+    assert(path);
+    assert(size);
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    void *data = NULL;
+    if (length > 0) {
+        data = alloc_malloc(tag, (size_t)length);
+        assert(data);
+        if (fread(data, 1, (size_t)length, f) != (size_t)length) {
+            alloc_free(tag, data);
+            data = NULL;
+        }
+        *size = (size_t)length;
+    }
+    fclose(f);
+    return data;
+}
+
+
+void file_unmap(void *data, alloc_tag_t tag, size_t size) {
+    alloc_free(tag, data);
+}
+#endif
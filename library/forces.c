@@ -1,8 +1,14 @@
+#include "alloc.h"
+#include "arena.h"
 #include "collision.h"
 #include "forces.h"
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
+
+// Vertices of the second bodies gathered for one find_collision_batch() call
+#define FORCES_BATCH_POINTS 256
 
 
 const double FORCES_MIN_GRAVITY_DISTANCE = 50;
@@ -29,10 +35,13 @@ typedef struct drag_aux {
 
 
 typedef struct collision_aux {
+    scene_t *scene;
     body_t *body1;
     body_t *body2;
     collision_handler_t handler;
     bool handled_collision;
+    // The axis found by the last test, for the handler
+    vector_t axis;
     void *aux;
     free_func_t aux_freer;
 } collision_aux_t;
@@ -64,8 +73,7 @@ void create_newtonian_gravity(scene_t *scene, double G, body_t *body1, body_t *b
     assert(body1);
     assert(body2);
 
-    gravity_aux_t *aux = malloc(sizeof(gravity_aux_t));
-    assert(aux);
+    gravity_aux_t *aux = arena_alloc(scene_get_arena(scene), sizeof(gravity_aux_t));
 
     aux->G = G;
     aux->body1 = body1;
@@ -75,7 +83,7 @@ void create_newtonian_gravity(scene_t *scene, double G, body_t *body1, body_t *b
     list_add(bodies, body1);
     list_add(bodies, body2);
 
-    scene_add_bodies_force_creator(scene, (force_creator_t)force_creator_gravity, aux, bodies, free);
+    scene_add_bodies_force_creator(scene, (force_creator_t)force_creator_gravity, aux, bodies, NULL);
 }
 
 
@@ -103,8 +111,7 @@ void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2) {
     assert(body1);
     assert(body2);
 
-    spring_aux_t *aux = malloc(sizeof(spring_aux_t));
-    assert(aux);
+    spring_aux_t *aux = arena_alloc(scene_get_arena(scene), sizeof(spring_aux_t));
     aux->k = k;
     aux->body1 = body1;
     aux->body2 = body2;
@@ -113,7 +120,7 @@ void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2) {
     list_add(bodies, body1);
     list_add(bodies, body2);
 
-    scene_add_bodies_force_creator(scene, (force_creator_t)force_creator_spring, aux, bodies, free);
+    scene_add_bodies_force_creator(scene, (force_creator_t)force_creator_spring, aux, bodies, NULL);
 }
 
 
@@ -136,44 +143,161 @@ void create_drag(scene_t *scene, double gamma, body_t *body) {
     assert(body);
     assert(gamma > 0);
 
-    drag_aux_t *aux = malloc(sizeof(drag_aux_t));
-    assert(aux);
+    drag_aux_t *aux = arena_alloc(scene_get_arena(scene), sizeof(drag_aux_t));
     aux->gamma = gamma;
     aux->body = body;
 
     list_t *bodies = list_init(2, NULL);
     list_add(bodies, body);
 
-    scene_add_bodies_force_creator(scene, (force_creator_t)force_creator_drag, aux, bodies, free);
+    scene_add_bodies_force_creator(scene, (force_creator_t)force_creator_drag, aux, bodies, NULL);
 }
 
 
-void force_creator_collision(collision_aux_t *aux) {
-    assert(aux);
+collision_stats_t *force_collision_stats(collision_aux_t *aux) {
+    return scene_get_thread_collision_stats(aux->scene, body_get_category(aux->body1),
+                                            body_get_category(aux->body2));
+}
 
+
+// Counts a pair as tested and checks its bounding circles; true if they overlap
+bool force_collision_in_range(collision_aux_t *aux, collision_stats_t *stats) {
     body_t *b1 = aux->body1;
     body_t *b2 = aux->body2;
 
     assert(b1);
     assert(b2);
 
+    stats->force_creators++;
     double distance = vec_distance(body_get_centroid(b1), body_get_centroid(b2));
     if (distance > body_get_bounding_radius(b1) + body_get_bounding_radius(b2)) {
+        stats->radius_rejections++;
+        aux->handled_collision = false;
+        return false;
+    }
+    return true;
+}
+
+
+// Records the result of a pair's separating axis test; true if its handler needs to run
+bool force_collision_record(collision_aux_t *aux, collision_info_t c_info) {
+    if (!c_info.collided) {
         aux->handled_collision = false;
-        return;
+        return false;
     }
+    aux->axis = c_info.axis;
+    return !aux->handled_collision;
+}
+
+
+bool force_collision_test_pair(collision_aux_t *aux, collision_stats_t *stats) {
+    body_t *b1 = aux->body1;
+    body_t *b2 = aux->body2;
+    collision_info_t c_info = find_collision_points(body_get_vertices(b1), body_get_num_vertices(b1),
+                                                    body_get_vertices(b2), body_get_num_vertices(b2), stats);
+    return force_collision_record(aux, c_info);
+}
+
+
+// Runs on any job thread, so it only touches this pair's own state
+bool force_tester_collision(collision_aux_t *aux) {
+    assert(aux);
+
+    collision_stats_t *stats = force_collision_stats(aux);
+    return force_collision_in_range(aux, stats) && force_collision_test_pair(aux, stats);
+}
+
 
-    collision_info_t* c_info = find_collision(body_get_shape_nocpy(b1), body_get_shape_nocpy(b2));
-    if (c_info && !aux->handled_collision) { 
-        vector_t axis = c_info->axis;
-        if (aux->handler) {
-            aux->handler(b1, b2, axis, aux->aux);
+// Tests pairs that share their first body, with one find_collision_batch() call
+// for each vertex count among the second bodies
+void force_batch_test_collisions_with(collision_aux_t **auxes, size_t num_auxes, bool *results) {
+    body_t *body = auxes[0]->body1;
+    size_t pending[SCENE_BATCH_MAX];
+    size_t num_pending = 0;
+    for (size_t i = 0; i < num_auxes; i++) {
+        results[i] = false;
+        if (force_collision_in_range(auxes[i], force_collision_stats(auxes[i]))) {
+            pending[num_pending++] = i;
         }
-        aux->handled_collision = true;
     }
-    else if (!c_info) {
-        aux->handled_collision = false;
+
+    vector_t candidates[FORCES_BATCH_POINTS];
+    size_t candidate_idxs[SCENE_BATCH_MAX];
+    collision_batch_t batch;
+    while (num_pending > 0) {
+        size_t n = body_get_num_vertices(auxes[pending[0]]->body2);
+        size_t num_candidates = 0;
+        size_t num_left = 0;
+        for (size_t j = 0; j < num_pending; j++) {
+            body_t *other = auxes[pending[j]]->body2;
+            if (body_get_num_vertices(other) == n && (num_candidates + 1) * n <= FORCES_BATCH_POINTS) {
+                memcpy(&candidates[num_candidates * n], body_get_vertices(other), sizeof(vector_t) * n);
+                candidate_idxs[num_candidates++] = pending[j];
+            }
+            else {
+                pending[num_left++] = pending[j];
+            }
+        }
+
+        if (num_candidates == 0) {
+            // Too many vertices for the buffer
+            candidate_idxs[num_candidates++] = pending[0];
+            pending[0] = pending[--num_left];
+        }
+        // A lone candidate is cheaper to test on its own
+        if (num_candidates == 1) {
+            size_t i = candidate_idxs[0];
+            results[i] = force_collision_test_pair(auxes[i], force_collision_stats(auxes[i]));
+        }
+        else {
+            find_collision_batch(body_get_vertices(body), body_get_num_vertices(body),
+                                 candidates, n, num_candidates, &batch);
+            for (size_t k = 0; k < num_candidates; k++) {
+                collision_aux_t *aux = auxes[candidate_idxs[k]];
+                collision_batch_add_stats(&batch, k, force_collision_stats(aux));
+                results[candidate_idxs[k]] = force_collision_record(aux, collision_batch_get_info(&batch, k));
+            }
+        }
+        num_pending = num_left;
+    }
+}
+
+
+// Runs on any job thread like force_tester_collision(), for a run of consecutive pairs
+void force_batch_tester_collision(collision_aux_t **auxes, size_t num_auxes, bool *results) {
+    assert(auxes);
+    assert(results);
+
+    size_t start = 0;
+    while (start < num_auxes) {
+        size_t end = start + 1;
+        while (end < num_auxes && auxes[end]->body1 == auxes[start]->body1) {
+            end++;
+        }
+        force_batch_test_collisions_with(&auxes[start], end - start, &results[start]);
+        start = end;
+    }
+}
+
+
+void force_creator_collision(collision_aux_t *aux) {
+    assert(aux);
+
+    if (aux->handler) {
+        aux->handler(aux->body1, aux->body2, aux->axis, aux->aux);
+        force_collision_stats(aux)->handlers_fired++;
+    }
+    aux->handled_collision = true;
+}
+
+
+// Collisions are made and dropped with the bodies of a streamed level,
+// so their auxes are allocated normally rather than from the scene's arena
+void force_free_collision_aux(collision_aux_t *aux) {
+    if (aux->aux_freer) {
+        aux->aux_freer(aux->aux);
     }
+    alloc_free(ALLOC_TAG_FORCES, aux);
 }
 
 
@@ -182,8 +306,9 @@ void create_collision(scene_t *scene, body_t *body1, body_t *body2, collision_ha
     assert(body1);
     assert(body2);
 
-    collision_aux_t *collision_aux = malloc(sizeof(collision_aux_t));
+    collision_aux_t *collision_aux = alloc_malloc(ALLOC_TAG_FORCES, sizeof(collision_aux_t));
     assert(collision_aux);
+    collision_aux->scene = scene;
     collision_aux->body1 = body1;
     collision_aux->body2 = body2;
     collision_aux->handler = handler;
@@ -195,7 +320,10 @@ void create_collision(scene_t *scene, body_t *body1, body_t *body2, collision_ha
     list_add(bodies, body1);
     list_add(bodies, body2);
 
-    scene_add_bodies_force_creator(scene, (force_creator_t)force_creator_collision, collision_aux, bodies, freer);
+    scene_add_batch_tested_force_creator(scene, (force_batch_tester_t)force_batch_tester_collision,
+                                         (force_tester_t)force_tester_collision,
+                                         (force_creator_t)force_creator_collision, collision_aux, bodies,
+                                         (free_func_t)force_free_collision_aux);
 }
 
 
@@ -226,8 +354,8 @@ void create_physics_collision(scene_t *scene, double elasticity, body_t *body1,
     assert(body1);
     assert(body2);
 
-    double *aux = malloc(sizeof(double));
+    double *aux = arena_alloc(scene_get_arena(scene), sizeof(double));
     *aux = elasticity;
 
-    create_collision(scene, body1, body2, (collision_handler_t) collision_handler_physics_collision, aux, free);
+    create_collision(scene, body1, body2, (collision_handler_t) collision_handler_physics_collision, aux, NULL);
 }
\ No newline at end of file
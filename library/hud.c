@@ -1,14 +1,17 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <stdio.h>
+#include "alloc.h"
+#include "dynarray.h"
 #include "hud.h"
 
 
-const size_t HUD_INIT_NUM_WIDGETS = 5;
+// Most HUDs have a handful of widgets, which then need no allocation
+DYNARRAY_DEFINE(widget_array, widget_t *, 8)
 
 
 typedef struct hud {
-    list_t *widgets;
+    widget_array_t widgets;
     void *aux;
     free_func_t aux_freer;
 } hud_t;
@@ -25,7 +28,7 @@ typedef struct widget {
 
 
 widget_t *widget_init(SDL_Surface *surface, SDL_Rect orientation, double angle, widget_func_t tick_func, void *aux, free_func_t aux_freer) {
-    widget_t *widget = malloc(sizeof(widget_t));
+    widget_t *widget = alloc_malloc(ALLOC_TAG_HUD, sizeof(widget_t));
     assert(widget);
     widget->surface = surface;
     widget->orientation = orientation;
@@ -47,7 +50,7 @@ void widget_free(widget_t *widget) {
         widget->aux_freer(widget->aux);
     }
 
-    free(widget);
+    alloc_free(ALLOC_TAG_HUD, widget);
 }
 
 
@@ -96,10 +99,9 @@ void widget_set_rect(widget_t *widget, SDL_Rect coordinates){
 
 
 hud_t *hud_init(void *aux, free_func_t aux_freer) {
-    hud_t *hud = malloc(sizeof(hud_t));
+    hud_t *hud = alloc_malloc(ALLOC_TAG_HUD, sizeof(hud_t));
     assert(hud);
-    list_t *widgets = list_init(HUD_INIT_NUM_WIDGETS, (free_func_t)widget_free);
-    hud->widgets = widgets;
+    widget_array_init(&hud->widgets);
     hud->aux = aux;
     hud->aux_freer = aux_freer;
     
@@ -110,12 +112,15 @@ hud_t *hud_init(void *aux, free_func_t aux_freer) {
 void hud_free(hud_t *hud) {
     assert(hud);
 
-    list_free(hud->widgets);
+    for (size_t i = 0; i < widget_array_size(&hud->widgets); i++) {
+        widget_free(*widget_array_get(&hud->widgets, i));
+    }
+    widget_array_free(&hud->widgets);
     if (hud->aux && hud->aux_freer) {
         hud->aux_freer(hud->aux);
     }
 
-    free(hud);
+    alloc_free(ALLOC_TAG_HUD, hud);
 }
 
 
@@ -123,17 +128,15 @@ void hud_add_widget(hud_t *hud, widget_t *widget) {
     assert(widget);
     assert(hud);
 
-    list_add(hud->widgets, widget);
+    widget_array_push(&hud->widgets, widget);
 }
 
 
 void hud_tick(hud_t *hud) {
     assert(hud);
 
-    list_t *widgets = hud->widgets;
-    assert(widgets);
-    for (size_t i = 0; i < list_size(widgets); i++) {
-        widget_t *widget = (widget_t *)list_get(widgets, i);
+    for (size_t i = 0; i < widget_array_size(&hud->widgets); i++) {
+        widget_t *widget = *widget_array_get(&hud->widgets, i);
 
         if (widget->tick_func) {
             widget->tick_func(widget);
@@ -144,10 +147,17 @@ void hud_tick(hud_t *hud) {
 }
 
 
-list_t *hud_get_widgets(hud_t *hud) {
+size_t hud_num_widgets(hud_t *hud) {
+    assert(hud);
+
+    return widget_array_size(&hud->widgets);
+}
+
+
+widget_t *hud_get_widget(hud_t *hud, size_t index) {
     assert(hud);
 
-    return hud->widgets;
+    return *widget_array_get(&hud->widgets, index);
 }
 
 
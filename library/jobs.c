@@ -0,0 +1,388 @@
+#include "jobs.h"
+#include "alloc.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <SDL2/SDL.h>
+
+#ifdef _WIN32
+#define JOBS_THREAD_LOCAL __declspec(thread)
+#else
+#define JOBS_THREAD_LOCAL __thread
+#endif
+
+const size_t JOBS_MAX_THREADS = 32;
+const size_t JOBS_MAX_DEPENDENTS = 8;
+const size_t JOBS_DEQUE_CAPACITY = 1024;
+const size_t JOBS_SLICES_PER_THREAD = 4;
+const size_t JOBS_SPINS_BEFORE_YIELD = 64;
+
+
+typedef struct job {
+    job_func_t f;
+    job_range_func_t range_f;
+    void *aux;
+    size_t start;
+    size_t end;
+    // Unfinished dependencies, plus one until the job is submitted
+    SDL_atomic_t pending;
+    // Set, under lock, once the job has run; later dependents don't wait for it
+    bool finished;
+    // Set last, once nothing else touches the job, so job_wait() can free it
+    SDL_atomic_t complete;
+    SDL_SpinLock lock;
+    size_t num_dependents;
+    job_t *dependents[8];
+    job_t *next_free;
+} job_t;
+
+
+// The owner pushes and pops at the bottom; thieves take from the top
+typedef struct job_deque {
+    job_t *jobs[1024];
+    size_t top;
+    size_t bottom;
+    SDL_SpinLock lock;
+} job_deque_t;
+
+
+// Set once jobs_init() has finished, and only changed with jobs_start_lock held,
+// so any thread can start the job system lazily without racing another
+SDL_atomic_t jobs_running;
+SDL_SpinLock jobs_start_lock = 0;
+size_t jobs_num_workers = 0;
+SDL_Thread *jobs_workers[32];
+job_deque_t *jobs_deques = NULL;
+SDL_sem *jobs_work_available = NULL;
+SDL_atomic_t jobs_quit;
+
+job_t *jobs_free_list = NULL;
+SDL_SpinLock jobs_free_lock = 0;
+
+JOBS_THREAD_LOCAL size_t jobs_curr_thread = 0;
+
+
+job_t *jobs_alloc_job() {
+    SDL_AtomicLock(&jobs_free_lock);
+    job_t *job = jobs_free_list;
+    if (job) {
+        jobs_free_list = job->next_free;
+    }
+    SDL_AtomicUnlock(&jobs_free_lock);
+
+    if (!job) {
+        job = alloc_malloc(ALLOC_TAG_OTHER, sizeof(job_t));
+        assert(job);
+    }
+    return job;
+}
+
+
+void jobs_release_job(job_t *job) {
+    SDL_AtomicLock(&jobs_free_lock);
+    job->next_free = jobs_free_list;
+    jobs_free_list = job;
+    SDL_AtomicUnlock(&jobs_free_lock);
+}
+
+
+job_t *jobs_make_job(job_func_t f, job_range_func_t range_f, void *aux,
+                     size_t start, size_t end, int pending) {
+    job_t *job = jobs_alloc_job();
+    job->f = f;
+    job->range_f = range_f;
+    job->aux = aux;
+    job->start = start;
+    job->end = end;
+    SDL_AtomicSet(&job->pending, pending);
+    job->finished = false;
+    SDL_AtomicSet(&job->complete, 0);
+    job->lock = 0;
+    job->num_dependents = 0;
+    job->next_free = NULL;
+    return job;
+}
+
+
+job_t *jobs_pop(size_t thread) {
+    job_deque_t *deque = &jobs_deques[thread];
+    job_t *job = NULL;
+    SDL_AtomicLock(&deque->lock);
+    if (deque->bottom > deque->top) {
+        deque->bottom--;
+        job = deque->jobs[deque->bottom % JOBS_DEQUE_CAPACITY];
+    }
+    SDL_AtomicUnlock(&deque->lock);
+    return job;
+}
+
+
+job_t *jobs_steal(size_t thread) {
+    job_deque_t *deque = &jobs_deques[thread];
+    job_t *job = NULL;
+    SDL_AtomicLock(&deque->lock);
+    if (deque->bottom > deque->top) {
+        job = deque->jobs[deque->top % JOBS_DEQUE_CAPACITY];
+        deque->top++;
+    }
+    SDL_AtomicUnlock(&deque->lock);
+    return job;
+}
+
+
+job_t *jobs_find_work() {
+    size_t num_threads = jobs_num_workers + 1;
+    job_t *job = jobs_pop(jobs_curr_thread);
+    for (size_t i = 1; !job && i < num_threads; i++) {
+        job = jobs_steal((jobs_curr_thread + i) % num_threads);
+    }
+    return job;
+}
+
+
+void jobs_run(job_t *job);
+
+void jobs_push(job_t *job) {
+    job_deque_t *deque = &jobs_deques[jobs_curr_thread];
+    bool pushed = false;
+    SDL_AtomicLock(&deque->lock);
+    if (deque->bottom - deque->top < JOBS_DEQUE_CAPACITY) {
+        deque->jobs[deque->bottom % JOBS_DEQUE_CAPACITY] = job;
+        deque->bottom++;
+        pushed = true;
+    }
+    SDL_AtomicUnlock(&deque->lock);
+
+    if (!pushed) {
+        // The deque is full, so run the job now instead
+        jobs_run(job);
+    }
+    else if (jobs_num_workers > 0) {
+        SDL_SemPost(jobs_work_available);
+    }
+}
+
+
+void jobs_run(job_t *job) {
+    if (job->range_f) {
+        job->range_f(job->start, job->end, job->aux);
+    }
+    else {
+        job->f(job->aux);
+    }
+
+    job_t *dependents[8];
+    SDL_AtomicLock(&job->lock);
+    job->finished = true;
+    size_t num_dependents = job->num_dependents;
+    for (size_t i = 0; i < num_dependents; i++) {
+        dependents[i] = job->dependents[i];
+    }
+    SDL_AtomicUnlock(&job->lock);
+
+    for (size_t i = 0; i < num_dependents; i++) {
+        if (SDL_AtomicAdd(&dependents[i]->pending, -1) == 1) {
+            jobs_push(dependents[i]);
+        }
+    }
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&job->complete, 1);
+}
+
+
+int jobs_worker(void *thread) {
+    jobs_curr_thread = (size_t)(uintptr_t)thread;
+
+    while (true) {
+        SDL_SemWait(jobs_work_available);
+        if (SDL_AtomicGet(&jobs_quit)) {
+            break;
+        }
+        job_t *job;
+        while ((job = jobs_find_work()) != NULL) {
+            jobs_run(job);
+        }
+    }
+    return 0;
+}
+
+
+// Starts the workers; the caller holds jobs_start_lock
+void jobs_start(size_t num_workers) {
+    assert(!SDL_AtomicGet(&jobs_running));
+    if (num_workers > JOBS_MAX_THREADS - 1) {
+        num_workers = JOBS_MAX_THREADS - 1;
+    }
+
+    jobs_deques = alloc_calloc(ALLOC_TAG_OTHER, num_workers + 1, sizeof(job_deque_t));
+    assert(jobs_deques);
+    jobs_work_available = SDL_CreateSemaphore(0);
+    assert(jobs_work_available);
+    SDL_AtomicSet(&jobs_quit, 0);
+    jobs_curr_thread = 0;
+    jobs_num_workers = num_workers;
+
+    for (size_t i = 0; i < num_workers; i++) {
+        jobs_workers[i] = SDL_CreateThread(jobs_worker, "faf_job_worker", (void *)(uintptr_t)(i + 1));
+        assert(jobs_workers[i]);
+    }
+    SDL_AtomicSet(&jobs_running, 1);
+}
+
+
+void jobs_init(size_t num_workers) {
+    SDL_AtomicLock(&jobs_start_lock);
+    jobs_start(num_workers);
+    SDL_AtomicUnlock(&jobs_start_lock);
+}
+
+
+void jobs_shutdown() {
+    SDL_AtomicLock(&jobs_start_lock);
+    if (!SDL_AtomicGet(&jobs_running)) {
+        SDL_AtomicUnlock(&jobs_start_lock);
+        return;
+    }
+
+    SDL_AtomicSet(&jobs_quit, 1);
+    for (size_t i = 0; i < jobs_num_workers; i++) {
+        SDL_SemPost(jobs_work_available);
+    }
+    for (size_t i = 0; i < jobs_num_workers; i++) {
+        SDL_WaitThread(jobs_workers[i], NULL);
+    }
+
+    SDL_DestroySemaphore(jobs_work_available);
+    alloc_free(ALLOC_TAG_OTHER, jobs_deques);
+    while (jobs_free_list) {
+        job_t *next = jobs_free_list->next_free;
+        alloc_free(ALLOC_TAG_OTHER, jobs_free_list);
+        jobs_free_list = next;
+    }
+    jobs_deques = NULL;
+    jobs_work_available = NULL;
+    jobs_num_workers = 0;
+    SDL_AtomicSet(&jobs_running, 0);
+    SDL_AtomicUnlock(&jobs_start_lock);
+}
+
+
+size_t jobs_default_num_workers() {
+#ifdef __EMSCRIPTEN__
+    return 0;
+#else
+    int num_cpus = SDL_GetCPUCount();
+    return num_cpus > 1 ? (size_t)num_cpus - 1 : 0;
+#endif
+}
+
+
+// Starts the job system for whichever thread uses it first; once it is running this is one atomic read
+void jobs_ensure_running() {
+    if (SDL_AtomicGet(&jobs_running)) {
+        return;
+    }
+    SDL_AtomicLock(&jobs_start_lock);
+    if (!SDL_AtomicGet(&jobs_running)) {
+        jobs_start(jobs_default_num_workers());
+    }
+    SDL_AtomicUnlock(&jobs_start_lock);
+}
+
+
+size_t jobs_num_threads() {
+    jobs_ensure_running();
+    return jobs_num_workers + 1;
+}
+
+
+size_t jobs_thread_index() {
+    return jobs_curr_thread;
+}
+
+
+job_t *job_create(job_func_t f, void *aux) {
+    assert(f);
+
+    return jobs_make_job(f, NULL, aux, 0, 0, 1);
+}
+
+
+void job_depends_on(job_t *job, job_t *dependency) {
+    assert(job);
+    assert(dependency);
+    assert(job != dependency);
+
+    SDL_AtomicLock(&dependency->lock);
+    if (!dependency->finished) {
+        assert(dependency->num_dependents < JOBS_MAX_DEPENDENTS);
+        dependency->dependents[dependency->num_dependents++] = job;
+        SDL_AtomicAdd(&job->pending, 1);
+    }
+    SDL_AtomicUnlock(&dependency->lock);
+}
+
+
+void job_submit(job_t *job) {
+    assert(job);
+    jobs_ensure_running();
+
+    if (SDL_AtomicAdd(&job->pending, -1) == 1) {
+        jobs_push(job);
+    }
+}
+
+
+void job_wait(job_t *job) {
+    assert(job);
+
+    size_t spins = 0;
+    while (!SDL_AtomicGet(&job->complete)) {
+        job_t *other = jobs_find_work();
+        if (other) {
+            jobs_run(other);
+            spins = 0;
+        }
+        else if (++spins == JOBS_SPINS_BEFORE_YIELD) {
+            SDL_Delay(0);
+            spins = 0;
+        }
+    }
+    SDL_MemoryBarrierAcquire();
+
+    jobs_release_job(job);
+}
+
+
+void jobs_parallel_for(size_t count, size_t grain, job_range_func_t f, void *aux) {
+    assert(f);
+    if (count == 0) {
+        return;
+    }
+    if (grain == 0) {
+        grain = 1;
+    }
+
+    size_t num_threads = jobs_num_threads();
+    size_t num_slices = (count + grain - 1) / grain;
+    if (num_slices > num_threads * JOBS_SLICES_PER_THREAD) {
+        num_slices = num_threads * JOBS_SLICES_PER_THREAD;
+    }
+    if (num_slices <= 1 || num_threads == 1) {
+        f(0, count, aux);
+        return;
+    }
+
+    job_t *slices[32 * 4];
+    for (size_t i = 1; i < num_slices; i++) {
+        slices[i] = jobs_make_job(NULL, f, aux, count * i / num_slices, count * (i + 1) / num_slices, 0);
+        jobs_push(slices[i]);
+    }
+
+    // The calling thread takes the first slice itself
+    f(0, count / num_slices, aux);
+    for (size_t i = 1; i < num_slices; i++) {
+        job_wait(slices[i]);
+    }
+}
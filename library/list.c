@@ -1,5 +1,7 @@
 #include "list.h"
+#include "alloc.h"
 #include <assert.h>
+#include "debug_assert.h"
 #include <stdlib.h>
 #include <stdio.h>
 
@@ -16,10 +18,10 @@ typedef struct list {
 
 
 list_t *list_init(size_t initial_size, free_func_t freer) {
-    list_t *new_list = malloc(sizeof(list_t));
+    list_t *new_list = alloc_malloc(ALLOC_TAG_LIST, sizeof(list_t));
     assert(new_list);
 
-    void **data = malloc(sizeof(void *) * initial_size);
+    void **data = alloc_malloc(ALLOC_TAG_LIST, sizeof(void *) * initial_size);
     assert(data);
 
 
@@ -39,15 +41,15 @@ void list_ensure_capacity(list_t *list) {
         }
         size_t new_size = list->max_size * SIZE_SCALE;
         list->max_size = new_size;
-        list->data = (void **)realloc(list->data, sizeof(void *) * new_size);
+        list->data = (void **)alloc_realloc(ALLOC_TAG_LIST, list->data, sizeof(void *) * new_size);
         assert(list->data);
     }
 }
 
 
 void list_add(list_t *list, void *value) {
-    assert(value);
-    assert(list);
+    DEBUG_ASSERT(value);
+    DEBUG_ASSERT(list);
 
     list_ensure_capacity(list);
 
@@ -57,6 +59,7 @@ void list_add(list_t *list, void *value) {
 
 
 void *list_get(list_t *list, size_t index) {
+    // Out of range indices are part of the contract, so this stays checked in release builds
     assert(list);
     assert(index < list->num_elems);
 
@@ -103,13 +106,13 @@ void list_free(list_t *list) {
         }
     }
 
-    free(list->data);
-    free(list);
+    alloc_free(ALLOC_TAG_LIST, list->data);
+    alloc_free(ALLOC_TAG_LIST, list);
 }
 
 
 size_t list_size(list_t *list) {
-    assert(list);
+    DEBUG_ASSERT(list);
 
     return list->num_elems;
 }
\ No newline at end of file
@@ -1,12 +1,18 @@
 #include "mathlib.h"
-#include <stdlib.h>
-#include <time.h>
+#include "rng.h"
+
+// The shared stream; any state but all zeros works until mathlib_seed() is called
+rng_t mathlib_rng = {{UINT64_C(0x9E3779B97F4A7C15), UINT64_C(0xBF58476D1CE4E5B9),
+                      UINT64_C(0x94D049BB133111EB), UINT64_C(0x2545F4914F6CDD1D)}};
+
+
+void mathlib_seed(uint64_t seed) {
+    mathlib_rng = rng_init(seed);
+}
 
 
 double mathlib_rand_in_range(double min, double max) {
-    double range = max - min;
-    double div = RAND_MAX / range;
-    return min + (rand() / div);
+    return rng_range(&mathlib_rng, min, max);
 }
 
 
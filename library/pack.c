@@ -0,0 +1,235 @@
+#include "pack.h"
+#include "alloc.h"
+#include "file_map.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+const uint32_t PACK_VERSION = 1;
+const char PACK_MAGIC[4] = {'F', 'A', 'F', 'P'};
+const uint32_t PACK_EMPTY_SLOT = 0;
+const uint64_t PACK_FNV_OFFSET = UINT64_C(14695981039346656037);
+const uint64_t PACK_FNV_PRIME = UINT64_C(1099511628211);
+
+
+typedef struct pack {
+    void *data;
+    size_t size;
+    const pack_header_t *header;
+    const uint32_t *slots;
+    const pack_entry_t *entries;
+    const char *paths;
+} pack_t;
+
+
+uint64_t pack_id(const char *path) {
+    assert(path);
+
+    uint64_t hash = PACK_FNV_OFFSET;
+    for (const char *c = path; *c; c++) {
+        hash = (hash ^ (uint8_t)*c) * PACK_FNV_PRIME;
+    }
+    return hash;
+}
+
+
+// Checks the header, the lookup table, and that every entry's path and contents lie inside the file
+bool pack_is_valid(pack_t *pack) {
+    const pack_header_t *header = pack->header;
+    if (pack->size < sizeof(pack_header_t) || memcmp(header->magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0 ||
+        header->version != PACK_VERSION || header->num_slots < 2 ||
+        (header->num_slots & (header->num_slots - 1)) != 0 ||
+        (uint64_t)header->num_slots < 2 * (uint64_t)header->num_entries) {
+        return false;
+    }
+    // 64-bit so the sums can't wrap around where size_t is 32 bits, as in WebAssembly
+    uint64_t paths_start = sizeof(pack_header_t) + (uint64_t)header->num_slots * sizeof(uint32_t) +
+                           (uint64_t)header->num_entries * sizeof(pack_entry_t);
+    if (paths_start > pack->size) {
+        return false;
+    }
+    // pack_find() relies on the table having empty slots
+    size_t num_used = 0;
+    for (size_t i = 0; i < header->num_slots; i++) {
+        if (pack->slots[i] > header->num_entries) {
+            return false;
+        }
+        num_used += pack->slots[i] != PACK_EMPTY_SLOT;
+    }
+    if (num_used > header->num_entries) {
+        return false;
+    }
+    size_t paths_size = pack->size - (size_t)paths_start;
+    for (size_t i = 0; i < header->num_entries; i++) {
+        const pack_entry_t *entry = &pack->entries[i];
+        if (entry->kind > PACK_FILE || entry->path_offset >= paths_size ||
+            !memchr(pack->paths + entry->path_offset, '\0', paths_size - entry->path_offset) ||
+            entry->offset % PACK_ALIGNMENT != 0 || (uint64_t)entry->offset + entry->size > pack->size) {
+            return false;
+        }
+        if (entry->kind == PACK_PIXELS && (uint64_t)entry->width * entry->height * 4 != entry->size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+pack_t *pack_open(const char *path) {
+    assert(path);
+
+    size_t size = 0;
+    void *data = file_map(path, ALLOC_TAG_ASSETS, &size);
+    if (!data) {
+        return NULL;
+    }
+
+    pack_t *pack = alloc_malloc(ALLOC_TAG_ASSETS, sizeof(pack_t));
+    assert(pack);
+    pack->data = data;
+    pack->size = size;
+    pack->header = data;
+    pack->slots = (const uint32_t *)(pack->header + 1);
+    if (size >= sizeof(pack_header_t)) {
+        pack->entries = (const pack_entry_t *)(pack->slots + pack->header->num_slots);
+        pack->paths = (const char *)(pack->entries + pack->header->num_entries);
+    }
+    if (!pack_is_valid(pack)) {
+        pack_close(pack);
+        return NULL;
+    }
+    return pack;
+}
+
+
+void pack_close(pack_t *pack) {
+    assert(pack);
+
+    file_unmap(pack->data, ALLOC_TAG_ASSETS, pack->size);
+    alloc_free(ALLOC_TAG_ASSETS, pack);
+}
+
+
+size_t pack_num_entries(pack_t *pack) {
+    assert(pack);
+
+    return pack->header->num_entries;
+}
+
+
+const pack_entry_t *pack_get_entry(pack_t *pack, size_t index) {
+    assert(pack);
+    assert(index < pack->header->num_entries);
+
+    return &pack->entries[index];
+}
+
+
+const pack_entry_t *pack_find(pack_t *pack, uint64_t id) {
+    assert(pack);
+
+    uint32_t mask = pack->header->num_slots - 1;
+    // The table is at most half full, so the probe always reaches an empty slot
+    for (uint32_t i = (uint32_t)id & mask;; i = (i + 1) & mask) {
+        uint32_t slot = pack->slots[i];
+        if (slot == PACK_EMPTY_SLOT) {
+            return NULL;
+        }
+        if (pack->entries[slot - 1].id == id) {
+            return &pack->entries[slot - 1];
+        }
+    }
+}
+
+
+const char *pack_entry_path(pack_t *pack, const pack_entry_t *entry) {
+    assert(pack);
+    assert(entry);
+
+    return pack->paths + entry->path_offset;
+}
+
+
+const void *pack_entry_data(pack_t *pack, const pack_entry_t *entry) {
+    assert(pack);
+    assert(entry);
+
+    return (const char *)pack->data + entry->offset;
+}
+
+
+size_t pack_align(size_t offset) {
+    return (offset + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT;
+}
+
+
+bool pack_write(const char *path, const pack_entry_t *entries, const char *const *paths,
+                const void *const *contents, size_t num_entries) {
+    assert(path);
+    assert(num_entries == 0 || (entries && paths && contents));
+
+    pack_header_t header;
+    memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+    header.version = PACK_VERSION;
+    header.num_entries = (uint32_t)num_entries;
+    header.num_slots = 2;
+    while (header.num_slots < 2 * num_entries) {
+        header.num_slots *= 2;
+    }
+
+    uint32_t *slots = alloc_malloc(ALLOC_TAG_ASSETS, sizeof(uint32_t) * header.num_slots);
+    assert(slots);
+    pack_entry_t *written = alloc_malloc(ALLOC_TAG_ASSETS, sizeof(pack_entry_t) * (num_entries + 1));
+    assert(written);
+    for (size_t i = 0; i < header.num_slots; i++) {
+        slots[i] = PACK_EMPTY_SLOT;
+    }
+
+    // Fills in the ids and the lookup table, then lays out the paths and contents
+    bool unique = true;
+    uint64_t paths_size = 0;
+    uint32_t mask = header.num_slots - 1;
+    for (size_t i = 0; i < num_entries && unique; i++) {
+        written[i] = entries[i];
+        written[i].id = pack_id(paths[i]);
+        written[i].path_offset = (uint32_t)paths_size;
+        paths_size += strlen(paths[i]) + 1;
+        uint32_t j = (uint32_t)written[i].id & mask;
+        while (slots[j] != PACK_EMPTY_SLOT) {
+            unique = unique && written[slots[j] - 1].id != written[i].id;
+            j = (j + 1) & mask;
+        }
+        slots[j] = (uint32_t)i + 1;
+    }
+    uint64_t paths_start = sizeof(pack_header_t) + (uint64_t)header.num_slots * sizeof(uint32_t) +
+                           (uint64_t)num_entries * sizeof(pack_entry_t);
+    uint64_t end = pack_align(paths_start + paths_size);
+    for (size_t i = 0; i < num_entries && unique; i++) {
+        written[i].offset = (uint32_t)end;
+        end = pack_align(end + written[i].size);
+    }
+
+    bool ok = false;
+    FILE *f = NULL;
+    // Offsets are 32-bit
+    if (unique && end <= UINT32_MAX && (f = fopen(path, "wb"))) {
+        const char padding[PACK_ALIGNMENT] = {0};
+        ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+             fwrite(slots, sizeof(uint32_t), header.num_slots, f) == header.num_slots &&
+             fwrite(written, sizeof(pack_entry_t), num_entries, f) == num_entries;
+        for (size_t i = 0; i < num_entries && ok; i++) {
+            ok = fputs(paths[i], f) >= 0 && fputc('\0', f) == '\0';
+        }
+        uint64_t position = paths_start + paths_size;
+        for (size_t i = 0; i < num_entries && ok; i++) {
+            size_t gap = written[i].offset - position;
+            ok = fwrite(padding, 1, gap, f) == gap &&
+                 fwrite(contents[i], 1, written[i].size, f) == written[i].size;
+            position = written[i].offset + written[i].size;
+        }
+        ok = fclose(f) == 0 && ok;
+    }
+    alloc_free(ALLOC_TAG_ASSETS, slots);
+    alloc_free(ALLOC_TAG_ASSETS, written);
+    return ok;
+}
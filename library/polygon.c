@@ -21,10 +21,10 @@ double polygon_signed_area(list_t *polygon) {
         vector_t *v2 = list_get(polygon, v2_idx);
 
         // Add first sum contribution (positive coefficient sum)
-        area += v1->x * v2->y;
+        area += (double)v1->x * v2->y;
 
         // Add second sum contribution (negative coefficient sum)
-        area -= v1->y * v2->x;
+        area -= (double)v1->y * v2->x;
     }
 
     // area is equal to 1/2 the absolute value of the sum of terms
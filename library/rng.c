@@ -0,0 +1,88 @@
+#include "rng.h"
+#include <assert.h>
+
+// Scales the top 53 bits of a random number to [0, 1)
+const double RNG_DOUBLE_SCALE = 1.0 / (UINT64_C(1) << 53);
+// Odd constant (2^64 over the golden ratio) that splitmix64 steps by
+const uint64_t RNG_GOLDEN_GAMMA = UINT64_C(0x9E3779B97F4A7C15);
+
+
+uint64_t rng_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+
+// splitmix64: spreads similar seeds far apart, and never gives an all-zero state
+uint64_t rng_splitmix(uint64_t *x) {
+    uint64_t z = (*x += RNG_GOLDEN_GAMMA);
+    z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+
+rng_t rng_init(uint64_t seed) {
+    rng_t rng;
+    for (size_t i = 0; i < 4; i++) {
+        rng.s[i] = rng_splitmix(&seed);
+    }
+    return rng;
+}
+
+
+rng_t rng_init_stream(uint64_t seed, uint64_t stream) {
+    // Mix the stream number before combining it, so nearby streams get unrelated seeds
+    uint64_t mixed = stream ^ RNG_GOLDEN_GAMMA;
+    return rng_init(seed ^ rng_splitmix(&mixed));
+}
+
+
+uint64_t rng_next(rng_t *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = rng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+    return result;
+}
+
+
+double rng_double(rng_t *rng) {
+    return (rng_next(rng) >> 11) * RNG_DOUBLE_SCALE;
+}
+
+
+double rng_range(rng_t *rng, double min, double max) {
+    return min + rng_double(rng) * (max - min);
+}
+
+
+size_t rng_index(rng_t *rng, size_t n) {
+    assert(n > 0);
+    // Scaling instead of taking a remainder keeps the bias below n / 2^53
+    return (size_t)(rng_double(rng) * n);
+}
+
+
+void rng_fill(rng_t *rng, uint64_t *values, size_t n) {
+    // A local copy of the state stays in registers through the loop
+    rng_t local = *rng;
+    for (size_t i = 0; i < n; i++) {
+        values[i] = rng_next(&local);
+    }
+    *rng = local;
+}
+
+
+void rng_fill_range(rng_t *rng, double *values, size_t n, double min, double max) {
+    rng_t local = *rng;
+    double range = max - min;
+    for (size_t i = 0; i < n; i++) {
+        values[i] = min + rng_double(&local) * range;
+    }
+    *rng = local;
+}
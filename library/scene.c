@@ -1,39 +1,73 @@
 #include "scene.h"
+#include "alloc.h"
+#include "arena.h"
+#include "dynarray.h"
+#include "jobs.h"
 #include <assert.h>
+#include "debug_assert.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <stdbool.h>
 
+// Force creators with at most this many bodies keep them in the struct itself
+#define SCENE_INLINE_BODIES 2
 
-const size_t SCENE_INIT_MAX_BODIES = 10;
-const size_t SCENE_INIT_FORCE_FUNC_COUNT = 10;
 const size_t SCENE_INIT_NUM_LAYERS = 2;
 const size_t SCENE_DEFAULT_LAYER = 1;
-
-
-typedef struct scene {
-    list_t *layers;
-    size_t num_layers;
-    list_t *force_funcs;
-    vector_t dimensions;
-    bool paused;
-} scene_t;
+const size_t SCENE_TEST_GRAIN = 256;
+const size_t SCENE_INIT_CONTACTS = 64;
 
 
 typedef struct force_struct {
+    force_batch_tester_t batch_tester;
+    force_tester_t tester;
     force_creator_t forcer;
     void *aux;
     free_func_t freer;
-    list_t *bodies;
+    // Used when there are at most SCENE_INLINE_BODIES bodies, e.g. for every pair force,
+    // so force creators removed during a level leave nothing behind in the arena
+    body_t *inline_bodies[SCENE_INLINE_BODIES];
+    // In the scene's arena when there are more
+    body_t **bodies;
+    size_t num_bodies;
 } force_struct_t;
 
 
+DYNARRAY_DEFINE(handle_array, body_handle_t, 16)
+DYNARRAY_DEFINE(index_array, size_t, 8)
+DYNARRAY_DEFINE(force_array, force_struct_t, 4)
+
+
+// Indices of the force creators whose testers passed, written by one thread
+typedef index_array_t contact_buffer_t;
+
+
+typedef struct scene {
+    // Every body in draw order: layer by layer, each in the order they were added
+    handle_array_t bodies;
+    // Layer i is bodies[layer_ends[i - 1]] up to bodies[layer_ends[i]]
+    index_array_t layer_ends;
+    force_array_t force_funcs;
+    // The kinematic state of every body in the scene
+    body_store_t *body_store;
+    vector_t dimensions;
+    bool paused;
+    // One block per thread of BODY_NUM_CATEGORIES x BODY_NUM_CATEGORIES counters,
+    // row-major by the first body
+    collision_stats_t *collision_stats;
+    // One contact buffer per thread, merged into the first one each tick
+    contact_buffer_t *contacts;
+    size_t num_threads;
+    // Holds the force creators and everything else that lives as long as the scene
+    arena_t *arena;
+} scene_t;
+
+
 void scene_add_layer(scene_t *scene) {
     assert(scene);
 
-    list_t *new_layer = list_init(SCENE_INIT_MAX_BODIES, (free_func_t) body_free);
-    list_add(scene->layers, new_layer);
-    scene->num_layers++;
+    index_array_push(&scene->layer_ends, handle_array_size(&scene->bodies));
 }
 
 
@@ -47,30 +81,84 @@ void scene_add_n_layers(scene_t *scene, size_t n) {
 
 
 size_t scene_num_layers(scene_t *scene) {
-    assert(scene);
+    DEBUG_ASSERT(scene);
 
-    return(scene->num_layers);
+    return index_array_size(&scene->layer_ends);
 }
 
 
-list_t *scene_get_layer(scene_t *scene, size_t idx) {
-    assert(scene);
-    assert(idx < scene->num_layers);
+size_t scene_layer_end(scene_t *scene, size_t idx) {
+    return *index_array_get(&scene->layer_ends, idx);
+}
+
+
+size_t scene_layer_start(scene_t *scene, size_t idx) {
+    return idx == 0 ? 0 : scene_layer_end(scene, idx - 1);
+}
+
+
+size_t scene_num_bodies_in_layer(scene_t *scene, size_t idx) {
+    DEBUG_ASSERT(scene);
+    DEBUG_ASSERT(idx < scene_num_layers(scene));
+
+    return scene_layer_end(scene, idx) - scene_layer_start(scene, idx);
+}
+
 
-    return (list_t *)list_get(scene->layers, idx);
+body_t *scene_get_body(scene_t *scene, size_t index) {
+    DEBUG_ASSERT(scene);
+    DEBUG_ASSERT(index < handle_array_size(&scene->bodies));
+
+    body_t *body = body_from_handle(*handle_array_get(&scene->bodies, index));
+    DEBUG_ASSERT(body);
+    return body;
 }
 
 
 void scene_free_force_func(force_struct_t *f) {
     assert(f);
 
+    // A bodies array that doesn't fit inline belongs to the scene's arena
     if (f->freer) {
         f->freer(f->aux);
     }
+}
+
+
+// Lets each thread's contact buffer hold every force creator, so testing them never allocates
+void scene_reserve_contacts(scene_t *scene) {
+    size_t num_forces = force_array_size(&scene->force_funcs);
+    for (size_t i = 0; i < scene->num_threads; i++) {
+        contact_buffer_t *buffer = &scene->contacts[i];
+        if (buffer->capacity < num_forces) {
+            index_array_reserve(buffer, num_forces > 2 * buffer->capacity ? num_forces : 2 * buffer->capacity);
+        }
+    }
+}
+
 
-    list_free(f->bodies);
+// Makes room for the counters and contact buffers of num_threads threads
+void scene_reserve_threads(scene_t *scene, size_t num_threads) {
+    if (num_threads <= scene->num_threads) {
+        return;
+    }
+
+    size_t block = BODY_NUM_CATEGORIES * BODY_NUM_CATEGORIES;
+    scene->collision_stats = alloc_realloc(ALLOC_TAG_SCENE, scene->collision_stats,
+                                           sizeof(collision_stats_t) * block * num_threads);
+    assert(scene->collision_stats);
+    memset(&scene->collision_stats[block * scene->num_threads], 0,
+           sizeof(collision_stats_t) * block * (num_threads - scene->num_threads));
+
+    scene->contacts = alloc_realloc(ALLOC_TAG_SCENE, scene->contacts, sizeof(contact_buffer_t) * num_threads);
+    assert(scene->contacts);
+    for (size_t i = scene->num_threads; i < num_threads; i++) {
+        index_array_init(&scene->contacts[i]);
+        index_array_reserve(&scene->contacts[i], SCENE_INIT_CONTACTS);
+    }
 
-    free(f);
+    scene->num_threads = num_threads;
+    scene_reserve_contacts(scene);
 }
 
 
@@ -78,18 +166,20 @@ scene_t *scene_init(vector_t dimensions) {
     assert(dimensions.x > 0);
     assert(dimensions.y > 0);
 
-    scene_t *new_scene = malloc(sizeof(scene_t));
+    scene_t *new_scene = alloc_malloc(ALLOC_TAG_SCENE, sizeof(scene_t));
     assert(new_scene);
 
-    list_t *layers = list_init(SCENE_INIT_NUM_LAYERS, (free_func_t) list_free);
-    list_t *force_funcs = list_init(SCENE_INIT_FORCE_FUNC_COUNT, 
-                                   (free_func_t) scene_free_force_func);
-
-    new_scene->layers = layers;
-    new_scene->num_layers = 0;
-    new_scene->force_funcs = force_funcs;
+    handle_array_init(&new_scene->bodies);
+    index_array_init(&new_scene->layer_ends);
+    force_array_init(&new_scene->force_funcs);
+    new_scene->body_store = body_store_init(0);
     new_scene->dimensions = dimensions;
     new_scene->paused = false;
+    new_scene->collision_stats = NULL;
+    new_scene->contacts = NULL;
+    new_scene->num_threads = 0;
+    scene_reserve_threads(new_scene, 1);
+    new_scene->arena = arena_init(0);
 
     scene_add_n_layers(new_scene, SCENE_INIT_NUM_LAYERS);
 
@@ -100,28 +190,42 @@ scene_t *scene_init(vector_t dimensions) {
 void scene_free(scene_t *scene) {
     assert(scene);
 
-    list_free(scene->layers);
-    list_free(scene->force_funcs);
-    free(scene);
+    for (size_t i = 0; i < scene_num_bodies(scene); i++) {
+        body_free(scene_get_body(scene, i));
+    }
+    handle_array_free(&scene->bodies);
+    index_array_free(&scene->layer_ends);
+    for (size_t i = 0; i < force_array_size(&scene->force_funcs); i++) {
+        scene_free_force_func(force_array_get(&scene->force_funcs, i));
+    }
+    force_array_free(&scene->force_funcs);
+    body_store_free(scene->body_store);
+    alloc_free(ALLOC_TAG_SCENE, scene->collision_stats);
+    for (size_t i = 0; i < scene->num_threads; i++) {
+        index_array_free(&scene->contacts[i]);
+    }
+    alloc_free(ALLOC_TAG_SCENE, scene->contacts);
+    arena_free(scene->arena);
+    alloc_free(ALLOC_TAG_SCENE, scene);
+}
+
+
+arena_t *scene_get_arena(scene_t *scene) {
+    DEBUG_ASSERT(scene);
+
+    return scene->arena;
 }
 
 
 size_t scene_num_bodies(scene_t *scene) {
-    assert(scene);
-    size_t num_bodies = 0;
-    for (size_t i = 0; i < scene->num_layers; i++) {
-        num_bodies += list_size(scene_get_layer(scene, i));
-    }
-    return num_bodies;
+    DEBUG_ASSERT(scene);
+
+    return handle_array_size(&scene->bodies);
 }
 
 
 void scene_add_body(scene_t *scene, body_t *body) {
-    assert(scene);
-    assert(body);
-
-    list_t *default_layer = scene_get_layer(scene, SCENE_DEFAULT_LAYER);
-    list_add(default_layer, body);
+    scene_add_body_in_layer(scene, body, SCENE_DEFAULT_LAYER);
 }
 
 
@@ -129,17 +233,22 @@ void scene_add_body_in_layer(scene_t *scene, body_t *body, size_t layer_no) {
     assert(scene);
     assert(body);
     
-    while (layer_no >= scene->num_layers) {
+    while (layer_no >= scene_num_layers(scene)) {
         scene_add_layer(scene);
     }
-    
-    list_t *layer = scene_get_layer(scene, layer_no);
-    list_add(layer, body);
+
+    // Shift the later layers up, which is cheap when bodies are added to the top layers
+    handle_array_insert(&scene->bodies, scene_layer_end(scene, layer_no), body_get_handle(body));
+    size_t *layer_ends = index_array_data(&scene->layer_ends);
+    for (size_t i = layer_no; i < scene_num_layers(scene); i++) {
+        layer_ends[i]++;
+    }
+    body_set_store(body, scene->body_store);
 }
 
 
 vector_t scene_get_dimensions(scene_t *scene) {
-    assert(scene);
+    DEBUG_ASSERT(scene);
 
     return scene->dimensions;
 }
@@ -161,54 +270,98 @@ void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
     assert(aux);
     assert(bodies);
 
-    force_struct_t *f = malloc(sizeof(force_struct_t));
-    assert(f);
-    f->forcer = forcer;
-    f->aux = aux;
-    f->bodies = bodies;
-    f->freer = freer;
-    list_add(scene->force_funcs, f);
+    scene_add_tested_force_creator(scene, NULL, forcer, aux, bodies, freer);
+}
+
+
+void scene_add_tested_force_creator(scene_t *scene, force_tester_t tester, force_creator_t forcer,
+                                    void *aux, list_t *bodies, free_func_t freer) {
+    assert(scene);
+    assert(forcer);
+    assert(aux);
+    assert(bodies);
+
+    scene_add_batch_tested_force_creator(scene, NULL, tester, forcer, aux, bodies, freer);
+}
+
+
+void scene_add_batch_tested_force_creator(scene_t *scene, force_batch_tester_t batch_tester, force_tester_t tester,
+                                          force_creator_t forcer, void *aux, list_t *bodies, free_func_t freer) {
+    assert(scene);
+    assert(!batch_tester || tester);
+    assert(forcer);
+    assert(aux);
+    assert(bodies);
+
+    force_struct_t f = {
+        .batch_tester = batch_tester,
+        .tester = tester,
+        .forcer = forcer,
+        .aux = aux,
+        .freer = freer,
+        .bodies = NULL,
+        .num_bodies = list_size(bodies)
+    };
+    body_t **f_bodies = f.inline_bodies;
+    if (f.num_bodies > SCENE_INLINE_BODIES) {
+        f.bodies = arena_alloc(scene->arena, sizeof(body_t *) * f.num_bodies);
+        f_bodies = f.bodies;
+    }
+    for (size_t i = 0; i < f.num_bodies; i++) {
+        f_bodies[i] = list_get(bodies, i);
+    }
+    list_free(bodies);
+    force_array_push(&scene->force_funcs, f);
+    scene_reserve_contacts(scene);
+}
+
+
+// Frees a force creator if any of its bodies is being removed; used with force_array_remove_if()
+bool scene_force_has_removed_body(force_struct_t *f, void *aux) {
+    body_t **bodies = f->bodies ? f->bodies : f->inline_bodies;
+    for (size_t i = 0; i < f->num_bodies; i++) {
+        if (body_is_removed(bodies[i])) {
+            scene_free_force_func(f);
+            return true;
+        }
+    }
+    return false;
 }
 
 
 void scene_delete_bodies_and_forces(scene_t *scene) {
     assert(scene);
 
-    for (size_t i = 0; i < scene->num_layers; i++) {
-        list_t *layer = scene_get_layer(scene, i);
-        size_t body_idx = 0;
-        while (body_idx < list_size(layer)) {
-            body_t *body = (body_t *)list_get(layer, body_idx);
-            if (body_is_removed(body)) {
-                list_remove(layer, body_idx);
-
-                size_t force_funcs_idx = 0;
-                while (force_funcs_idx < list_size(scene->force_funcs)) {
-                    force_struct_t *force = list_get(scene->force_funcs, force_funcs_idx);
-
-                    bool removed = false;
-                    for (size_t i = 0; i < list_size(force->bodies); i++) {
-                        body_t *b = list_get(force->bodies, i);
-                        if (body == b) {
-                            list_remove(scene->force_funcs, force_funcs_idx);
-                            scene_free_force_func(force);
-                            removed = true;
-                            break;
-                        }
-                    }
-                    if (!removed) {
-                        force_funcs_idx++;
-                    }
-                }
+    size_t num_bodies = scene_num_bodies(scene);
+    size_t num_removed = 0;
+    for (size_t i = 0; i < num_bodies; i++) {
+        num_removed += body_is_removed(scene_get_body(scene, i));
+    }
+    if (num_removed == 0) {
+        return;
+    }
 
+    // Drop the force creators of every removed body in one pass, while the bodies are still live
+    force_array_remove_if(&scene->force_funcs, scene_force_has_removed_body, NULL);
+
+    // Compact the bodies in one pass, keeping their order
+    body_handle_t *bodies = handle_array_data(&scene->bodies);
+    size_t *layer_ends = index_array_data(&scene->layer_ends);
+    size_t kept = 0;
+    size_t idx = 0;
+    for (size_t i = 0; i < scene_num_layers(scene); i++) {
+        for (; idx < layer_ends[i]; idx++) {
+            body_t *body = scene_get_body(scene, idx);
+            if (body_is_removed(body)) {
                 body_free(body);
             }
             else {
-                body_idx++;
+                bodies[kept++] = bodies[idx];
             }
         }
-
+        layer_ends[i] = kept;
     }
+    handle_array_truncate(&scene->bodies, kept);
 }
 
 
@@ -216,35 +369,111 @@ void scene_for_each(scene_t *scene, body_func_t f, void *args) {
     assert(scene);
     assert(f);
 
-    for (size_t i = 0; i < scene->num_layers; i++) {
-        list_t *layer = scene_get_layer(scene, i);
-        for (size_t j = 0; j < list_size(layer); j++) {
-            f((body_t *)list_get(layer, j), args);
+    for (size_t i = 0; i < scene_num_bodies(scene); i++) {
+        f(scene_get_body(scene, i), args);
+    }
+}
+
+
+// Helper function to use body_finish_tick() with the scene_for_each() abstraction
+void scene_helper_body_finish_tick(body_t *body, void *dt) {
+    body_finish_tick(body, *(double *)dt);
+}
+
+
+// Runs the testers of one slice of the force creators; called by jobs_parallel_for()
+void scene_test_force_range(size_t start, size_t end, void *aux) {
+    scene_t *scene = aux;
+    contact_buffer_t *buffer = &scene->contacts[jobs_thread_index()];
+    size_t i = start;
+    while (i < end) {
+        force_struct_t *f = force_array_get(&scene->force_funcs, i);
+        if (!f->batch_tester) {
+            if (f->tester && f->tester(f->aux)) {
+                index_array_push(buffer, i);
+            }
+            i++;
+            continue;
+        }
+
+        // Test the run of force creators that share this batch tester together
+        void *auxes[SCENE_BATCH_MAX];
+        bool results[SCENE_BATCH_MAX];
+        size_t num_auxes = 0;
+        while (i + num_auxes < end && num_auxes < SCENE_BATCH_MAX) {
+            force_struct_t *next = force_array_get(&scene->force_funcs, i + num_auxes);
+            if (next->batch_tester != f->batch_tester) {
+                break;
+            }
+            auxes[num_auxes++] = next->aux;
+        }
+        f->batch_tester(auxes, num_auxes, results);
+        for (size_t j = 0; j < num_auxes; j++) {
+            if (results[j]) {
+                index_array_push(buffer, i + j);
+            }
         }
+        i += num_auxes;
     }
 }
 
 
-// Helper function to use body_tick() with the scene_for_each() abstraction
-void scene_helper_body_tick(body_t *body, void *dt) {
-    body_tick(body, *(double *)dt);
+int scene_compare_force_idxs(const void *a, const void *b) {
+    size_t idx1 = *(const size_t *)a;
+    size_t idx2 = *(const size_t *)b;
+    return (idx1 > idx2) - (idx1 < idx2);
+}
+
+
+// Gathers every thread's contacts into the first buffer, in force creator order
+void scene_merge_contacts(scene_t *scene) {
+    contact_buffer_t *merged = &scene->contacts[0];
+    for (size_t i = 1; i < scene->num_threads; i++) {
+        contact_buffer_t *buffer = &scene->contacts[i];
+        for (size_t j = 0; j < index_array_size(buffer); j++) {
+            index_array_push(merged, *index_array_get(buffer, j));
+        }
+        index_array_clear(buffer);
+    }
+    qsort(index_array_data(merged), index_array_size(merged), sizeof(size_t), scene_compare_force_idxs);
 }
 
 
 void scene_tick(scene_t *scene, double dt) {
     assert(scene);
     if (scene->paused) return;
-    
-    for (size_t i = 0; i < list_size(scene->force_funcs); i++) {
-        force_struct_t *f = list_get(scene->force_funcs, i);
-        f->forcer(f->aux);
+
+    // Test in parallel, then respond serially in the order the force creators were added
+    scene_reserve_threads(scene, jobs_num_threads());
+    size_t num_tested = force_array_size(&scene->force_funcs);
+    jobs_parallel_for(num_tested, SCENE_TEST_GRAIN, scene_test_force_range, scene);
+    scene_merge_contacts(scene);
+
+    contact_buffer_t *contacts = &scene->contacts[0];
+    size_t *contact_idxs = index_array_data(contacts);
+    size_t next_contact = 0;
+    // Force creators may add more, which can move the array, so f is only used before calling one
+    for (size_t i = 0; i < force_array_size(&scene->force_funcs); i++) {
+        force_struct_t *f = force_array_get(&scene->force_funcs, i);
+        if (!f->tester) {
+            f->forcer(f->aux);
+        }
+        else if (i >= num_tested) {
+            // Added by an earlier force creator during this tick
+            if (f->tester(f->aux)) {
+                f->forcer(f->aux);
+            }
+        }
+        else if (next_contact < index_array_size(contacts) && contact_idxs[next_contact] == i) {
+            next_contact++;
+            f->forcer(f->aux);
+        }
     }
+    index_array_clear(contacts);
 
-    double *d = malloc(sizeof(double));
-    assert(d);
-    *d = dt;
-    scene_for_each(scene, scene_helper_body_tick, (void *)d);
-    free(d);
+    // Integrate in parallel, then run tick functions serially in layer order
+    body_store_tick(scene->body_store, dt);
+    scene_for_each(scene, scene_helper_body_finish_tick, &dt);
 
     scene_delete_bodies_and_forces(scene);
 }
@@ -268,4 +497,49 @@ void scene_toggle_pause(scene_t *scene) {
     assert(scene);
 
     scene->paused = !scene->paused;
-}
\ No newline at end of file
+}
+
+
+collision_stats_t scene_get_collision_stats(scene_t *scene, size_t category1, size_t category2) {
+    assert(scene);
+    assert(category1 < BODY_NUM_CATEGORIES);
+    assert(category2 < BODY_NUM_CATEGORIES);
+
+    size_t block = BODY_NUM_CATEGORIES * BODY_NUM_CATEGORIES;
+    collision_stats_t total = {0};
+    for (size_t i = 0; i < scene->num_threads; i++) {
+        collision_stats_add(&total, scene->collision_stats[i * block + category1 * BODY_NUM_CATEGORIES + category2]);
+    }
+    return total;
+}
+
+
+collision_stats_t *scene_get_thread_collision_stats(scene_t *scene, size_t category1, size_t category2) {
+    DEBUG_ASSERT(scene);
+    DEBUG_ASSERT(category1 < BODY_NUM_CATEGORIES);
+    DEBUG_ASSERT(category2 < BODY_NUM_CATEGORIES);
+
+    size_t thread = jobs_thread_index();
+    DEBUG_ASSERT(thread < scene->num_threads);
+    size_t block = BODY_NUM_CATEGORIES * BODY_NUM_CATEGORIES;
+    return &scene->collision_stats[thread * block + category1 * BODY_NUM_CATEGORIES + category2];
+}
+
+
+collision_stats_t scene_get_total_collision_stats(scene_t *scene) {
+    assert(scene);
+
+    collision_stats_t total = {0};
+    for (size_t i = 0; i < BODY_NUM_CATEGORIES * BODY_NUM_CATEGORIES * scene->num_threads; i++) {
+        collision_stats_add(&total, scene->collision_stats[i]);
+    }
+    return total;
+}
+
+
+void scene_reset_collision_stats(scene_t *scene) {
+    assert(scene);
+
+    memset(scene->collision_stats, 0,
+           sizeof(collision_stats_t) * BODY_NUM_CATEGORIES * BODY_NUM_CATEGORIES * scene->num_threads);
+}
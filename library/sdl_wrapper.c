@@ -3,13 +3,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
-#include "polygon.h"
+#include "alloc.h"
+#include "assets.h"
 #include "sdl_wrapper.h"
+#include "vector_batch.h"
 
 const char WINDOW_TITLE[] = "FURIOUS AND FAST";
 const int WINDOW_WIDTH = 1000;
 const int WINDOW_HEIGHT = 500;
 const double MS_PER_S = 1e3;
+#define POLYGON_STACK_POINTS 64
 
 /**
  * The coordinate at the center of the screen.
@@ -27,6 +30,10 @@ SDL_Window *window;
  * The renderer used to draw the scene.
  */
 SDL_Renderer *renderer;
+/**
+ * The surface rendered to when running without a window, or NULL.
+ */
+SDL_Surface *offscreen = NULL;
 /**
  * The keypress handler, or NULL if none has been configured.
  */
@@ -44,14 +51,13 @@ clock_t last_clock = 0;
 
 /** Computes the center of the window in pixel coordinates */
 vector_t get_window_center(void) {
-    int *width = malloc(sizeof(*width)),
-        *height = malloc(sizeof(*height));
-    assert(width != NULL);
-    assert(height != NULL);
-    SDL_GetWindowSize(window, width, height);
-    vector_t dimensions = {.x = *width, .y = *height};
-    free(width);
-    free(height);
+    if (offscreen) {
+        vector_t dimensions = {.x = offscreen->w, .y = offscreen->h};
+        return vec_multiply(0.5, dimensions);
+    }
+    int width, height;
+    SDL_GetWindowSize(window, &width, &height);
+    vector_t dimensions = {.x = width, .y = height};
     return vec_multiply(0.5, dimensions);
 }
 
@@ -119,15 +125,36 @@ void sdl_init(vector_t min, vector_t max) {
         SDL_WINDOW_RESIZABLE
     );
     renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    assets_set_renderer(renderer);
+}
+
+void sdl_init_offscreen(vector_t min, vector_t max) {
+    // Check parameters
+    assert(min.x < max.x);
+    assert(min.y < max.y);
+
+    center = vec_multiply(0.5, vec_add(min, max));
+    max_diff = vec_subtract(max, center);
+    SDL_Init(SDL_INIT_TIMER);
+    IMG_Init(IMG_INIT_JPG | IMG_INIT_PNG | IMG_INIT_TIF | IMG_INIT_WEBP);
+    TTF_Init();
+    window = NULL;
+    offscreen = SDL_CreateRGBSurfaceWithFormat(0, WINDOW_WIDTH, WINDOW_HEIGHT, 32,
+                                               SDL_PIXELFORMAT_RGBA32);
+    assert(offscreen);
+    renderer = SDL_CreateSoftwareRenderer(offscreen);
+    assert(renderer);
+    assets_set_renderer(renderer);
 }
 
 bool sdl_is_done(void *object) {
-    SDL_Event *event = malloc(sizeof(*event));
-    assert(event != NULL);
-    while (SDL_PollEvent(event)) {
-        switch (event->type) {
+    SDL_Event event;
+    while (SDL_PollEvent(&event)) {
+        switch (event.type) {
             case SDL_QUIT:
-                free(event);
+                // The cached textures go before the renderer that made them
+                assets_free();
+                assets_set_renderer(NULL);
                 SDL_DestroyRenderer(renderer);
 	            SDL_DestroyWindow(window);
                 IMG_Quit();
@@ -138,39 +165,36 @@ bool sdl_is_done(void *object) {
                 // Skip the keypress if no handler is configured
                 // or an unrecognized key was pressed
                 if (key_handler == NULL) break;
-                char key = get_keycode(event->key.keysym.sym);
+                char key = get_keycode(event.key.keysym.sym);
                 if (key == '\0') break;
 
-                uint32_t timestamp = event->key.timestamp;
-                if (!event->key.repeat) {
+                uint32_t timestamp = event.key.timestamp;
+                if (!event.key.repeat) {
                     key_start_timestamp = timestamp;
                 }
                 key_event_type_t type =
-                    event->type == SDL_KEYDOWN ? KEY_PRESSED : KEY_RELEASED;
+                    event.type == SDL_KEYDOWN ? KEY_PRESSED : KEY_RELEASED;
                 double held_time = (timestamp - key_start_timestamp) / MS_PER_S;
                 key_handler(key, type, held_time, object);
                 break;
         }
     }
-    free(event);
     return false;
 }
 
 enum event sdl_event_loop(void) {
     enum event e = NO_EVENT;
-    SDL_Event *event = malloc(sizeof(*event));
-    assert(event);
-    while (SDL_PollEvent(event)) {
-        if (event->type == SDL_QUIT) {
+    SDL_Event event;
+    while (SDL_PollEvent(&event)) {
+        if (event.type == SDL_QUIT) {
             e = QUIT;
             break;
         }
-        else if (event->type == SDL_MOUSEBUTTONDOWN) {
+        else if (event.type == SDL_MOUSEBUTTONDOWN) {
             e = MOUSE;
             break;
         }
     }
-    free(event);
     return e;
 }
 
@@ -179,27 +203,30 @@ void sdl_clear(void) {
     SDL_RenderClear(renderer);
 }
 
-void sdl_draw_polygon(list_t *points, rgb_color_t color) {
+// Draws a filled polygon from contiguous vertices, translated by a scene-space offset
+void sdl_draw_vertices(const vector_t *vertices, size_t n, vector_t translation, rgb_color_t color) {
     // Check parameters
-    size_t n = list_size(points);
     assert(n >= 3);
     assert(0 <= color.r && color.r <= 1);
     assert(0 <= color.g && color.g <= 1);
     assert(0 <= color.b && color.b <= 1);
 
     vector_t window_center = get_window_center();
+    double scale = get_scene_scale(window_center);
 
-    // Convert each vertex to a point on screen
-    int16_t *x_points = malloc(sizeof(*x_points) * n),
-            *y_points = malloc(sizeof(*y_points) * n);
-    assert(x_points != NULL);
-    assert(y_points != NULL);
-    for (size_t i = 0; i < n; i++) {
-        vector_t *vertex = list_get(points, i);
-        vector_t pixel = get_window_position(*vertex, window_center);
-        x_points[i] = pixel.x;
-        y_points[i] = pixel.y;
+    // Convert each vertex to a point on screen.
+    // Only polygons with more vertices than the stack buffers need the heap.
+    int16_t x_stack[POLYGON_STACK_POINTS], y_stack[POLYGON_STACK_POINTS];
+    int16_t *x_points = x_stack, *y_points = y_stack;
+    if (n > POLYGON_STACK_POINTS) {
+        x_points = alloc_malloc(ALLOC_TAG_SDL, sizeof(*x_points) * n);
+        y_points = alloc_malloc(ALLOC_TAG_SDL, sizeof(*y_points) * n);
+        assert(x_points != NULL);
+        assert(y_points != NULL);
     }
+    // Map the center of the scene to the center of the window
+    vec_batch_to_screen(vertices, n, vec_subtract(translation, center), scale, window_center,
+                        x_points, y_points);
 
     // Draw polygon with the given color
     filledPolygonRGBA(
@@ -207,8 +234,30 @@ void sdl_draw_polygon(list_t *points, rgb_color_t color) {
         x_points, y_points, n,
         color.r * 255, color.g * 255, color.b * 255, 255
     );
-    free(x_points);
-    free(y_points);
+    if (n > POLYGON_STACK_POINTS) {
+        alloc_free(ALLOC_TAG_SDL, x_points);
+        alloc_free(ALLOC_TAG_SDL, y_points);
+    }
+}
+
+void sdl_draw_polygon(list_t *points, rgb_color_t color) {
+    size_t n = list_size(points);
+    if (n == 0) {
+        return;
+    }
+    vector_t vertex_stack[POLYGON_STACK_POINTS];
+    vector_t *vertices = vertex_stack;
+    if (n > POLYGON_STACK_POINTS) {
+        vertices = alloc_malloc(ALLOC_TAG_SDL, sizeof(*vertices) * n);
+        assert(vertices != NULL);
+    }
+    for (size_t i = 0; i < n; i++) {
+        vertices[i] = *(vector_t *)list_get(points, i);
+    }
+    sdl_draw_vertices(vertices, n, VEC_ZERO, color);
+    if (n > POLYGON_STACK_POINTS) {
+        alloc_free(ALLOC_TAG_SDL, vertices);
+    }
 }
 
 void sdl_show(void) {
@@ -218,24 +267,28 @@ void sdl_show(void) {
              min = vec_subtract(center, max_diff);
     vector_t max_pixel = get_window_position(max, window_center),
              min_pixel = get_window_position(min, window_center);
-    SDL_Rect *boundary = malloc(sizeof(*boundary));
-    boundary->x = min_pixel.x;
-    boundary->y = max_pixel.y;
-    boundary->w = max_pixel.x - min_pixel.x;
-    boundary->h = min_pixel.y - max_pixel.y;
+    SDL_Rect boundary = {
+        .x = min_pixel.x,
+        .y = max_pixel.y,
+        .w = max_pixel.x - min_pixel.x,
+        .h = min_pixel.y - max_pixel.y
+    };
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-    SDL_RenderDrawRect(renderer, boundary);
-    free(boundary);
+    SDL_RenderDrawRect(renderer, &boundary);
 
     SDL_RenderPresent(renderer);
 }
 
 void sdl_render_sprite(SDL_Surface *surface, vector_t center, vector_t dim, double angle) {
-    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+    // Images from the asset cache keep their texture; anything else, e.g. text, is converted each time
+    SDL_Texture *cached = assets_get_texture(surface);
+    SDL_Texture *texture = cached ? cached : SDL_CreateTextureFromSurface(renderer, surface);
     SDL_Rect dstrect = {center.x - dim.x / 2, WINDOW_HEIGHT - (center.y + dim.y / 2),
                         dim.x, dim.y};
     SDL_RenderCopyEx(renderer, texture, NULL, &dstrect, angle, NULL, SDL_FLIP_NONE);
-    SDL_DestroyTexture(texture);
+    if (!cached) {
+        SDL_DestroyTexture(texture);
+    }
 }
 
 void sdl_render_window(window_t *window) {
@@ -249,32 +302,27 @@ void sdl_render_window(window_t *window) {
     vector_t max_dims = window_get_dims(window);
     vector_t center = window_get_center(window);
     vector_t window_center = {.x = max_dims.x / 2., max_dims.y / 2.};
-    size_t num_layers = scene_num_layers(scene);
-    for (size_t i = 0; i < num_layers; i++) {
-        list_t *layer = scene_get_layer(scene, i);
-        size_t num_bodies = list_size(layer);
-        for (size_t j = 0; j < num_bodies; j++) {
-            body_t *body = (body_t *)list_get(layer, j);
-            vector_t c = body_get_centroid(body);
-            double r = body_get_bounding_radius(body);
-            double dx = fabs(c.x - center.x);
-            double dy = fabs(c.y - center.y);
-            if (dx < r + max_dims.x / 2. && dy < r + max_dims.y / 2.) {
-                if (body_get_surface(body) && !body_get_debug_mode(body)) {
-                    vector_t scene_c = body_get_centroid(body);
-                    vector_t window_c = scene_to_window_space(window, scene_c);
-                    // Convert to degrees and clockwise orientation
-                    double rot_angle = -body_get_rotation(body) * 180. / M_PI;
-                    sdl_render_sprite(body_get_surface(body), window_c, body_get_dimensions(body), rot_angle);
-                }
-                else {
-                    // Translate the shape to window space
-                    list_t *shape = body_get_shape(body);
-                    vector_t window_trans = vec_subtract(window_center, center);
-                    polygon_translate(shape, window_trans);
-                    sdl_draw_polygon(shape, body_get_color(body));
-                    list_free(shape);
-                }
+    // Bodies come in draw order, layer by layer
+    size_t num_bodies = scene_num_bodies(scene);
+    for (size_t i = 0; i < num_bodies; i++) {
+        body_t *body = scene_get_body(scene, i);
+        vector_t c = body_get_centroid(body);
+        double r = body_get_bounding_radius(body);
+        double dx = fabs(c.x - center.x);
+        double dy = fabs(c.y - center.y);
+        if (dx < r + max_dims.x / 2. && dy < r + max_dims.y / 2.) {
+            if (body_get_surface(body) && !body_get_debug_mode(body)) {
+                vector_t scene_c = body_get_centroid(body);
+                vector_t window_c = scene_to_window_space(window, scene_c);
+                // Convert to degrees and clockwise orientation
+                double rot_angle = -body_get_rotation(body) * 180. / M_PI;
+                sdl_render_sprite(body_get_surface(body), window_c, body_get_dimensions(body), rot_angle);
+            }
+            else {
+                // Translate the shape to window space
+                vector_t window_trans = vec_subtract(window_center, center);
+                sdl_draw_vertices(body_get_vertices(body), body_get_num_vertices(body),
+                                  window_trans, body_get_color(body));
             }
         }
     }
@@ -282,11 +330,8 @@ void sdl_render_window(window_t *window) {
     // Render the HUD
     hud_t *hud = window_get_hud(window);
     if (hud) {
-        list_t *widgets = hud_get_widgets(hud);
-        assert(widgets);
-
-        for (size_t i = 0; i < list_size(widgets); i++) {
-            widget_t *widget = list_get(widgets, i);
+        for (size_t i = 0; i < hud_num_widgets(hud); i++) {
+            widget_t *widget = hud_get_widget(hud, i);
             SDL_Surface *surface = widget_get_surface(widget);
             if (surface) {
                 SDL_Rect orientation = widget_get_rect(widget);
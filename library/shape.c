@@ -1,6 +1,7 @@
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
+#include "alloc.h"
 #include "polygon.h"
 #include "mathlib.h"
 #include "shape.h"
@@ -46,14 +47,14 @@ body_t *shape_init_star(size_t n_points, double outer_radius,
     for (size_t i = 0; i < n_points; i++) {
         double rotation = rot_per_point * i;
         // Add the outer vertex by rotating the from the top of the star
-        vector_t *v = malloc(sizeof(vector_t));
+        vector_t *v = alloc_malloc(ALLOC_TAG_SHAPE, sizeof(vector_t));
         assert(v);
         *v = vec_rotate(top, rotation);
         *v = vec_add(*v, center);
         list_add(polygon, v);
 
         // Add the inner vertex by rotating from the first inner vertex
-        v = malloc(sizeof(vector_t));
+        v = alloc_malloc(ALLOC_TAG_SHAPE, sizeof(vector_t));
         assert(v);
         *v = vec_rotate(inner_start, rotation);
         *v = vec_add(*v, center);
@@ -69,15 +70,15 @@ body_t *shape_init_star(size_t n_points, double outer_radius,
 }
 
 
-body_t *shape_init_random_star(size_t n_points, double density, vector_t center,
+body_t *shape_init_random_star(rng_t *rng, size_t n_points, double density, vector_t center,
                                bool rand_size, bool init_velocity) {
     // Randomly generate properties for the star
-    double scale = rand_size ? mathlib_rand_in_range(SCALE_MIN, SCALE_MAX) : 1;
+    double scale = rand_size ? rng_range(rng, SCALE_MIN, SCALE_MAX) : 1;
     double outer_radius = OUTER_RADIUS_BASE * scale;
     double inner_radius = INNER_RADIUS_BASE * scale;
-    double r = mathlib_rand_in_range(0, 1);
-    double g = mathlib_rand_in_range(0, 1);
-    double b = mathlib_rand_in_range(0, 1);
+    double r = rng_double(rng);
+    double g = rng_double(rng);
+    double b = rng_double(rng);
     rgb_color_t color = {.r = r, .g = g, .b = b};
     vector_t velocity = init_velocity ? DEFAULT_VELOCITY : VEC_ZERO;
 
@@ -98,7 +99,7 @@ body_t *shape_init_circle_sector_with_sprite(double radius, double sector_angle,
                                              double density, void *info, free_func_t info_freer,
                                              const char *filename, vector_t dimensions) {
     list_t *points = list_init(EDGES, free);
-    vector_t *pen = malloc(sizeof(vector_t));
+    vector_t *pen = alloc_malloc(ALLOC_TAG_SHAPE, sizeof(vector_t));
     assert(pen);
 
     // if it is not a fill circle, start point at the origin
@@ -107,7 +108,7 @@ body_t *shape_init_circle_sector_with_sprite(double radius, double sector_angle,
         list_add(points, pen);
     }
 
-    pen = malloc(sizeof(vector_t));
+    pen = alloc_malloc(ALLOC_TAG_SHAPE, sizeof(vector_t));
     assert(pen);
     pen->x = radius * cos(sector_angle / 2);        
     pen->y = radius * sin(sector_angle / 2);
@@ -115,7 +116,7 @@ body_t *shape_init_circle_sector_with_sprite(double radius, double sector_angle,
 
     double rot_angle = (2 * M_PI - sector_angle) / EDGES;
     for (size_t i = 0; i < (EDGES - 1); i++) {
-        vector_t *new_pen = malloc(sizeof(vector_t));
+        vector_t *new_pen = alloc_malloc(ALLOC_TAG_SHAPE, sizeof(vector_t));
         assert(new_pen);
 
         *new_pen = vec_rotate(*pen, rot_angle);
@@ -161,7 +162,7 @@ body_t *shape_init_oval(double a, double b, size_t num_edges,
                                 + a * a * sin(theta) * sin(theta));
         double x = k * cos(theta);
         double y = k * sin(theta);
-        vector_t *new_point = malloc(sizeof(vector_t));
+        vector_t *new_point = alloc_malloc(ALLOC_TAG_SHAPE, sizeof(vector_t));
         assert(new_point);
         *new_point = (vector_t){.x = x, .y = y};
         list_add(oval_shape, new_point);
@@ -183,22 +184,22 @@ body_t *shape_init_rectangle_with_sprite(double l, double h, rgb_color_t color,
                                          void *info, free_func_t info_freer, const char *filename,
                                          vector_t dimensions) {
     list_t *rectangle_points = list_init(4, free);
-    vector_t *bot_left = malloc(sizeof(vector_t));
+    vector_t *bot_left = alloc_malloc(ALLOC_TAG_SHAPE, sizeof(vector_t));
     assert(bot_left);
     *bot_left = (vector_t) {.x = (-l/2.), .y = (-h/2.)};
     list_add(rectangle_points, bot_left);
 
-    vector_t *top_left = malloc(sizeof(vector_t));
+    vector_t *top_left = alloc_malloc(ALLOC_TAG_SHAPE, sizeof(vector_t));
     assert(top_left);
     *top_left = (vector_t) {.x = (-l/2.), .y = (h/2.)};
     list_add(rectangle_points, top_left);
        
-    vector_t *top_right = malloc(sizeof(vector_t));
+    vector_t *top_right = alloc_malloc(ALLOC_TAG_SHAPE, sizeof(vector_t));
     assert(top_right);
     *top_right = (vector_t) {.x = (l/2.), .y = (h/2.)};
     list_add(rectangle_points, top_right);
         
-    vector_t *bot_right = malloc(sizeof(vector_t));
+    vector_t *bot_right = alloc_malloc(ALLOC_TAG_SHAPE, sizeof(vector_t));
     assert(bot_right);
     *bot_right = (vector_t) {.x = (l/2.), .y = (-h/2.)};
     list_add(rectangle_points, bot_right);
@@ -216,7 +217,7 @@ body_t *shape_init_rectangle_with_sprite(double l, double h, rgb_color_t color,
 body_t *shape_init_needle(double radius, double length, rgb_color_t color, void *info, free_func_t info_freer) {
     list_t *points = list_init(20, free);
 
-    vector_t *pen = malloc(sizeof(vector_t));
+    vector_t *pen = alloc_malloc(ALLOC_TAG_SHAPE, sizeof(vector_t));
     assert(pen);
 
     pen->x = 0;
@@ -227,7 +228,7 @@ body_t *shape_init_needle(double radius, double length, rgb_color_t color, void
 
     double rot_angle = (M_PI) / (EDGES / 2);
     for (size_t i = 0; i < (EDGES / 2); i++) {
-        vector_t *new_pen = malloc(sizeof(vector_t));
+        vector_t *new_pen = alloc_malloc(ALLOC_TAG_SHAPE, sizeof(vector_t));
         assert(new_pen);
 
         *new_pen = vec_rotate(*pen, rot_angle);
@@ -243,15 +244,15 @@ body_t *shape_init_needle(double radius, double length, rgb_color_t color, void
 body_t *shape_init_triangle_with_info(double width, double height, rgb_color_t color, double mass, void *info, free_func_t info_freer) {
     list_t *points = list_init(3, free);
 
-    vector_t *point1 = malloc(sizeof(vector_t));
+    vector_t *point1 = alloc_malloc(ALLOC_TAG_SHAPE, sizeof(vector_t));
     point1->x = -1.0 * (width / 2.0);
     point1->y = 0;
     list_add(points, point1);
-    vector_t *point2 = malloc(sizeof(vector_t));
+    vector_t *point2 = alloc_malloc(ALLOC_TAG_SHAPE, sizeof(vector_t));
     point2->x = (width / 2.0);
     point2->y = 0;
     list_add(points, point2);
-    vector_t *point3 = malloc(sizeof(vector_t));
+    vector_t *point3 = alloc_malloc(ALLOC_TAG_SHAPE, sizeof(vector_t));
     point3->x = 0;
     point3->y = height;
     list_add(points, point3);
@@ -260,14 +261,6 @@ body_t *shape_init_triangle_with_info(double width, double height, rgb_color_t c
 }
 
 
-body_t *shape_init_ai_collider(body_t *ai_car) {
-    vector_t dimensions = body_get_dimensions(ai_car);
-    rgb_color_t black = {.r = 0, .g = 0, .b = 0};
-    body_t *ai_collider = shape_init_triangle_with_info(4 * dimensions.x, 20, black, 0.1, (void*)ai_car, NULL);
-    return ai_collider;
-}
-
-
 body_t *shape_init_player_indicator(body_t *player_car) {
     vector_t dimensions = body_get_dimensions(player_car);
     rgb_color_t blue = {.r = 0, .g = 0, .b = 0.8};
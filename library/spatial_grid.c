@@ -0,0 +1,223 @@
+#include "spatial_grid.h"
+#include "alloc.h"
+#include "dynarray.h"
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// A power of two, so a cell's bucket is its hash masked
+#define SPATIAL_GRID_NUM_BUCKETS 1024
+const size_t SPATIAL_GRID_NO_ENTRY = SIZE_MAX;
+// Large primes that spread neighboring cells over the buckets
+const uint64_t SPATIAL_GRID_X_PRIME = UINT64_C(73856093);
+const uint64_t SPATIAL_GRID_Y_PRIME = UINT64_C(19349663);
+
+
+typedef struct grid_box {
+    double min_x;
+    double min_y;
+    double max_x;
+    double max_y;
+} grid_box_t;
+
+// One box's listing in one cell
+typedef struct grid_entry {
+    size_t id;
+    // The next entry in the same bucket, which may be from another cell
+    size_t next;
+    int64_t x;
+    int64_t y;
+} grid_entry_t;
+
+DYNARRAY_DEFINE(grid_entry_array, grid_entry_t, 1)
+DYNARRAY_DEFINE(grid_box_array, grid_box_t, 1)
+DYNARRAY_DEFINE(grid_id_array, size_t, 1)
+
+
+typedef struct spatial_grid {
+    double cell_size;
+    size_t size;
+    // The first entry of each bucket's chain
+    size_t buckets[SPATIAL_GRID_NUM_BUCKETS];
+    grid_entry_array_t entries;
+    // Boxes that touch more cells than there are buckets, which every query checks
+    grid_id_array_t oversized;
+    // Indexed by id
+    grid_box_array_t boxes;
+} spatial_grid_t;
+
+
+spatial_grid_t *spatial_grid_init(double cell_size) {
+    assert(cell_size > 0);
+
+    spatial_grid_t *grid = alloc_malloc(ALLOC_TAG_SCENE, sizeof(spatial_grid_t));
+    assert(grid);
+    grid->cell_size = cell_size;
+    grid_entry_array_init(&grid->entries);
+    grid_id_array_init(&grid->oversized);
+    grid_box_array_init(&grid->boxes);
+    spatial_grid_clear(grid);
+    return grid;
+}
+
+
+void spatial_grid_free(spatial_grid_t *grid) {
+    assert(grid);
+
+    grid_entry_array_free(&grid->entries);
+    grid_id_array_free(&grid->oversized);
+    grid_box_array_free(&grid->boxes);
+    alloc_free(ALLOC_TAG_SCENE, grid);
+}
+
+
+void spatial_grid_clear(spatial_grid_t *grid) {
+    assert(grid);
+
+    for (size_t i = 0; i < SPATIAL_GRID_NUM_BUCKETS; i++) {
+        grid->buckets[i] = SPATIAL_GRID_NO_ENTRY;
+    }
+    grid_entry_array_clear(&grid->entries);
+    grid_id_array_clear(&grid->oversized);
+    grid->size = 0;
+}
+
+
+void spatial_grid_reserve(spatial_grid_t *grid, size_t num_boxes, double max_size) {
+    assert(grid);
+    assert(max_size >= 0);
+
+    grid_box_array_reserve(&grid->boxes, num_boxes);
+    // A box can straddle one more cell than fits inside it, each way
+    double cells = floor(max_size / grid->cell_size) + 2;
+    if (cells * cells > SPATIAL_GRID_NUM_BUCKETS) {
+        grid_id_array_reserve(&grid->oversized, num_boxes);
+    }
+    else {
+        grid_entry_array_reserve(&grid->entries, num_boxes * (size_t)(cells * cells));
+    }
+}
+
+
+size_t spatial_grid_size(spatial_grid_t *grid) {
+    assert(grid);
+
+    return grid->size;
+}
+
+
+int64_t spatial_grid_cell(spatial_grid_t *grid, double coordinate) {
+    return (int64_t)floor(coordinate / grid->cell_size);
+}
+
+
+size_t spatial_grid_bucket(int64_t x, int64_t y) {
+    uint64_t hash = ((uint64_t)x * SPATIAL_GRID_X_PRIME) ^ ((uint64_t)y * SPATIAL_GRID_Y_PRIME);
+    return (size_t)(hash & (SPATIAL_GRID_NUM_BUCKETS - 1));
+}
+
+
+void spatial_grid_insert(spatial_grid_t *grid, size_t id, vector_t min, vector_t max) {
+    assert(grid);
+    assert(min.x <= max.x && min.y <= max.y);
+
+    while (grid_box_array_size(&grid->boxes) <= id) {
+        grid_box_array_push(&grid->boxes, (grid_box_t){0});
+    }
+    *grid_box_array_get(&grid->boxes, id) = (grid_box_t){min.x, min.y, max.x, max.y};
+    grid->size++;
+
+    int64_t min_x = spatial_grid_cell(grid, min.x), max_x = spatial_grid_cell(grid, max.x);
+    int64_t min_y = spatial_grid_cell(grid, min.y), max_y = spatial_grid_cell(grid, max.y);
+    if ((double)(max_x - min_x + 1) * (max_y - min_y + 1) > SPATIAL_GRID_NUM_BUCKETS) {
+        grid_id_array_push(&grid->oversized, id);
+        return;
+    }
+    for (int64_t x = min_x; x <= max_x; x++) {
+        for (int64_t y = min_y; y <= max_y; y++) {
+            size_t bucket = spatial_grid_bucket(x, y);
+            grid_entry_t entry = {.id = id, .next = grid->buckets[bucket], .x = x, .y = y};
+            grid->buckets[bucket] = grid_entry_array_size(&grid->entries);
+            grid_entry_array_push(&grid->entries, entry);
+        }
+    }
+}
+
+
+// The cells a region covers, as inclusive ranges
+typedef struct grid_cells {
+    int64_t min_x;
+    int64_t min_y;
+    int64_t max_x;
+    int64_t max_y;
+} grid_cells_t;
+
+
+// Records a box if it overlaps the region, returning the new number found
+size_t spatial_grid_visit(spatial_grid_t *grid, size_t id, grid_box_t region, size_t *ids, size_t max_ids,
+                          size_t num_found) {
+    const grid_box_t *box = grid_box_array_get(&grid->boxes, id);
+    if (box->max_x < region.min_x || box->min_x > region.max_x ||
+        box->max_y < region.min_y || box->min_y > region.max_y) {
+        return num_found;
+    }
+    if (num_found < max_ids) {
+        ids[num_found] = id;
+    }
+    return num_found + 1;
+}
+
+
+// Visits the entries of a bucket that are listed in the given cell. A box listed in several
+// cells is only visited from the first cell the box and the query share, so queries find each
+// box once without marking anything, and any number of them can run at once.
+void spatial_grid_visit_bucket(spatial_grid_t *grid, size_t bucket, grid_cells_t query,
+                               bool any_cell, int64_t x, int64_t y, grid_box_t region, size_t *ids,
+                               size_t max_ids, size_t *num_found) {
+    const grid_entry_t *entries = grid_entry_array_data(&grid->entries);
+    for (size_t i = grid->buckets[bucket]; i != SPATIAL_GRID_NO_ENTRY; i = entries[i].next) {
+        const grid_entry_t *entry = &entries[i];
+        if (!any_cell && (entry->x != x || entry->y != y)) {
+            continue;
+        }
+        const grid_box_t *box = grid_box_array_get(&grid->boxes, entry->id);
+        int64_t first_x = spatial_grid_cell(grid, box->min_x);
+        int64_t first_y = spatial_grid_cell(grid, box->min_y);
+        if (entry->x != (first_x > query.min_x ? first_x : query.min_x) ||
+            entry->y != (first_y > query.min_y ? first_y : query.min_y)) {
+            continue;
+        }
+        *num_found = spatial_grid_visit(grid, entry->id, region, ids, max_ids, *num_found);
+    }
+}
+
+
+size_t spatial_grid_query(spatial_grid_t *grid, vector_t min, vector_t max, size_t *ids, size_t max_ids) {
+    assert(grid);
+    assert(ids || max_ids == 0);
+
+    grid_box_t region = {min.x, min.y, max.x, max.y};
+    size_t num_found = 0;
+    for (size_t i = 0; i < grid_id_array_size(&grid->oversized); i++) {
+        num_found = spatial_grid_visit(grid, *grid_id_array_get(&grid->oversized, i), region,
+                                       ids, max_ids, num_found);
+    }
+
+    grid_cells_t query = {spatial_grid_cell(grid, min.x), spatial_grid_cell(grid, min.y),
+                          spatial_grid_cell(grid, max.x), spatial_grid_cell(grid, max.y)};
+    if ((double)(query.max_x - query.min_x + 1) * (query.max_y - query.min_y + 1) > SPATIAL_GRID_NUM_BUCKETS) {
+        // The region covers more cells than there are buckets, so every bucket is checked once
+        for (size_t bucket = 0; bucket < SPATIAL_GRID_NUM_BUCKETS; bucket++) {
+            spatial_grid_visit_bucket(grid, bucket, query, true, 0, 0, region, ids, max_ids, &num_found);
+        }
+        return num_found;
+    }
+    for (int64_t x = query.min_x; x <= query.max_x; x++) {
+        for (int64_t y = query.min_y; y <= query.max_y; y++) {
+            spatial_grid_visit_bucket(grid, spatial_grid_bucket(x, y), query, false, x, y, region, ids, max_ids,
+                                      &num_found);
+        }
+    }
+    return num_found;
+}
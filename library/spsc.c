@@ -0,0 +1,92 @@
+#include "spsc.h"
+#include "alloc.h"
+#include <assert.h>
+#include <limits.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+
+// Keeps the two threads' counters on different cache lines
+#define SPSC_CACHE_LINE 64
+
+
+typedef struct spsc {
+    // Counts of items ever pushed and popped; the difference is the size.
+    // Each is written by one thread only, and wraps around harmlessly.
+    SDL_atomic_t tail;
+    char tail_padding[SPSC_CACHE_LINE - sizeof(SDL_atomic_t)];
+    SDL_atomic_t head;
+    char head_padding[SPSC_CACHE_LINE - sizeof(SDL_atomic_t)];
+    unsigned mask;
+    size_t item_size;
+    char *items;
+} spsc_t;
+
+
+spsc_t *spsc_init(size_t capacity, size_t item_size) {
+    assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+    assert(capacity <= INT_MAX);
+    assert(item_size > 0);
+
+    spsc_t *queue = alloc_malloc(ALLOC_TAG_OTHER, sizeof(spsc_t));
+    assert(queue);
+    SDL_AtomicSet(&queue->tail, 0);
+    SDL_AtomicSet(&queue->head, 0);
+    queue->mask = (unsigned)capacity - 1;
+    queue->item_size = item_size;
+    queue->items = alloc_malloc(ALLOC_TAG_OTHER, capacity * item_size);
+    assert(queue->items);
+    return queue;
+}
+
+
+void spsc_free(spsc_t *queue) {
+    assert(queue);
+
+    alloc_free(ALLOC_TAG_OTHER, queue->items);
+    alloc_free(ALLOC_TAG_OTHER, queue);
+}
+
+
+bool spsc_push(spsc_t *queue, const void *item) {
+    assert(queue);
+    assert(item);
+
+    unsigned tail = (unsigned)SDL_AtomicGet(&queue->tail);
+    unsigned head = (unsigned)SDL_AtomicGet(&queue->head);
+    if (tail - head > queue->mask) {
+        return false;
+    }
+    // Writes the slot only after seeing the head that freed it
+    SDL_MemoryBarrierAcquire();
+    memcpy(queue->items + (tail & queue->mask) * queue->item_size, item, queue->item_size);
+    // The item must be written before the consumer can see the new tail
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&queue->tail, (int)(tail + 1));
+    return true;
+}
+
+
+bool spsc_pop(spsc_t *queue, void *item) {
+    assert(queue);
+    assert(item);
+
+    unsigned head = (unsigned)SDL_AtomicGet(&queue->head);
+    unsigned tail = (unsigned)SDL_AtomicGet(&queue->tail);
+    if (head == tail) {
+        return false;
+    }
+    // Reads the item only after seeing the tail that published it
+    SDL_MemoryBarrierAcquire();
+    memcpy(item, queue->items + (head & queue->mask) * queue->item_size, queue->item_size);
+    // The item must be copied out before the producer can reuse its slot
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&queue->head, (int)(head + 1));
+    return true;
+}
+
+
+size_t spsc_size(spsc_t *queue) {
+    assert(queue);
+
+    return (unsigned)SDL_AtomicGet(&queue->tail) - (unsigned)SDL_AtomicGet(&queue->head);
+}
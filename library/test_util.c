@@ -21,9 +21,18 @@ bool within(double epsilon, double d1, double d2) {
     return fabs(d1 - d2) < epsilon;
 }
 
+#ifdef FAF_SINGLE_PRECISION
+const double TEST_FLOAT_RELATIVE_EPSILON = 1e-5;
+
+bool isclose(double d1, double d2) {
+    double magnitude = fmax(1, fmax(fabs(d1), fabs(d2)));
+    return within(TEST_FLOAT_RELATIVE_EPSILON * magnitude, d1, d2);
+}
+#else
 bool isclose(double d1, double d2) {
     return within(1e-7, d1, d2);
 }
+#endif
 
 bool vec_within(double epsilon, vector_t v1, vector_t v2) {
     return within(epsilon, v1.x, v2.x) && within(epsilon, v1.y, v2.y);
@@ -40,15 +40,15 @@ vector_t vec_multiply(double scalar, vector_t v) {
 
 
 double vec_dot(vector_t v1, vector_t v2) {
-    double x_cont = v1.x * v2.x;
-    double y_cont = v1.y * v2.y;
+    double x_cont = (double)v1.x * v2.x;
+    double y_cont = (double)v1.y * v2.y;
     
     return x_cont + y_cont;
 }
 
 
 double vec_cross(vector_t v1, vector_t v2) {
-    return v1.x * v2.y - v1.y * v2.x;
+    return (double)v1.x * v2.y - (double)v1.y * v2.x;
 }
 
 
@@ -0,0 +1,1057 @@
+#include "vector_batch.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <SDL2/SDL.h>
+
+#if (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)) && \
+    !defined(__EMSCRIPTEN__)
+#define VEC_BATCH_X86
+#include <immintrin.h>
+#endif
+
+// GCC and clang need the instruction set enabled per function; MSVC doesn't
+#if defined(VEC_BATCH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define VEC_BATCH_SSE2_TARGET __attribute__((target("sse2")))
+#define VEC_BATCH_AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define VEC_BATCH_SSE2_TARGET
+#define VEC_BATCH_AVX2_TARGET
+#endif
+
+// Matches the precision of real_t, so the scalar and SIMD kernels round identically
+#ifdef FAF_SINGLE_PRECISION
+#define VEC_BATCH_SQRT sqrtf
+#else
+#define VEC_BATCH_SQRT sqrt
+#endif
+
+const double VEC_BATCH_PIXEL_MIN = -32768;
+const double VEC_BATCH_PIXEL_MAX = 32767;
+
+
+typedef struct vec_batch_kernels {
+    void (*translate)(vector_t *points, size_t n, vector_t translation);
+    void (*rotate)(vector_t *points, size_t n, double angle, vector_t point);
+    vector_t (*project)(const vector_t *points, size_t n, vector_t axis);
+    vector_t (*centroid)(const vector_t *points, size_t n);
+    void (*project_polygons)(const vector_t *points, size_t n, size_t stride, size_t num_polygons,
+                             const vector_t *axes, vector_t *projections);
+    void (*edge_normals)(const vector_t *points, size_t n, size_t num_polygons, size_t edge,
+                         vector_t *normals);
+    void (*to_screen)(const vector_t *points, size_t n, vector_t offset, double scale,
+                      vector_t screen_center, int16_t *xs, int16_t *ys);
+} vec_batch_kernels_t;
+
+
+void vec_batch_translate_scalar(vector_t *points, size_t n, vector_t translation) {
+    for (size_t i = 0; i < n; i++) {
+        points[i].x = points[i].x + translation.x;
+        points[i].y = points[i].y + translation.y;
+    }
+}
+
+
+void vec_batch_rotate_scalar(vector_t *points, size_t n, double angle, vector_t point) {
+    real_t c = cos(angle);
+    real_t s = sin(angle);
+    for (size_t i = 0; i < n; i++) {
+        real_t x = points[i].x + -point.x;
+        real_t y = points[i].y + -point.y;
+        points[i].x = (x * c - y * s) + point.x;
+        points[i].y = (x * s + y * c) + point.y;
+    }
+}
+
+
+vector_t vec_batch_project_scalar(const vector_t *points, size_t n, vector_t axis) {
+    real_t min = INFINITY;
+    real_t max = -INFINITY;
+    for (size_t i = 0; i < n; i++) {
+        real_t dot = points[i].x * axis.x + points[i].y * axis.y;
+        if (dot < min) {
+            min = dot;
+        }
+        if (dot > max) {
+            max = dot;
+        }
+    }
+    return (vector_t){.x = min, .y = max};
+}
+
+
+vector_t vec_batch_centroid_scalar(const vector_t *points, size_t n) {
+    double c_x = 0;
+    double c_y = 0;
+    double area = 0;
+    for (size_t i = 0; i < n; i++) {
+        vector_t v1 = points[i];
+        vector_t v2 = points[i + 1 < n ? i + 1 : 0];
+        // Products are always doubles, since they cancel out in the sum
+        double x1y2 = (double)v1.x * v2.y;
+        double y1x2 = (double)v1.y * v2.x;
+        double cross = x1y2 - y1x2;
+        c_x += (v1.x + v2.x) * cross;
+        c_y += (v1.y + v2.y) * cross;
+        area += x1y2;
+        area -= y1x2;
+    }
+    area /= 2;
+    return (vector_t){.x = c_x / (6 * area), .y = c_y / (6 * area)};
+}
+
+
+// Polygon i starts at points[i * stride], so a stride of 0 projects one polygon onto many axes
+void vec_batch_project_polygons_scalar(const vector_t *points, size_t n, size_t stride, size_t num_polygons,
+                                       const vector_t *axes, vector_t *projections) {
+    for (size_t i = 0; i < num_polygons; i++) {
+        projections[i] = vec_batch_project_scalar(&points[i * stride], n, axes[i]);
+    }
+}
+
+
+void vec_batch_edge_normals_scalar(const vector_t *points, size_t n, size_t num_polygons, size_t edge,
+                                   vector_t *normals) {
+    real_t c = cos(M_PI / 2);
+    real_t s = sin(M_PI / 2);
+    for (size_t i = 0; i < num_polygons; i++) {
+        vector_t v1 = points[i * n + edge];
+        vector_t v2 = points[i * n + (edge + 1 < n ? edge + 1 : 0)];
+        real_t x = v1.x - v2.x;
+        real_t y = v1.y - v2.y;
+        real_t inv_magnitude = 1 / VEC_BATCH_SQRT(x * x + y * y);
+        x = x * inv_magnitude;
+        y = y * inv_magnitude;
+        normals[i].x = x * c - y * s;
+        normals[i].y = x * s + y * c;
+    }
+}
+
+
+int16_t vec_batch_pixel_scalar(double coord) {
+    if (coord < VEC_BATCH_PIXEL_MIN) {
+        coord = VEC_BATCH_PIXEL_MIN;
+    }
+    if (coord > VEC_BATCH_PIXEL_MAX) {
+        coord = VEC_BATCH_PIXEL_MAX;
+    }
+    return (int16_t)round(coord);
+}
+
+
+void vec_batch_to_screen_scalar(const vector_t *points, size_t n, vector_t offset, double scale,
+                                vector_t screen_center, int16_t *xs, int16_t *ys) {
+    for (size_t i = 0; i < n; i++) {
+        double x = scale * (points[i].x + offset.x);
+        double y = scale * (points[i].y + offset.y);
+        // Flip y axis since positive y is down on the screen
+        xs[i] = vec_batch_pixel_scalar(screen_center.x + x);
+        ys[i] = vec_batch_pixel_scalar(screen_center.y - y);
+    }
+}
+
+
+#ifdef VEC_BATCH_X86
+
+// Rounds half away from zero, like round(), after clamping to the range of int16_t
+VEC_BATCH_SSE2_TARGET
+__m128i vec_batch_pixels_sse2(__m128d coords) {
+    coords = _mm_max_pd(coords, _mm_set1_pd(VEC_BATCH_PIXEL_MIN));
+    coords = _mm_min_pd(coords, _mm_set1_pd(VEC_BATCH_PIXEL_MAX));
+    __m128d truncated = _mm_cvtepi32_pd(_mm_cvttpd_epi32(coords));
+    __m128d frac = _mm_sub_pd(coords, truncated);
+    __m128d one = _mm_set1_pd(1);
+    __m128d up = _mm_and_pd(_mm_cmpge_pd(frac, _mm_set1_pd(0.5)), one);
+    __m128d down = _mm_and_pd(_mm_cmple_pd(frac, _mm_set1_pd(-0.5)), one);
+    return _mm_cvttpd_epi32(_mm_sub_pd(_mm_add_pd(truncated, up), down));
+}
+
+
+// Rounds four coordinates like vec_batch_pixels_sse2()
+VEC_BATCH_AVX2_TARGET
+__m128i vec_batch_pixels_avx2(__m256d coords) {
+    coords = _mm256_max_pd(coords, _mm256_set1_pd(VEC_BATCH_PIXEL_MIN));
+    coords = _mm256_min_pd(coords, _mm256_set1_pd(VEC_BATCH_PIXEL_MAX));
+    __m256d truncated = _mm256_round_pd(coords, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    __m256d frac = _mm256_sub_pd(coords, truncated);
+    __m256d one = _mm256_set1_pd(1);
+    __m256d up = _mm256_and_pd(_mm256_cmp_pd(frac, _mm256_set1_pd(0.5), _CMP_GE_OQ), one);
+    __m256d down = _mm256_and_pd(_mm256_cmp_pd(frac, _mm256_set1_pd(-0.5), _CMP_LE_OQ), one);
+    return _mm256_cvttpd_epi32(_mm256_sub_pd(_mm256_add_pd(truncated, up), down));
+}
+
+
+#ifndef FAF_SINGLE_PRECISION
+
+// Each __m128d holds one point, x in the low lane
+
+VEC_BATCH_SSE2_TARGET
+void vec_batch_translate_sse2(vector_t *points, size_t n, vector_t translation) {
+    double *coords = (double *)points;
+    __m128d t = _mm_set_pd(translation.y, translation.x);
+    for (size_t i = 0; i < n; i++) {
+        _mm_storeu_pd(&coords[2 * i], _mm_add_pd(_mm_loadu_pd(&coords[2 * i]), t));
+    }
+}
+
+
+VEC_BATCH_SSE2_TARGET
+void vec_batch_rotate_sse2(vector_t *points, size_t n, double angle, vector_t point) {
+    double *coords = (double *)points;
+    double c = cos(angle);
+    double s = sin(angle);
+    __m128d to_origin = _mm_set_pd(-point.y, -point.x);
+    __m128d from_origin = _mm_set_pd(point.y, point.x);
+    // x' = x * c + y * -s and y' = x * s + y * c
+    __m128d x_coeffs = _mm_set_pd(s, c);
+    __m128d y_coeffs = _mm_set_pd(c, -s);
+    for (size_t i = 0; i < n; i++) {
+        __m128d v = _mm_add_pd(_mm_loadu_pd(&coords[2 * i]), to_origin);
+        __m128d xx = _mm_unpacklo_pd(v, v);
+        __m128d yy = _mm_unpackhi_pd(v, v);
+        __m128d rotated = _mm_add_pd(_mm_mul_pd(xx, x_coeffs), _mm_mul_pd(yy, y_coeffs));
+        _mm_storeu_pd(&coords[2 * i], _mm_add_pd(rotated, from_origin));
+    }
+}
+
+
+VEC_BATCH_SSE2_TARGET
+vector_t vec_batch_project_sse2(const vector_t *points, size_t n, vector_t axis) {
+    const double *coords = (const double *)points;
+    __m128d a = _mm_set_pd(axis.y, axis.x);
+    __m128d min = _mm_set1_pd(INFINITY);
+    __m128d max = _mm_set1_pd(-INFINITY);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d m0 = _mm_mul_pd(_mm_loadu_pd(&coords[2 * i]), a);
+        __m128d m1 = _mm_mul_pd(_mm_loadu_pd(&coords[2 * i + 2]), a);
+        __m128d dots = _mm_add_pd(_mm_unpacklo_pd(m0, m1), _mm_unpackhi_pd(m0, m1));
+        min = _mm_min_pd(min, dots);
+        max = _mm_max_pd(max, dots);
+    }
+    if (i < n) {
+        __m128d m = _mm_mul_pd(_mm_loadu_pd(&coords[2 * i]), a);
+        __m128d dot = _mm_add_pd(_mm_unpacklo_pd(m, m), _mm_unpackhi_pd(m, m));
+        min = _mm_min_pd(min, dot);
+        max = _mm_max_pd(max, dot);
+    }
+    min = _mm_min_sd(min, _mm_unpackhi_pd(min, min));
+    max = _mm_max_sd(max, _mm_unpackhi_pd(max, max));
+    return (vector_t){.x = _mm_cvtsd_f64(min), .y = _mm_cvtsd_f64(max)};
+}
+
+
+VEC_BATCH_SSE2_TARGET
+vector_t vec_batch_centroid_sse2(const vector_t *points, size_t n) {
+    const double *coords = (const double *)points;
+    __m128d centroid = _mm_setzero_pd();
+    __m128d area = _mm_setzero_pd();
+    for (size_t i = 0; i < n; i++) {
+        __m128d v1 = _mm_loadu_pd(&coords[2 * i]);
+        __m128d v2 = _mm_loadu_pd(&coords[2 * (i + 1 < n ? i + 1 : 0)]);
+        // {x1 * y2, y1 * x2}
+        __m128d products = _mm_mul_pd(v1, _mm_shuffle_pd(v2, v2, 1));
+        __m128d y1x2 = _mm_unpackhi_pd(products, products);
+        __m128d cross = _mm_sub_sd(products, y1x2);
+        cross = _mm_unpacklo_pd(cross, cross);
+        centroid = _mm_add_pd(centroid, _mm_mul_pd(_mm_add_pd(v1, v2), cross));
+        area = _mm_sub_sd(_mm_add_sd(area, products), y1x2);
+    }
+    double signed_area = _mm_cvtsd_f64(area) / 2;
+    centroid = _mm_div_pd(centroid, _mm_set1_pd(6 * signed_area));
+    vector_t result;
+    _mm_storeu_pd((double *)&result, centroid);
+    return result;
+}
+
+
+// Each __m128d holds one coordinate of two polygons, so polygons run in lanes.
+// min_pd(dot, min) keeps min when they compare equal, like the scalar version.
+
+VEC_BATCH_SSE2_TARGET
+void vec_batch_project_polygons_sse2(const vector_t *points, size_t n, size_t stride, size_t num_polygons,
+                                     const vector_t *axes, vector_t *projections) {
+    const double *coords = (const double *)points;
+    size_t i = 0;
+    for (; i + 2 <= num_polygons; i += 2) {
+        __m128d a0 = _mm_loadu_pd((const double *)&axes[i]);
+        __m128d a1 = _mm_loadu_pd((const double *)&axes[i + 1]);
+        __m128d axis_x = _mm_unpacklo_pd(a0, a1);
+        __m128d axis_y = _mm_unpackhi_pd(a0, a1);
+        __m128d min = _mm_set1_pd(INFINITY);
+        __m128d max = _mm_set1_pd(-INFINITY);
+        const double *p0 = &coords[2 * i * stride];
+        const double *p1 = &coords[2 * (i + 1) * stride];
+        for (size_t k = 0; k < n; k++) {
+            __m128d v0 = _mm_loadu_pd(&p0[2 * k]);
+            __m128d v1 = _mm_loadu_pd(&p1[2 * k]);
+            __m128d dots = _mm_add_pd(_mm_mul_pd(_mm_unpacklo_pd(v0, v1), axis_x),
+                                      _mm_mul_pd(_mm_unpackhi_pd(v0, v1), axis_y));
+            min = _mm_min_pd(dots, min);
+            max = _mm_max_pd(dots, max);
+        }
+        _mm_storeu_pd((double *)&projections[i], _mm_unpacklo_pd(min, max));
+        _mm_storeu_pd((double *)&projections[i + 1], _mm_unpackhi_pd(min, max));
+    }
+    if (i < num_polygons) {
+        vec_batch_project_polygons_scalar(&points[i * stride], n, stride, num_polygons - i, &axes[i],
+                                          &projections[i]);
+    }
+}
+
+
+VEC_BATCH_SSE2_TARGET
+void vec_batch_edge_normals_sse2(const vector_t *points, size_t n, size_t num_polygons, size_t edge,
+                                 vector_t *normals) {
+    const double *coords = (const double *)points;
+    size_t next = edge + 1 < n ? edge + 1 : 0;
+    __m128d c = _mm_set1_pd(cos(M_PI / 2));
+    __m128d s = _mm_set1_pd(sin(M_PI / 2));
+    size_t i = 0;
+    for (; i + 2 <= num_polygons; i += 2) {
+        __m128d d0 = _mm_sub_pd(_mm_loadu_pd(&coords[2 * (i * n + edge)]),
+                                _mm_loadu_pd(&coords[2 * (i * n + next)]));
+        __m128d d1 = _mm_sub_pd(_mm_loadu_pd(&coords[2 * ((i + 1) * n + edge)]),
+                                _mm_loadu_pd(&coords[2 * ((i + 1) * n + next)]));
+        __m128d x = _mm_unpacklo_pd(d0, d1);
+        __m128d y = _mm_unpackhi_pd(d0, d1);
+        __m128d magnitude = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(x, x), _mm_mul_pd(y, y)));
+        __m128d inv_magnitude = _mm_div_pd(_mm_set1_pd(1), magnitude);
+        x = _mm_mul_pd(x, inv_magnitude);
+        y = _mm_mul_pd(y, inv_magnitude);
+        __m128d normal_x = _mm_sub_pd(_mm_mul_pd(x, c), _mm_mul_pd(y, s));
+        __m128d normal_y = _mm_add_pd(_mm_mul_pd(x, s), _mm_mul_pd(y, c));
+        _mm_storeu_pd((double *)&normals[i], _mm_unpacklo_pd(normal_x, normal_y));
+        _mm_storeu_pd((double *)&normals[i + 1], _mm_unpackhi_pd(normal_x, normal_y));
+    }
+    if (i < num_polygons) {
+        vec_batch_edge_normals_scalar(&points[i * n], n, num_polygons - i, edge, &normals[i]);
+    }
+}
+
+
+VEC_BATCH_SSE2_TARGET
+void vec_batch_to_screen_sse2(const vector_t *points, size_t n, vector_t offset, double scale,
+                              vector_t screen_center, int16_t *xs, int16_t *ys) {
+    const double *coords = (const double *)points;
+    __m128d o = _mm_set_pd(offset.y, offset.x);
+    __m128d s = _mm_set1_pd(scale);
+    __m128d c = _mm_set_pd(screen_center.y, screen_center.x);
+    // Flip y axis since positive y is down on the screen
+    __m128d flip = _mm_set_pd(-1, 1);
+    for (size_t i = 0; i < n; i++) {
+        __m128d scaled = _mm_mul_pd(s, _mm_add_pd(_mm_loadu_pd(&coords[2 * i]), o));
+        __m128i pixel = vec_batch_pixels_sse2(_mm_add_pd(c, _mm_mul_pd(scaled, flip)));
+        xs[i] = (int16_t)_mm_cvtsi128_si32(pixel);
+        ys[i] = (int16_t)_mm_cvtsi128_si32(_mm_shuffle_epi32(pixel, 1));
+    }
+}
+
+
+// Each __m256d holds two points, {x0, y0, x1, y1}
+
+VEC_BATCH_AVX2_TARGET
+void vec_batch_translate_avx2(vector_t *points, size_t n, vector_t translation) {
+    double *coords = (double *)points;
+    __m256d t = _mm256_set_pd(translation.y, translation.x, translation.y, translation.x);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm256_storeu_pd(&coords[2 * i], _mm256_add_pd(_mm256_loadu_pd(&coords[2 * i]), t));
+    }
+    if (i < n) {
+        _mm_storeu_pd(&coords[2 * i], _mm_add_pd(_mm_loadu_pd(&coords[2 * i]), _mm256_castpd256_pd128(t)));
+    }
+}
+
+
+VEC_BATCH_AVX2_TARGET
+void vec_batch_rotate_avx2(vector_t *points, size_t n, double angle, vector_t point) {
+    double *coords = (double *)points;
+    double c = cos(angle);
+    double s = sin(angle);
+    __m256d to_origin = _mm256_set_pd(-point.y, -point.x, -point.y, -point.x);
+    __m256d from_origin = _mm256_set_pd(point.y, point.x, point.y, point.x);
+    __m256d x_coeffs = _mm256_set_pd(s, c, s, c);
+    __m256d y_coeffs = _mm256_set_pd(c, -s, c, -s);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m256d v = _mm256_add_pd(_mm256_loadu_pd(&coords[2 * i]), to_origin);
+        __m256d xx = _mm256_unpacklo_pd(v, v);
+        __m256d yy = _mm256_unpackhi_pd(v, v);
+        __m256d rotated = _mm256_add_pd(_mm256_mul_pd(xx, x_coeffs), _mm256_mul_pd(yy, y_coeffs));
+        _mm256_storeu_pd(&coords[2 * i], _mm256_add_pd(rotated, from_origin));
+    }
+    if (i < n) {
+        vec_batch_rotate_sse2(&points[i], n - i, angle, point);
+    }
+}
+
+
+VEC_BATCH_AVX2_TARGET
+vector_t vec_batch_project_avx2(const vector_t *points, size_t n, vector_t axis) {
+    const double *coords = (const double *)points;
+    __m256d a = _mm256_set_pd(axis.y, axis.x, axis.y, axis.x);
+    __m256d min = _mm256_set1_pd(INFINITY);
+    __m256d max = _mm256_set1_pd(-INFINITY);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d m0 = _mm256_mul_pd(_mm256_loadu_pd(&coords[2 * i]), a);
+        __m256d m1 = _mm256_mul_pd(_mm256_loadu_pd(&coords[2 * i + 4]), a);
+        // {dot0, dot2, dot1, dot3}
+        __m256d dots = _mm256_hadd_pd(m0, m1);
+        min = _mm256_min_pd(min, dots);
+        max = _mm256_max_pd(max, dots);
+    }
+    __m128d min2 = _mm_min_pd(_mm256_castpd256_pd128(min), _mm256_extractf128_pd(min, 1));
+    __m128d max2 = _mm_max_pd(_mm256_castpd256_pd128(max), _mm256_extractf128_pd(max, 1));
+    double lo = _mm_cvtsd_f64(_mm_min_sd(min2, _mm_unpackhi_pd(min2, min2)));
+    double hi = _mm_cvtsd_f64(_mm_max_sd(max2, _mm_unpackhi_pd(max2, max2)));
+    if (i < n) {
+        vector_t rest = vec_batch_project_sse2(&points[i], n - i, axis);
+        lo = rest.x < lo ? rest.x : lo;
+        hi = rest.y > hi ? rest.y : hi;
+    }
+    return (vector_t){.x = lo, .y = hi};
+}
+
+
+VEC_BATCH_AVX2_TARGET
+void vec_batch_to_screen_avx2(const vector_t *points, size_t n, vector_t offset, double scale,
+                              vector_t screen_center, int16_t *xs, int16_t *ys) {
+    const double *coords = (const double *)points;
+    __m256d o = _mm256_set_pd(offset.y, offset.x, offset.y, offset.x);
+    __m256d s = _mm256_set1_pd(scale);
+    __m256d c = _mm256_set_pd(screen_center.y, screen_center.x, screen_center.y, screen_center.x);
+    __m256d flip = _mm256_set_pd(-1, 1, -1, 1);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m256d scaled = _mm256_mul_pd(s, _mm256_add_pd(_mm256_loadu_pd(&coords[2 * i]), o));
+        __m128i rounded = vec_batch_pixels_avx2(_mm256_add_pd(c, _mm256_mul_pd(scaled, flip)));
+        int32_t out[4];
+        _mm_storeu_si128((__m128i *)out, rounded);
+        xs[i] = (int16_t)out[0];
+        ys[i] = (int16_t)out[1];
+        xs[i + 1] = (int16_t)out[2];
+        ys[i + 1] = (int16_t)out[3];
+    }
+    if (i < n) {
+        vec_batch_to_screen_sse2(&points[i], n - i, offset, scale, screen_center, &xs[i], &ys[i]);
+    }
+}
+
+
+// Loads one point from each of four polygons and splits them into {x0, x1, x2, x3} and {y0, y1, y2, y3}
+VEC_BATCH_AVX2_TARGET
+void vec_batch_load_lanes_avx2(const double *p0, const double *p1, const double *p2, const double *p3,
+                               __m256d *xs, __m256d *ys) {
+    __m256d even = _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(p0)), _mm_loadu_pd(p2), 1);
+    __m256d odd = _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(p1)), _mm_loadu_pd(p3), 1);
+    *xs = _mm256_unpacklo_pd(even, odd);
+    *ys = _mm256_unpackhi_pd(even, odd);
+}
+
+
+// Interleaves {x0, x1, x2, x3} and {y0, y1, y2, y3} back into four points
+VEC_BATCH_AVX2_TARGET
+void vec_batch_store_lanes_avx2(vector_t *out, __m256d xs, __m256d ys) {
+    __m256d even = _mm256_unpacklo_pd(xs, ys);
+    __m256d odd = _mm256_unpackhi_pd(xs, ys);
+    _mm256_storeu_pd((double *)out, _mm256_permute2f128_pd(even, odd, 0x20));
+    _mm256_storeu_pd((double *)&out[2], _mm256_permute2f128_pd(even, odd, 0x31));
+}
+
+
+VEC_BATCH_AVX2_TARGET
+void vec_batch_project_polygons_avx2(const vector_t *points, size_t n, size_t stride, size_t num_polygons,
+                                     const vector_t *axes, vector_t *projections) {
+    const double *coords = (const double *)points;
+    size_t i = 0;
+    for (; i + 4 <= num_polygons; i += 4) {
+        __m256d axis_x, axis_y;
+        vec_batch_load_lanes_avx2((const double *)&axes[i], (const double *)&axes[i + 1],
+                                  (const double *)&axes[i + 2], (const double *)&axes[i + 3], &axis_x, &axis_y);
+        __m256d min = _mm256_set1_pd(INFINITY);
+        __m256d max = _mm256_set1_pd(-INFINITY);
+        const double *p0 = &coords[2 * i * stride];
+        const double *p1 = &coords[2 * (i + 1) * stride];
+        const double *p2 = &coords[2 * (i + 2) * stride];
+        const double *p3 = &coords[2 * (i + 3) * stride];
+        for (size_t k = 0; k < n; k++) {
+            __m256d xs, ys;
+            vec_batch_load_lanes_avx2(&p0[2 * k], &p1[2 * k], &p2[2 * k], &p3[2 * k], &xs, &ys);
+            __m256d dots = _mm256_add_pd(_mm256_mul_pd(xs, axis_x), _mm256_mul_pd(ys, axis_y));
+            min = _mm256_min_pd(dots, min);
+            max = _mm256_max_pd(dots, max);
+        }
+        vec_batch_store_lanes_avx2(&projections[i], min, max);
+    }
+    if (i < num_polygons) {
+        vec_batch_project_polygons_sse2(&points[i * stride], n, stride, num_polygons - i, &axes[i],
+                                        &projections[i]);
+    }
+}
+
+
+VEC_BATCH_AVX2_TARGET
+void vec_batch_edge_normals_avx2(const vector_t *points, size_t n, size_t num_polygons, size_t edge,
+                                 vector_t *normals) {
+    const double *coords = (const double *)points;
+    size_t next = edge + 1 < n ? edge + 1 : 0;
+    __m256d c = _mm256_set1_pd(cos(M_PI / 2));
+    __m256d s = _mm256_set1_pd(sin(M_PI / 2));
+    size_t i = 0;
+    for (; i + 4 <= num_polygons; i += 4) {
+        __m256d x1, y1, x2, y2;
+        vec_batch_load_lanes_avx2(&coords[2 * (i * n + edge)], &coords[2 * ((i + 1) * n + edge)],
+                                  &coords[2 * ((i + 2) * n + edge)], &coords[2 * ((i + 3) * n + edge)], &x1, &y1);
+        vec_batch_load_lanes_avx2(&coords[2 * (i * n + next)], &coords[2 * ((i + 1) * n + next)],
+                                  &coords[2 * ((i + 2) * n + next)], &coords[2 * ((i + 3) * n + next)], &x2, &y2);
+        __m256d x = _mm256_sub_pd(x1, x2);
+        __m256d y = _mm256_sub_pd(y1, y2);
+        __m256d magnitude = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y)));
+        __m256d inv_magnitude = _mm256_div_pd(_mm256_set1_pd(1), magnitude);
+        x = _mm256_mul_pd(x, inv_magnitude);
+        y = _mm256_mul_pd(y, inv_magnitude);
+        __m256d normal_x = _mm256_sub_pd(_mm256_mul_pd(x, c), _mm256_mul_pd(y, s));
+        __m256d normal_y = _mm256_add_pd(_mm256_mul_pd(x, s), _mm256_mul_pd(y, c));
+        vec_batch_store_lanes_avx2(&normals[i], normal_x, normal_y);
+    }
+    if (i < num_polygons) {
+        vec_batch_edge_normals_sse2(&points[i * n], n, num_polygons - i, edge, &normals[i]);
+    }
+}
+
+// The centroid is a running sum, so it can't use more than one point per step
+#define VEC_BATCH_CENTROID_SIMD vec_batch_centroid_sse2
+
+#else // #ifndef FAF_SINGLE_PRECISION
+
+// Each __m128 holds two points, {x0, y0, x1, y1}. A lone point is
+// moved through the low half with _mm_loadl_pi() and _mm_storel_pi().
+
+VEC_BATCH_SSE2_TARGET
+__m128 vec_batch_load_point_sse2(const float *coords) {
+    return _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)coords);
+}
+
+
+VEC_BATCH_SSE2_TARGET
+void vec_batch_translate_sse2(vector_t *points, size_t n, vector_t translation) {
+    float *coords = (float *)points;
+    __m128 t = _mm_set_ps(translation.y, translation.x, translation.y, translation.x);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_ps(&coords[2 * i], _mm_add_ps(_mm_loadu_ps(&coords[2 * i]), t));
+    }
+    if (i < n) {
+        _mm_storel_pi((__m64 *)&coords[2 * i], _mm_add_ps(vec_batch_load_point_sse2(&coords[2 * i]), t));
+    }
+}
+
+
+// x' = x * c + y * -s and y' = x * s + y * c, for both points
+VEC_BATCH_SSE2_TARGET
+__m128 vec_batch_rotate_points_sse2(__m128 v, __m128 x_coeffs, __m128 y_coeffs) {
+    __m128 xx = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 0, 0));
+    __m128 yy = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 1, 1));
+    return _mm_add_ps(_mm_mul_ps(xx, x_coeffs), _mm_mul_ps(yy, y_coeffs));
+}
+
+
+VEC_BATCH_SSE2_TARGET
+void vec_batch_rotate_sse2(vector_t *points, size_t n, double angle, vector_t point) {
+    float *coords = (float *)points;
+    float c = cos(angle);
+    float s = sin(angle);
+    __m128 to_origin = _mm_set_ps(-point.y, -point.x, -point.y, -point.x);
+    __m128 from_origin = _mm_set_ps(point.y, point.x, point.y, point.x);
+    __m128 x_coeffs = _mm_set_ps(s, c, s, c);
+    __m128 y_coeffs = _mm_set_ps(c, -s, c, -s);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128 v = _mm_add_ps(_mm_loadu_ps(&coords[2 * i]), to_origin);
+        __m128 rotated = vec_batch_rotate_points_sse2(v, x_coeffs, y_coeffs);
+        _mm_storeu_ps(&coords[2 * i], _mm_add_ps(rotated, from_origin));
+    }
+    if (i < n) {
+        __m128 v = _mm_add_ps(vec_batch_load_point_sse2(&coords[2 * i]), to_origin);
+        __m128 rotated = vec_batch_rotate_points_sse2(v, x_coeffs, y_coeffs);
+        _mm_storel_pi((__m64 *)&coords[2 * i], _mm_add_ps(rotated, from_origin));
+    }
+}
+
+
+VEC_BATCH_SSE2_TARGET
+vector_t vec_batch_project_sse2(const vector_t *points, size_t n, vector_t axis) {
+    const float *coords = (const float *)points;
+    __m128 a = _mm_set_ps(axis.y, axis.x, axis.y, axis.x);
+    __m128 min = _mm_set1_ps(INFINITY);
+    __m128 max = _mm_set1_ps(-INFINITY);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 m0 = _mm_mul_ps(_mm_loadu_ps(&coords[2 * i]), a);
+        __m128 m1 = _mm_mul_ps(_mm_loadu_ps(&coords[2 * i + 4]), a);
+        // {dot0, dot1, dot2, dot3}
+        __m128 dots = _mm_add_ps(_mm_shuffle_ps(m0, m1, _MM_SHUFFLE(2, 0, 2, 0)),
+                                 _mm_shuffle_ps(m0, m1, _MM_SHUFFLE(3, 1, 3, 1)));
+        min = _mm_min_ps(min, dots);
+        max = _mm_max_ps(max, dots);
+    }
+    min = _mm_min_ps(min, _mm_movehl_ps(min, min));
+    max = _mm_max_ps(max, _mm_movehl_ps(max, max));
+    float lo = _mm_cvtss_f32(_mm_min_ss(min, _mm_shuffle_ps(min, min, 1)));
+    float hi = _mm_cvtss_f32(_mm_max_ss(max, _mm_shuffle_ps(max, max, 1)));
+    for (; i < n; i++) {
+        float dot = coords[2 * i] * axis.x + coords[2 * i + 1] * axis.y;
+        lo = dot < lo ? dot : lo;
+        hi = dot > hi ? dot : hi;
+    }
+    return (vector_t){.x = lo, .y = hi};
+}
+
+
+// Loads one point from each of four polygons, the first at p and each
+// following one step floats further, and splits them into {x0, x1, x2, x3} and {y0, y1, y2, y3}
+VEC_BATCH_SSE2_TARGET
+void vec_batch_load_lanes_sse2(const float *p, size_t step, __m128 *xs, __m128 *ys) {
+    __m128 v01 = _mm_loadh_pi(vec_batch_load_point_sse2(p), (const __m64 *)(p + step));
+    __m128 v23 = _mm_loadh_pi(vec_batch_load_point_sse2(p + 2 * step), (const __m64 *)(p + 3 * step));
+    *xs = _mm_shuffle_ps(v01, v23, _MM_SHUFFLE(2, 0, 2, 0));
+    *ys = _mm_shuffle_ps(v01, v23, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+
+// Interleaves {x0, x1, x2, x3} and {y0, y1, y2, y3} back into four points
+VEC_BATCH_SSE2_TARGET
+void vec_batch_store_lanes_sse2(vector_t *out, __m128 xs, __m128 ys) {
+    _mm_storeu_ps((float *)out, _mm_unpacklo_ps(xs, ys));
+    _mm_storeu_ps((float *)&out[2], _mm_unpackhi_ps(xs, ys));
+}
+
+
+// Each __m128 holds one coordinate of four polygons, so polygons run in lanes.
+// min_ps(dot, min) keeps min when they compare equal, like the scalar version.
+
+VEC_BATCH_SSE2_TARGET
+void vec_batch_project_polygons_sse2(const vector_t *points, size_t n, size_t stride, size_t num_polygons,
+                                     const vector_t *axes, vector_t *projections) {
+    const float *coords = (const float *)points;
+    size_t i = 0;
+    for (; i + 4 <= num_polygons; i += 4) {
+        __m128 axis_x, axis_y;
+        vec_batch_load_lanes_sse2((const float *)&axes[i], 2, &axis_x, &axis_y);
+        __m128 min = _mm_set1_ps(INFINITY);
+        __m128 max = _mm_set1_ps(-INFINITY);
+        const float *p = &coords[2 * i * stride];
+        for (size_t k = 0; k < n; k++) {
+            __m128 xs, ys;
+            vec_batch_load_lanes_sse2(&p[2 * k], 2 * stride, &xs, &ys);
+            __m128 dots = _mm_add_ps(_mm_mul_ps(xs, axis_x), _mm_mul_ps(ys, axis_y));
+            min = _mm_min_ps(dots, min);
+            max = _mm_max_ps(dots, max);
+        }
+        vec_batch_store_lanes_sse2(&projections[i], min, max);
+    }
+    if (i < num_polygons) {
+        vec_batch_project_polygons_scalar(&points[i * stride], n, stride, num_polygons - i, &axes[i],
+                                          &projections[i]);
+    }
+}
+
+
+VEC_BATCH_SSE2_TARGET
+void vec_batch_edge_normals_sse2(const vector_t *points, size_t n, size_t num_polygons, size_t edge,
+                                 vector_t *normals) {
+    const float *coords = (const float *)points;
+    size_t next = edge + 1 < n ? edge + 1 : 0;
+    __m128 c = _mm_set1_ps(cos(M_PI / 2));
+    __m128 s = _mm_set1_ps(sin(M_PI / 2));
+    size_t i = 0;
+    for (; i + 4 <= num_polygons; i += 4) {
+        __m128 x1, y1, x2, y2;
+        vec_batch_load_lanes_sse2(&coords[2 * (i * n + edge)], 2 * n, &x1, &y1);
+        vec_batch_load_lanes_sse2(&coords[2 * (i * n + next)], 2 * n, &x2, &y2);
+        __m128 x = _mm_sub_ps(x1, x2);
+        __m128 y = _mm_sub_ps(y1, y2);
+        __m128 magnitude = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)));
+        __m128 inv_magnitude = _mm_div_ps(_mm_set1_ps(1), magnitude);
+        x = _mm_mul_ps(x, inv_magnitude);
+        y = _mm_mul_ps(y, inv_magnitude);
+        __m128 normal_x = _mm_sub_ps(_mm_mul_ps(x, c), _mm_mul_ps(y, s));
+        __m128 normal_y = _mm_add_ps(_mm_mul_ps(x, s), _mm_mul_ps(y, c));
+        vec_batch_store_lanes_sse2(&normals[i], normal_x, normal_y);
+    }
+    if (i < num_polygons) {
+        vec_batch_edge_normals_scalar(&points[i * n], n, num_polygons - i, edge, &normals[i]);
+    }
+}
+
+
+// Points are offset in single precision, like the scalar version, then converted to pixels in double precision
+
+VEC_BATCH_SSE2_TARGET
+void vec_batch_to_screen_sse2(const vector_t *points, size_t n, vector_t offset, double scale,
+                              vector_t screen_center, int16_t *xs, int16_t *ys) {
+    const float *coords = (const float *)points;
+    __m128 o = _mm_set_ps(0, 0, offset.y, offset.x);
+    __m128d s = _mm_set1_pd(scale);
+    __m128d c = _mm_set_pd(screen_center.y, screen_center.x);
+    // Flip y axis since positive y is down on the screen
+    __m128d flip = _mm_set_pd(-1, 1);
+    for (size_t i = 0; i < n; i++) {
+        __m128d shifted = _mm_cvtps_pd(_mm_add_ps(vec_batch_load_point_sse2(&coords[2 * i]), o));
+        __m128i pixel = vec_batch_pixels_sse2(_mm_add_pd(c, _mm_mul_pd(_mm_mul_pd(s, shifted), flip)));
+        xs[i] = (int16_t)_mm_cvtsi128_si32(pixel);
+        ys[i] = (int16_t)_mm_cvtsi128_si32(_mm_shuffle_epi32(pixel, 1));
+    }
+}
+
+
+// Each __m256 holds four points, {x0, y0, x1, y1 | x2, y2, x3, y3}
+
+VEC_BATCH_AVX2_TARGET
+void vec_batch_translate_avx2(vector_t *points, size_t n, vector_t translation) {
+    float *coords = (float *)points;
+    __m256 t = _mm256_set_ps(translation.y, translation.x, translation.y, translation.x,
+                             translation.y, translation.x, translation.y, translation.x);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_ps(&coords[2 * i], _mm256_add_ps(_mm256_loadu_ps(&coords[2 * i]), t));
+    }
+    if (i < n) {
+        vec_batch_translate_sse2(&points[i], n - i, translation);
+    }
+}
+
+
+VEC_BATCH_AVX2_TARGET
+void vec_batch_rotate_avx2(vector_t *points, size_t n, double angle, vector_t point) {
+    float *coords = (float *)points;
+    float c = cos(angle);
+    float s = sin(angle);
+    __m256 to_origin = _mm256_set_ps(-point.y, -point.x, -point.y, -point.x,
+                                     -point.y, -point.x, -point.y, -point.x);
+    __m256 from_origin = _mm256_set_ps(point.y, point.x, point.y, point.x, point.y, point.x, point.y, point.x);
+    __m256 x_coeffs = _mm256_set_ps(s, c, s, c, s, c, s, c);
+    __m256 y_coeffs = _mm256_set_ps(c, -s, c, -s, c, -s, c, -s);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256 v = _mm256_add_ps(_mm256_loadu_ps(&coords[2 * i]), to_origin);
+        __m256 xx = _mm256_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 0, 0));
+        __m256 yy = _mm256_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 1, 1));
+        __m256 rotated = _mm256_add_ps(_mm256_mul_ps(xx, x_coeffs), _mm256_mul_ps(yy, y_coeffs));
+        _mm256_storeu_ps(&coords[2 * i], _mm256_add_ps(rotated, from_origin));
+    }
+    if (i < n) {
+        vec_batch_rotate_sse2(&points[i], n - i, angle, point);
+    }
+}
+
+
+VEC_BATCH_AVX2_TARGET
+vector_t vec_batch_project_avx2(const vector_t *points, size_t n, vector_t axis) {
+    const float *coords = (const float *)points;
+    __m256 a = _mm256_set_ps(axis.y, axis.x, axis.y, axis.x, axis.y, axis.x, axis.y, axis.x);
+    __m256 min = _mm256_set1_ps(INFINITY);
+    __m256 max = _mm256_set1_ps(-INFINITY);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 m0 = _mm256_mul_ps(_mm256_loadu_ps(&coords[2 * i]), a);
+        __m256 m1 = _mm256_mul_ps(_mm256_loadu_ps(&coords[2 * i + 8]), a);
+        // {dot0, dot1, dot4, dot5 | dot2, dot3, dot6, dot7}
+        __m256 dots = _mm256_add_ps(_mm256_shuffle_ps(m0, m1, _MM_SHUFFLE(2, 0, 2, 0)),
+                                    _mm256_shuffle_ps(m0, m1, _MM_SHUFFLE(3, 1, 3, 1)));
+        min = _mm256_min_ps(min, dots);
+        max = _mm256_max_ps(max, dots);
+    }
+    __m128 min4 = _mm_min_ps(_mm256_castps256_ps128(min), _mm256_extractf128_ps(min, 1));
+    __m128 max4 = _mm_max_ps(_mm256_castps256_ps128(max), _mm256_extractf128_ps(max, 1));
+    min4 = _mm_min_ps(min4, _mm_movehl_ps(min4, min4));
+    max4 = _mm_max_ps(max4, _mm_movehl_ps(max4, max4));
+    float lo = _mm_cvtss_f32(_mm_min_ss(min4, _mm_shuffle_ps(min4, min4, 1)));
+    float hi = _mm_cvtss_f32(_mm_max_ss(max4, _mm_shuffle_ps(max4, max4, 1)));
+    if (i < n) {
+        vector_t rest = vec_batch_project_sse2(&points[i], n - i, axis);
+        lo = rest.x < lo ? rest.x : lo;
+        hi = rest.y > hi ? rest.y : hi;
+    }
+    return (vector_t){.x = lo, .y = hi};
+}
+
+
+// Loads one point from each of eight polygons, step floats apart, like vec_batch_load_lanes_sse2()
+VEC_BATCH_AVX2_TARGET
+void vec_batch_load_lanes_avx2(const float *p, size_t step, __m256 *xs, __m256 *ys) {
+    __m128 lo_xs, lo_ys, hi_xs, hi_ys;
+    vec_batch_load_lanes_sse2(p, step, &lo_xs, &lo_ys);
+    vec_batch_load_lanes_sse2(p + 4 * step, step, &hi_xs, &hi_ys);
+    *xs = _mm256_insertf128_ps(_mm256_castps128_ps256(lo_xs), hi_xs, 1);
+    *ys = _mm256_insertf128_ps(_mm256_castps128_ps256(lo_ys), hi_ys, 1);
+}
+
+
+// Interleaves {x0, ..., x7} and {y0, ..., y7} back into eight points
+VEC_BATCH_AVX2_TARGET
+void vec_batch_store_lanes_avx2(vector_t *out, __m256 xs, __m256 ys) {
+    __m256 lo = _mm256_unpacklo_ps(xs, ys);
+    __m256 hi = _mm256_unpackhi_ps(xs, ys);
+    _mm256_storeu_ps((float *)out, _mm256_permute2f128_ps(lo, hi, 0x20));
+    _mm256_storeu_ps((float *)&out[4], _mm256_permute2f128_ps(lo, hi, 0x31));
+}
+
+
+VEC_BATCH_AVX2_TARGET
+void vec_batch_project_polygons_avx2(const vector_t *points, size_t n, size_t stride, size_t num_polygons,
+                                     const vector_t *axes, vector_t *projections) {
+    const float *coords = (const float *)points;
+    size_t i = 0;
+    for (; i + 8 <= num_polygons; i += 8) {
+        __m256 axis_x, axis_y;
+        vec_batch_load_lanes_avx2((const float *)&axes[i], 2, &axis_x, &axis_y);
+        __m256 min = _mm256_set1_ps(INFINITY);
+        __m256 max = _mm256_set1_ps(-INFINITY);
+        const float *p = &coords[2 * i * stride];
+        for (size_t k = 0; k < n; k++) {
+            __m256 xs, ys;
+            vec_batch_load_lanes_avx2(&p[2 * k], 2 * stride, &xs, &ys);
+            __m256 dots = _mm256_add_ps(_mm256_mul_ps(xs, axis_x), _mm256_mul_ps(ys, axis_y));
+            min = _mm256_min_ps(dots, min);
+            max = _mm256_max_ps(dots, max);
+        }
+        vec_batch_store_lanes_avx2(&projections[i], min, max);
+    }
+    if (i < num_polygons) {
+        vec_batch_project_polygons_sse2(&points[i * stride], n, stride, num_polygons - i, &axes[i],
+                                        &projections[i]);
+    }
+}
+
+
+VEC_BATCH_AVX2_TARGET
+void vec_batch_edge_normals_avx2(const vector_t *points, size_t n, size_t num_polygons, size_t edge,
+                                 vector_t *normals) {
+    const float *coords = (const float *)points;
+    size_t next = edge + 1 < n ? edge + 1 : 0;
+    __m256 c = _mm256_set1_ps(cos(M_PI / 2));
+    __m256 s = _mm256_set1_ps(sin(M_PI / 2));
+    size_t i = 0;
+    for (; i + 8 <= num_polygons; i += 8) {
+        __m256 x1, y1, x2, y2;
+        vec_batch_load_lanes_avx2(&coords[2 * (i * n + edge)], 2 * n, &x1, &y1);
+        vec_batch_load_lanes_avx2(&coords[2 * (i * n + next)], 2 * n, &x2, &y2);
+        __m256 x = _mm256_sub_ps(x1, x2);
+        __m256 y = _mm256_sub_ps(y1, y2);
+        __m256 magnitude = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)));
+        __m256 inv_magnitude = _mm256_div_ps(_mm256_set1_ps(1), magnitude);
+        x = _mm256_mul_ps(x, inv_magnitude);
+        y = _mm256_mul_ps(y, inv_magnitude);
+        __m256 normal_x = _mm256_sub_ps(_mm256_mul_ps(x, c), _mm256_mul_ps(y, s));
+        __m256 normal_y = _mm256_add_ps(_mm256_mul_ps(x, s), _mm256_mul_ps(y, c));
+        vec_batch_store_lanes_avx2(&normals[i], normal_x, normal_y);
+    }
+    if (i < num_polygons) {
+        vec_batch_edge_normals_sse2(&points[i * n], n, num_polygons - i, edge, &normals[i]);
+    }
+}
+
+
+VEC_BATCH_AVX2_TARGET
+void vec_batch_to_screen_avx2(const vector_t *points, size_t n, vector_t offset, double scale,
+                              vector_t screen_center, int16_t *xs, int16_t *ys) {
+    const float *coords = (const float *)points;
+    __m128 o = _mm_set_ps(offset.y, offset.x, offset.y, offset.x);
+    __m256d s = _mm256_set1_pd(scale);
+    __m256d c = _mm256_set_pd(screen_center.y, screen_center.x, screen_center.y, screen_center.x);
+    __m256d flip = _mm256_set_pd(-1, 1, -1, 1);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m256d shifted = _mm256_cvtps_pd(_mm_add_ps(_mm_loadu_ps(&coords[2 * i]), o));
+        __m256d scaled = _mm256_mul_pd(s, shifted);
+        __m128i rounded = vec_batch_pixels_avx2(_mm256_add_pd(c, _mm256_mul_pd(scaled, flip)));
+        int32_t out[4];
+        _mm_storeu_si128((__m128i *)out, rounded);
+        xs[i] = (int16_t)out[0];
+        ys[i] = (int16_t)out[1];
+        xs[i + 1] = (int16_t)out[2];
+        ys[i + 1] = (int16_t)out[3];
+    }
+    if (i < n) {
+        vec_batch_to_screen_sse2(&points[i], n - i, offset, scale, screen_center, &xs[i], &ys[i]);
+    }
+}
+
+// The centroid sums products in double precision, which only the scalar version does
+#define VEC_BATCH_CENTROID_SIMD vec_batch_centroid_scalar
+
+#endif // #ifndef FAF_SINGLE_PRECISION
+
+#endif // #ifdef VEC_BATCH_X86
+
+
+const vec_batch_kernels_t VEC_BATCH_KERNELS[] = {
+    [VEC_BATCH_SCALAR] = {
+        vec_batch_translate_scalar, vec_batch_rotate_scalar, vec_batch_project_scalar,
+        vec_batch_centroid_scalar, vec_batch_project_polygons_scalar, vec_batch_edge_normals_scalar,
+        vec_batch_to_screen_scalar
+    },
+#ifdef VEC_BATCH_X86
+    [VEC_BATCH_SSE2] = {
+        vec_batch_translate_sse2, vec_batch_rotate_sse2, vec_batch_project_sse2,
+        VEC_BATCH_CENTROID_SIMD, vec_batch_project_polygons_sse2, vec_batch_edge_normals_sse2,
+        vec_batch_to_screen_sse2
+    },
+    [VEC_BATCH_AVX2] = {
+        vec_batch_translate_avx2, vec_batch_rotate_avx2, vec_batch_project_avx2,
+        VEC_BATCH_CENTROID_SIMD, vec_batch_project_polygons_avx2, vec_batch_edge_normals_avx2,
+        vec_batch_to_screen_avx2
+    },
+#endif
+};
+
+const char *VEC_BATCH_ISA_NAMES[] = {"scalar", "sse2", "avx2"};
+
+// Set on the first kernel call, which the main thread makes when it creates a body
+const vec_batch_kernels_t *vec_batch_kernels = NULL;
+vec_batch_isa_t vec_batch_isa = VEC_BATCH_SCALAR;
+
+
+bool vec_batch_isa_supported(vec_batch_isa_t isa) {
+    switch (isa) {
+        case VEC_BATCH_SCALAR:
+            return true;
+#ifdef VEC_BATCH_X86
+        case VEC_BATCH_SSE2:
+            return SDL_HasSSE2();
+        case VEC_BATCH_AVX2:
+            return SDL_HasAVX2();
+#endif
+        default:
+            return false;
+    }
+}
+
+
+vec_batch_isa_t vec_batch_best_isa() {
+    vec_batch_isa_t best = VEC_BATCH_SCALAR;
+    for (vec_batch_isa_t isa = VEC_BATCH_SCALAR; isa < NUM_VEC_BATCH_ISAS; isa++) {
+        if (vec_batch_isa_supported(isa)) {
+            best = isa;
+        }
+    }
+    return best;
+}
+
+
+const vec_batch_kernels_t *vec_batch_get_kernels() {
+    if (!vec_batch_kernels) {
+        vec_batch_set_isa(vec_batch_best_isa());
+    }
+    return vec_batch_kernels;
+}
+
+
+vec_batch_isa_t vec_batch_get_isa() {
+    vec_batch_get_kernels();
+    return vec_batch_isa;
+}
+
+
+void vec_batch_set_isa(vec_batch_isa_t isa) {
+    assert(isa < NUM_VEC_BATCH_ISAS);
+    assert(vec_batch_isa_supported(isa));
+
+    vec_batch_isa = isa;
+    vec_batch_kernels = &VEC_BATCH_KERNELS[isa];
+}
+
+
+const char *vec_batch_isa_name(vec_batch_isa_t isa) {
+    assert(isa < NUM_VEC_BATCH_ISAS);
+
+    return VEC_BATCH_ISA_NAMES[isa];
+}
+
+
+void vec_batch_translate(vector_t *points, size_t n, vector_t translation) {
+    assert(points || n == 0);
+
+    vec_batch_get_kernels()->translate(points, n, translation);
+}
+
+
+void vec_batch_rotate(vector_t *points, size_t n, double angle, vector_t point) {
+    assert(points || n == 0);
+
+    vec_batch_get_kernels()->rotate(points, n, angle, point);
+}
+
+
+vector_t vec_batch_project(const vector_t *points, size_t n, vector_t axis) {
+    assert(points);
+    assert(n > 0);
+
+    return vec_batch_get_kernels()->project(points, n, axis);
+}
+
+
+vector_t vec_batch_centroid(const vector_t *points, size_t n) {
+    assert(points);
+
+    return vec_batch_get_kernels()->centroid(points, n);
+}
+
+
+void vec_batch_centroids(const vector_t *points, const size_t *sizes, size_t num_polygons,
+                         vector_t *centroids) {
+    assert(points);
+    assert(sizes);
+    assert(centroids);
+
+    const vec_batch_kernels_t *kernels = vec_batch_get_kernels();
+    for (size_t i = 0; i < num_polygons; i++) {
+        centroids[i] = kernels->centroid(points, sizes[i]);
+        points += sizes[i];
+    }
+}
+
+
+void vec_batch_project_polygons(const vector_t *points, size_t n, size_t num_polygons,
+                                const vector_t *axes, vector_t *projections) {
+    assert(points || num_polygons == 0);
+    assert(n > 0);
+    assert(axes || num_polygons == 0);
+    assert(projections || num_polygons == 0);
+
+    vec_batch_get_kernels()->project_polygons(points, n, n, num_polygons, axes, projections);
+}
+
+
+void vec_batch_project_axes(const vector_t *points, size_t n, const vector_t *axes, size_t num_axes,
+                            vector_t *projections) {
+    assert(points);
+    assert(n > 0);
+    assert(axes || num_axes == 0);
+    assert(projections || num_axes == 0);
+
+    vec_batch_get_kernels()->project_polygons(points, n, 0, num_axes, axes, projections);
+}
+
+
+void vec_batch_edge_normals(const vector_t *points, size_t n, size_t num_polygons, size_t edge,
+                            vector_t *normals) {
+    assert(points || num_polygons == 0);
+    assert(edge < n);
+    assert(normals || num_polygons == 0);
+
+    vec_batch_get_kernels()->edge_normals(points, n, num_polygons, edge, normals);
+}
+
+
+void vec_batch_to_screen(const vector_t *points, size_t n, vector_t offset, double scale,
+                         vector_t screen_center, int16_t *xs, int16_t *ys) {
+    assert(points || n == 0);
+    assert(xs);
+    assert(ys);
+
+    vec_batch_get_kernels()->to_screen(points, n, offset, scale, screen_center, xs, ys);
+}
@@ -1,13 +1,13 @@
 #include <stdlib.h>
 #include <assert.h>
+#include "debug_assert.h"
 #include <stdio.h>
 #include <stdbool.h>
+#include "alloc.h"
+#include "dynarray.h"
 #include "window.h"
 
 
-const size_t WINDOW_INIT_KEY_HANDLERS = 1;
-
-
 typedef struct window {
     scene_t *scene;
     vector_t center;
@@ -15,7 +15,7 @@ typedef struct window {
     vector_t velocity;
     body_t *focused_body;
     vector_t focus_offset;
-    list_t *key_handlers;
+    key_handlers_t *key_handlers;
     hud_t *hud;
     bool clear_scene;
 } window_t;
@@ -28,14 +28,28 @@ typedef struct key_handler_info {
 } key_handler_info_t;
 
 
-void free_key_handler_info(key_handler_info_t *info) {
-    assert(info);
+DYNARRAY_DEFINE(key_handlers, key_handler_info_t, 4)
 
-    if (info->aux_freer && info->aux) {
-        info->aux_freer(info->aux);
-    }
 
-    free(info);
+key_handlers_t *window_make_key_handlers() {
+    key_handlers_t *handlers = alloc_malloc(ALLOC_TAG_WINDOW, sizeof(key_handlers_t));
+    assert(handlers);
+    key_handlers_init(handlers);
+    return handlers;
+}
+
+
+void window_free_key_handlers(key_handlers_t *handlers) {
+    assert(handlers);
+
+    for (size_t i = 0; i < key_handlers_size(handlers); i++) {
+        key_handler_info_t *info = key_handlers_get(handlers, i);
+        if (info->aux_freer && info->aux) {
+            info->aux_freer(info->aux);
+        }
+    }
+    key_handlers_free(handlers);
+    alloc_free(ALLOC_TAG_WINDOW, handlers);
 }
 
 
@@ -44,15 +58,14 @@ window_t *window_init(scene_t *scene, vector_t center, vector_t dims) {
     assert(dims.x > 0);
     assert(dims.y > 0);
 
-    window_t *window = malloc(sizeof(window_t));
-    assert(window);
+    window_t *window = alloc_malloc(ALLOC_TAG_WINDOW, sizeof(window_t));
+    DEBUG_ASSERT(window);
     window->scene = scene;
     window->center = center;
     window->dims = dims;
     window->velocity = VEC_ZERO;
     window->focused_body = NULL;
-    window->key_handlers = list_init(WINDOW_INIT_KEY_HANDLERS,
-                                     (free_func_t)free_key_handler_info);
+    window->key_handlers = window_make_key_handlers();
     window->hud = NULL;
     window->clear_scene = false;
 
@@ -61,25 +74,25 @@ window_t *window_init(scene_t *scene, vector_t center, vector_t dims) {
 
 
 void window_free(window_t *window) {
-    assert(window);
+    DEBUG_ASSERT(window);
     scene_free(window->scene);
-    list_free(window->key_handlers);
+    window_free_key_handlers(window->key_handlers);
     if (window->hud) {
         hud_free(window->hud);
     }
-    free(window);
+    alloc_free(ALLOC_TAG_WINDOW, window);
 }
 
 
 scene_t *window_get_scene(window_t *window) {
-    assert(window);
+    DEBUG_ASSERT(window);
 
     return window->scene;
 }
 
 
 void window_set_scene(window_t *window, scene_t *new_scene, vector_t new_center) {
-    assert(window);
+    DEBUG_ASSERT(window);
     assert(new_scene);
 
     scene_free(window->scene);
@@ -91,42 +104,42 @@ void window_set_scene(window_t *window, scene_t *new_scene, vector_t new_center)
 
 
 vector_t window_get_center(window_t *window) {
-    assert(window);
+    DEBUG_ASSERT(window);
 
     return window->center;
 }
 
 
 void window_set_center(window_t *window, vector_t new_center) {
-    assert(window);
+    DEBUG_ASSERT(window);
 
     window->center = new_center;
 }
 
 
 vector_t window_get_dims(window_t *window) {
-    assert(window);
+    DEBUG_ASSERT(window);
 
     return window->dims;
 }
 
 
 vector_t window_get_velocity(window_t *window) {
-    assert(window);
+    DEBUG_ASSERT(window);
 
     return window->velocity;
 }
 
 
 void window_set_velocity(window_t *window, vector_t new_velocity) {
-    assert(window);
+    DEBUG_ASSERT(window);
 
     window->velocity = new_velocity;
 }
 
 
 void window_follow_body(window_t *window, body_t *body, vector_t focus_offset) {
-    assert(window);
+    DEBUG_ASSERT(window);
     assert(body);
 
     window->focused_body = body;
@@ -135,7 +148,7 @@ void window_follow_body(window_t *window, body_t *body, vector_t focus_offset) {
 
 
 void window_tick(window_t *window, double dt) {
-    assert(window);
+    DEBUG_ASSERT(window);
     
     scene_t *scene = window->scene;
     scene_tick(window->scene, dt);
@@ -173,45 +186,40 @@ void window_tick(window_t *window, double dt) {
 }
 
 void window_on_key(window_t *window, char key, key_event_type_t type, double held_time) {
-    assert(window);
+    DEBUG_ASSERT(window);
 
-    for (size_t i = 0; i < list_size(window->key_handlers); i++) {
-        key_handler_info_t *info = (key_handler_info_t *)list_get(window->key_handlers, i);
-        info->f(key, type, held_time, info->aux);
+    // A handler may replace the window's handlers, so copy each one before calling it
+    for (size_t i = 0; i < key_handlers_size(window->key_handlers); i++) {
+        key_handler_info_t info = *key_handlers_get(window->key_handlers, i);
+        info.f(key, type, held_time, info.aux);
     }
 }
 
 void window_add_key_handler(window_t *window, key_handler_t f, void *aux, free_func_t aux_freer) {
-    assert(window);
-
-    key_handler_info_t *info = malloc(sizeof(key_handler_info_t));
-    assert(info);
-    info->f = f;
-    info->aux = aux;
-    info->aux_freer = aux_freer;
-    list_add(window->key_handlers, info);
+    DEBUG_ASSERT(window);
+
+    key_handler_info_t info = {.f = f, .aux = aux, .aux_freer = aux_freer};
+    key_handlers_push(window->key_handlers, info);
 }
 
 void window_clear_key_handlers(window_t *window) {
-    assert(window);
+    DEBUG_ASSERT(window);
 
-    if (list_size(window->key_handlers) > 0) {
-        list_free(window->key_handlers);
-        window->key_handlers = list_init(WINDOW_INIT_KEY_HANDLERS, 
-                                         (free_func_t)free_key_handler_info);
+    if (key_handlers_size(window->key_handlers) > 0) {
+        window_free_key_handlers(window->key_handlers);
+        window->key_handlers = window_make_key_handlers();
     }
 }
 
 void window_clear_key_handlers_no_free(window_t *window) {
-    assert(window);
+    DEBUG_ASSERT(window);
 
-    window->key_handlers = list_init(WINDOW_INIT_KEY_HANDLERS, 
-                                     (free_func_t)free_key_handler_info);
+    window->key_handlers = window_make_key_handlers();
 }
 
 
 vector_t scene_to_window_space(window_t *window, vector_t v) {
-    assert(window);
+    DEBUG_ASSERT(window);
 
     vector_t window_botl = vec_subtract(window->center, vec_multiply(1. / 2., window->dims));
 
@@ -220,7 +228,7 @@ vector_t scene_to_window_space(window_t *window, vector_t v) {
 
 
 void window_set_hud(window_t *window, hud_t *hud) {
-    assert(window);
+    DEBUG_ASSERT(window);
     // Don't want to assert hud, because we might use this to clear the hud
 
     if (window->hud) {
@@ -231,36 +239,36 @@ void window_set_hud(window_t *window, hud_t *hud) {
 
 
 void window_set_hud_no_free(window_t *window, hud_t *hud) {
-    assert(window);
+    DEBUG_ASSERT(window);
 
     window->hud = hud;
 }
 
 
-list_t *window_get_key_handlers(window_t *window) {
-    assert(window);
+key_handlers_t *window_get_key_handlers(window_t *window) {
+    DEBUG_ASSERT(window);
 
     return window->key_handlers;
 }
 
 
-void window_set_key_handlers(window_t *window, list_t *handlers) {
-    assert(window);
+void window_set_key_handlers(window_t *window, key_handlers_t *handlers) {
+    DEBUG_ASSERT(window);
     assert(handlers);
 
-    list_free(window->key_handlers);
+    window_free_key_handlers(window->key_handlers);
     window->key_handlers = handlers;
 }
 
 
 hud_t *window_get_hud(window_t *window) {
-    assert(window);
+    DEBUG_ASSERT(window);
 
     return window->hud;
 }
 
 void window_clear_scene(window_t *window) {
-    assert(window);
+    DEBUG_ASSERT(window);
 
     window->clear_scene = true;
 }
\ No newline at end of file
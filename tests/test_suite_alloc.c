@@ -0,0 +1,232 @@
+#include "alloc.h"
+#include "jobs.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char *TEST_FILE = "test_suite_alloc.c";
+
+
+void test_tag_totals() {
+    alloc_reset();
+
+    void *a = alloc_malloc_at(ALLOC_TAG_BODY, 16, TEST_FILE, 1);
+    void *b = alloc_calloc_at(ALLOC_TAG_BODY, 4, 8, TEST_FILE, 2);
+    void *c = alloc_malloc_at(ALLOC_TAG_LIST, 100, TEST_FILE, 3);
+    assert(a && b && c);
+    assert(((char *)b)[31] == 0);
+    c = alloc_realloc_at(ALLOC_TAG_LIST, c, 200, TEST_FILE, 4);
+    assert(c);
+
+    alloc_stats_t body = alloc_get_total_stats(ALLOC_TAG_BODY);
+    assert(body.allocs == 2);
+    assert(body.bytes == 48);
+    alloc_stats_t list = alloc_get_total_stats(ALLOC_TAG_LIST);
+    assert(list.allocs == 2);
+    assert(list.bytes == 300);
+    assert(alloc_get_total_stats(ALLOC_TAG_SCENE).allocs == 0);
+
+    alloc_free_at(ALLOC_TAG_BODY, a);
+    alloc_free_at(ALLOC_TAG_BODY, b);
+    alloc_free_at(ALLOC_TAG_LIST, c);
+    alloc_free_at(ALLOC_TAG_LIST, NULL);
+    assert(alloc_get_total_stats(ALLOC_TAG_BODY).frees == 2);
+    assert(alloc_get_total_stats(ALLOC_TAG_LIST).frees == 1);
+
+    alloc_reset();
+    assert(alloc_get_total_stats(ALLOC_TAG_BODY).allocs == 0);
+}
+
+
+void test_callsites() {
+    alloc_reset();
+
+    for (int i = 0; i < 10; i++) {
+        free(alloc_malloc_at(ALLOC_TAG_SCENE, 8, TEST_FILE, 42));
+    }
+    free(alloc_malloc_at(ALLOC_TAG_SCENE, 24, TEST_FILE, 43));
+    // Callsites are matched by file name, not by pointer
+    char file_copy[32];
+    strcpy(file_copy, TEST_FILE);
+    free(alloc_malloc_at(ALLOC_TAG_SCENE, 8, file_copy, 42));
+
+    alloc_stats_t site = alloc_get_callsite_stats(TEST_FILE, 42);
+    assert(site.allocs == 11);
+    assert(site.bytes == 88);
+    site = alloc_get_callsite_stats(TEST_FILE, 43);
+    assert(site.allocs == 1);
+    assert(site.bytes == 24);
+    assert(alloc_get_callsite_stats(TEST_FILE, 44).allocs == 0);
+    assert(alloc_get_callsite_stats("other.c", 42).allocs == 0);
+
+    // Many distinct callsites still keep the totals exact
+    for (int line = 1000; line < 3000; line++) {
+        free(alloc_malloc_at(ALLOC_TAG_OTHER, 1, TEST_FILE, line));
+    }
+    assert(alloc_get_total_stats(ALLOC_TAG_OTHER).allocs == 2000);
+    assert(alloc_get_callsite_stats(TEST_FILE, 42).allocs == 11);
+
+    alloc_reset();
+}
+
+
+void test_report_order() {
+    alloc_reset();
+
+    // Equally busy callsites, recorded out of order
+    free(alloc_malloc_at(ALLOC_TAG_OTHER, 8, TEST_FILE, 7));
+    free(alloc_malloc_at(ALLOC_TAG_OTHER, 8, TEST_FILE, 5));
+    free(alloc_malloc_at(ALLOC_TAG_OTHER, 8, TEST_FILE, 6));
+    free(alloc_malloc_at(ALLOC_TAG_OTHER, 8, TEST_FILE, 6));
+
+    FILE *report = tmpfile();
+    assert(report);
+    alloc_print_report(report, 3);
+    rewind(report);
+    char line[128];
+    int lines[3];
+    size_t num_lines = 0;
+    bool in_callsites = false;
+    while (fgets(line, sizeof(line), report) && num_lines < 3) {
+        char *colon = strchr(line, ':');
+        if (in_callsites && colon) {
+            lines[num_lines++] = atoi(colon + 1);
+        }
+        in_callsites = in_callsites || strncmp(line, "busiest callsites", 17) == 0;
+    }
+    fclose(report);
+
+    // The busiest first, then ties by line
+    assert(num_lines == 3);
+    assert(lines[0] == 6 && lines[1] == 5 && lines[2] == 7);
+
+    alloc_reset();
+}
+
+
+void test_frames() {
+    alloc_reset();
+
+    alloc_frame_begin();
+    free(alloc_malloc_at(ALLOC_TAG_BODY, 10, TEST_FILE, 1));
+    free(alloc_malloc_at(ALLOC_TAG_BODY, 10, TEST_FILE, 1));
+    alloc_frame_end();
+    assert(alloc_get_num_frames() == 1);
+    assert(alloc_get_frame_stats(ALLOC_TAG_BODY).allocs == 2);
+    assert(alloc_get_frame_stats(ALLOC_TAG_BODY).bytes == 20);
+
+    alloc_frame_begin();
+    free(alloc_malloc_at(ALLOC_TAG_HUD, 5, TEST_FILE, 2));
+    // The last frame stays visible until the current one ends
+    assert(alloc_get_frame_stats(ALLOC_TAG_BODY).allocs == 2);
+    alloc_frame_end();
+    assert(alloc_get_num_frames() == 2);
+    assert(alloc_get_frame_stats(ALLOC_TAG_BODY).allocs == 0);
+    assert(alloc_get_frame_stats(ALLOC_TAG_HUD).allocs == 1);
+    assert(alloc_get_total_stats(ALLOC_TAG_BODY).allocs == 2);
+
+    alloc_reset();
+}
+
+
+void allocate_range(size_t start, size_t end, void *aux) {
+    for (size_t i = start; i < end; i++) {
+        free(alloc_malloc_at(ALLOC_TAG_BODY, 3, TEST_FILE, (int)(i % 8)));
+    }
+}
+
+void test_worker_allocations() {
+    alloc_reset();
+
+    // Workers record into the same table and counters at once without losing any
+    size_t count = 20000;
+    jobs_parallel_for(count, 100, allocate_range, NULL);
+    assert(alloc_get_total_stats(ALLOC_TAG_BODY).allocs == count);
+    assert(alloc_get_total_stats(ALLOC_TAG_BODY).bytes == 3 * count);
+    size_t callsite_allocs = 0;
+    for (int line = 0; line < 8; line++) {
+        callsite_allocs += alloc_get_callsite_stats(TEST_FILE, line).allocs;
+    }
+    assert(callsite_allocs == count);
+
+    alloc_reset();
+}
+
+
+void allocate_in_hot_section(void *aux) {
+    alloc_hot_section_begin("test");
+    free(alloc_malloc_at(ALLOC_TAG_OTHER, 1, TEST_FILE, 1));
+    alloc_hot_section_end();
+}
+
+void test_hot_sections() {
+    alloc_reset();
+
+    // Sections that don't allocate are fine, even nested
+    alloc_hot_section_begin("outer");
+    alloc_hot_section_begin("inner");
+    alloc_hot_section_end();
+    alloc_hot_section_end();
+    assert(alloc_get_hot_violations() == 0);
+
+    // Outside a section nothing is flagged
+    free(alloc_malloc_at(ALLOC_TAG_OTHER, 1, TEST_FILE, 1));
+    assert(alloc_get_hot_violations() == 0);
+
+    alloc_set_hot_asserts(false);
+    allocate_in_hot_section(NULL);
+    assert(alloc_get_hot_violations() == 1);
+
+    alloc_set_hot_asserts(true);
+    assert(test_assert_fail(allocate_in_hot_section, NULL));
+
+    alloc_reset();
+}
+
+
+void test_cold_sections() {
+    alloc_reset();
+
+    // A cold section inside a hot one may allocate
+    alloc_hot_section_begin("tick");
+    alloc_cold_section_begin("load");
+    free(alloc_malloc_at(ALLOC_TAG_OTHER, 1, TEST_FILE, 1));
+    assert(alloc_get_hot_violations() == 0);
+
+    // but a hot section inside it is checked again
+    assert(test_assert_fail(allocate_in_hot_section, NULL));
+    alloc_reset();
+
+    alloc_set_hot_asserts(false);
+    alloc_hot_section_begin("tick");
+    alloc_cold_section_begin("load");
+    alloc_cold_section_end();
+    free(alloc_malloc_at(ALLOC_TAG_OTHER, 1, TEST_FILE, 1));
+    alloc_hot_section_end();
+    assert(alloc_get_hot_violations() == 1);
+    alloc_set_hot_asserts(true);
+
+    alloc_reset();
+}
+
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_tag_totals)
+    DO_TEST(test_callsites)
+    DO_TEST(test_report_order)
+    DO_TEST(test_frames)
+    DO_TEST(test_worker_allocations)
+    DO_TEST(test_hot_sections)
+    DO_TEST(test_cold_sections)
+
+    puts("alloc_test PASS");
+}
@@ -0,0 +1,72 @@
+#include "arena.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdalign.h>
+#include <stdint.h>
+#include <string.h>
+
+
+void test_alloc_aligned() {
+    arena_t *arena = arena_init(256);
+    assert(arena_num_blocks(arena) == 0);
+    for (size_t size = 1; size <= 40; size++) {
+        void *memory = arena_alloc(arena, size);
+        assert((uintptr_t)memory % alignof(max_align_t) == 0);
+        memset(memory, 0xAB, size);
+    }
+    assert(arena_bytes_used(arena) == 40 * 41 / 2);
+    arena_free(arena);
+}
+
+
+void test_alloc_distinct() {
+    arena_t *arena = arena_init(128);
+    size_t *values[100];
+    for (size_t i = 0; i < 100; i++) {
+        values[i] = arena_alloc(arena, sizeof(size_t));
+        *values[i] = i;
+    }
+    // Writing later values must not have clobbered earlier ones
+    for (size_t i = 0; i < 100; i++) {
+        assert(*values[i] == i);
+    }
+    assert(arena_num_blocks(arena) > 1);
+    arena_free(arena);
+}
+
+
+void test_large_alloc() {
+    arena_t *arena = arena_init(1024);
+    char *small = arena_alloc(arena, 16);
+    strcpy(small, "still here");
+    size_t blocks = arena_num_blocks(arena);
+
+    // A request bigger than a block gets its own block
+    char *large = arena_alloc(arena, 10000);
+    memset(large, 1, 10000);
+    assert(arena_num_blocks(arena) == blocks + 1);
+
+    // and the partly used block keeps serving small requests
+    char *next = arena_alloc(arena, 16);
+    assert(next == small + 16 || next == small + 2 * alignof(max_align_t));
+    assert(arena_num_blocks(arena) == blocks + 1);
+    assert(strcmp(small, "still here") == 0);
+    arena_free(arena);
+}
+
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_alloc_aligned)
+    DO_TEST(test_alloc_distinct)
+    DO_TEST(test_large_alloc)
+
+    puts("arena_test PASS");
+}
@@ -0,0 +1,151 @@
+#include "assets.h"
+#include "jobs.h"
+#include "pack.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+const char *TEST_DIR = "out/test_assets";
+const char *FONT_PATH = "out/test_assets/font.ttf";
+const char *SOUND_PATH = "out/test_assets/sounds/beep.wav";
+const char *FONT_CONTENTS = "not really a font";
+const char *SOUND_CONTENTS = "not really a sound, but a little longer";
+
+
+void write_file(const char *path, const char *contents) {
+    FILE *file = fopen(path, "wb");
+    assert(file);
+    fputs(contents, file);
+    fclose(file);
+}
+
+
+void make_test_dir() {
+    mkdir("out", 0755);
+    mkdir(TEST_DIR, 0755);
+    mkdir("out/test_assets/sounds", 0755);
+    write_file(FONT_PATH, FONT_CONTENTS);
+    write_file(SOUND_PATH, SOUND_CONTENTS);
+    // Neither of these is an asset, so neither is preloaded
+    write_file("out/test_assets/notes.txt", "ignored");
+    write_file("out/test_assets/.hidden.wav", "ignored");
+}
+
+
+void check_contents(const char *path, const char *contents) {
+    size_t size;
+    const char *data = assets_get_data(path, &size);
+    assert(data);
+    assert(size == strlen(contents));
+    assert(memcmp(data, contents, size) == 0);
+    // The same contents are returned every time
+    size_t size2;
+    assert(assets_get_data(path, &size2) == data);
+    assert(size2 == size);
+}
+
+
+void preload_and_check(size_t num_workers) {
+    jobs_init(num_workers);
+    make_test_dir();
+
+    assets_preload(TEST_DIR);
+    assert(assets_progress() <= 1);
+    size_t pumps = 0;
+    while (!assets_pump(0)) {
+        pumps++;
+        assert(pumps < 1000000);
+    }
+    assert(assets_progress() == 1);
+    check_contents(FONT_PATH, FONT_CONTENTS);
+    check_contents(SOUND_PATH, SOUND_CONTENTS);
+
+    assets_free();
+    jobs_shutdown();
+}
+
+
+void test_preload_with_workers() {
+    preload_and_check(2);
+}
+
+
+void test_preload_without_workers() {
+    preload_and_check(0);
+}
+
+
+void test_load_without_preload() {
+    make_test_dir();
+    // Nothing is being preloaded
+    assert(assets_progress() == 1);
+    assert(assets_pump(0));
+    check_contents(FONT_PATH, FONT_CONTENTS);
+    assets_free();
+}
+
+
+void test_preload_from_pack() {
+    jobs_init(0);
+    mkdir("out", 0755);
+    // Only in the archive, not on disk
+    const char *paths[2] = {"out/packed/font.ttf", "out/elsewhere/beep.wav"};
+    pack_entry_t entries[2] = {{.kind = PACK_FILE, .size = (uint32_t)strlen(FONT_CONTENTS)},
+                               {.kind = PACK_FILE, .size = (uint32_t)strlen(SOUND_CONTENTS)}};
+    const void *contents[2] = {FONT_CONTENTS, SOUND_CONTENTS};
+    assert(pack_write("out/test_assets.fafpak", entries, paths, contents, 2));
+
+    assert(!assets_open_pack("out/missing.fafpak"));
+    assets_free();
+    assert(assets_open_pack("out/test_assets.fafpak"));
+    assets_preload("out/packed");
+    // Only the directory's assets are preloaded
+    assert(assets_progress() == 0);
+    while (!assets_pump(0)) {
+    }
+    check_contents("out/packed/font.ttf", FONT_CONTENTS);
+    check_contents("out/elsewhere/beep.wav", SOUND_CONTENTS);
+
+    assets_free();
+    jobs_shutdown();
+}
+
+
+void test_missing_files() {
+    size_t size;
+    assert(assets_get_data("out/test_assets/missing.wav", &size) == NULL);
+    assert(assets_get_surface("out/test_assets/missing.png") == NULL);
+    assert(assets_open_font("out/test_assets/missing.ttf", 12) == NULL);
+    assets_free();
+}
+
+
+void test_uncached_surface_has_no_texture() {
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, 4, 4, 32, SDL_PIXELFORMAT_RGBA32);
+    assert(surface);
+    assert(assets_get_texture(surface) == NULL);
+    SDL_FreeSurface(surface);
+}
+
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_preload_with_workers)
+    DO_TEST(test_preload_without_workers)
+    DO_TEST(test_load_without_preload)
+    DO_TEST(test_preload_from_pack)
+    DO_TEST(test_missing_files)
+    DO_TEST(test_uncached_surface_has_no_texture)
+
+    puts("assets_test PASS");
+}
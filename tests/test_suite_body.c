@@ -1,4 +1,5 @@
 #include "body.h"
+#include "jobs.h"
 #include "test_util.h"
 #include <assert.h>
 #include <math.h>
@@ -74,8 +75,14 @@ void test_body_setters() {
 
 void test_body_tick() {
     const vector_t A = {1, 2};
+#ifdef FAF_SINGLE_PRECISION
+    // A float position can't accumulate steps as small as 1e-6
+    const double DT = 1e-3;
+    const int STEPS = 1000;
+#else
     const double DT = 1e-6;
     const int STEPS = 1000000;
+#endif
     list_t *shape = list_init(4, free);
     vector_t *v = malloc(sizeof(*v));
     v->x = v->y = -1;
@@ -241,6 +248,161 @@ void test_body_info_freer() {
     body_free(body);
 }
 
+list_t *make_unit_square(vector_t center) {
+    list_t *shape = list_init(4, free);
+    vector_t offsets[4] = {{-1, -1}, {+1, -1}, {+1, +1}, {-1, +1}};
+    for (size_t i = 0; i < 4; i++) {
+        vector_t *v = malloc(sizeof(*v));
+        *v = vec_add(center, offsets[i]);
+        list_add(shape, v);
+    }
+    return shape;
+}
+
+void count_tick(body_t *body, void *dt) {
+    size_t *ticks = body_get_info(body);
+    (*ticks)++;
+    // Tick functions run before the body moves
+    assert(vec_equal(body_get_centroid(body), VEC_ZERO));
+}
+
+void test_body_store_tick() {
+    const size_t NUM_BODIES = 2000;
+    const double DT = 0.1;
+    jobs_shutdown();
+    jobs_init(3);
+
+    body_store_t *store = body_store_init(0);
+    body_t **stored = malloc(sizeof(body_t *) * NUM_BODIES);
+    body_t **single = malloc(sizeof(body_t *) * NUM_BODIES);
+    for (size_t i = 0; i < NUM_BODIES; i++) {
+        vector_t center = {i, -(double)i};
+        double mass = 1 + i % 7;
+        stored[i] = body_init(make_unit_square(center), mass, (rgb_color_t) {0, 0, 0});
+        single[i] = body_init(make_unit_square(center), mass, (rgb_color_t) {0, 0, 0});
+        body_set_store(stored[i], store);
+        for (size_t j = 0; j < 2; j++) {
+            body_t *body = j == 0 ? stored[i] : single[i];
+            body_set_velocity(body, (vector_t) {i % 5, 1});
+            body_add_force(body, (vector_t) {i % 3, -(double)(i % 11)});
+            body_add_impulse(body, (vector_t) {1, i % 2});
+        }
+    }
+    assert(body_store_size(store) == NUM_BODIES);
+
+    body_store_tick(store, DT);
+    for (size_t i = 0; i < NUM_BODIES; i++) {
+        body_tick(single[i], DT);
+        body_finish_tick(stored[i], DT);
+        assert(vec_equal(body_get_velocity(stored[i]), body_get_velocity(single[i])));
+        assert(vec_equal(body_get_centroid(stored[i]), body_get_centroid(single[i])));
+        vector_t *v1 = list_get(body_get_shape_nocpy(stored[i]), 2);
+        vector_t *v2 = list_get(body_get_shape_nocpy(single[i]), 2);
+        assert(vec_equal(*v1, *v2));
+    }
+
+    // Freeing bodies keeps the rest of the store intact
+    for (size_t i = 0; i < NUM_BODIES; i += 2) {
+        body_free(stored[i]);
+    }
+    assert(body_store_size(store) == NUM_BODIES / 2);
+    for (size_t i = 1; i < NUM_BODIES; i += 2) {
+        assert(vec_equal(body_get_centroid(stored[i]), body_get_centroid(single[i])));
+        assert(vec_equal(body_get_velocity(stored[i]), body_get_velocity(single[i])));
+        body_free(stored[i]);
+    }
+    for (size_t i = 0; i < NUM_BODIES; i++) {
+        body_free(single[i]);
+    }
+    body_store_free(store);
+    free(stored);
+    free(single);
+    jobs_shutdown();
+}
+
+void test_body_finish_tick() {
+    body_store_t *store = body_store_init(1);
+    size_t ticks = 0;
+    body_t *ticking = body_init_with_info(make_unit_square(VEC_ZERO), 1, (rgb_color_t) {0, 0, 0},
+                                          &ticks, NULL);
+    body_t *plain = body_init(make_unit_square(VEC_ZERO), 1, (rgb_color_t) {0, 0, 0});
+    body_register_tick_func(ticking, count_tick);
+    body_set_store(ticking, store);
+    body_set_store(plain, store);
+    body_set_velocity(ticking, (vector_t) {2, 0});
+    body_set_velocity(plain, (vector_t) {2, 0});
+
+    // Only bodies without tick functions move during body_store_tick()
+    body_store_tick(store, 1);
+    assert(vec_equal(body_get_centroid(plain), (vector_t) {2, 0}));
+    assert(vec_equal(body_get_centroid(ticking), VEC_ZERO));
+    assert(ticks == 0);
+    body_finish_tick(ticking, 1);
+    body_finish_tick(plain, 1);
+    assert(ticks == 1);
+    assert(vec_equal(body_get_centroid(ticking), (vector_t) {2, 0}));
+    assert(vec_equal(body_get_centroid(plain), (vector_t) {2, 0}));
+
+    // A body added after body_store_tick() gets a full tick
+    body_t *late = body_init(make_unit_square(VEC_ZERO), 1, (rgb_color_t) {0, 0, 0});
+    body_set_velocity(late, (vector_t) {0, 3});
+    body_set_store(late, store);
+    body_finish_tick(late, 1);
+    assert(vec_equal(body_get_centroid(late), (vector_t) {0, 3}));
+
+    // Without its tick function, a body moves during body_store_tick() again
+    body_unregister_tick_func(ticking, count_tick);
+    body_store_tick(store, 1);
+    assert(vec_equal(body_get_centroid(ticking), (vector_t) {4, 0}));
+    body_finish_tick(ticking, 1);
+    assert(ticks == 1);
+    assert(vec_equal(body_get_centroid(ticking), (vector_t) {4, 0}));
+
+    body_free(ticking);
+    body_free(plain);
+    body_free(late);
+    body_store_free(store);
+}
+
+void test_body_handles() {
+    size_t num_live = body_pool_num_live();
+    body_t *body = body_init(make_unit_square(VEC_ZERO), 1, (rgb_color_t) {0, 0, 0});
+    body_handle_t handle = body_get_handle(body);
+    assert(body_pool_num_live() == num_live + 1);
+    assert(body_from_handle(handle) == body);
+    assert(body_is_live(body));
+    assert(body_from_handle(BODY_NULL_HANDLE) == NULL);
+
+    body_free(body);
+    assert(body_pool_num_live() == num_live);
+    assert(!body_is_live(body));
+    assert(body_from_handle(handle) == NULL);
+
+    // The freed slot is reused, but the old handle still doesn't resolve
+    body_t *reused = body_init(make_unit_square(VEC_ZERO), 1, (rgb_color_t) {0, 0, 0});
+    assert(reused == body);
+    assert(body_from_handle(handle) == NULL);
+    assert(body_from_handle(body_get_handle(reused)) == reused);
+    body_free(reused);
+
+    // Bodies never move, even when the pool grows
+    const size_t num_bodies = 1000;
+    body_t **bodies = malloc(sizeof(body_t *) * num_bodies);
+    body_handle_t *handles = malloc(sizeof(body_handle_t) * num_bodies);
+    for (size_t i = 0; i < num_bodies; i++) {
+        bodies[i] = body_init(make_unit_square((vector_t) {i, 0}), 1, (rgb_color_t) {0, 0, 0});
+        handles[i] = body_get_handle(bodies[i]);
+    }
+    for (size_t i = 0; i < num_bodies; i++) {
+        assert(body_from_handle(handles[i]) == bodies[i]);
+        assert(vec_equal(body_get_centroid(bodies[i]), (vector_t) {i, 0}));
+        body_free(bodies[i]);
+    }
+    assert(body_pool_num_live() == num_live);
+    free(bodies);
+    free(handles);
+}
+
 int main(int argc, char *argv[]) {
     // Run all tests if there are no command-line arguments
     bool all_tests = argc == 1;
@@ -258,6 +420,9 @@ int main(int argc, char *argv[]) {
     DO_TEST(test_body_remove)
     DO_TEST(test_body_info)
     DO_TEST(test_body_info_freer)
+    DO_TEST(test_body_store_tick)
+    DO_TEST(test_body_finish_tick)
+    DO_TEST(test_body_handles)
 
     puts("body_test PASS");
 }
@@ -1,8 +1,128 @@
 #include "collision.h"
+#include "vector_batch.h"
 #include "test_util.h"
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
+
+list_t *make_square(vector_t center, double side) {
+    list_t *square = list_init(4, free);
+    double offsets[4][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+    for (size_t i = 0; i < 4; i++) {
+        vector_t *v = malloc(sizeof(vector_t));
+        assert(v);
+        v->x = center.x + offsets[i][0] * side / 2;
+        v->y = center.y + offsets[i][1] * side / 2;
+        list_add(square, v);
+    }
+    return square;
+}
+
+void test_find_collision() {
+    list_t *square1 = make_square(VEC_ZERO, 2);
+    list_t *square2 = make_square((vector_t){1.5, 0}, 2);
+    list_t *square3 = make_square((vector_t){5, 0}, 2);
+
+    collision_info_t info = find_collision(square1, square2);
+    assert(info.collided);
+    assert(vec_isclose(info.axis, (vector_t){1, 0}));
+    assert(isclose(info.min_overlap, 0.5));
+    assert(!find_collision(square1, square3).collided);
+
+    list_free(square1);
+    list_free(square2);
+    list_free(square3);
+}
+
+void test_collision_stats() {
+    list_t *square1 = make_square(VEC_ZERO, 2);
+    list_t *square2 = make_square((vector_t){1.5, 0}, 2);
+    list_t *square3 = make_square((vector_t){5, 0}, 2);
+    collision_stats_t stats = {0};
+
+    // Overlapping squares test every axis of both shapes
+    assert(find_collision_with_stats(square1, square2, &stats).collided);
+    assert(stats.sat_tests == 1);
+    assert(stats.axes_tested == 8);
+    assert(stats.contacts == 1);
+    assert(stats.early_outs == 0);
+
+    // Separated squares stop at the first separating axis
+    assert(!find_collision_with_stats(square1, square3, &stats).collided);
+    assert(stats.sat_tests == 2);
+    assert(stats.axes_tested < 16);
+    assert(stats.contacts == 1);
+    assert(stats.early_outs == 1);
+
+    collision_stats_t total = {.force_creators = 3};
+    collision_stats_add(&total, stats);
+    assert(total.force_creators == 3);
+    assert(total.sat_tests == 2);
+    assert(total.axes_tested == stats.axes_tested);
+
+    list_free(square1);
+    list_free(square2);
+    list_free(square3);
+}
+
+// Writes the vertices of a rotated rectangle, counterclockwise
+void fill_rectangle(vector_t *points, vector_t center, vector_t size, double angle) {
+    double offsets[4][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+    for (size_t i = 0; i < 4; i++) {
+        vector_t corner = {offsets[i][0] * size.x / 2, offsets[i][1] * size.y / 2};
+        points[i] = vec_add(center, vec_rotate(corner, angle));
+    }
+}
+
+double rand_double(double max) {
+    return (double)rand() / RAND_MAX * max;
+}
+
+void test_find_collision_batch() {
+    // A pentagon against rectangles scattered around it
+    vector_t shape[5];
+    for (size_t i = 0; i < 5; i++) {
+        shape[i] = (vector_t){3 * cos(2 * M_PI * i / 5), 3 * sin(2 * M_PI * i / 5)};
+    }
+    vector_t candidates[4 * COLLISION_BATCH_MAX];
+    for (size_t i = 0; i < COLLISION_BATCH_MAX; i++) {
+        vector_t center = {rand_double(14) - 7, rand_double(14) - 7};
+        vector_t size = {1 + rand_double(4), 1 + rand_double(4)};
+        fill_rectangle(&candidates[4 * i], center, size, rand_double(M_PI));
+    }
+
+    for (vec_batch_isa_t isa = VEC_BATCH_SCALAR; isa < NUM_VEC_BATCH_ISAS; isa++) {
+        if (!vec_batch_isa_supported(isa)) {
+            continue;
+        }
+        vec_batch_set_isa(isa);
+        // Odd sizes leave candidates outside the SIMD lanes
+        size_t sizes[] = {COLLISION_BATCH_MAX, 7};
+        for (size_t s = 0; s < 2; s++) {
+            collision_batch_t batch;
+            find_collision_batch(shape, 5, candidates, 4, sizes[s], &batch);
+            size_t num_collided = 0;
+            for (size_t i = 0; i < sizes[s]; i++) {
+                collision_stats_t expected_stats = {0};
+                collision_stats_t stats = {0};
+                collision_info_t expected = find_collision_points(shape, 5, &candidates[4 * i], 4, &expected_stats);
+                collision_info_t info = collision_batch_get_info(&batch, i);
+                collision_batch_add_stats(&batch, i, &stats);
+                assert(info.collided == expected.collided);
+                assert(memcmp(&stats, &expected_stats, sizeof(stats)) == 0);
+                if (info.collided) {
+                    assert(memcmp(&info.axis, &expected.axis, sizeof(vector_t)) == 0);
+                    assert(info.min_overlap == expected.min_overlap);
+                    num_collided++;
+                }
+            }
+            // The scattering should give both outcomes
+            assert(s == 1 || (num_collided > 0 && num_collided < sizes[s]));
+        }
+    }
+    vec_batch_set_isa(vec_batch_best_isa());
+}
 
 int main(int argc, char *argv[]) {
     // Run all tests if there are no command-line arguments
@@ -13,5 +133,9 @@ int main(int argc, char *argv[]) {
         read_testname(argv[1], testname, sizeof(testname));
     }
 
+    DO_TEST(test_find_collision)
+    DO_TEST(test_collision_stats)
+    DO_TEST(test_find_collision_batch)
+
     puts("collision_test PASS");
 }
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include "dynarray.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdlib.h>
+
+typedef struct point {
+    int x;
+    int y;
+} point_t;
+
+DYNARRAY_DEFINE(int_array, int, 4)
+DYNARRAY_DEFINE(point_array, point_t, 2)
+
+
+void test_push_and_get() {
+    int_array_t a;
+    int_array_init(&a);
+    assert(int_array_size(&a) == 0);
+
+    // The first four stay inline, the rest spill to the heap
+    for (int i = 0; i < 100; i++) {
+        int *slot = int_array_push(&a, i * i);
+        assert(*slot == i * i);
+        assert(int_array_size(&a) == (size_t)i + 1);
+        assert((a.heap == NULL) == (i < 4));
+    }
+    for (int i = 0; i < 100; i++) {
+        assert(*int_array_get(&a, i) == i * i);
+        assert(int_array_data(&a)[i] == i * i);
+    }
+
+    int_array_clear(&a);
+    assert(int_array_size(&a) == 0);
+    int_array_push(&a, 7);
+    assert(*int_array_get(&a, 0) == 7);
+    int_array_free(&a);
+    assert(int_array_size(&a) == 0);
+}
+
+
+void test_reserve_and_move() {
+    point_array_t a;
+    point_array_init(&a);
+    point_array_push(&a, (point_t){1, 2});
+    point_array_reserve(&a, 50);
+    assert(a.capacity == 50);
+    assert(point_array_get(&a, 0)->y == 2);
+
+    // Moving the struct keeps its elements reachable, inline or not
+    point_array_t moved = a;
+    assert(point_array_get(&moved, 0)->x == 1);
+    point_array_free(&moved);
+
+    point_array_t small;
+    point_array_init(&small);
+    point_array_push(&small, (point_t){3, 4});
+    point_array_t small_moved = small;
+    assert(point_array_get(&small_moved, 0)->x == 3);
+    point_array_free(&small_moved);
+}
+
+
+void test_insert_and_remove() {
+    int_array_t a;
+    int_array_init(&a);
+    for (int i = 0; i < 6; i++) {
+        int_array_push(&a, i);
+    }
+    int_array_insert(&a, 0, -1);
+    int_array_insert(&a, 3, 10);
+    int_array_insert(&a, int_array_size(&a), 20);
+    int expected[] = {-1, 0, 1, 10, 2, 3, 4, 5, 20};
+    assert(int_array_size(&a) == 9);
+    for (size_t i = 0; i < 9; i++) {
+        assert(*int_array_get(&a, i) == expected[i]);
+    }
+
+    int_array_remove(&a, 3);
+    int after_remove[] = {-1, 0, 1, 2, 3, 4, 5, 20};
+    for (size_t i = 0; i < 8; i++) {
+        assert(*int_array_get(&a, i) == after_remove[i]);
+    }
+
+    // Swap remove moves the last element into the gap
+    int_array_swap_remove(&a, 1);
+    assert(int_array_size(&a) == 7);
+    assert(*int_array_get(&a, 1) == 20);
+    int_array_swap_remove(&a, 6);
+    assert(int_array_size(&a) == 6);
+    assert(*int_array_get(&a, 5) == 4);
+
+    int_array_truncate(&a, 2);
+    assert(int_array_size(&a) == 2);
+    int_array_free(&a);
+}
+
+
+bool is_multiple(int *value, void *aux) {
+    int *removed = aux;
+    if (*value % 3 == 0) {
+        (*removed)++;
+        return true;
+    }
+    return false;
+}
+
+
+void test_remove_if() {
+    int_array_t a;
+    int_array_init(&a);
+    for (int i = 0; i < 30; i++) {
+        int_array_push(&a, i);
+    }
+
+    int removed = 0;
+    assert(int_array_remove_if(&a, is_multiple, &removed) == 10);
+    assert(removed == 10);
+    assert(int_array_size(&a) == 20);
+    // The rest keep their order
+    int prev = -1;
+    for (size_t i = 0; i < int_array_size(&a); i++) {
+        int value = *int_array_get(&a, i);
+        assert(value % 3 != 0);
+        assert(value > prev);
+        prev = value;
+    }
+    assert(int_array_remove_if(&a, is_multiple, &removed) == 0);
+    int_array_free(&a);
+}
+
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_push_and_get)
+    DO_TEST(test_reserve_and_move)
+    DO_TEST(test_insert_and_remove)
+    DO_TEST(test_remove_if)
+
+    puts("dynarray_test PASS");
+}
@@ -0,0 +1,57 @@
+#include "file_map.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+const char *FILE_MAP_PATH = "out/test_file_map.bin";
+const char *FILE_MAP_BYTES = "some bytes to map";
+
+
+void write_test_file(const char *contents) {
+    mkdir("out", 0755);
+    FILE *f = fopen(FILE_MAP_PATH, "wb");
+    assert(f);
+    fwrite(contents, 1, strlen(contents), f);
+    fclose(f);
+}
+
+
+void test_map() {
+    write_test_file(FILE_MAP_BYTES);
+    size_t size = 0;
+    void *data = file_map(FILE_MAP_PATH, ALLOC_TAG_OTHER, &size);
+    assert(data);
+    assert(size == strlen(FILE_MAP_BYTES));
+    assert(memcmp(data, FILE_MAP_BYTES, size) == 0);
+    file_unmap(data, ALLOC_TAG_OTHER, size);
+    remove(FILE_MAP_PATH);
+}
+
+
+void test_missing_and_empty() {
+    size_t size = 0;
+    assert(file_map("out/missing.bin", ALLOC_TAG_OTHER, &size) == NULL);
+
+    write_test_file("");
+    assert(file_map(FILE_MAP_PATH, ALLOC_TAG_OTHER, &size) == NULL);
+    remove(FILE_MAP_PATH);
+}
+
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_map)
+    DO_TEST(test_missing_and_empty)
+
+    puts("file_map_test PASS");
+}
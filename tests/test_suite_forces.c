@@ -1,9 +1,202 @@
 #include "forces.h"
+#include "jobs.h"
 #include "test_util.h"
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
 
+const rgb_color_t TEST_COLOR = {.r = 0, .g = 0, .b = 0};
+
+list_t *make_square(vector_t center, double side) {
+    list_t *square = list_init(4, free);
+    double offsets[4][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+    for (size_t i = 0; i < 4; i++) {
+        vector_t *v = malloc(sizeof(vector_t));
+        assert(v);
+        v->x = center.x + offsets[i][0] * side / 2;
+        v->y = center.y + offsets[i][1] * side / 2;
+        list_add(square, v);
+    }
+    return square;
+}
+
+void count_hit(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+    (*(size_t *)aux)++;
+}
+
+void test_collision_stats_by_category() {
+    scene_t *scene = scene_init((vector_t){100, 100});
+    body_t *mover = body_init(make_square((vector_t){10, 10}, 2), 1, TEST_COLOR);
+    body_t *near = body_init(make_square((vector_t){11.5, 10}, 2), 1, TEST_COLOR);
+    body_t *far = body_init(make_square((vector_t){80, 80}, 2), 1, TEST_COLOR);
+    body_set_category(mover, 1);
+    body_set_category(near, 2);
+    body_set_category(far, 3);
+    scene_add_body(scene, mover);
+    scene_add_body(scene, near);
+    scene_add_body(scene, far);
+
+    size_t hits = 0;
+    create_collision(scene, mover, near, count_hit, &hits, NULL);
+    create_collision(scene, mover, far, count_hit, &hits, NULL);
+    scene_tick(scene, 0);
+    scene_tick(scene, 0);
+
+    // The handler only fires on the first tick of a collision
+    collision_stats_t near_stats = scene_get_collision_stats(scene, 1, 2);
+    assert(hits == 1);
+    assert(near_stats.force_creators == 2);
+    assert(near_stats.radius_rejections == 0);
+    assert(near_stats.sat_tests == 2);
+    assert(near_stats.contacts == 2);
+    assert(near_stats.handlers_fired == 1);
+
+    collision_stats_t far_stats = scene_get_collision_stats(scene, 1, 3);
+    assert(far_stats.force_creators == 2);
+    assert(far_stats.radius_rejections == 2);
+    assert(far_stats.sat_tests == 0);
+    assert(scene_get_collision_stats(scene, 3, 1).force_creators == 0);
+
+    collision_stats_t total = scene_get_total_collision_stats(scene);
+    assert(total.force_creators == 4);
+    assert(total.radius_rejections == 2);
+    assert(total.handlers_fired == 1);
+
+    scene_reset_collision_stats(scene);
+    assert(scene_get_total_collision_stats(scene).force_creators == 0);
+
+    scene_free(scene);
+}
+
+typedef struct hit_log {
+    size_t hits[1000];
+    size_t num_hits;
+} hit_log_t;
+
+typedef struct logged_pair {
+    hit_log_t *log;
+    size_t id;
+} logged_pair_t;
+
+void log_hit(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+    logged_pair_t *pair = aux;
+    assert(pair->log->num_hits < 1000);
+    pair->log->hits[pair->log->num_hits++] = pair->id;
+}
+
+// Collides every pair in a row of overlapping squares and logs the handlers in order
+void run_logged_collisions(size_t num_workers, hit_log_t *log, logged_pair_t *pairs) {
+    // Earlier ticks may have started the job system with the default workers
+    jobs_shutdown();
+    jobs_init(num_workers);
+    scene_t *scene = scene_init((vector_t){1000, 1000});
+    body_t *bodies[40];
+    for (size_t i = 0; i < 40; i++) {
+        bodies[i] = body_init(make_square((vector_t){10 + i * 1.5, 10}, 2), 1, TEST_COLOR);
+        scene_add_body(scene, bodies[i]);
+    }
+    size_t id = 0;
+    for (size_t i = 0; i < 40; i++) {
+        for (size_t j = i + 1; j < 40; j++) {
+            pairs[id] = (logged_pair_t){.log = log, .id = id};
+            create_collision(scene, bodies[i], bodies[j], log_hit, &pairs[id], NULL);
+            id++;
+        }
+    }
+    log->num_hits = 0;
+    scene_tick(scene, 0);
+    scene_tick(scene, 0);
+    assert(scene_get_total_collision_stats(scene).handlers_fired == log->num_hits);
+    scene_free(scene);
+    jobs_shutdown();
+}
+
+void test_collision_order_is_deterministic() {
+    static hit_log_t serial, parallel;
+    static logged_pair_t pairs[40 * 39 / 2];
+    run_logged_collisions(0, &serial, pairs);
+    // Each square overlaps the next one only, and handlers fire once per collision
+    assert(serial.num_hits == 39);
+    for (size_t i = 1; i < serial.num_hits; i++) {
+        assert(serial.hits[i - 1] < serial.hits[i]);
+    }
+
+    for (size_t round = 0; round < 10; round++) {
+        run_logged_collisions(3, &parallel, pairs);
+        assert(parallel.num_hits == serial.num_hits);
+        for (size_t i = 0; i < serial.num_hits; i++) {
+            assert(parallel.hits[i] == serial.hits[i]);
+        }
+    }
+}
+
+typedef struct chain_aux {
+    scene_t *scene;
+    body_t *other;
+    size_t hits;
+} chain_aux_t;
+
+void chain_hit(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+    chain_aux_t *chain = aux;
+    chain->hits++;
+    if (chain->other) {
+        // Collisions added mid-tick are tested and handled in the same tick
+        create_collision(chain->scene, body2, chain->other, chain_hit, chain, NULL);
+        chain->other = NULL;
+    }
+}
+
+void test_collision_added_during_tick() {
+    scene_t *scene = scene_init((vector_t){100, 100});
+    body_t *a = body_init(make_square((vector_t){10, 10}, 2), 1, TEST_COLOR);
+    body_t *b = body_init(make_square((vector_t){11, 10}, 2), 1, TEST_COLOR);
+    body_t *c = body_init(make_square((vector_t){12, 10}, 2), 1, TEST_COLOR);
+    scene_add_body(scene, a);
+    scene_add_body(scene, b);
+    scene_add_body(scene, c);
+
+    chain_aux_t chain = {.scene = scene, .other = c, .hits = 0};
+    create_collision(scene, a, b, chain_hit, &chain, NULL);
+    scene_tick(scene, 0);
+    assert(chain.hits == 2);
+    scene_tick(scene, 0);
+    assert(chain.hits == 2);
+
+    scene_free(scene);
+}
+
+size_t freed_auxes = 0;
+
+void count_free(void *aux) {
+    assert(aux);
+    freed_auxes++;
+}
+
+void test_collision_aux_freed() {
+    scene_t *scene = scene_init((vector_t){100, 100});
+    body_t *a = body_init(make_square((vector_t){10, 10}, 2), 1, TEST_COLOR);
+    body_t *b = body_init(make_square((vector_t){50, 10}, 2), 1, TEST_COLOR);
+    body_t *c = body_init(make_square((vector_t){90, 10}, 2), 1, TEST_COLOR);
+    scene_add_body(scene, a);
+    scene_add_body(scene, b);
+    scene_add_body(scene, c);
+
+    // The physics collision's elasticity comes from the scene's arena; the handler's aux is freed
+    size_t used = arena_bytes_used(scene_get_arena(scene));
+    int handler_aux = 0;
+    create_collision(scene, a, b, chain_hit, &handler_aux, count_free);
+    create_collision(scene, a, c, chain_hit, &handler_aux, count_free);
+    create_physics_collision(scene, 0.5, b, c);
+    assert(arena_bytes_used(scene_get_arena(scene)) > used);
+
+    freed_auxes = 0;
+    body_remove(b);
+    scene_tick(scene, 0);
+    assert(freed_auxes == 1);
+    scene_free(scene);
+    assert(freed_auxes == 2);
+}
+
 int main(int argc, char *argv[]) {
     // Run all tests if there are no command-line arguments
     bool all_tests = argc == 1;
@@ -13,5 +206,10 @@ int main(int argc, char *argv[]) {
         read_testname(argv[1], testname, sizeof(testname));
     }
 
+    DO_TEST(test_collision_stats_by_category)
+    DO_TEST(test_collision_order_is_deterministic)
+    DO_TEST(test_collision_added_during_tick)
+    DO_TEST(test_collision_aux_freed)
+
     puts("forces_test PASS");
 }
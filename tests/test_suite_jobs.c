@@ -0,0 +1,215 @@
+#include "jobs.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <SDL2/SDL.h>
+
+const size_t TEST_NUM_WORKERS = 3;
+const size_t LARGE_COUNT = 100000;
+
+
+void count_range(size_t start, size_t end, void *aux) {
+    SDL_atomic_t *counts = aux;
+    assert(start < end);
+    for (size_t i = start; i < end; i++) {
+        SDL_AtomicAdd(&counts[i], 1);
+    }
+}
+
+void check_parallel_for(size_t count, size_t grain) {
+    SDL_atomic_t *counts = calloc(count + 1, sizeof(SDL_atomic_t));
+    assert(counts);
+    jobs_parallel_for(count, grain, count_range, counts);
+    for (size_t i = 0; i < count; i++) {
+        assert(SDL_AtomicGet(&counts[i]) == 1);
+    }
+    assert(SDL_AtomicGet(&counts[count]) == 0);
+    free(counts);
+}
+
+void test_parallel_for() {
+    jobs_init(TEST_NUM_WORKERS);
+    assert(jobs_num_threads() == TEST_NUM_WORKERS + 1);
+
+    check_parallel_for(0, 1);
+    check_parallel_for(1, 1);
+    check_parallel_for(7, 2);
+    check_parallel_for(100, 0);
+    check_parallel_for(1000, 1);
+    check_parallel_for(LARGE_COUNT, 64);
+    check_parallel_for(LARGE_COUNT, LARGE_COUNT * 2);
+
+    jobs_shutdown();
+}
+
+
+void test_no_workers() {
+    // Everything runs on the waiting thread
+    jobs_init(0);
+    assert(jobs_num_threads() == 1);
+    check_parallel_for(1000, 10);
+    jobs_shutdown();
+}
+
+
+typedef struct order {
+    SDL_atomic_t next;
+    int positions[8];
+} order_t;
+
+typedef struct step {
+    order_t *order;
+    size_t idx;
+} step_t;
+
+void record_step(void *aux) {
+    step_t *step = aux;
+    step->order->positions[step->idx] = SDL_AtomicAdd(&step->order->next, 1);
+}
+
+void test_dependencies() {
+    jobs_init(TEST_NUM_WORKERS);
+
+    for (size_t round = 0; round < 100; round++) {
+        order_t order = {.positions = {0}};
+        SDL_AtomicSet(&order.next, 0);
+        step_t steps[4];
+        job_t *jobs[4];
+        for (size_t i = 0; i < 4; i++) {
+            steps[i] = (step_t){.order = &order, .idx = i};
+            jobs[i] = job_create(record_step, &steps[i]);
+        }
+
+        // A diamond: 0 before 1 and 2, which are both before 3
+        job_depends_on(jobs[1], jobs[0]);
+        job_depends_on(jobs[2], jobs[0]);
+        job_depends_on(jobs[3], jobs[1]);
+        job_depends_on(jobs[3], jobs[2]);
+        for (size_t i = 4; i > 0; i--) {
+            job_submit(jobs[i - 1]);
+        }
+        for (size_t i = 0; i < 4; i++) {
+            job_wait(jobs[i]);
+        }
+
+        assert(order.positions[0] == 0);
+        assert(order.positions[1] > 0 && order.positions[2] > 0);
+        assert(order.positions[3] == 3);
+    }
+
+    jobs_shutdown();
+}
+
+
+void test_finished_dependency() {
+    jobs_init(TEST_NUM_WORKERS);
+
+    order_t order = {.positions = {0}};
+    SDL_AtomicSet(&order.next, 0);
+    step_t first = {.order = &order, .idx = 0};
+    step_t second = {.order = &order, .idx = 1};
+
+    job_t *job1 = job_create(record_step, &first);
+    job_submit(job1);
+    while (SDL_AtomicGet(&order.next) == 0) {
+        SDL_Delay(0);
+    }
+    // Depending on a job that has already run doesn't block
+    job_t *job2 = job_create(record_step, &second);
+    job_depends_on(job2, job1);
+    job_submit(job2);
+    job_wait(job2);
+    job_wait(job1);
+    assert(order.positions[1] == 1);
+
+    jobs_shutdown();
+}
+
+
+void nested_range(size_t start, size_t end, void *aux) {
+    SDL_atomic_t *counts = aux;
+    for (size_t i = start; i < end; i++) {
+        jobs_parallel_for(100, 10, count_range, &counts[i * 100]);
+    }
+}
+
+void record_thread(size_t start, size_t end, void *aux) {
+    SDL_atomic_t *seen = aux;
+    size_t thread = jobs_thread_index();
+    assert(thread < jobs_num_threads());
+    SDL_AtomicAdd(&seen[thread], (int)(end - start));
+}
+
+void test_nested_and_thread_index() {
+    jobs_init(TEST_NUM_WORKERS);
+    assert(jobs_thread_index() == 0);
+
+    SDL_atomic_t *counts = calloc(20 * 100, sizeof(SDL_atomic_t));
+    assert(counts);
+    jobs_parallel_for(20, 1, nested_range, counts);
+    for (size_t i = 0; i < 20 * 100; i++) {
+        assert(SDL_AtomicGet(&counts[i]) == 1);
+    }
+    free(counts);
+
+    SDL_atomic_t seen[4];
+    for (size_t i = 0; i < 4; i++) {
+        SDL_AtomicSet(&seen[i], 0);
+    }
+    jobs_parallel_for(LARGE_COUNT, 100, record_thread, seen);
+    int total = 0;
+    for (size_t i = 0; i < 4; i++) {
+        total += SDL_AtomicGet(&seen[i]);
+    }
+    assert(total == (int)LARGE_COUNT);
+
+    jobs_shutdown();
+}
+
+
+int start_lazily(void *aux) {
+    size_t *num_threads = aux;
+    *num_threads = jobs_num_threads();
+    return 0;
+}
+
+void test_lazy_start_from_threads() {
+    // Threads that all find the job system stopped start it once between them
+    SDL_Thread *threads[4];
+    size_t num_threads[4];
+    for (size_t i = 0; i < 4; i++) {
+        threads[i] = SDL_CreateThread(start_lazily, "test_lazy_start", &num_threads[i]);
+        assert(threads[i]);
+    }
+    for (size_t i = 0; i < 4; i++) {
+        SDL_WaitThread(threads[i], NULL);
+        assert(num_threads[i] == jobs_default_num_workers() + 1);
+    }
+    check_parallel_for(1000, 10);
+    jobs_shutdown();
+
+    // and it can be started again afterwards
+    jobs_init(0);
+    assert(jobs_num_threads() == 1);
+    jobs_shutdown();
+}
+
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_parallel_for)
+    DO_TEST(test_no_workers)
+    DO_TEST(test_dependencies)
+    DO_TEST(test_finished_dependency)
+    DO_TEST(test_nested_and_thread_index)
+    DO_TEST(test_lazy_start_from_threads)
+
+    puts("jobs_test PASS");
+}
@@ -0,0 +1,116 @@
+#include "pack.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define NUM_ENTRIES 3
+
+const char *PACK_PATH = "out/test_pack.fafpak";
+const char *ENTRY_PATHS[NUM_ENTRIES] = {"assets/a.png", "assets/fonts/b.ttf", "assets/c.wav"};
+const char *FONT_BYTES = "pretend font";
+const char *SOUND_BYTES = "a sound that is longer than sixteen bytes";
+// A 2 x 3 image
+const uint8_t PIXELS[2 * 3 * 4] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,
+                                   13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24};
+
+
+bool write_test_pack() {
+    mkdir("out", 0755);
+    pack_entry_t entries[NUM_ENTRIES] = {
+        {.kind = PACK_PIXELS, .size = sizeof(PIXELS), .width = 2, .height = 3},
+        {.kind = PACK_FILE, .size = (uint32_t)strlen(FONT_BYTES)},
+        {.kind = PACK_FILE, .size = (uint32_t)strlen(SOUND_BYTES)}
+    };
+    const void *contents[NUM_ENTRIES] = {PIXELS, FONT_BYTES, SOUND_BYTES};
+    return pack_write(PACK_PATH, entries, ENTRY_PATHS, contents, NUM_ENTRIES);
+}
+
+
+void test_round_trip() {
+    assert(write_test_pack());
+    pack_t *pack = pack_open(PACK_PATH);
+    assert(pack);
+    assert(pack_num_entries(pack) == NUM_ENTRIES);
+
+    for (size_t i = 0; i < NUM_ENTRIES; i++) {
+        const pack_entry_t *entry = pack_find(pack, pack_id(ENTRY_PATHS[i]));
+        assert(entry == pack_get_entry(pack, i));
+        assert(strcmp(pack_entry_path(pack, entry), ENTRY_PATHS[i]) == 0);
+        assert(entry->offset % PACK_ALIGNMENT == 0);
+    }
+
+    const pack_entry_t *image = pack_find(pack, pack_id("assets/a.png"));
+    assert(image->kind == PACK_PIXELS && image->width == 2 && image->height == 3);
+    assert(memcmp(pack_entry_data(pack, image), PIXELS, sizeof(PIXELS)) == 0);
+    const pack_entry_t *sound = pack_find(pack, pack_id("assets/c.wav"));
+    assert(sound->kind == PACK_FILE && sound->size == strlen(SOUND_BYTES));
+    assert(memcmp(pack_entry_data(pack, sound), SOUND_BYTES, sound->size) == 0);
+
+    assert(pack_find(pack, pack_id("assets/missing.png")) == NULL);
+    pack_close(pack);
+}
+
+
+void test_empty_pack() {
+    assert(pack_write(PACK_PATH, NULL, NULL, NULL, 0));
+    pack_t *pack = pack_open(PACK_PATH);
+    assert(pack);
+    assert(pack_num_entries(pack) == 0);
+    assert(pack_find(pack, pack_id("assets/a.png")) == NULL);
+    pack_close(pack);
+}
+
+
+void test_duplicate_paths() {
+    pack_entry_t entries[2] = {{.kind = PACK_FILE, .size = 1}, {.kind = PACK_FILE, .size = 1}};
+    const char *paths[2] = {"assets/same.wav", "assets/same.wav"};
+    const void *contents[2] = {"a", "b"};
+    assert(!pack_write(PACK_PATH, entries, paths, contents, 2));
+}
+
+
+void test_rejects_bad_files() {
+    assert(pack_open("out/missing.fafpak") == NULL);
+
+    assert(write_test_pack());
+    FILE *f = fopen(PACK_PATH, "rb");
+    assert(f);
+    char bytes[1024];
+    size_t size = fread(bytes, 1, sizeof(bytes), f);
+    fclose(f);
+    assert(size < sizeof(bytes));
+
+    // A truncated archive
+    f = fopen(PACK_PATH, "wb");
+    fwrite(bytes, 1, size - 1, f);
+    fclose(f);
+    assert(pack_open(PACK_PATH) == NULL);
+
+    // Another kind of file
+    bytes[0] = 'X';
+    f = fopen(PACK_PATH, "wb");
+    fwrite(bytes, 1, size, f);
+    fclose(f);
+    assert(pack_open(PACK_PATH) == NULL);
+}
+
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_round_trip)
+    DO_TEST(test_empty_pack)
+    DO_TEST(test_duplicate_paths)
+    DO_TEST(test_rejects_bad_files)
+
+    puts("pack_test PASS");
+}
@@ -0,0 +1,110 @@
+#include "rng.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define NUM_SAMPLES 100000
+#define NUM_BUCKETS 10
+
+
+void test_reference_output() {
+    // The first outputs of the reference xoshiro256** from the state {1, 2, 3, 4}
+    rng_t rng = {{1, 2, 3, 4}};
+    assert(rng_next(&rng) == 11520);
+    assert(rng_next(&rng) == 0);
+}
+
+
+void test_same_seed_same_numbers() {
+    rng_t rng1 = rng_init(42), rng2 = rng_init(42);
+    for (size_t i = 0; i < 1000; i++) {
+        assert(rng_next(&rng1) == rng_next(&rng2));
+    }
+    rng1 = rng_init_stream(42, 7);
+    rng2 = rng_init_stream(42, 7);
+    for (size_t i = 0; i < 1000; i++) {
+        assert(rng_range(&rng1, -3, 5) == rng_range(&rng2, -3, 5));
+    }
+}
+
+
+void test_streams_differ() {
+    rng_t streams[4] = {rng_init(5), rng_init_stream(5, 0), rng_init_stream(5, 1), rng_init_stream(6, 1)};
+    uint64_t first[4];
+    for (size_t i = 0; i < 4; i++) {
+        first[i] = rng_next(&streams[i]);
+    }
+    for (size_t i = 0; i < 4; i++) {
+        for (size_t j = i + 1; j < 4; j++) {
+            assert(first[i] != first[j]);
+        }
+    }
+    // The seed 0 still makes a working generator
+    rng_t zero = rng_init(0);
+    assert(rng_next(&zero) != 0 || rng_next(&zero) != 0);
+}
+
+
+void test_range() {
+    rng_t rng = rng_init(1);
+    for (size_t i = 0; i < NUM_SAMPLES; i++) {
+        double d = rng_double(&rng);
+        assert(d >= 0 && d < 1);
+        double r = rng_range(&rng, -2.5, 7);
+        assert(r >= -2.5 && r < 7);
+        assert(rng_index(&rng, 3) < 3);
+    }
+    assert(rng_index(&rng, 1) == 0);
+}
+
+
+void test_uniform() {
+    rng_t rng = rng_init(2);
+    size_t counts[NUM_BUCKETS] = {0};
+    for (size_t i = 0; i < NUM_SAMPLES; i++) {
+        counts[rng_index(&rng, NUM_BUCKETS)]++;
+    }
+    double expected = (double)NUM_SAMPLES / NUM_BUCKETS;
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+        assert(fabs(counts[i] - expected) < expected * 0.05);
+    }
+}
+
+
+void test_fill_matches_next() {
+    rng_t rng1 = rng_init(3), rng2 = rng_init(3);
+    uint64_t bits[37];
+    rng_fill(&rng1, bits, 37);
+    for (size_t i = 0; i < 37; i++) {
+        assert(bits[i] == rng_next(&rng2));
+    }
+    double values[37];
+    rng_fill_range(&rng1, values, 37, 10, 20);
+    for (size_t i = 0; i < 37; i++) {
+        assert(values[i] == rng_range(&rng2, 10, 20));
+    }
+    // Both generators end in the same state
+    assert(memcmp(&rng1, &rng2, sizeof(rng_t)) == 0);
+}
+
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_reference_output)
+    DO_TEST(test_same_seed_same_numbers)
+    DO_TEST(test_streams_differ)
+    DO_TEST(test_range)
+    DO_TEST(test_uniform)
+    DO_TEST(test_fill_matches_next)
+
+    puts("rng_test PASS");
+}
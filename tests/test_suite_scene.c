@@ -4,6 +4,159 @@
 #include <math.h>
 #include <stdlib.h>
 
+list_t *make_square(vector_t center) {
+    list_t *shape = list_init(4, free);
+    vector_t offsets[4] = {{-1, -1}, {+1, -1}, {+1, +1}, {-1, +1}};
+    for (size_t i = 0; i < 4; i++) {
+        vector_t *v = malloc(sizeof(*v));
+        *v = vec_add(center, offsets[i]);
+        list_add(shape, v);
+    }
+    return shape;
+}
+
+void steer(body_t *body, void *dt) {
+    // Changing the velocity only affects the next tick's movement
+    body_set_velocity(body, vec_add(body_get_velocity(body), (vector_t) {0, 1}));
+}
+
+void follow(body_t *body, void *dt) {
+    body_t *leader = body_get_info(body);
+    body_set_centroid(body, vec_add(body_get_centroid(leader), (vector_t) {0, -5}));
+}
+
+void test_scene_tick_order() {
+    scene_t *scene = scene_init((vector_t) {100, 100});
+    body_t *leader = body_init(make_square(VEC_ZERO), 1, (rgb_color_t) {0, 0, 0});
+    body_t *follower = body_init_with_info(make_square(VEC_ZERO), 1, (rgb_color_t) {0, 0, 0},
+                                           leader, NULL);
+    body_t *drifter = body_init(make_square(VEC_ZERO), 1, (rgb_color_t) {0, 0, 0});
+    body_register_tick_func(leader, steer);
+    body_register_tick_func(follower, follow);
+    body_set_velocity(leader, (vector_t) {1, 0});
+    body_set_velocity(drifter, (vector_t) {0, 2});
+    scene_add_body(scene, leader);
+    scene_add_body(scene, follower);
+    scene_add_body(scene, drifter);
+
+    scene_tick(scene, 1);
+    assert(vec_equal(body_get_centroid(leader), (vector_t) {1, 0}));
+    assert(vec_equal(body_get_velocity(leader), (vector_t) {1, 1}));
+    // The follower ticks after the leader has moved
+    assert(vec_equal(body_get_centroid(follower), (vector_t) {1, -5}));
+    assert(vec_equal(body_get_centroid(drifter), (vector_t) {0, 2}));
+
+    scene_tick(scene, 1);
+    assert(vec_equal(body_get_centroid(leader), (vector_t) {2, 1}));
+    assert(vec_equal(body_get_centroid(follower), (vector_t) {2, -4}));
+
+    body_remove(leader);
+    body_remove(follower);
+    scene_tick(scene, 1);
+    assert(scene_num_bodies(scene) == 1);
+    assert(vec_equal(body_get_centroid(drifter), (vector_t) {0, 6}));
+
+    scene_free(scene);
+}
+
+void test_scene_layers() {
+    scene_t *scene = scene_init((vector_t) {100, 100});
+    rgb_color_t black = {0, 0, 0};
+    body_t *top1 = body_init(make_square(VEC_ZERO), 1, black);
+    body_t *bottom1 = body_init(make_square(VEC_ZERO), 1, black);
+    body_t *top2 = body_init(make_square(VEC_ZERO), 1, black);
+    body_t *bottom2 = body_init(make_square(VEC_ZERO), 1, black);
+    body_t *extra = body_init(make_square(VEC_ZERO), 1, black);
+    scene_add_body(scene, top1);
+    scene_add_body_in_layer(scene, bottom1, 0);
+    scene_add_body(scene, top2);
+    scene_add_body_in_layer(scene, bottom2, 0);
+    scene_add_body_in_layer(scene, extra, 3);
+    assert(scene_num_layers(scene) == 4);
+    assert(scene_num_bodies(scene) == 5);
+    assert(scene_num_bodies_in_layer(scene, 0) == 2);
+    assert(scene_num_bodies_in_layer(scene, 1) == 2);
+    assert(scene_num_bodies_in_layer(scene, 2) == 0);
+
+    // Draw order is by layer, then by the order bodies were added
+    body_t *expected[] = {bottom1, bottom2, top1, top2, extra};
+    for (size_t i = 0; i < 5; i++) {
+        assert(scene_get_body(scene, i) == expected[i]);
+    }
+
+    body_handle_t removed = body_get_handle(bottom1);
+    body_remove(bottom1);
+    body_remove(top2);
+    scene_tick(scene, 1);
+    assert(body_from_handle(removed) == NULL);
+    assert(scene_num_bodies(scene) == 3);
+    assert(scene_num_bodies_in_layer(scene, 0) == 1);
+    assert(scene_num_bodies_in_layer(scene, 1) == 1);
+    assert(scene_get_body(scene, 0) == bottom2);
+    assert(scene_get_body(scene, 1) == top1);
+    assert(scene_get_body(scene, 2) == extra);
+
+    scene_free(scene);
+}
+
+typedef struct counted_force {
+    bool hit;
+    size_t *batch_calls;
+    size_t *order;
+    size_t *num_run;
+    size_t index;
+} counted_force_t;
+
+bool counted_tester(counted_force_t *force) {
+    return force->hit;
+}
+
+void counted_batch_tester(void **auxes, size_t num_auxes, bool *results) {
+    assert(num_auxes <= SCENE_BATCH_MAX);
+    counted_force_t *first = auxes[0];
+    (*first->batch_calls)++;
+    for (size_t i = 0; i < num_auxes; i++) {
+        results[i] = counted_tester(auxes[i]);
+    }
+}
+
+void counted_forcer(counted_force_t *force) {
+    force->order[(*force->num_run)++] = force->index;
+}
+
+void test_scene_batch_tester() {
+    const size_t num_forces = 150;
+    scene_t *scene = scene_init((vector_t) {100, 100});
+    body_t *body = body_init(make_square(VEC_ZERO), 1, (rgb_color_t) {0, 0, 0});
+    scene_add_body(scene, body);
+
+    size_t batch_calls = 0;
+    size_t num_run = 0;
+    size_t order[150];
+    counted_force_t forces[150];
+    for (size_t i = 0; i < num_forces; i++) {
+        forces[i] = (counted_force_t) {
+            .hit = i % 3 == 0, .batch_calls = &batch_calls, .order = order, .num_run = &num_run, .index = i
+        };
+        list_t *bodies = list_init(1, NULL);
+        list_add(bodies, body);
+        scene_add_batch_tested_force_creator(scene, (force_batch_tester_t)counted_batch_tester,
+                                             (force_tester_t)counted_tester, (force_creator_t)counted_forcer,
+                                             &forces[i], bodies, NULL);
+    }
+
+    scene_tick(scene, 1);
+    // Runs are split at SCENE_BATCH_MAX, and forcers still run in the order they were added
+    assert(batch_calls >= (num_forces + SCENE_BATCH_MAX - 1) / SCENE_BATCH_MAX);
+    assert(batch_calls < num_forces);
+    assert(num_run == num_forces / 3);
+    for (size_t i = 0; i < num_run; i++) {
+        assert(order[i] == 3 * i);
+    }
+
+    scene_free(scene);
+}
+
 int main(int argc, char *argv[]) {
     // Run all tests if there are no command-line arguments
     bool all_tests = argc == 1;
@@ -13,5 +166,9 @@ int main(int argc, char *argv[]) {
         read_testname(argv[1], testname, sizeof(testname));
     }
 
+    DO_TEST(test_scene_tick_order)
+    DO_TEST(test_scene_layers)
+    DO_TEST(test_scene_batch_tester)
+
     puts("scene_test PASS");
 }
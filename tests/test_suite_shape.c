@@ -1,58 +1,62 @@
 #include "shape.h"
 #include "test_util.h"
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 const int N_POINTS = 5;
 const double DENSITY = 1;
 const bool RAND_SIZE = false;
 const bool INIT_VELO = true;
+const uint64_t SEED = 2023;
 
 void test_shape_is_on_screen() {
+    rng_t rng = rng_init(SEED);
     vector_t lower_bound = {.x = 0, .y = 0};
     vector_t upper_bound = {.x = 1000, .y = 500};
 
     // test star at the center of the screen
     vector_t center = {.x = 500, .y = 250};
-    body_t *star = shape_init_random_star(N_POINTS, DENSITY, center, RAND_SIZE, INIT_VELO);
+    body_t *star = shape_init_random_star(&rng, N_POINTS, DENSITY, center, RAND_SIZE, INIT_VELO);
     assert(body_is_on_screen(star, lower_bound, upper_bound) == true);
     body_free(star);
     
     //test star at the right edge of the screen
     center = (vector_t) {.x = 1000, .y = 250};
-    star = shape_init_random_star(N_POINTS, DENSITY, center, RAND_SIZE, INIT_VELO);
+    star = shape_init_random_star(&rng, N_POINTS, DENSITY, center, RAND_SIZE, INIT_VELO);
     assert(body_is_on_screen(star, lower_bound, upper_bound) == true);
     body_free(star);
     
     //test star at the top edge of the screen
     center = (vector_t) {.x = 500, .y = 500};
-    star = shape_init_random_star(N_POINTS, DENSITY, center, RAND_SIZE, INIT_VELO);
+    star = shape_init_random_star(&rng, N_POINTS, DENSITY, center, RAND_SIZE, INIT_VELO);
     assert(body_is_on_screen(star, lower_bound, upper_bound) == true);
     body_free(star);
     
     //test star barely off the screen
     center = (vector_t) {.x = 1051, .y = 500};
-    star = shape_init_random_star(N_POINTS, DENSITY, center, RAND_SIZE, INIT_VELO);
+    star = shape_init_random_star(&rng, N_POINTS, DENSITY, center, RAND_SIZE, INIT_VELO);
     assert(body_is_on_screen(star, lower_bound, upper_bound) == false);
     body_free(star);
     
     //test star barely off the screen
     center = (vector_t) {.x = 500, .y = 551};
-    star = shape_init_random_star(N_POINTS, DENSITY, center, RAND_SIZE, INIT_VELO);
+    star = shape_init_random_star(&rng, N_POINTS, DENSITY, center, RAND_SIZE, INIT_VELO);
     assert(body_is_on_screen(star, lower_bound, upper_bound) == false);
     body_free(star);
     
     //test star completely off the screen
     center = (vector_t) {.x = 1500, .y = 1000};
-    star = shape_init_random_star(N_POINTS, DENSITY, center, RAND_SIZE, INIT_VELO);
+    star = shape_init_random_star(&rng, N_POINTS, DENSITY, center, RAND_SIZE, INIT_VELO);
     assert(body_is_on_screen(star, lower_bound, upper_bound) == false);
     body_free(star);
 }
 
 void test_rotate_shape() {
+    rng_t rng = rng_init(SEED);
     vector_t center = {.x = 200, .y = 50};
 
-    body_t *star = shape_init_random_star(N_POINTS, DENSITY, center, RAND_SIZE, INIT_VELO);
+    body_t *star = shape_init_random_star(&rng, N_POINTS, DENSITY, center, RAND_SIZE, INIT_VELO);
     double dt = 1;
 
     list_t *polygon = body_get_shape_nocpy(star);
@@ -81,13 +85,14 @@ void test_rotate_shape() {
 }
 
 void test_shape_update() {
+    rng_t rng = rng_init(SEED);
     vector_t start_position = {.x = 1000, .y = 500};
     vector_t lower_bound = {.x = 0, .y = 0};
     vector_t upper_bound = {.x = 1000, .y = 500};
     vector_t net_acceleration = VEC_ZERO;
     double min_elasticity = 1;
     double max_elasticity = 1;
-    body_t *star = star = shape_init_random_star(N_POINTS, DENSITY, start_position, RAND_SIZE, INIT_VELO);
+    body_t *star = star = shape_init_random_star(&rng, N_POINTS, DENSITY, start_position, RAND_SIZE, INIT_VELO);
     double dt = 1;
     
     // test collision with the wall
@@ -104,7 +109,7 @@ void test_shape_update() {
 
     // test velocity with no acceleration
     start_position = (vector_t) {.x = 500, .y = 250};
-    star = shape_init_random_star(N_POINTS, DENSITY, start_position, RAND_SIZE, INIT_VELO);
+    star = shape_init_random_star(&rng, N_POINTS, DENSITY, start_position, RAND_SIZE, INIT_VELO);
     shape_update(star, dt, lower_bound, upper_bound, net_acceleration,
                  min_elasticity, max_elasticity);
     centroid = body_get_centroid(star);
@@ -115,7 +120,7 @@ void test_shape_update() {
 
     // test velocity with acceleration
     net_acceleration = (vector_t) {.x = 20, .y = 20};
-    star = shape_init_random_star(N_POINTS, DENSITY, start_position, RAND_SIZE, INIT_VELO);
+    star = shape_init_random_star(&rng, N_POINTS, DENSITY, start_position, RAND_SIZE, INIT_VELO);
     shape_update(star, dt, lower_bound, upper_bound, net_acceleration,
                  min_elasticity, max_elasticity);
     centroid = body_get_centroid(star);
@@ -134,6 +139,19 @@ void test_shape_update() {
 }
 
 
+void test_random_star_is_reproducible() {
+    rng_t rng1 = rng_init(SEED), rng2 = rng_init(SEED);
+    vector_t center = {.x = 500, .y = 250};
+    body_t *star1 = shape_init_random_star(&rng1, N_POINTS, DENSITY, center, true, INIT_VELO);
+    body_t *star2 = shape_init_random_star(&rng2, N_POINTS, DENSITY, center, true, INIT_VELO);
+    rgb_color_t color1 = body_get_color(star1), color2 = body_get_color(star2);
+    assert(color1.r == color2.r && color1.g == color2.g && color1.b == color2.b);
+    assert(body_get_mass(star1) == body_get_mass(star2));
+    body_free(star1);
+    body_free(star2);
+}
+
+
 int main(int argc, char *argv[]) {
     // Run all tests if there are no command-line arguments
     bool all_tests = argc == 1;
@@ -146,6 +164,7 @@ int main(int argc, char *argv[]) {
     DO_TEST(test_shape_is_on_screen)
     DO_TEST(test_rotate_shape)
     DO_TEST(test_shape_update)
+    DO_TEST(test_random_star_is_reproducible)
 
     puts("shape_test PASS");
 }
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include "spatial_grid.h"
+#include "jobs.h"
+#include "rng.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define NUM_BOXES 500
+#define MAX_FOUND 600
+#define NUM_QUERIES 256
+
+
+bool found(size_t *ids, size_t num_ids, size_t id) {
+    for (size_t i = 0; i < num_ids; i++) {
+        if (ids[i] == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void test_empty() {
+    spatial_grid_t *grid = spatial_grid_init(10);
+    size_t ids[1];
+    assert(spatial_grid_size(grid) == 0);
+    assert(spatial_grid_query(grid, (vector_t){-100, -100}, (vector_t){100, 100}, ids, 1) == 0);
+    spatial_grid_free(grid);
+}
+
+
+void test_overlap() {
+    spatial_grid_t *grid = spatial_grid_init(10);
+    spatial_grid_insert(grid, 0, (vector_t){0, 0}, (vector_t){5, 5});
+    spatial_grid_insert(grid, 1, (vector_t){20, 20}, (vector_t){25, 25});
+    // Spans many cells, and negative ones
+    spatial_grid_insert(grid, 2, (vector_t){-45, -5}, (vector_t){45, 2});
+    assert(spatial_grid_size(grid) == 3);
+
+    size_t ids[3];
+    // Shares a cell with box 0 but doesn't touch it
+    assert(spatial_grid_query(grid, (vector_t){6, 6}, (vector_t){9, 9}, ids, 3) == 0);
+    assert(spatial_grid_query(grid, (vector_t){4, 4}, (vector_t){21, 21}, ids, 3) == 2);
+    assert(found(ids, 2, 0) && found(ids, 2, 1));
+    // Box 2 is in every cell of this region, but is found once
+    assert(spatial_grid_query(grid, (vector_t){-40, -3}, (vector_t){40, 1}, ids, 3) == 2);
+    assert(found(ids, 2, 0) && found(ids, 2, 2));
+    // Touching edges overlap
+    assert(spatial_grid_query(grid, (vector_t){25, 25}, (vector_t){30, 30}, ids, 3) == 1);
+    assert(ids[0] == 1);
+
+    // Only as many ids as fit are written, but all are counted
+    ids[1] = 99;
+    assert(spatial_grid_query(grid, (vector_t){-100, -100}, (vector_t){100, 100}, ids, 1) == 3);
+    assert(ids[1] == 99);
+    spatial_grid_free(grid);
+}
+
+
+void test_clear() {
+    spatial_grid_t *grid = spatial_grid_init(10);
+    spatial_grid_insert(grid, 0, (vector_t){0, 0}, (vector_t){5, 5});
+    spatial_grid_clear(grid);
+    assert(spatial_grid_size(grid) == 0);
+    size_t ids[1];
+    assert(spatial_grid_query(grid, (vector_t){0, 0}, (vector_t){5, 5}, ids, 1) == 0);
+
+    spatial_grid_insert(grid, 3, (vector_t){50, 50}, (vector_t){60, 60});
+    assert(spatial_grid_query(grid, (vector_t){0, 0}, (vector_t){55, 55}, ids, 1) == 1);
+    assert(ids[0] == 3);
+    spatial_grid_free(grid);
+}
+
+
+void test_reserve() {
+    spatial_grid_t *grid = spatial_grid_init(10);
+    spatial_grid_reserve(grid, 4, 15);
+    for (size_t i = 0; i < 4; i++) {
+        // Each straddles as many cells as a box of its size can
+        double x = 10 * i + 5;
+        spatial_grid_insert(grid, i, (vector_t){x, x}, (vector_t){x + 15, x + 15});
+    }
+    size_t ids[4];
+    assert(spatial_grid_query(grid, (vector_t){0, 0}, (vector_t){100, 100}, ids, 4) == 4);
+    assert(spatial_grid_query(grid, (vector_t){18, 18}, (vector_t){19, 19}, ids, 4) == 2);
+    assert(found(ids, 2, 0) && found(ids, 2, 1));
+    spatial_grid_free(grid);
+}
+
+
+void test_huge_boxes() {
+    // Boxes and regions covering more cells than the grid has buckets
+    spatial_grid_t *grid = spatial_grid_init(1);
+    spatial_grid_insert(grid, 0, (vector_t){-1000, -1000}, (vector_t){1000, 1000});
+    spatial_grid_insert(grid, 1, (vector_t){2000, 2000}, (vector_t){2001, 2001});
+    size_t ids[2];
+    assert(spatial_grid_query(grid, (vector_t){0, 0}, (vector_t){1, 1}, ids, 2) == 1);
+    assert(ids[0] == 0);
+    assert(spatial_grid_query(grid, (vector_t){-5000, -5000}, (vector_t){5000, 5000}, ids, 2) == 2);
+    assert(found(ids, 2, 0) && found(ids, 2, 1));
+    spatial_grid_free(grid);
+}
+
+
+void test_matches_brute_force() {
+    rng_t rng = rng_init(7);
+    vector_t mins[NUM_BOXES], maxes[NUM_BOXES];
+    spatial_grid_t *grid = spatial_grid_init(25);
+    for (size_t i = 0; i < NUM_BOXES; i++) {
+        mins[i] = (vector_t){rng_range(&rng, -500, 500), rng_range(&rng, -500, 500)};
+        maxes[i] = vec_add(mins[i], (vector_t){rng_range(&rng, 0, 60), rng_range(&rng, 0, 60)});
+        spatial_grid_insert(grid, i, mins[i], maxes[i]);
+    }
+
+    size_t ids[MAX_FOUND];
+    for (size_t query = 0; query < 200; query++) {
+        vector_t min = {rng_range(&rng, -600, 600), rng_range(&rng, -600, 600)};
+        vector_t max = vec_add(min, (vector_t){rng_range(&rng, 0, 200), rng_range(&rng, 0, 200)});
+        size_t num_found = spatial_grid_query(grid, min, max, ids, MAX_FOUND);
+
+        size_t expected = 0;
+        for (size_t i = 0; i < NUM_BOXES; i++) {
+            bool overlaps = maxes[i].x >= min.x && mins[i].x <= max.x &&
+                            maxes[i].y >= min.y && mins[i].y <= max.y;
+            assert(found(ids, num_found, i) == overlaps);
+            expected += overlaps;
+        }
+        assert(num_found == expected);
+    }
+    spatial_grid_free(grid);
+}
+
+
+typedef struct parallel_queries {
+    spatial_grid_t *grid;
+    vector_t mins[NUM_QUERIES];
+    vector_t maxes[NUM_QUERIES];
+    size_t counts[NUM_QUERIES];
+} parallel_queries_t;
+
+void run_queries(size_t start, size_t end, parallel_queries_t *queries) {
+    size_t ids[MAX_FOUND];
+    for (size_t i = start; i < end; i++) {
+        queries->counts[i] = spatial_grid_query(queries->grid, queries->mins[i], queries->maxes[i], ids, MAX_FOUND);
+    }
+}
+
+void test_parallel_queries() {
+    static parallel_queries_t queries;
+    rng_t rng = rng_init(11);
+    queries.grid = spatial_grid_init(10);
+    for (size_t i = 0; i < NUM_BOXES; i++) {
+        vector_t min = {rng_range(&rng, -300, 300), rng_range(&rng, -300, 300)};
+        spatial_grid_insert(queries.grid, i, min, vec_add(min, (vector_t){rng_range(&rng, 0, 40), 40}));
+    }
+    size_t expected[NUM_QUERIES];
+    size_t ids[MAX_FOUND];
+    for (size_t i = 0; i < NUM_QUERIES; i++) {
+        queries.mins[i] = (vector_t){rng_range(&rng, -300, 300), rng_range(&rng, -300, 300)};
+        queries.maxes[i] = vec_add(queries.mins[i], (vector_t){100, 100});
+        expected[i] = spatial_grid_query(queries.grid, queries.mins[i], queries.maxes[i], ids, MAX_FOUND);
+    }
+
+    // Queries share the grid without taking turns, and still each find every box once
+    jobs_init(4);
+    jobs_parallel_for(NUM_QUERIES, 1, (job_range_func_t)run_queries, &queries);
+    jobs_shutdown();
+    for (size_t i = 0; i < NUM_QUERIES; i++) {
+        assert(queries.counts[i] == expected[i]);
+    }
+    spatial_grid_free(queries.grid);
+}
+
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_empty)
+    DO_TEST(test_overlap)
+    DO_TEST(test_clear)
+    DO_TEST(test_reserve)
+    DO_TEST(test_huge_boxes)
+    DO_TEST(test_matches_brute_force)
+    DO_TEST(test_parallel_queries)
+
+    puts("spatial_grid_test PASS");
+}
@@ -0,0 +1,104 @@
+#include "spsc.h"
+#include "jobs.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+const size_t NUM_TRANSFERS = 200000;
+
+typedef struct command {
+    uint32_t id;
+    double value;
+} command_t;
+
+
+void test_fifo() {
+    spsc_t *queue = spsc_init(4, sizeof(command_t));
+    command_t command;
+    assert(!spsc_pop(queue, &command));
+
+    for (uint32_t i = 0; i < 4; i++) {
+        command_t pushed = {.id = i, .value = i * 0.5};
+        assert(spsc_push(queue, &pushed));
+    }
+    assert(spsc_size(queue) == 4);
+    // Full
+    command_t extra = {.id = 99};
+    assert(!spsc_push(queue, &extra));
+
+    for (uint32_t i = 0; i < 4; i++) {
+        assert(spsc_pop(queue, &command));
+        assert(command.id == i && command.value == i * 0.5);
+    }
+    assert(!spsc_pop(queue, &command));
+    assert(spsc_size(queue) == 0);
+    spsc_free(queue);
+}
+
+
+void test_wrap_around() {
+    spsc_t *queue = spsc_init(8, sizeof(uint32_t));
+    uint32_t next_push = 0, next_pop = 0;
+    // Keeps the queue partly full while the counters pass the end many times
+    for (size_t round = 0; round < 1000; round++) {
+        for (size_t i = 0; i < 5; i++) {
+            assert(spsc_push(queue, &next_push));
+            next_push++;
+        }
+        for (size_t i = 0; i < 5; i++) {
+            uint32_t value;
+            assert(spsc_pop(queue, &value));
+            assert(value == next_pop);
+            next_pop++;
+        }
+    }
+    spsc_free(queue);
+}
+
+
+void produce(void *aux) {
+    spsc_t *queue = aux;
+    for (uint32_t i = 0; i < NUM_TRANSFERS; i++) {
+        command_t command = {.id = i, .value = -(double)i};
+        while (!spsc_push(queue, &command)) {
+        }
+    }
+}
+
+
+void test_two_threads() {
+    jobs_init(1);
+    spsc_t *queue = spsc_init(64, sizeof(command_t));
+    job_t *producer = job_create(produce, queue);
+    job_submit(producer);
+
+    // Every command arrives once, in order and intact
+    for (uint32_t i = 0; i < NUM_TRANSFERS; i++) {
+        command_t command;
+        while (!spsc_pop(queue, &command)) {
+        }
+        assert(command.id == i && command.value == -(double)i);
+    }
+    job_wait(producer);
+    assert(spsc_size(queue) == 0);
+    spsc_free(queue);
+    jobs_shutdown();
+}
+
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_fifo)
+    DO_TEST(test_wrap_around)
+    DO_TEST(test_two_threads)
+
+    puts("spsc_test PASS");
+}
@@ -0,0 +1,265 @@
+#include "polygon.h"
+#include "vector_batch.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+const size_t MAX_POINTS = 37;
+
+
+double rand_coord() {
+    return (double)rand() / RAND_MAX * 2000 - 1000;
+}
+
+void fill_random(vector_t *points, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        points[i] = (vector_t){rand_coord(), rand_coord()};
+    }
+}
+
+// A convex polygon around center, so its centroid is well defined
+void fill_polygon(vector_t *points, size_t n, vector_t center) {
+    for (size_t i = 0; i < n; i++) {
+        double angle = 2 * M_PI * i / n;
+        double radius = 10 + i % 3;
+        points[i] = vec_add(center, (vector_t){radius * cos(angle), radius * sin(angle)});
+    }
+}
+
+list_t *make_list(vector_t *points, size_t n) {
+    list_t *list = list_init(n, free);
+    for (size_t i = 0; i < n; i++) {
+        vector_t *v = malloc(sizeof(*v));
+        *v = points[i];
+        list_add(list, v);
+    }
+    return list;
+}
+
+bool same_bits(vector_t v1, vector_t v2) {
+    return memcmp(&v1, &v2, sizeof(vector_t)) == 0;
+}
+
+#ifdef FAF_SINGLE_PRECISION
+// Coordinates here stay within a few thousand units, where a float is precise to about 1e-3
+const double FLOAT_TOLERANCE = 1e-2;
+#endif
+
+// The kernels match the functions in vector.h and polygon.h bit for bit, except in
+// single precision, where those functions round some intermediate results as doubles
+bool same_result(vector_t v1, vector_t v2) {
+#ifdef FAF_SINGLE_PRECISION
+    return vec_within(FLOAT_TOLERANCE, v1, v2);
+#else
+    return same_bits(v1, v2);
+#endif
+}
+
+
+// Every set of kernels must match the list-based polygon functions
+void check_kernels(vec_batch_isa_t isa) {
+    vec_batch_set_isa(isa);
+    assert(vec_batch_get_isa() == isa);
+
+    vector_t points[37], expected[37];
+    for (size_t n = 1; n <= MAX_POINTS; n++) {
+        fill_random(points, n);
+        list_t *list = make_list(points, n);
+
+        vector_t translation = {rand_coord(), rand_coord()};
+        vec_batch_translate(points, n, translation);
+        polygon_translate(list, translation);
+        for (size_t i = 0; i < n; i++) {
+            assert(same_result(points[i], *(vector_t *)list_get(list, i)));
+        }
+
+        double angle = rand_coord() / 100;
+        vector_t pivot = {rand_coord(), rand_coord()};
+        vec_batch_rotate(points, n, angle, pivot);
+        polygon_rotate(list, angle, pivot);
+        for (size_t i = 0; i < n; i++) {
+            assert(same_result(points[i], *(vector_t *)list_get(list, i)));
+        }
+
+        vector_t axis = vec_unit((vector_t){rand_coord(), rand_coord()});
+        vector_t projection = vec_batch_project(points, n, axis);
+        double min = INFINITY, max = -INFINITY;
+        for (size_t i = 0; i < n; i++) {
+            double dot = vec_dot(points[i], axis);
+            min = dot < min ? dot : min;
+            max = dot > max ? dot : max;
+        }
+        assert(same_result(projection, (vector_t){min, max}));
+        list_free(list);
+
+        // Treat the points as polygons of 1 to 4 vertices
+        size_t m = n % 4 + 1;
+        size_t num_polygons = n / m;
+        vector_t axes[37], projections[37];
+        for (size_t i = 0; i < num_polygons; i++) {
+            axes[i] = vec_unit((vector_t){rand_coord(), rand_coord()});
+        }
+        vec_batch_project_polygons(points, m, num_polygons, axes, projections);
+        for (size_t i = 0; i < num_polygons; i++) {
+            assert(same_bits(projections[i], vec_batch_project(&points[i * m], m, axes[i])));
+        }
+        vec_batch_project_axes(points, n, axes, num_polygons, projections);
+        for (size_t i = 0; i < num_polygons; i++) {
+            assert(same_bits(projections[i], vec_batch_project(points, n, axes[i])));
+        }
+        if (m >= 2) {
+            for (size_t edge = 0; edge < m; edge++) {
+                vec_batch_edge_normals(points, m, num_polygons, edge, axes);
+                for (size_t i = 0; i < num_polygons; i++) {
+                    vector_t v1 = points[i * m + edge];
+                    vector_t v2 = points[i * m + (edge + 1) % m];
+                    vector_t normal = vec_rotate(vec_unit(vec_subtract(v1, v2)), M_PI / 2);
+                    assert(same_result(axes[i], normal));
+                }
+            }
+        }
+
+        if (n >= 3) {
+            fill_polygon(expected, n, (vector_t){rand_coord(), rand_coord()});
+            list = make_list(expected, n);
+            assert(same_result(vec_batch_centroid(expected, n), polygon_centroid(list)));
+            list_free(list);
+        }
+    }
+}
+
+void test_kernels_match_polygon() {
+    for (vec_batch_isa_t isa = VEC_BATCH_SCALAR; isa < NUM_VEC_BATCH_ISAS; isa++) {
+        if (vec_batch_isa_supported(isa)) {
+            check_kernels(isa);
+        }
+    }
+    vec_batch_set_isa(vec_batch_best_isa());
+}
+
+
+// Every set of kernels must give exactly the results of the scalar kernels, in either precision
+void check_matches_scalar(vec_batch_isa_t isa) {
+    vector_t points[37], expected[37], axes[37], projections[37], expected_projections[37];
+    for (size_t n = 1; n <= MAX_POINTS; n++) {
+        fill_random(points, n);
+        memcpy(expected, points, sizeof(vector_t) * n);
+        vector_t translation = {rand_coord(), rand_coord()};
+        double angle = rand_coord() / 100;
+        vector_t pivot = {rand_coord(), rand_coord()};
+        vector_t axis = vec_unit((vector_t){rand_coord(), rand_coord()});
+        for (size_t i = 0; i < n; i++) {
+            axes[i] = vec_unit((vector_t){rand_coord(), rand_coord()});
+        }
+        size_t m = n % 4 + 1;
+        size_t num_polygons = n / m;
+
+        vec_batch_set_isa(VEC_BATCH_SCALAR);
+        vec_batch_translate(expected, n, translation);
+        vec_batch_rotate(expected, n, angle, pivot);
+        vector_t expected_projection = vec_batch_project(expected, n, axis);
+        vec_batch_project_polygons(expected, m, num_polygons, axes, expected_projections);
+
+        vec_batch_set_isa(isa);
+        vec_batch_translate(points, n, translation);
+        vec_batch_rotate(points, n, angle, pivot);
+        for (size_t i = 0; i < n; i++) {
+            assert(same_bits(points[i], expected[i]));
+        }
+        assert(same_bits(vec_batch_project(points, n, axis), expected_projection));
+        vec_batch_project_polygons(points, m, num_polygons, axes, projections);
+        for (size_t i = 0; i < num_polygons; i++) {
+            assert(same_bits(projections[i], expected_projections[i]));
+        }
+
+        if (m >= 2) {
+            vec_batch_set_isa(VEC_BATCH_SCALAR);
+            vec_batch_edge_normals(points, m, num_polygons, m - 1, expected_projections);
+            vec_batch_set_isa(isa);
+            vec_batch_edge_normals(points, m, num_polygons, m - 1, projections);
+            for (size_t i = 0; i < num_polygons; i++) {
+                assert(same_bits(projections[i], expected_projections[i]));
+            }
+        }
+    }
+}
+
+void test_kernels_match_scalar() {
+    for (vec_batch_isa_t isa = VEC_BATCH_SCALAR; isa < NUM_VEC_BATCH_ISAS; isa++) {
+        if (vec_batch_isa_supported(isa)) {
+            check_matches_scalar(isa);
+        }
+    }
+    vec_batch_set_isa(vec_batch_best_isa());
+}
+
+
+void test_centroids() {
+    const size_t sizes[] = {3, 4, 7, 12};
+    vector_t points[3 + 4 + 7 + 12];
+    vector_t centers[4] = {{0, 0}, {5, -3}, {100, 100}, {-40, 8}};
+    size_t offset = 0;
+    for (size_t i = 0; i < 4; i++) {
+        fill_polygon(&points[offset], sizes[i], centers[i]);
+        offset += sizes[i];
+    }
+
+    vector_t centroids[4];
+    vec_batch_centroids(points, sizes, 4, centroids);
+    offset = 0;
+    for (size_t i = 0; i < 4; i++) {
+        assert(same_bits(centroids[i], vec_batch_centroid(&points[offset], sizes[i])));
+        offset += sizes[i];
+    }
+    // A regular-ish polygon's centroid is close to its center
+    assert(fabs(centroids[2].x - 100) < 1 && fabs(centroids[2].y - 100) < 1);
+}
+
+
+void test_to_screen() {
+    vector_t points[] = {
+        {0, 0}, {1.25, -1.25}, {0.5, -0.5}, {-0.75, 0.75}, {10, 20}, {-250.5, 126.25},
+        {-1e9, 1e9}, {1e9, -1e9}
+    };
+    size_t n = sizeof(points) / sizeof(*points);
+    vector_t offset = {0.25, -0.25};
+    vector_t screen_center = {500, 250};
+    double scale = 2;
+
+    // Halves round away from zero, like round()
+    int16_t expected_x[] = {501, 503, 502, 499, 521, -1, -32768, 32767};
+    int16_t expected_y[] = {251, 253, 252, 249, 211, -2, -32768, 32767};
+    for (vec_batch_isa_t isa = VEC_BATCH_SCALAR; isa < NUM_VEC_BATCH_ISAS; isa++) {
+        if (!vec_batch_isa_supported(isa)) {
+            continue;
+        }
+        vec_batch_set_isa(isa);
+        int16_t xs[8], ys[8];
+        vec_batch_to_screen(points, n, offset, scale, screen_center, xs, ys);
+        for (size_t i = 0; i < n; i++) {
+            assert(xs[i] == expected_x[i]);
+            assert(ys[i] == expected_y[i]);
+        }
+    }
+    vec_batch_set_isa(vec_batch_best_isa());
+}
+
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_kernels_match_polygon)
+    DO_TEST(test_kernels_match_scalar)
+    DO_TEST(test_centroids)
+    DO_TEST(test_to_screen)
+
+    puts("vector_batch_test PASS");
+}
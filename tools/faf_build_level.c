@@ -0,0 +1,37 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "faf_levels.h"
+
+// Builds a level file offline, so races on it start without generating the track:
+//   faf_build_level <desert|ice|forest> <seed> <track length> <output file>
+
+const char *LEVEL_NAMES[3] = {"desert", "ice", "forest"};
+
+
+int main(int argc, char *argv[]) {
+    if (argc != 5) {
+        fprintf(stderr, "usage: %s <desert|ice|forest> <seed> <track length> <output file>\n", argv[0]);
+        return 1;
+    }
+
+    int level = -1;
+    for (int i = 0; i < 3; i++) {
+        if (strcmp(argv[1], LEVEL_NAMES[i]) == 0) {
+            level = i;
+        }
+    }
+    uint64_t seed = strtoull(argv[2], NULL, 10);
+    double track_length = strtod(argv[3], NULL);
+    if (level < 0 || !(track_length > 0) || track_length > 1e6) {
+        fprintf(stderr, "%s: unknown level or bad track length\n", argv[0]);
+        return 1;
+    }
+
+    if (!faf_save_level(argv[4], (faf_level_t)level, seed, track_length)) {
+        fprintf(stderr, "%s: could not write %s\n", argv[0], argv[4]);
+        return 1;
+    }
+    return 0;
+}
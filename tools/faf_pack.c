@@ -0,0 +1,105 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include "alloc.h"
+#include "pack.h"
+
+// Builds an asset archive offline (see include/pack.h), so the game starts without decoding images:
+//   faf_pack [-e] <output file> <asset file>...
+// Images (.png, .jpg) are stored as decoded RGBA pixels, and every other file as it is.
+// With -e, PNG images are also stored as they are, which keeps the archive small for
+// downloading; JPEG images are still decoded, since the web build's SDL_image only reads PNG.
+
+
+bool has_extension(const char *path, const char *extension) {
+    const char *dot = strrchr(path, '.');
+    return dot && strcmp(dot, extension) == 0;
+}
+
+
+// Decodes an image into tightly packed RGBA32 rows
+void *decode_image(const char *path, pack_entry_t *entry) {
+    SDL_Surface *image = IMG_Load(path);
+    if (!image) {
+        return NULL;
+    }
+    SDL_Surface *rgba = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(image);
+    if (!rgba) {
+        return NULL;
+    }
+
+    entry->kind = PACK_PIXELS;
+    entry->width = (uint32_t)rgba->w;
+    entry->height = (uint32_t)rgba->h;
+    entry->size = entry->width * entry->height * 4;
+    // Freed with SDL_free(), like the contents of other files
+    char *pixels = SDL_malloc(entry->size);
+    assert(pixels);
+    SDL_LockSurface(rgba);
+    for (uint32_t y = 0; y < entry->height; y++) {
+        memcpy(pixels + y * entry->width * 4, (char *)rgba->pixels + y * rgba->pitch, entry->width * 4);
+    }
+    SDL_UnlockSurface(rgba);
+    SDL_FreeSurface(rgba);
+    return pixels;
+}
+
+
+void *read_file(const char *path, pack_entry_t *entry) {
+    size_t size;
+    void *data = SDL_LoadFile(path, &size);
+    if (!data) {
+        return NULL;
+    }
+    entry->kind = PACK_FILE;
+    entry->size = (uint32_t)size;
+    entry->width = 0;
+    entry->height = 0;
+    return data;
+}
+
+
+int main(int argc, char *argv[]) {
+    bool keep_encoded = argc > 1 && strcmp(argv[1], "-e") == 0;
+    int first = keep_encoded ? 2 : 1;
+    if (argc < first + 2) {
+        fprintf(stderr, "usage: %s [-e] <output file> <asset file>...\n", argv[0]);
+        return 1;
+    }
+    const char *output = argv[first];
+    const char *const *paths = (const char *const *)&argv[first + 1];
+    size_t num_entries = (size_t)(argc - first - 1);
+
+    pack_entry_t *entries = alloc_malloc(ALLOC_TAG_ASSETS, sizeof(pack_entry_t) * num_entries);
+    assert(entries);
+    void **contents = alloc_malloc(ALLOC_TAG_ASSETS, sizeof(void *) * num_entries);
+    assert(contents);
+    IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG);
+    bool ok = true;
+    for (size_t i = 0; i < num_entries; i++) {
+        memset(&entries[i], 0, sizeof(pack_entry_t));
+        bool decode = has_extension(paths[i], ".jpg") || (!keep_encoded && has_extension(paths[i], ".png"));
+        contents[i] = decode ? decode_image(paths[i], &entries[i]) : read_file(paths[i], &entries[i]);
+        if (!contents[i]) {
+            fprintf(stderr, "%s: could not load %s\n", argv[0], paths[i]);
+            ok = false;
+        }
+    }
+    IMG_Quit();
+
+    if (ok && !pack_write(output, entries, paths, (const void *const *)contents, num_entries)) {
+        fprintf(stderr, "%s: could not write %s\n", argv[0], output);
+        ok = false;
+    }
+    for (size_t i = 0; i < num_entries; i++) {
+        SDL_free(contents[i]);
+    }
+    alloc_free(ALLOC_TAG_ASSETS, contents);
+    alloc_free(ALLOC_TAG_ASSETS, entries);
+    return ok ? 0 : 1;
+}